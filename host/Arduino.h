@@ -0,0 +1,173 @@
+#pragma once
+
+// Just enough of the Arduino core for the firmware modules the native build
+// links: a String over std::string, the timing calls (on systemClock(), see
+// hal.hpp) and the ESP32 allocation helpers.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+
+class StringSumHelper;
+
+class String {
+ public:
+  String() {}
+  String(const char* text) : _value(text != nullptr ? text : "") {}
+  String(const char* text, unsigned int length) : _value(text != nullptr ? std::string(text, length) : "") {}
+  String(const std::string& value) : _value(value) {}
+  explicit String(char c) : _value(1, c) {}
+  explicit String(int value) : _value(std::to_string(value)) {}
+  explicit String(unsigned int value) : _value(std::to_string(value)) {}
+  explicit String(long value) : _value(std::to_string(value)) {}
+  explicit String(unsigned long value) : _value(std::to_string(value)) {}
+  explicit String(long long value) : _value(std::to_string(value)) {}
+  explicit String(unsigned long long value) : _value(std::to_string(value)) {}
+  explicit String(double value, unsigned int decimals = 2) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    _value = buffer;
+  }
+
+  String& operator=(const char* text) {
+    _value = text != nullptr ? text : "";
+    return *this;
+  }
+
+  unsigned int length() const { return _value.size(); }
+  const char* c_str() const { return _value.c_str(); }
+  bool isEmpty() const { return _value.empty(); }
+  bool reserve(unsigned int size) {
+    _value.reserve(size);
+    return true;
+  }
+
+  bool concat(const String& other) {
+    _value += other._value;
+    return true;
+  }
+  bool concat(const char* text) {
+    if (text == nullptr) return false;
+    _value += text;
+    return true;
+  }
+  bool concat(const char* text, unsigned int length) {
+    if (text == nullptr) return false;
+    _value.append(text, length);
+    return true;
+  }
+  bool concat(char c) {
+    _value += c;
+    return true;
+  }
+
+  String& operator+=(const String& other) {
+    concat(other);
+    return *this;
+  }
+  String& operator+=(const char* text) {
+    concat(text);
+    return *this;
+  }
+  String& operator+=(char c) {
+    concat(c);
+    return *this;
+  }
+
+  bool operator==(const String& other) const { return _value == other._value; }
+  bool operator==(const char* other) const { return _value == (other != nullptr ? other : ""); }
+  bool operator!=(const String& other) const { return !(*this == other); }
+  bool operator!=(const char* other) const { return !(*this == other); }
+  bool operator<(const String& other) const { return _value < other._value; }
+  bool equals(const String& other) const { return *this == other; }
+
+  char charAt(unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return _value[index]; }
+
+  int indexOf(char c, unsigned int from = 0) const { return position(_value.find(c, from)); }
+  int indexOf(const String& text, unsigned int from = 0) const { return position(_value.find(text._value, from)); }
+  int lastIndexOf(char c) const { return position(_value.rfind(c)); }
+  int lastIndexOf(const String& text) const { return position(_value.rfind(text._value)); }
+  bool startsWith(const String& prefix) const { return _value.compare(0, prefix._value.size(), prefix._value) == 0; }
+  bool endsWith(const String& suffix) const {
+    return _value.size() >= suffix._value.size() &&
+      _value.compare(_value.size() - suffix._value.size(), suffix._value.size(), suffix._value) == 0;
+  }
+
+  String substring(unsigned int from) const { return from < _value.size() ? String(_value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    return from < _value.size() ? String(_value.substr(from, to - from)) : String();
+  }
+
+  void remove(unsigned int index) { remove(index, _value.size()); }
+  void remove(unsigned int index, unsigned int count) {
+    if (index < _value.size()) _value.erase(index, count);
+  }
+  void trim() {
+    size_t first = _value.find_first_not_of(" \t\r\n");
+    size_t last = _value.find_last_not_of(" \t\r\n");
+    _value = first == std::string::npos ? std::string() : _value.substr(first, last - first + 1);
+  }
+  void toLowerCase() {
+    for (char& c : _value) c = (char)tolower((unsigned char)c);
+  }
+  void toUpperCase() {
+    for (char& c : _value) c = (char)toupper((unsigned char)c);
+  }
+  long toInt() const { return atol(_value.c_str()); }
+
+  void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const {
+    if (size == 0) return;
+    size_t count = index < _value.size() ? std::min<size_t>(size - 1, _value.size() - index) : 0;
+    memcpy(buffer, _value.data() + index, count);
+    buffer[count] = 0;
+  }
+
+ private:
+  static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+
+  std::string _value;
+};
+
+// The type `String + ...` evaluates to, as in the Arduino core
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& value) : String(value) {}
+};
+
+inline StringSumHelper operator+(const String& left, const String& right) {
+  String sum(left);
+  sum += right;
+  return sum;
+}
+inline StringSumHelper operator+(const String& left, const char* right) {
+  String sum(left);
+  sum += right;
+  return sum;
+}
+inline StringSumHelper operator+(const char* left, const String& right) {
+  String sum(left);
+  sum += right;
+  return sum;
+}
+inline StringSumHelper operator+(const String& left, char right) {
+  String sum(left);
+  sum += right;
+  return sum;
+}
+
+// On systemClock() (hal.hpp), so tests can run the firmware on a fake clock
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// PSRAM does not exist here; the heap stands in for it
+inline void* ps_malloc(size_t size) { return malloc(size); }
@@ -0,0 +1,83 @@
+#pragma once
+
+// fs::FS and fs::File over a host directory, for the stores that keep their
+// data in LittleFS. Paths are rooted at setRoot(); tests point it at a fresh
+// temporary directory.
+
+#include <Arduino.h>
+
+#include <memory>
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet,
+  SeekCur,
+  SeekEnd
+};
+
+struct FileImpl;
+
+class File {
+ public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl) : _impl(impl) {}
+
+  size_t write(const uint8_t* data, size_t length);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t read(uint8_t* buffer, size_t length);
+  int read();
+  int available();
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void flush();
+  void close();
+
+  // The last path component, as LittleFS reports it
+  const char* name() const;
+  const char* path() const;
+  bool isDirectory() const;
+  File openNextFile(const char* mode = "r");
+
+  operator bool() const;
+
+ private:
+  std::shared_ptr<FileImpl> _impl;
+};
+
+class FS {
+ public:
+  File open(const char* path, const char* mode = "r", bool create = false);
+  File open(const String& path, const char* mode = "r", bool create = false) {
+    return open(path.c_str(), mode, create);
+  }
+
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+  bool mkdir(const char* path);
+  bool mkdir(const String& path) { return mkdir(path.c_str()); }
+  bool rmdir(const char* path);
+
+  // Host directory that "/" maps to. Created if missing.
+  void setRoot(const char* directory);
+  const char* root() const { return _root.c_str(); }
+
+ private:
+  std::string hostPath(const char* path) const;
+
+  std::string _root = ".";
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
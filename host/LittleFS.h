@@ -0,0 +1,18 @@
+#pragma once
+
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+ public:
+  bool begin(bool formatOnFail = false) {
+    (void)formatOnFail;
+    return true;
+  }
+  void end() {}
+};
+
+}  // namespace fs
+
+extern fs::LittleFSFS LittleFS;
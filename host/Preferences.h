@@ -0,0 +1,63 @@
+#pragma once
+
+// NVS as an in-memory map that lives as long as the process, so a test can
+// save state, "reboot" by re-running the restore path and read it back.
+// clearAll() is there for test setup.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) {
+    _namespace = name;
+    _readOnly = readOnly;
+    _open = true;
+    return true;
+  }
+
+  void end() { _open = false; }
+
+  size_t getBytesLength(const char* key) {
+    auto found = store().find(fullKey(key));
+    return _open && found != store().end() ? found->second.size() : 0;
+  }
+
+  size_t getBytes(const char* key, void* buffer, size_t length) {
+    auto found = store().find(fullKey(key));
+    if (!_open || found == store().end() || found->second.size() > length) return 0;
+    memcpy(buffer, found->second.data(), found->second.size());
+    return found->second.size();
+  }
+
+  size_t putBytes(const char* key, const void* data, size_t length) {
+    if (!_open || _readOnly) return 0;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    store()[fullKey(key)].assign(bytes, bytes + length);
+    return length;
+  }
+
+  bool remove(const char* key) {
+    return _open && !_readOnly && store().erase(fullKey(key)) > 0;
+  }
+
+  // Every namespace
+  static void clearAll() { store().clear(); }
+
+ private:
+  static std::map<std::string, std::vector<uint8_t>>& store() {
+    static std::map<std::string, std::vector<uint8_t>> values;
+    return values;
+  }
+
+  std::string fullKey(const char* key) const { return _namespace + "/" + key; }
+
+  std::string _namespace;
+  bool _readOnly = false;
+  bool _open = false;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Hardware RNG on the device; rand() here
+inline uint32_t esp_random() {
+  return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
@@ -0,0 +1,50 @@
+#include "fakes.hpp"
+
+#include <LittleFS.h>
+#include <stdlib.h>
+
+bool FakeNetwork::resolve(const char* host, uint32_t& address, uint32_t timeoutMs) {
+  (void)host;
+  (void)timeoutMs;
+  lookups++;
+  if (failResolve) return false;
+  address = 0x0100000A;  // 10.0.0.1 in network byte order
+  return true;
+}
+
+HttpProbeResult FakeHttpClient::get(const String& host, int port, const String& path, const String& expected) {
+  Request request = {host, port, path, expected};
+  requests.push_back(request);
+
+  HttpProbeResult result = respond ? respond(request) : httpResult(PROBE_OK);
+  _clock.advance(result.millis);
+  return result;
+}
+
+HttpProbeResult httpResult(ProbeError error, int status, uint32_t millis) {
+  HttpProbeResult result = {error, error == PROBE_OK || error == PROBE_HTTP_STATUS ? status : 0, 0, millis};
+  return result;
+}
+
+Service fakeService(uint64_t id, ServiceType type) {
+  Service service;
+  resetServiceRuntime(service);
+  service.id = id;
+  service.name = "service-" + formatServiceId(id);
+  service.type = type;
+  service.host = "example.lan";
+  service.port = 8080;
+  service.path = "/";
+  service.expectedResponse = "*";
+  service.checkInterval = 60;
+  service.passThreshold = 1;
+  service.failThreshold = 1;
+  return service;
+}
+
+void useTempLittleFS() {
+  char directory[] = "/tmp/uptime-monitor-XXXXXX";
+  if (mkdtemp(directory) != nullptr) {
+    LittleFS.setRoot(directory);
+  }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "check_runner.hpp"
+#include "hal.hpp"
+#include "http_probe.hpp"
+
+// Helpers shared by the host tests and tools, and scriptable stand-ins for
+// hal.hpp for tests that drive the check pipeline without sockets or real
+// time.
+
+// Time only moves when told to, or when code under test sleeps.
+class FakeClock : public Clock {
+ public:
+  uint32_t millis() override { return (uint32_t)(_micros / 1000); }
+  uint32_t micros() override { return (uint32_t)_micros; }
+  void sleep(uint32_t ms) override { advance(ms); }
+  uint32_t unixTime() override { return _unixStart != 0 ? _unixStart + (uint32_t)(_micros / 1000000) : 0; }
+
+  void advance(uint32_t ms) { _micros += (uint64_t)ms * 1000; }
+  void advanceMicros(uint32_t us) { _micros += us; }
+
+  // Unix time at millis() == 0; 0 leaves the wall clock unset
+  void setUnixStart(uint32_t unixTime) { _unixStart = unixTime; }
+
+ private:
+  uint64_t _micros = 0;
+  uint32_t _unixStart = 0;
+};
+
+// Resolves every name to 10.0.0.1 unless failResolve is set. Sockets are not
+// supported; pair it with FakeHttpClient.
+class FakeNetwork : public Network {
+ public:
+  bool linkUp() override { return up; }
+  bool resolve(const char* host, uint32_t& address, uint32_t timeoutMs) override;
+  std::unique_ptr<Socket> newSocket() override { return nullptr; }
+
+  bool up = true;
+  bool failResolve = false;
+  int lookups = 0;
+};
+
+// Answers every GET through `respond`, which may advance the clock to model
+// a slow server. Defaults to an immediate 200.
+class FakeHttpClient : public HttpClient {
+ public:
+  struct Request {
+    String host;
+    int port;
+    String path;
+    String expected;
+  };
+
+  explicit FakeHttpClient(FakeClock& clock) : _clock(clock) {}
+
+  HttpProbeResult get(const String& host, int port, const String& path, const String& expected) override;
+
+  std::function<HttpProbeResult(const Request&)> respond;
+  std::vector<Request> requests;
+
+ private:
+  FakeClock& _clock;
+};
+
+class FakePinger : public Pinger {
+ public:
+  bool ping(uint32_t address, int count) override {
+    (void)address;
+    (void)count;
+    pings++;
+    return reachable;
+  }
+
+  bool reachable = true;
+  int pings = 0;
+};
+
+// Counts how often the screen would have been updated.
+class RecordingDisplay : public StatusDisplay {
+ public:
+  void servicesChanged(const ServiceTable& table) override {
+    (void)table;
+    updates++;
+  }
+
+  int updates = 0;
+};
+
+// A result for FakeHttpClient::respond
+HttpProbeResult httpResult(ProbeError error, int status = 200, uint32_t millis = 0);
+
+// A never-checked service with the web form's defaults: HTTP GET of
+// example.lan:8080/, checked every 60 s, pass and fail thresholds of 1.
+Service fakeService(uint64_t id, ServiceType type = TYPE_HTTP_GET);
+
+// Points LittleFS at a new empty temporary directory.
+void useTempLittleFS();
@@ -0,0 +1,30 @@
+#pragma once
+
+// The FreeRTOS pieces the host-built modules use, on std::mutex. Ticks are
+// milliseconds.
+
+#include <stdint.h>
+
+#include <mutex>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Critical sections: a plain lock, not a spinlock with interrupts masked
+struct portMUX_TYPE {
+  std::mutex mutex;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux) (mux)->mutex.unlock()
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+
+#include <chrono>
+#include <mutex>
+
+typedef std::timed_mutex* SemaphoreHandle_t;
+
+// Never freed, like the firmware's mutexes
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new std::timed_mutex();
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    semaphore->lock();
+    return pdTRUE;
+  }
+  return semaphore->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  semaphore->unlock();
+  return pdTRUE;
+}
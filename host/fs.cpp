@@ -0,0 +1,155 @@
+#include <FS.h>
+#include <LittleFS.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+fs::LittleFSFS LittleFS;
+
+namespace fs {
+
+struct FileImpl {
+  std::string path;  // as the firmware named it
+  std::string hostPath;
+  FILE* file = nullptr;
+  DIR* dir = nullptr;
+  std::string name;
+
+  ~FileImpl() {
+    if (file != nullptr) fclose(file);
+    if (dir != nullptr) closedir(dir);
+  }
+};
+
+size_t File::write(const uint8_t* data, size_t length) {
+  if (!_impl || _impl->file == nullptr) return 0;
+  return fwrite(data, 1, length, _impl->file);
+}
+
+size_t File::read(uint8_t* buffer, size_t length) {
+  if (!_impl || _impl->file == nullptr) return 0;
+  return fread(buffer, 1, length, _impl->file);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::available() {
+  return (int)(size() - position());
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  if (!_impl || _impl->file == nullptr) return false;
+  int whence = mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END;
+  return fseek(_impl->file, position, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!_impl || _impl->file == nullptr) return 0;
+  long position = ftell(_impl->file);
+  return position < 0 ? 0 : (size_t)position;
+}
+
+size_t File::size() const {
+  if (!_impl || _impl->file == nullptr) return 0;
+  fflush(_impl->file);
+  struct stat info;
+  return fstat(fileno(_impl->file), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+void File::flush() {
+  if (_impl && _impl->file != nullptr) fflush(_impl->file);
+}
+
+void File::close() {
+  _impl.reset();
+}
+
+const char* File::name() const {
+  return _impl ? _impl->name.c_str() : "";
+}
+
+const char* File::path() const {
+  return _impl ? _impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+  return _impl && _impl->dir != nullptr;
+}
+
+File File::openNextFile(const char* mode) {
+  if (!isDirectory()) return File();
+
+  struct dirent* entry;
+  while ((entry = readdir(_impl->dir)) != nullptr) {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..") continue;
+
+    std::string path = _impl->path == "/" ? "/" + name : _impl->path + "/" + name;
+    return LittleFS.open(path.c_str(), mode);
+  }
+  return File();
+}
+
+File::operator bool() const {
+  return _impl && (_impl->file != nullptr || _impl->dir != nullptr);
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+  (void)create;
+  if (path == nullptr || path[0] != '/') return File();
+
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  impl->hostPath = hostPath(path);
+  impl->name = impl->path.substr(impl->path.rfind('/') + 1);
+
+  struct stat info;
+  if (stat(impl->hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+    impl->dir = opendir(impl->hostPath.c_str());
+    return impl->dir != nullptr ? File(impl) : File();
+  }
+
+  std::string fileMode = mode;
+  if (fileMode.find('b') == std::string::npos) fileMode += "b";
+  impl->file = fopen(impl->hostPath.c_str(), fileMode.c_str());
+  return impl->file != nullptr ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+  struct stat info;
+  return path != nullptr && stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return path != nullptr && unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+void FS::setRoot(const char* directory) {
+  _root = directory;
+  ::mkdir(directory, 0755);
+}
+
+std::string FS::hostPath(const char* path) const {
+  return _root + path;
+}
+
+}  // namespace fs
@@ -0,0 +1,226 @@
+#include "host_platform.hpp"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "config.hpp"
+
+namespace {
+
+Clock* installedClock = nullptr;
+
+uint64_t monotonicMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+PosixClock::PosixClock() : _startMicros(monotonicMicros()) {}
+
+uint32_t PosixClock::millis() {
+  return (uint32_t)((monotonicMicros() - _startMicros) / 1000);
+}
+
+uint32_t PosixClock::micros() {
+  return (uint32_t)(monotonicMicros() - _startMicros);
+}
+
+void PosixClock::sleep(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+uint32_t PosixClock::unixTime() {
+  time_t now = time(nullptr);
+  return now >= CLOCK_VALID_AFTER ? (uint32_t)now : 0;
+}
+
+PosixSocket::~PosixSocket() {
+  stop();
+}
+
+bool PosixSocket::connect(uint32_t address, uint16_t port, uint32_t timeoutMs) {
+  stop();
+  _fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (_fd < 0) return false;
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+
+  sockaddr_in peer = {};
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons(port);
+  peer.sin_addr.s_addr = address;
+  if (::connect(_fd, reinterpret_cast<sockaddr*>(&peer), sizeof(peer)) == 0) return true;
+  if (errno != EINPROGRESS) {
+    stop();
+    return false;
+  }
+
+  pollfd pending = {_fd, POLLOUT, 0};
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (poll(&pending, 1, timeoutMs) != 1 || getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 ||
+      error != 0) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+size_t PosixSocket::write(const uint8_t* data, size_t length) {
+  if (_fd < 0) return 0;
+  ssize_t written = send(_fd, data, length, MSG_NOSIGNAL);
+  return written < 0 ? 0 : (size_t)written;
+}
+
+int PosixSocket::available() {
+  int count = 0;
+  if (_fd < 0 || ioctl(_fd, FIONREAD, &count) != 0) return 0;
+  return count;
+}
+
+int PosixSocket::read(uint8_t* buffer, size_t size) {
+  if (_fd < 0) return -1;
+  ssize_t count = recv(_fd, buffer, size, MSG_DONTWAIT);
+  return count > 0 ? (int)count : -1;
+}
+
+bool PosixSocket::connected() {
+  if (_fd < 0) return false;
+  if (available() > 0) return true;
+
+  uint8_t c;
+  ssize_t count = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return count > 0 || (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+void PosixSocket::stop() {
+  if (_fd >= 0) close(_fd);
+  _fd = -1;
+}
+
+bool PosixNetwork::resolve(const char* host, uint32_t& address, uint32_t timeoutMs) {
+  in_addr parsed;
+  if (inet_pton(AF_INET, host, &parsed) == 1) {
+    address = parsed.s_addr;
+    return true;
+  }
+  if (_dnsPort != 0) {
+    return queryDnsServer(host, address, timeoutMs);
+  }
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  addrinfo* found = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &found) != 0 || found == nullptr) return false;
+  address = reinterpret_cast<sockaddr_in*>(found->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(found);
+  return true;
+}
+
+// One A query over UDP, no retries. Answers are matched by id and the first
+// A record is taken.
+bool PosixNetwork::queryDnsServer(const char* host, uint32_t& address, uint32_t timeoutMs) {
+  uint8_t packet[512];
+  uint16_t id = (uint16_t)rand();
+  uint8_t header[12] = {(uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0};
+  memcpy(packet, header, sizeof(header));
+
+  size_t length = sizeof(header);
+  for (const char* label = host; *label != '\0';) {
+    const char* dot = strchr(label, '.');
+    size_t size = dot != nullptr ? (size_t)(dot - label) : strlen(label);
+    if (size == 0 || size > 63 || length + size + 6 > sizeof(packet)) return false;
+    packet[length++] = (uint8_t)size;
+    memcpy(packet + length, label, size);
+    length += size;
+    label += size + (dot != nullptr ? 1 : 0);
+  }
+  const uint8_t question[] = {0, 0, 1, 0, 1};  // root, type A, class IN
+  memcpy(packet + length, question, sizeof(question));
+  length += sizeof(question);
+  size_t questionEnd = length;
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+  sockaddr_in server = {};
+  server.sin_family = AF_INET;
+  server.sin_port = htons(_dnsPort);
+  server.sin_addr.s_addr = _dnsAddress;
+  bool sent = sendto(fd, packet, length, 0, reinterpret_cast<sockaddr*>(&server), sizeof(server)) ==
+    (ssize_t)length;
+
+  uint64_t deadline = monotonicMicros() + (uint64_t)timeoutMs * 1000;
+  bool answered = false;
+  bool found = false;
+  while (sent && !answered) {
+    uint64_t now = monotonicMicros();
+    pollfd pending = {fd, POLLIN, 0};
+    if (now >= deadline || poll(&pending, 1, (int)((deadline - now + 999) / 1000)) != 1) break;
+
+    ssize_t received = recv(fd, packet, sizeof(packet), 0);
+    if (received < (ssize_t)questionEnd || packet[0] != (uint8_t)(id >> 8) || packet[1] != (uint8_t)id) {
+      continue;
+    }
+    answered = true;
+    if ((packet[3] & 0x0f) != 0) break;  // NXDOMAIN and other errors
+
+    int answers = (packet[6] << 8) | packet[7];
+    size_t at = questionEnd;
+    for (int i = 0; i < answers && !found; i++) {
+      // Owner name: labels, or a pointer that ends it
+      while (at < (size_t)received && packet[at] != 0 && (packet[at] & 0xc0) != 0xc0) at += packet[at] + 1;
+      at += at < (size_t)received && packet[at] != 0 ? 2 : 1;
+      if (at + 10 > (size_t)received) break;
+
+      uint16_t type = (packet[at] << 8) | packet[at + 1];
+      uint16_t dataLength = (packet[at + 8] << 8) | packet[at + 9];
+      at += 10;
+      if (at + dataLength > (size_t)received) break;
+      if (type == 1 && dataLength == 4) {
+        memcpy(&address, packet + at, 4);
+        found = true;
+      }
+      at += dataLength;
+    }
+  }
+  close(fd);
+  return found;
+}
+
+std::unique_ptr<Socket> PosixNetwork::newSocket() {
+  return std::unique_ptr<Socket>(new PosixSocket());
+}
+
+void setSystemClock(Clock& clock) {
+  installedClock = &clock;
+}
+
+Clock& systemClock() {
+  static PosixClock posixClock;
+  return installedClock != nullptr ? *installedClock : posixClock;
+}
+
+unsigned long millis() {
+  return systemClock().millis();
+}
+
+unsigned long micros() {
+  return systemClock().micros();
+}
+
+void delay(unsigned long ms) {
+  systemClock().sleep(ms);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "hal.hpp"
+
+// hal.hpp on POSIX, for the native build: the process's monotonic clock and
+// BSD sockets. Tests that need control over time use FakeClock (fakes.hpp)
+// instead and install it with setSystemClock().
+
+class PosixClock : public Clock {
+ public:
+  PosixClock();
+
+  uint32_t millis() override;
+  uint32_t micros() override;
+  void sleep(uint32_t ms) override;
+  uint32_t unixTime() override;
+
+ private:
+  uint64_t _startMicros;
+};
+
+class PosixSocket : public Socket {
+ public:
+  ~PosixSocket() override;
+
+  bool connect(uint32_t address, uint16_t port, uint32_t timeoutMs) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  int available() override;
+  int read(uint8_t* buffer, size_t size) override;
+  bool connected() override;
+  void stop() override;
+
+ private:
+  int _fd = -1;
+};
+
+// Names resolve through the system resolver, or a DNS server set with
+// useDnsServer(); dotted quads directly.
+class PosixNetwork : public Network {
+ public:
+  bool linkUp() override { return _linkUp; }
+  bool resolve(const char* host, uint32_t& address, uint32_t timeoutMs) override;
+  std::unique_ptr<Socket> newSocket() override;
+
+  // Simulates losing the WiFi link
+  void setLinkUp(bool up) { _linkUp = up; }
+
+  // Sends A queries to the server at `address` (network byte order):`port`
+  // and gives up after resolve()'s `timeoutMs`. The system resolver has its
+  // own timeouts, so tests of a hanging server use this.
+  void useDnsServer(uint32_t address, uint16_t port) {
+    _dnsAddress = address;
+    _dnsPort = port;
+  }
+
+ private:
+  bool queryDnsServer(const char* host, uint32_t& address, uint32_t timeoutMs);
+
+  bool _linkUp = true;
+  uint32_t _dnsAddress = 0;
+  uint16_t _dnsPort = 0;
+};
+
+// Makes `clock` the one behind systemClock(), millis() and delay(). Until
+// called, a PosixClock is used.
+void setSystemClock(Clock& clock);
@@ -0,0 +1,26 @@
+#include "logger.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Host builds log straight to stderr, warnings and errors only unless
+// HOST_LOG_DEBUG is set, so test output stays readable.
+#ifndef HOST_LOG_DEBUG
+#define HOST_LOG_DEBUG 0
+#endif
+
+bool initLogger() {
+  return true;
+}
+
+void logPrintf(LogLevel level, const char* format, ...) {
+  if (level < LOG_WARN && !HOST_LOG_DEBUG) return;
+
+  static const char* const LEVELS[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+  fprintf(stderr, "%lu %s ", millis(), LEVELS[level]);
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
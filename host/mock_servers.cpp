@@ -0,0 +1,258 @@
+#include "mock_servers.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const int POLL_MS = 20;  // how often the server threads look at `stopping`
+const uint32_t LOOPBACK = 0x0100007F;
+
+// A socket bound to 127.0.0.1 at a free port, -1 on failure
+int bindLoopback(int type, uint16_t& port) {
+  int fd = socket(AF_INET, type, 0);
+  if (fd < 0) return -1;
+
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = LOOPBACK;
+  socklen_t length = sizeof(local);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length) != 0) {
+    close(fd);
+    return -1;
+  }
+  port = ntohs(local.sin_port);
+  return fd;
+}
+
+bool readable(int fd, int timeoutMs) {
+  pollfd pending = {fd, POLLIN, 0};
+  return poll(&pending, 1, timeoutMs) == 1;
+}
+
+// False once the client has gone
+bool sendAll(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (count <= 0) return false;
+    sent += count;
+  }
+  return true;
+}
+
+// Closes with a reset instead of a FIN
+void reset(int fd) {
+  linger abort = {1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_LINGER, &abort, sizeof(abort));
+  close(fd);
+}
+
+}  // namespace
+
+MockHttpServer::MockHttpServer(MockHttpBehaviour behaviour, const std::string& body, int status)
+  : _behaviour(behaviour), _body(body), _status(status) {
+  _listener = bindLoopback(SOCK_STREAM, _port);
+  if (_listener >= 0 && listen(_listener, 4) == 0) {
+    _thread = std::thread(&MockHttpServer::run, this);
+  }
+}
+
+MockHttpServer::~MockHttpServer() {
+  _stopping = true;
+  if (_thread.joinable()) _thread.join();
+  if (_listener >= 0) close(_listener);
+}
+
+void MockHttpServer::run() {
+  while (!_stopping) {
+    if (!readable(_listener, POLL_MS)) continue;
+    int client = accept(_listener, nullptr, nullptr);
+    if (client < 0) continue;
+    _connections++;
+    serve(client);
+  }
+}
+
+void MockHttpServer::serve(int client) {
+  // The request, up to its blank line
+  std::string request;
+  char buffer[512];
+  while (!_stopping && request.find("\r\n\r\n") == std::string::npos) {
+    if (!readable(client, POLL_MS)) continue;
+    ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+    if (count <= 0) {
+      close(client);
+      return;
+    }
+    request.append(buffer, count);
+  }
+
+  std::string status = "HTTP/1.1 " + std::to_string(_status) + " OK\r\n";
+  std::string headers = status + "Content-Type: text/plain\r\nContent-Length: " + std::to_string(_body.size()) +
+    "\r\nConnection: close\r\n\r\n";
+  bool open = true;
+
+  switch (_behaviour) {
+    case MOCK_HTTP_OK:
+      sendAll(client, headers + _body);
+      break;
+
+    case MOCK_HTTP_SLOWLORIS: {
+      open = sendAll(client, status);
+      const std::string trickle = "X-Padding: a\r\n";
+      for (size_t i = 0; open && !_stopping; i++) {
+        usleep(50 * 1000);
+        open = sendAll(client, trickle.substr(i % trickle.size(), 1));
+      }
+      break;
+    }
+
+    case MOCK_HTTP_HALF_OPEN:
+      // Until the client gives up
+      while (!_stopping) {
+        if (readable(client, POLL_MS) && recv(client, buffer, sizeof(buffer), 0) <= 0) break;
+      }
+      break;
+
+    case MOCK_HTTP_RESET_IN_HEADERS:
+      sendAll(client, headers.substr(0, headers.size() / 2));
+      usleep(100 * 1000);  // let the client read it before the reset
+      reset(client);
+      return;
+
+    case MOCK_HTTP_RESET_IN_BODY:
+      sendAll(client, headers + _body.substr(0, _body.size() / 2));
+      usleep(100 * 1000);
+      reset(client);
+      return;
+
+    case MOCK_HTTP_HUGE_BODY: {
+      open = sendAll(client, status + "Content-Length: 104857600\r\n\r\n");
+      std::string block(4096, 'x');
+      for (int i = 0; open && !_stopping && i < 104857600 / 4096; i++) {
+        open = sendAll(client, block);
+      }
+      break;
+    }
+
+    case MOCK_HTTP_ENDLESS_CHUNKED: {
+      open = sendAll(client, status + "Transfer-Encoding: chunked\r\n\r\n");
+      std::string chunk = "64\r\n" + std::string(100, 'x') + "\r\n";
+      while (open && !_stopping) {
+        open = sendAll(client, chunk);
+        usleep(20 * 1000);
+      }
+      break;
+    }
+
+    case MOCK_HTTP_HUGE_HEADERS: {
+      open = sendAll(client, status);
+      std::string line = "X-Padding: " + std::string(100, 'a') + "\r\n";
+      while (open && !_stopping) {
+        open = sendAll(client, line);
+      }
+      break;
+    }
+
+    case MOCK_HTTP_NOT_HTTP:
+      sendAll(client, "SSH-2.0-OpenSSH_9.6\r\n");
+      break;
+  }
+  close(client);
+}
+
+MockDnsServer::MockDnsServer(MockDnsBehaviour behaviour, uint32_t answer) : _behaviour(behaviour), _answer(answer) {
+  _socket = bindLoopback(SOCK_DGRAM, _port);
+  if (_socket >= 0) {
+    _thread = std::thread(&MockDnsServer::run, this);
+  }
+}
+
+MockDnsServer::~MockDnsServer() {
+  _stopping = true;
+  if (_thread.joinable()) _thread.join();
+  if (_socket >= 0) close(_socket);
+}
+
+void MockDnsServer::run() {
+  uint8_t packet[512];
+  while (!_stopping) {
+    if (!readable(_socket, POLL_MS)) continue;
+
+    sockaddr_in client = {};
+    socklen_t clientLength = sizeof(client);
+    ssize_t length = recvfrom(_socket, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&client),
+      &clientLength);
+    if (length < 12) continue;
+    _queries++;
+    if (_behaviour == MOCK_DNS_HANG) continue;
+
+    // The query turned into its answer: same id and question
+    packet[2] = 0x81;
+    packet[3] = _behaviour == MOCK_DNS_NXDOMAIN ? 0x83 : 0x80;
+    packet[6] = 0;
+    packet[7] = _behaviour == MOCK_DNS_ANSWER ? 1 : 0;
+    if (_behaviour == MOCK_DNS_ANSWER && length + 16 <= (ssize_t)sizeof(packet)) {
+      // Name pointer to the question, A, IN, TTL 60, 4 bytes
+      const uint8_t record[] = {0xc0, 0x0c, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4};
+      memcpy(packet + length, record, sizeof(record));
+      memcpy(packet + length + sizeof(record), &_answer, 4);
+      length += sizeof(record) + 4;
+    }
+    sendto(_socket, packet, length, 0, reinterpret_cast<sockaddr*>(&client), clientLength);
+  }
+}
+
+MockEchoServer::MockEchoServer(bool answers) : _answers(answers) {
+  _socket = bindLoopback(SOCK_DGRAM, _port);
+  if (_socket >= 0) {
+    _thread = std::thread(&MockEchoServer::run, this);
+  }
+}
+
+MockEchoServer::~MockEchoServer() {
+  _stopping = true;
+  if (_thread.joinable()) _thread.join();
+  if (_socket >= 0) close(_socket);
+}
+
+void MockEchoServer::run() {
+  uint8_t packet[64];
+  while (!_stopping) {
+    if (!readable(_socket, POLL_MS)) continue;
+
+    sockaddr_in client = {};
+    socklen_t clientLength = sizeof(client);
+    ssize_t length = recvfrom(_socket, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&client),
+      &clientLength);
+    if (length > 0 && _answers) {
+      sendto(_socket, packet, length, 0, reinterpret_cast<sockaddr*>(&client), clientLength);
+    }
+  }
+}
+
+bool UdpEchoPinger::ping(uint32_t address, int count) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+
+  sockaddr_in target = {};
+  target.sin_family = AF_INET;
+  target.sin_port = htons(_port);
+  target.sin_addr.s_addr = address;
+
+  bool answered = false;
+  for (int i = 0; i < count && !answered; i++) {
+    uint8_t sequence = (uint8_t)i;
+    if (sendto(fd, &sequence, 1, 0, reinterpret_cast<sockaddr*>(&target), sizeof(target)) != 1) break;
+    uint8_t echo;
+    answered = readable(fd, _timeoutMs) && recv(fd, &echo, 1, 0) == 1 && echo == sequence;
+  }
+  close(fd);
+  return answered;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "hal.hpp"
+
+// Local servers that fail the way real outages do, for the probe fault
+// tests. Each listens on 127.0.0.1 at a free port and serves from its own
+// thread, one client at a time, until destroyed.
+
+enum MockHttpBehaviour {
+  MOCK_HTTP_OK,                // 200 with the body
+  MOCK_HTTP_SLOWLORIS,         // the status line, then a header byte every 50 ms, forever
+  MOCK_HTTP_HALF_OPEN,         // reads the request, then neither answers nor closes
+  MOCK_HTTP_RESET_IN_HEADERS,  // part of the headers, then a TCP reset
+  MOCK_HTTP_RESET_IN_BODY,     // the headers and the first half of the body, then a reset
+  MOCK_HTTP_HUGE_BODY,         // 200 with a 100 MB body, as fast as it is read
+  MOCK_HTTP_ENDLESS_CHUNKED,   // 200, chunked, 100 bytes every 20 ms that never end
+  MOCK_HTTP_HUGE_HEADERS,      // header lines that never reach the blank one
+  MOCK_HTTP_NOT_HTTP           // an SSH banner
+};
+
+class MockHttpServer {
+ public:
+  explicit MockHttpServer(MockHttpBehaviour behaviour, const std::string& body = "OK", int status = 200);
+  ~MockHttpServer();
+
+  uint16_t port() const { return _port; }
+  int connections() const { return _connections; }
+
+ private:
+  void run();
+  void serve(int client);
+
+  MockHttpBehaviour _behaviour;
+  std::string _body;
+  int _status;
+  int _listener = -1;
+  uint16_t _port = 0;
+  std::atomic<int> _connections{0};
+  std::atomic<bool> _stopping{false};
+  std::thread _thread;
+};
+
+enum MockDnsBehaviour {
+  MOCK_DNS_ANSWER,   // one A record
+  MOCK_DNS_HANG,     // never replies
+  MOCK_DNS_NXDOMAIN
+};
+
+// Pair with PosixNetwork::useDnsServer().
+class MockDnsServer {
+ public:
+  // `answer` is IPv4 in network byte order; 127.0.0.1 by default
+  explicit MockDnsServer(MockDnsBehaviour behaviour, uint32_t answer = 0x0100007F);
+  ~MockDnsServer();
+
+  uint16_t port() const { return _port; }
+  int queries() const { return _queries; }
+
+ private:
+  void run();
+
+  MockDnsBehaviour _behaviour;
+  uint32_t _answer;
+  int _socket = -1;
+  uint16_t _port = 0;
+  std::atomic<int> _queries{0};
+  std::atomic<bool> _stopping{false};
+  std::thread _thread;
+};
+
+// Echoes UDP datagrams back, or swallows them like a host that is down.
+class MockEchoServer {
+ public:
+  explicit MockEchoServer(bool answers);
+  ~MockEchoServer();
+
+  uint16_t port() const { return _port; }
+
+ private:
+  void run();
+
+  bool _answers;
+  int _socket = -1;
+  uint16_t _port = 0;
+  std::atomic<bool> _stopping{false};
+  std::thread _thread;
+};
+
+// ICMP needs privileges, so this pings a MockEchoServer over UDP instead.
+// Like ESP32Ping, each echo request is given up on after `timeoutMs`.
+class UdpEchoPinger : public Pinger {
+ public:
+  UdpEchoPinger(uint16_t port, uint32_t timeoutMs) : _port(port), _timeoutMs(timeoutMs) {}
+
+  bool ping(uint32_t address, int count) override;
+
+ private:
+  uint16_t _port;
+  uint32_t _timeoutMs;
+};
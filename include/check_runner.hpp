@@ -0,0 +1,45 @@
+#pragma once
+
+#include "hal.hpp"
+#include "http_probe.hpp"
+#include "service_table.hpp"
+
+// One round of service checks: finds the services that are due, probes each
+// through the platform seams in hal.hpp and applies the result to the
+// threshold state machine. Recording, notifications and persistence stay with
+// the caller, which gets a callback per check. Runs in loop(), the only
+// writer of the table; on the host the same code runs against fakes or mock
+// servers.
+
+struct CheckPlatform {
+  Clock& clock;
+  Network& network;
+  HttpClient& http;
+  Pinger& pinger;
+  StatusDisplay& display;
+};
+
+// What one check did, handed to the caller after applyCheckResult().
+struct CheckOutcome {
+  uint16_t slot;         // table slot of the service
+  ProbeError error;      // PROBE_OK if it passed
+  bool firstCheck;       // the service had never been checked
+  bool changed;          // isUp changed
+  uint32_t lateness;     // ms past due when the probe started, 0 on the first
+  uint32_t probeMicros;  // time spent in the probe
+  uint32_t startMillis;  // when the round started; the check's timestamp
+  uint32_t unixTime;     // wall clock at the end, 0 if not set
+};
+
+typedef void (*CheckCallback)(Service& service, const CheckOutcome& outcome);
+
+// Runs the probe for `service`'s type, or the simulated one with
+// SIMULATE_PROBES. Sets lastError on failure.
+ProbeError probeService(Service& service, CheckPlatform& platform);
+
+// Checks every service due now, in table order. A failed probe while the
+// link is down says nothing about the service: it is left due and the round
+// ends there. Tells the display as soon as a status changes (or a service
+// leaves "pending") rather than after the round, which may spend seconds in
+// timeouts. Returns the number of checks made.
+int runDueChecks(ServiceTable& table, CheckPlatform& platform, CheckCallback onCheck);
@@ -26,3 +26,14 @@ extern const char* SMTP_USERNAME;
 extern const char* SMTP_PASSWORD;
 extern const char* SMTP_FROM_ADDRESS;
 extern const char* SMTP_TO_ADDRESS;
+
+// Syslog (UDP) for the log; empty server disables it
+extern const char* SYSLOG_SERVER;
+extern const int SYSLOG_PORT;
+
+// SNTP server for the wall-clock time of the stored history
+extern const char* NTP_SERVER;
+
+// Earliest plausible SNTP time (unix seconds); before it the clock has not
+// been set
+const long CLOCK_VALID_AFTER = 1700000000L;
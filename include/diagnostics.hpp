@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Runtime diagnostics: heap pressure, task stacks and CPU share, and timing of
+// the loop() task. Recording is a few adds per loop iteration, so it stays on
+// in release builds. Histograms are written by loop() only and read without
+// locking, so a reader may see one sample half-applied.
+
+// Durations in fixed 1-2-5 buckets from 100 us to 10 s, plus an open one.
+struct TimingHistogram {
+  static const int BUCKETS = 17;
+  static const uint32_t BOUNDS[BUCKETS - 1];  // upper bounds in microseconds
+
+  uint32_t counts[BUCKETS];
+  uint32_t count;
+  uint32_t lastMicros;
+  uint32_t maxMicros;
+  uint64_t totalMicros;
+
+  void record(uint32_t micros);
+  uint32_t averageMicros() const { return count > 0 ? (uint32_t)(totalMicros / count) : 0; }
+
+  // Upper bound of the bucket holding the given percentile (0-100); the
+  // maximum for the open bucket. Only as precise as the buckets.
+  uint32_t percentileMicros(uint8_t percentile) const;
+};
+
+struct HeapStats {
+  uint32_t internalFree;
+  uint32_t internalLargest;  // largest block that can still be allocated
+  uint32_t internalMinFree;  // low-water mark since boot
+  uint32_t psramSize;        // 0 without PSRAM
+  uint32_t psramFree;
+  uint32_t psramLargest;
+  uint32_t psramMinFree;
+};
+
+struct TaskSample {
+  char name[16];
+  uint8_t priority;
+  int8_t core;          // -1 if not pinned
+  uint32_t stackFree;   // minimum free stack since the task started, in bytes
+  float cpuPercent;     // share of both cores since the previous sample, -1 if unknown
+};
+
+// Milestones of the boot sequence, in the order they usually happen
+enum BootStage {
+  BOOT_FIRST_FRAME,  // first frame on the panel
+  BOOT_WIFI,         // first WiFi association
+  BOOT_SERVER,       // web server listening
+  BOOT_CLOCK,        // SNTP set the clock
+  BOOT_FIRST_CHECK,  // first probe finished
+  BOOT_STAGE_COUNT
+};
+
+// Busy part of one loop() iteration, not counting the wait for the next check.
+void recordLoopIteration(uint32_t micros);
+
+// One checkServices() call, including every probe it ran.
+void recordCheckRound(uint32_t micros);
+
+// One probe, and how late it started after its service fell due.
+void recordProbe(uint32_t micros, uint32_t latenessMillis);
+
+// A service changed between UP and DOWN.
+void recordStateTransition();
+
+// Notes that `stage` was reached now. Only the first call per stage counts.
+// Safe from any task.
+void recordBootStage(BootStage stage);
+
+// Milliseconds from boot to `stage`, 0 if it was not reached yet.
+uint32_t bootStageMillis(BootStage stage);
+
+// "firstFrame", "wifi", ...
+const char* bootStageName(BootStage stage);
+
+const TimingHistogram& loopTiming();
+const TimingHistogram& checkRoundTiming();
+const TimingHistogram& probeTiming();
+const TimingHistogram& scheduleLateness();
+uint32_t stateTransitions();
+
+HeapStats heapStats();
+
+// 0 when the free memory is one block, approaching 100 as it splinters.
+uint8_t fragmentationPercent(uint32_t free, uint32_t largest);
+
+// Fills `samples` with up to `max` tasks and returns how many. CPU share is
+// measured over the time since the previous call, so call from one place
+// only (the web server). Returns -1 if the FreeRTOS build has no trace
+// facility.
+int sampleTasks(TaskSample* samples, int max);
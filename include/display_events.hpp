@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// Notifications from the loop() task to the render task. Events carry no
+// service data; the render task reads the published snapshot when it wakes.
+enum DisplayEventType : uint8_t {
+  DISPLAY_EVENT_SERVICES_CHANGED,  // a new snapshot was published
+  DISPLAY_EVENT_TOUCH              // a gesture is waiting in the touch queue
+};
+
+struct DisplayEvent {
+  DisplayEventType type;
+  uint32_t postedMicros;  // for event-to-frame latency
+};
+
+// Creates the event queue. Call once before the render task starts.
+bool initDisplayEventQueue();
+
+// Queues an event without blocking. Dropped if the queue is full, which is
+// harmless: the render task coalesces events into one frame anyway.
+void postDisplayEvent(DisplayEventType type);
+
+// Waits up to `timeout` for the next event.
+bool receiveDisplayEvent(DisplayEvent& event, TickType_t timeout);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Arduino.h>
+#ifndef LGFX_USE_V1
+#define LGFX_USE_V1
+#endif
+#include <LovyanGFX.hpp>
+
+// Counters for tuning the display pipeline. Written by the render loop and
+// read (without locking) by the web server, so values may be one frame stale.
+struct DisplayStats {
+  uint32_t frames;           // flushes that pushed at least one widget
+  uint32_t pushedPixels;     // pixels sent to the panel since boot
+  uint32_t lastFramePixels;
+  uint32_t lastFrameMicros;
+  uint32_t maxFrameMicros;
+  uint64_t totalFrameMicros;
+};
+
+// Whole frames as seen by the render task: all renderers plus the wait for
+// vertical blank. Latency runs from the event that asked for a frame to the
+// end of that frame; touch latency starts at the touch interrupt that decided
+// the gesture. Same locking caveat as DisplayStats.
+struct FrameStats {
+  uint32_t frames;
+  uint32_t lastFrameMicros;
+  uint32_t maxFrameMicros;
+  uint64_t totalFrameMicros;
+  uint32_t lastVsyncWaitMicros;
+  uint32_t vsyncTimeouts;
+  uint32_t lastLatencyMicros;
+  uint32_t maxLatencyMicros;
+  uint32_t lastTouchLatencyMicros;
+  uint32_t maxTouchLatencyMicros;
+};
+
+// Retained-mode screen made of fixed rectangular text widgets.
+//
+// Each widget owns an LGFX_Sprite in PSRAM that is recomposed only when its
+// text or colour changes; flush() then pushes just those rectangles. A screen
+// that only updates a counter therefore sends a few thousand pixels instead of
+// clearing and redrawing the whole 480x480 panel.
+class WidgetScreen {
+ public:
+  static const int MAX_WIDGETS = 12;
+
+  // Declares a widget and returns its id. `panelColor` draws a rounded panel
+  // behind non-empty text; `textX`/`textY` offset the text inside the widget.
+  // Call before begin().
+  int addWidget(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t textSize,
+                bool hasPanel = false, uint16_t panelColor = 0, int16_t textX = 0, int16_t textY = 0);
+
+  // Allocates the widget sprites and clears the panel.
+  void begin(lgfx::LGFX_Device* display, uint16_t background);
+
+  // Updates a widget. Marks it dirty only if something visible changed.
+  void setText(int id, const String& text, uint16_t color);
+
+  // Hidden widgets are skipped by flush(), leaving their area to other
+  // renderers. Showing a widget again marks it dirty.
+  void setVisible(int id, bool visible);
+
+  // Forces every widget to be repainted on the next flush().
+  void invalidate();
+
+  // Recomposes and pushes dirty widgets. Returns the number of pixels pushed.
+  uint32_t flush();
+
+  // Called once per flush() before the first widget is pushed.
+  void setBeforePush(void (*hook)()) { _beforePush = hook; }
+
+  // Adds work done by other renderers sharing the panel to the counters.
+  void recordFrame(uint32_t pixels, uint32_t micros);
+
+  const DisplayStats& stats() const { return _stats; }
+
+ private:
+  struct Widget {
+    int16_t x, y, w, h;
+    int16_t textX, textY;
+    uint8_t textSize;
+    bool hasPanel;
+    uint16_t panelColor;
+    LGFX_Sprite* sprite;  // nullptr if PSRAM allocation failed; drawn directly instead
+    String text;
+    uint16_t color;
+    bool dirty;
+    bool visible;
+  };
+
+  void draw(lgfx::LovyanGFX& target, const Widget& widget, int16_t originX, int16_t originY);
+
+  lgfx::LGFX_Device* _display = nullptr;
+  uint16_t _background = 0;
+  Widget _widgets[MAX_WIDGETS];
+  int _widgetCount = 0;
+  DisplayStats _stats = {};
+  void (*_beforePush)() = nullptr;
+};
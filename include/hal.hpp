@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <memory>
+
+struct ServiceTable;
+
+// Seams between the check pipeline and the platform. The firmware implements
+// them on the Arduino core (hal_esp32.hpp); the native build (env:native)
+// implements them on POSIX and with fakes (host/). Code that only reaches
+// the platform through these, plus Arduino's String and fs::FS, builds and
+// runs on a Linux machine.
+//
+// Storage needs no interface of its own: the stores use Arduino's fs::FS
+// through LittleFS, and host/FS.h provides one backed by a directory.
+
+// Time and waiting. millis() and micros() wrap like the Arduino ones.
+class Clock {
+ public:
+  virtual ~Clock() {}
+
+  virtual uint32_t millis() = 0;
+  virtual uint32_t micros() = 0;
+  virtual void sleep(uint32_t ms) = 0;
+
+  // Unix seconds, 0 while the wall clock is not set (see CLOCK_VALID_AFTER).
+  virtual uint32_t unixTime() = 0;
+};
+
+// One outgoing TCP connection. Reads never block.
+class Socket {
+ public:
+  virtual ~Socket() {}
+
+  // `address` is IPv4 in network byte order. Gives up after `timeoutMs`.
+  virtual bool connect(uint32_t address, uint16_t port, uint32_t timeoutMs) = 0;
+  virtual size_t write(const uint8_t* data, size_t length) = 0;
+
+  // Bytes that can be read now.
+  virtual int available() = 0;
+
+  // Reads up to `size` bytes that have arrived; -1 if there are none.
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+
+  // True while the peer has not closed, or unread data is left.
+  virtual bool connected() = 0;
+  virtual void stop() = 0;
+};
+
+class Network {
+ public:
+  virtual ~Network() {}
+
+  // True while the station is associated and has an address.
+  virtual bool linkUp() = 0;
+
+  // Looks up the IPv4 address (network byte order) of `host`, which may be a
+  // dotted quad. Gives up after `timeoutMs`, even if the name server has not
+  // answered yet.
+  virtual bool resolve(const char* host, uint32_t& address, uint32_t timeoutMs) = 0;
+
+  virtual std::unique_ptr<Socket> newSocket() = 0;
+};
+
+// ICMP echo, or whatever stands in for it.
+class Pinger {
+ public:
+  virtual ~Pinger() {}
+
+  // Sends `count` echo requests; true if any was answered.
+  virtual bool ping(uint32_t address, int count) = 0;
+};
+
+// What the check pipeline tells the screen.
+class StatusDisplay {
+ public:
+  virtual ~StatusDisplay() {}
+
+  // A check changed what the screen shows (a status, or leaving "pending").
+  // Called from the checking task between probes.
+  virtual void servicesChanged(const ServiceTable& table) = 0;
+};
+
+// The clock behind millis() and the stores' unix time: the Arduino one on
+// the device, settable on the host.
+Clock& systemClock();
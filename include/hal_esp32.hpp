@@ -0,0 +1,41 @@
+#pragma once
+
+#include <WiFi.h>
+
+#include "hal.hpp"
+
+// hal.hpp on the Arduino core: millis() and SNTP time, WiFiClient, lwIP's
+// resolver and ESP32Ping.
+
+class ArduinoClock : public Clock {
+ public:
+  uint32_t millis() override;
+  uint32_t micros() override;
+  void sleep(uint32_t ms) override;
+  uint32_t unixTime() override;
+};
+
+class WiFiSocket : public Socket {
+ public:
+  bool connect(uint32_t address, uint16_t port, uint32_t timeoutMs) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  int available() override;
+  int read(uint8_t* buffer, size_t size) override;
+  bool connected() override;
+  void stop() override;
+
+ private:
+  WiFiClient _client;
+};
+
+class WiFiNetwork : public Network {
+ public:
+  bool linkUp() override;
+  bool resolve(const char* host, uint32_t& address, uint32_t timeoutMs) override;
+  std::unique_ptr<Socket> newSocket() override;
+};
+
+class IcmpPinger : public Pinger {
+ public:
+  bool ping(uint32_t address, int count) override;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "display_ui.hpp"
+#include "service_history.hpp"
+
+// Scrolling bar chart of the latest check latencies of one service, one
+// COLUMN_WIDTH column per check, newest on the right. When only new samples
+// arrived since the last push, the sprite is scrolled left and just those
+// columns are drawn; another service or a change of scale redraws it all.
+class LatencySparkline {
+ public:
+  static const int16_t COLUMN_WIDTH = 2;
+
+  void begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t background);
+  void setBeforePush(void (*hook)()) { _beforePush = hook; }
+  void invalidate() { _valid = false; }
+
+  // Updates the chart for service `id` (history may be nullptr). Returns
+  // pixels pushed.
+  uint32_t render(const ServiceHistory* history, uint64_t id);
+
+  // Latency at the top of the chart, in ms.
+  uint32_t scaleMs() const { return _scale; }
+
+ private:
+  uint32_t scaleFor(const ServiceHistory& history, uint32_t total, int visible) const;
+  void drawColumn(int column, uint16_t sample);
+
+  LGFX_Sprite* _sprite = nullptr;
+  int16_t _x = 0, _y = 0, _w = 0, _h = 0;
+  uint16_t _background = 0;
+  void (*_beforePush)() = nullptr;
+
+  bool _valid = false;
+  uint64_t _shownId = 0;
+  uint32_t _shownSamples = 0;
+  uint32_t _scale = 0;
+};
+
+// 24 h up/down bar, one column per UptimeBucket, current bucket on the right.
+// Scrolls by a column when a new bucket starts and otherwise only redraws the
+// current one when its counts change.
+class UptimeBar {
+ public:
+  void begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t background);
+  void setBeforePush(void (*hook)()) { _beforePush = hook; }
+  void invalidate() { _valid = false; }
+
+  uint32_t render(const ServiceHistory* history, uint64_t id, uint32_t nowMillis);
+
+ private:
+  void drawColumn(int column, const ServiceHistory* history, uint32_t bucketIndex);
+
+  LGFX_Sprite* _sprite = nullptr;
+  int16_t _x = 0, _y = 0, _w = 0, _h = 0;
+  int16_t _columnWidth = 0;
+  uint16_t _background = 0;
+  void (*_beforePush)() = nullptr;
+
+  bool _valid = false;
+  uint64_t _shownId = 0;
+  uint32_t _shownBucket = 0;
+  uint16_t _shownUp = 0;
+  uint16_t _shownDown = 0;
+};
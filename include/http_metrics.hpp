@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include "diagnostics.hpp"
+
+// Per-route counters for the web server. Route callbacks are wrapped at
+// registration, so handlers stay unchanged:
+//
+//   server.on("/api/x", HTTP_GET, trackRoute("GET /api/x", [](...) { ... }));
+//
+// Handler latency is the time spent inside the route's callbacks (body chunks
+// plus the final request callback), not time spent waiting on the network.
+// Everything here runs on the AsyncTCP task, including the handler that
+// reports the counters, so nothing is locked.
+struct RouteStats {
+  const char* name;
+  uint32_t requests;
+  uint32_t status[5];  // 1xx .. 5xx
+  uint32_t noResponse;  // handler returned without sending a response
+  uint64_t bodyBytes;   // response bodies, 0 for chunked responses
+  TimingHistogram latency;
+};
+
+// Requests between their first callback and the end of the request callback.
+// AsyncTCP handles one event at a time, so this is only above one while
+// request bodies are still arriving.
+struct InFlightStats {
+  uint32_t current;
+  uint32_t peak;
+  uint32_t abandoned;  // body started but the request never completed
+};
+
+ArRequestHandlerFunction trackRoute(const char* name, ArRequestHandlerFunction handler);
+
+// Wraps the body callback of a route already wrapped with trackRoute().
+ArBodyHandlerFunction trackRouteBody(ArBodyHandlerFunction handler);
+
+int routeCount();
+const RouteStats& routeStats(int index);
+InFlightStats inFlightStats();
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "hal.hpp"
+
+// Bounded HTTP GET for the service checks.
+//
+// HTTPClient only times out between reads, so a server that trickles bytes,
+// never finishes a chunked body or sends a huge one can hold the loop() task
+// indefinitely or exhaust the heap. This probe speaks HTTP/1.0 over a plain
+// socket so responses are never chunked. It enforces one deadline for the
+// whole exchange and caps how much of the headers and body it reads,
+// scanning the body through a fixed window instead of buffering it.
+//
+// Name resolution gets the whole deadline, and a slow lookup leaves that
+// much less for the rest. A failed lookup is reported separately from
+// connect errors.
+#ifndef PROBE_CONNECT_TIMEOUT_MS
+#define PROBE_CONNECT_TIMEOUT_MS 3000
+#endif
+
+#ifndef PROBE_DEADLINE_MS
+#define PROBE_DEADLINE_MS 8000  // connect, request, headers and body together
+#endif
+
+#ifndef PROBE_MAX_HEADER_BYTES
+#define PROBE_MAX_HEADER_BYTES 4096
+#endif
+
+#ifndef PROBE_MAX_BODY_BYTES
+#define PROBE_MAX_BODY_BYTES 16384  // searched for the expected response
+#endif
+
+enum ProbeError : uint8_t {
+  PROBE_OK,
+  PROBE_DNS_FAILED,
+  PROBE_CONNECT_FAILED,     // refused, unreachable or no handshake in time
+  PROBE_TIMEOUT,            // the response (or a slow lookup) missed the deadline
+  PROBE_CONNECTION_CLOSED,  // closed or reset before the headers were complete
+  PROBE_BAD_RESPONSE,       // not HTTP, or headers over PROBE_MAX_HEADER_BYTES
+  PROBE_HTTP_STATUS,        // a status the caller does not accept
+  PROBE_MISMATCH            // expected text not in the first PROBE_MAX_BODY_BYTES
+};
+
+struct HttpProbeResult {
+  ProbeError error;
+  int status;          // HTTP status, 0 if none was received
+  uint32_t bodyBytes;  // body bytes read
+  uint32_t millis;     // time taken
+};
+
+class HttpClient {
+ public:
+  virtual ~HttpClient() {}
+
+  // Sends GET `path` and reads the status line and headers. With `expected`
+  // set (and not "*"), a 200 response's body is searched for it. Any status
+  // is returned with PROBE_OK; the caller decides which ones count as UP.
+  virtual HttpProbeResult get(const String& host, int port, const String& path, const String& expected) = 0;
+};
+
+// The bounded probe described above, over `network`'s sockets.
+class BoundedHttpClient : public HttpClient {
+ public:
+  BoundedHttpClient(Network& network, Clock& clock) : _network(network), _clock(clock) {}
+
+  HttpProbeResult get(const String& host, int port, const String& path, const String& expected) override;
+
+ private:
+  Network& _network;
+  Clock& _clock;
+};
+
+// Short description for Service::lastError.
+String describeProbeError(const HttpProbeResult& result);
+
+// Stable short name of a ProbeError for exports, e.g. "timeout".
+const char* probeErrorName(uint8_t error);
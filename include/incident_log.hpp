@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "service_table.hpp"
+
+// Outage history for reports: every DOWN→UP cycle becomes one incident
+// record, appended to /incidents.bin once the service is back UP. An
+// incident runs from the first failed probe of the run that left the
+// service DOWN to the probe that brought it back. A service failing from
+// boot counts as DOWN from its first probe. An outage open at a reboot is
+// saved with the runtime state and continues afterwards, so it keeps its
+// original start.
+//
+// Next to the records, /incidents.idx keeps a sparse index. It has one
+// entry per INCIDENT_INDEX_EVERY records, holding the earliest start and
+// latest end in that block. A time-range query reads the index and then
+// only the blocks that can overlap the range. When the file reaches
+// INCIDENT_FILE_RECORDS it becomes /incidents.old.bin, replacing the one
+// before, so at most two files' worth is kept.
+//
+// Times are unix seconds. An incident that ends before SNTP has set the
+// clock cannot be dated and is dropped.
+#ifndef INCIDENT_FILE_RECORDS
+#define INCIDENT_FILE_RECORDS 1024  // 24 bytes each
+#endif
+
+#ifndef INCIDENT_INDEX_EVERY
+#define INCIDENT_INDEX_EVERY 32
+#endif
+
+// File layout, little-endian
+struct __attribute__((packed)) IncidentRecord {
+  uint64_t id;
+  uint32_t start;         // first failed probe
+  uint32_t end;           // probe that brought it back UP; 0 while ongoing
+  uint32_t failedProbes;  // from the first failure until back UP
+  uint8_t firstError;     // ProbeError of the first failed probe
+  uint8_t reserved[3];
+};
+
+struct __attribute__((packed)) IncidentIndexEntry {
+  uint32_t minStart;
+  uint32_t maxEnd;
+};
+
+static_assert(sizeof(IncidentRecord) == 24, "incident record layout changed");
+
+// Streams the incidents of one service (or all with id 0) that overlap
+// [from, to], oldest file first, then those still ongoing. Records within a
+// file are in the order they ended. Safe from the web server; each call
+// holds the log's lock only while it reads one block.
+class IncidentCursor {
+ public:
+  IncidentCursor(uint32_t from, uint32_t to, uint64_t id);
+
+  // False after the last match.
+  bool next(IncidentRecord& record);
+
+ private:
+  bool loadBlock();
+  bool matches(const IncidentRecord& record) const;
+
+  uint32_t _from;
+  uint32_t _to;
+  uint64_t _id;
+  uint32_t _generation;  // file being read, see incident_log.cpp
+  uint32_t _block;       // next block of that file
+  IncidentRecord _records[INCIDENT_INDEX_EVERY];
+  int _count;
+  int _position;
+  int _openSlot;         // next slot to look at for ongoing incidents, -1 before
+};
+
+// Opens the log, repairing a record or index write cut short by a reset.
+// Call after LittleFS is mounted. Without it incidents are not recorded.
+bool initIncidentLog();
+
+// Failure run or outage still open for one service, as carried across a
+// reboot by the runtime state.
+struct OpenIncidentState {
+  uint32_t start;  // unix seconds of the first failure, 0 if not known
+  uint32_t failedProbes;
+  uint8_t firstError;
+  bool down;       // the run reached DOWN, so it is an incident
+};
+
+// Reads the open run of table slot `slot` if it belongs to `id`. False if
+// the service has none. Writer (loop()) only.
+bool openIncidentState(uint16_t slot, uint64_t id, OpenIncidentState& state);
+
+// Puts back a run read by openIncidentState() before the reboot. Call before
+// the first trackIncident() for the slot.
+void restoreOpenIncident(uint16_t slot, uint64_t id, const OpenIncidentState& state);
+
+// Follows one check of the service in table slot `slot`, after
+// applyCheckResult(). `unixTime` is 0 while the clock is unset. Appends the
+// incident when the service comes back UP. Writer (loop()) only.
+void trackIncident(uint16_t slot, const Service& service, bool passed, uint8_t error, uint32_t nowMillis,
+  uint32_t unixTime);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Non-blocking log. logPrintf() formats into a fixed-size record in a PSRAM
+// ring and returns; a low-priority task writes records to Serial (and to a
+// syslog server if one is configured), so a full USB CDC buffer stalls only
+// that task. When the writer falls behind, the oldest records are
+// overwritten and counted as dropped.
+//
+// Any task may log; ISRs may not. Before initLogger(), or if the ring could
+// not be allocated, logPrintf() writes to Serial directly.
+#ifndef LOG_CAPACITY
+#define LOG_CAPACITY 256  // records kept for /api/logs
+#endif
+
+enum LogLevel : uint8_t {
+  LOG_DEBUG,
+  LOG_INFO,
+  LOG_WARN,
+  LOG_ERROR
+};
+
+struct LogRecord {
+  uint32_t sequence;  // 1 for the first record since boot
+  uint32_t millis;
+  LogLevel level;
+  char text[119];     // truncated to fit
+};
+
+struct LoggerStats {
+  uint32_t written;
+  uint32_t dropped;        // overwritten before the writer task reached them
+  uint32_t syslogFailed;
+};
+
+// Allocates the ring and starts the writer task.
+bool initLogger();
+
+void logPrintf(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Sequence range currently held in the ring; oldest > newest when empty.
+uint32_t logOldestSequence();
+uint32_t logNewestSequence();
+
+// Copies record `sequence`. False if it was overwritten or not written yet.
+bool readLogRecord(uint32_t sequence, LogRecord& record);
+
+// "<millis> <LEVEL> <text>\n" into `out`; returns the length without the
+// terminator, truncating to fit.
+size_t formatLogRecord(const LogRecord& record, char* out, size_t size);
+
+LoggerStats loggerStats();
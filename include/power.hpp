@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Power policy. When the IDF is built with power management (CONFIG_PM_ENABLE)
+// the CPU scales between 80 and 240 MHz, and with tickless idle it drops into
+// automatic light sleep whenever every task is blocked; WiFi stays associated
+// through modem sleep and DTIM wake-ups. The RGB panel cannot be scanned out
+// during light sleep, so the display holds a lock that forbids it (and keeps
+// the APB clock stable) for as long as the backlight is on.
+//
+// There is no current sensor on the board, so draw is estimated from how the
+// time was spent, using the per-state figures below. Calibrate them with a
+// meter for a specific unit.
+#ifndef POWER_ACTIVE_MA
+#define POWER_ACTIVE_MA 110  // CPU busy, radio active
+#endif
+
+#ifndef POWER_IDLE_MA
+#define POWER_IDLE_MA 40  // blocked, modem sleep
+#endif
+
+#ifndef POWER_LIGHT_SLEEP_MA
+#define POWER_LIGHT_SLEEP_MA 8  // light sleep between DTIM beacons
+#endif
+
+#ifndef POWER_BACKLIGHT_MA
+#define POWER_BACKLIGHT_MA 90  // backlight at full brightness
+#endif
+
+struct PowerStats {
+  bool dynamicFrequency;      // CPU frequency scaling configured
+  bool lightSleep;            // automatic light sleep configured
+  uint64_t uptimeMillis;
+  uint64_t idleMillis;        // loop() blocked waiting for the next check
+  uint64_t sleepableMillis;   // ... of which with the display off
+  uint64_t backlightMillis;   // time with the backlight on
+  uint64_t brightnessMillis;  // brightness (0-255) integrated over time
+  uint32_t checks;
+  uint32_t lastCheckLateness;  // ms between a check falling due and starting
+  uint32_t maxCheckLateness;
+  uint64_t totalCheckLateness;
+};
+
+// Configures modem sleep, frequency scaling and light sleep. The display
+// counts as powered unless setDisplayPowered(false) was called before.
+void initPowerManagement();
+
+bool lightSleepEnabled();
+
+// Forbids light sleep and frequency changes while `on`.
+void setDisplayPowered(bool on);
+
+// Bookkeeping for the estimate.
+void recordBacklight(uint8_t brightness);
+void recordLoopIdle(uint32_t millis);
+void recordCheckLateness(uint32_t millis);
+
+PowerStats powerStats();
+
+// Average current since boot in mA, from the time split in `stats`.
+float estimatedCurrentMa(const PowerStats& stats);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "http_probe.hpp"
+#include "service_table.hpp"
+
+// Synthetic probes for load-testing the check pipeline on a device, without
+// a fleet of real endpoints. Build with -DSIMULATE_PROBES=1 and every check
+// calls simulatedProbe() instead of the network: it blocks like a real probe
+// for a latency drawn from the profile below and fails at the configured
+// rate. Draws are a hash of the service name and its check number, so the
+// same configuration replays the same sequence of results.
+//
+// Scheduling, thresholds, history, notifications and the display all run as
+// usual; /api/diag then reports probe time, schedule lateness percentiles,
+// checks per second, transitions and heap use for the run.
+#ifndef SIMULATE_PROBES
+#define SIMULATE_PROBES 0
+#endif
+
+#ifndef SIMULATED_LATENCY_MS
+#define SIMULATED_LATENCY_MS 20  // typical response time
+#endif
+
+#ifndef SIMULATED_SLOW_PERCENT
+#define SIMULATED_SLOW_PERCENT 5  // share of checks that take SIMULATED_SLOW_MS
+#endif
+
+#ifndef SIMULATED_SLOW_MS
+#define SIMULATED_SLOW_MS 2000
+#endif
+
+#ifndef SIMULATED_ERROR_PERCENT
+#define SIMULATED_ERROR_PERCENT 2
+#endif
+
+#ifndef SIMULATED_SERVICE_COUNT
+#define SIMULATED_SERVICE_COUNT MAX_SERVICES  // generated at boot into an empty table
+#endif
+
+#ifndef SIMULATED_CHECK_INTERVAL
+#define SIMULATED_CHECK_INTERVAL 10  // seconds
+#endif
+
+// Runs one synthetic check. Sets lastError like the real probes; slow
+// failures are reported as timeouts.
+ProbeError simulatedProbe(Service& service);
+
+// Fills an empty table with `count` simulated services. Returns how many
+// were added.
+int addSimulatedServices(ServiceTable& table, int count);
+
+// Checks simulated since boot, and how many of them were made to fail.
+uint32_t simulatedChecks();
+uint32_t simulatedFailures();
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "service_table.hpp"
+
+// Binary trace of every probe outcome, kept on LittleFS so production
+// incidents can be replayed exactly on a host (see tools/trace_replay).
+// Records are buffered in RAM and appended in batches to the newest of a
+// rotating set of segment files; nothing already written is rewritten.
+// Starting a segment deletes the oldest one. GET /api/trace downloads the
+// buffered and stored records oldest first.
+//
+// Besides probe results the trace holds a record at each boot, followed by
+// the runtime state restored for each service (see runtime_state.hpp). It
+// also holds the thresholds of every service, written at boot, after each
+// configuration change and again every half capacity so that the oldest
+// segments kept still carry them.
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 4096  // records kept at most, 16 bytes each
+#endif
+
+#ifndef TRACE_SEGMENT_RECORDS
+#define TRACE_SEGMENT_RECORDS 512  // records per segment file; divides TRACE_CAPACITY
+#endif
+
+#ifndef TRACE_FLUSH_RECORDS
+#define TRACE_FLUSH_RECORDS 32  // buffered before a write...
+#endif
+
+#ifndef TRACE_FLUSH_MS
+#define TRACE_FLUSH_MS 60000  // ...or after this long, whichever comes first
+#endif
+
+const uint32_t TRACE_MAGIC = 0x43525450;  // "PTRC"
+const uint16_t TRACE_VERSION = 1;
+
+enum TraceKind : uint8_t {
+  TRACE_PASS,
+  TRACE_FAIL,
+  TRACE_CONFIG,
+  TRACE_BOOT,
+  TRACE_RESTORE
+};
+
+// On-disk and download layout, little-endian. For TRACE_PASS/TRACE_FAIL
+// `value` is the latency in ms (capped at 65535) and `detail` the ProbeError;
+// for TRACE_CONFIG they are the pass and fail thresholds (capped); for
+// TRACE_RESTORE the consecutive passes or fails, and bit 0 set if UP, bit 1
+// if the count is of passes. A boot record has id 0.
+struct __attribute__((packed)) TraceRecord {
+  uint64_t id;
+  uint32_t millis;
+  uint16_t value;
+  TraceKind kind;
+  uint8_t detail;
+};
+
+// Precedes the records in a segment file and in a download. `sequence` is
+// the sequence number of the first record that follows.
+struct __attribute__((packed)) TraceHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t capacity;
+  uint32_t sequence;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "trace record layout changed");
+static_assert(sizeof(TraceHeader) == 16, "trace header layout changed");
+static_assert(TRACE_CAPACITY % TRACE_SEGMENT_RECORDS == 0 && TRACE_CAPACITY / TRACE_SEGMENT_RECORDS >= 2,
+  "TRACE_CAPACITY must hold two or more whole segments");
+
+// Finds the stored segments and records a boot. Call after LittleFS is
+// mounted. Without it the record functions do nothing.
+bool initProbeTrace();
+
+// Appends a probe result. Writer (loop()) only, like the functions below.
+void traceProbe(const Service& service, bool passed, uint8_t error, uint32_t latencyMs, uint32_t nowMillis);
+
+// Appends the thresholds of every service in `table`.
+void traceServiceConfigs(const ServiceTable& table, uint32_t nowMillis);
+
+// Appends the restored status and counter of every service in `table` that
+// has them. Call right after a boot.
+void traceRestoredState(const ServiceTable& table, uint32_t nowMillis);
+
+// True once half of TRACE_CAPACITY has been written since the last traceServiceConfigs().
+bool traceConfigDue();
+
+// Writes buffered records if the batch is full or TRACE_FLUSH_MS has passed.
+void flushProbeTrace(uint32_t nowMillis);
+
+// Sequence range readable with readTrace(), oldest > newest when empty.
+uint32_t traceOldestSequence();
+uint32_t traceNewestSequence();
+
+// Copies up to `max` records starting at `sequence` (from the RAM buffer or
+// a segment file). Returns how many were copied; 0 if `sequence` was deleted.
+// Safe to call from the web server.
+int readTrace(uint32_t sequence, TraceRecord* records, int max);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "service_table.hpp"
+
+// Warm restart. Each service's status, consecutive counters, last latency
+// and open incident are saved to NVS. At boot they are put back, so a reboot
+// does not show everything DOWN, re-notify, wait out the pass threshold again
+// or cut an outage in two.
+//
+// Saves happen every RUNTIME_STATE_SAVE_MS while checks run. A status
+// change is saved sooner, but no more often than RUNTIME_STATE_MIN_GAP_MS
+// so a flapping service cannot wear the flash. A snapshot can therefore be
+// a few minutes stale; the next probe corrects it.
+#ifndef RUNTIME_STATE_SAVE_MS
+#define RUNTIME_STATE_SAVE_MS (5UL * 60 * 1000)
+#endif
+
+#ifndef RUNTIME_STATE_MIN_GAP_MS
+#define RUNTIME_STATE_MIN_GAP_MS 30000
+#endif
+
+// Restores the saved state of the services in `table`, matched by id, and
+// returns how many were restored. Call after loading the services.
+int restoreRuntimeState(ServiceTable& table);
+
+// Notes that check results were applied; `statusChanged` if a service went
+// UP or DOWN. Writer (loop()) only, like saveRuntimeStateIfDue().
+void markRuntimeStateDirty(bool statusChanged);
+
+// Writes the snapshot if it is due.
+void saveRuntimeStateIfDue(const ServiceTable& table, uint32_t nowMillis);
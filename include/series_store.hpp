@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "service_table.hpp"
+
+// Long-term check history on LittleFS under /series, in fixed-size blocks.
+// Full blocks are appended to the newest of a rotating set of segment files
+// per service, /series/<id>.<n>; starting a segment deletes the oldest one,
+// and nothing already written is rewritten. Samples are packed
+// Gorilla-style into a bit stream:
+//
+//   time     delta-of-delta of the unix second: '0' for a steady interval,
+//            then '10' + 7 bits, '110' + 12 bits, '1110' + 20 bits or
+//            '1111' + 32 bits, signed
+//   status   '0' if up/down and the ProbeError are unchanged, else '1' + 4 bits
+//   latency  a log-scale code (exact below 32 ms, then 16 steps per
+//            doubling, within 3%): '0' unchanged, '10' + 3-bit signed
+//            change, '11' + 8-bit code
+//
+// A check at a steady interval with no change in status costs 3 bits plus
+// the latency change, typically under a byte.
+//
+// The block being filled (the hot block) stays in PSRAM. It is appended
+// when full, and copied to /series/<id>.hot every SERIES_FLUSH_MS, so a
+// power loss costs at most that much history. Samples need wall-clock
+// time, so they are skipped until SNTP has set the clock.
+#ifndef SERIES_BLOCK_SIZE
+#define SERIES_BLOCK_SIZE 512
+#endif
+
+#ifndef SERIES_BUDGET_BYTES
+#define SERIES_BUDGET_BYTES (640 * 1024)  // shared by all services
+#endif
+
+#ifndef SERIES_FLUSH_MS
+#define SERIES_FLUSH_MS (30UL * 60 * 1000)
+#endif
+
+#ifndef SERIES_SEGMENT_BLOCKS
+#define SERIES_SEGMENT_BLOCKS 8  // blocks per segment file; 4 KB, one LittleFS block
+#endif
+
+const int SERIES_SEGMENTS_PER_SERVICE =
+  SERIES_BUDGET_BYTES / SERIES_BLOCK_SIZE / SERIES_SEGMENT_BLOCKS / MAX_SERVICES > 2
+    ? SERIES_BUDGET_BYTES / SERIES_BLOCK_SIZE / SERIES_SEGMENT_BLOCKS / MAX_SERVICES : 2;
+
+// Blocks kept per service at most, the hot block included
+const int SERIES_BLOCKS_PER_SERVICE = SERIES_SEGMENTS_PER_SERVICE * SERIES_SEGMENT_BLOCKS;
+
+struct SeriesBlockHeader {
+  uint32_t sequence;   // 1 for a service's first block; 0 marks an unused block
+  uint32_t startTime;  // unix seconds the time deltas start from
+  uint16_t count;      // samples in the block
+  uint16_t bits;       // bits of `data` in use
+  uint32_t reserved;
+};
+
+struct SeriesBlock {
+  SeriesBlockHeader header;
+  uint8_t data[SERIES_BLOCK_SIZE - sizeof(SeriesBlockHeader)];
+};
+
+static_assert(sizeof(SeriesBlock) == SERIES_BLOCK_SIZE, "series block must fill SERIES_BLOCK_SIZE");
+
+struct SeriesSample {
+  uint32_t time;       // unix seconds
+  bool up;
+  uint8_t error;       // ProbeError
+  uint32_t latencyMs;  // as decoded from the latency code
+};
+
+// Walks the samples of one block.
+class SeriesDecoder {
+ public:
+  explicit SeriesDecoder(const SeriesBlock& block);
+
+  // False after the last sample.
+  bool next(SeriesSample& sample);
+
+ private:
+  uint32_t readBits(int count);
+  int32_t readSigned(int count);
+
+  const SeriesBlock& _block;
+  uint32_t _bit;
+  uint16_t _index;
+  uint32_t _time;
+  int32_t _delta;
+  uint8_t _status;
+  uint8_t _code;
+};
+
+struct SeriesStats {
+  uint32_t samples;         // recorded since boot
+  uint32_t skippedNoClock;  // checks before the clock was set
+  uint32_t blocksWritten;
+  uint32_t writeErrors;
+};
+
+// Allocates the hot blocks in PSRAM. Returns false if that fails; recording
+// then does nothing.
+bool initSeriesStore();
+
+// Appends one check result of the service `id` in table slot `slot`.
+// Writer (loop()) only.
+void recordSeriesSample(uint16_t slot, uint64_t id, bool up, uint8_t error, uint32_t latencyMs);
+
+// Writes hot blocks that have waited SERIES_FLUSH_MS. Writer only.
+void flushSeriesStore(uint32_t nowMillis);
+
+// Deletes the files of services no longer in `table`. Writer only.
+void pruneSeriesStore(const ServiceTable& table);
+
+// Block sequence range of the service `id`; oldest > newest without history.
+void seriesBlockRange(uint64_t id, uint32_t& oldest, uint32_t& newest);
+
+// First block in [oldest, newest] of the service `id` that can hold samples
+// at or after unix time `from`, found from the block headers alone. Safe
+// from the web server.
+uint32_t seriesBlockFrom(uint64_t id, uint32_t oldest, uint32_t newest, uint32_t from);
+
+// Copies block `sequence` of the service `id`, the hot block included.
+// False if it is missing or was deleted. Safe from the web server.
+bool readSeriesBlock(uint64_t id, uint32_t sequence, SeriesBlock& block);
+
+SeriesStats seriesStats();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Service types
+// Right now the behavior for each is rudimentary
+// However, you can use this to expand and add services with more complex checks
+enum ServiceType {
+  TYPE_HOME_ASSISTANT,
+  TYPE_JELLYFIN,
+  TYPE_HTTP_GET,
+  TYPE_PING
+};
+
+// Service structure
+struct Service {
+  uint64_t id;            // Stable 64-bit id, exposed as lowercase hex (see formatServiceId)
+  String name;
+  ServiceType type;
+  String host;
+  int port;
+  String path;
+  String expectedResponse;
+  int checkInterval;
+  int passThreshold;      // Number of consecutive passes required to mark as UP
+  int failThreshold;      // Number of consecutive fails required to mark as DOWN
+  int consecutivePasses;  // Current count of consecutive passes
+  int consecutiveFails;   // Current count of consecutive fails
+  bool isUp;
+  unsigned long lastCheck;
+  unsigned long lastUptime;
+  String lastError;
+  int secondsSinceLastCheck;
+  uint32_t lastLatency;   // ms taken by the last check, pass or fail
+};
+
+// Store up to 20 services by default. Override with -DMAX_SERVICES_VALUE=<n>.
+#ifndef MAX_SERVICES_VALUE
+#define MAX_SERVICES_VALUE 20
+#endif
+
+const int MAX_SERVICES = MAX_SERVICES_VALUE;
+
+String getServiceTypeString(ServiceType type);
+
+// Parses the API name of a service type. Returns false for unknown names.
+bool parseServiceType(const String& text, ServiceType& type);
+
+// Clears counters, status and timing so the service is treated as never checked.
+void resetServiceRuntime(Service& service);
+
+// True until a check result has been applied (or restored after a reboot).
+// lastCheck cannot tell: it also anchors the first check's schedule.
+bool neverChecked(const Service& service);
+
+// Copies the user-configurable fields (everything except id and runtime state).
+void copyServiceConfig(Service& target, const Service& source);
+
+// True if switching from `before` to `after` changes what is probed, which
+// makes the existing runtime state meaningless.
+bool probeConfigChanged(const Service& before, const Service& after);
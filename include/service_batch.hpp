@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <vector>
+
+#include "service_table.hpp"
+
+// Transactional config changes for POST /api/batch.
+//
+// A batch is parsed and validated as a whole against the published snapshot,
+// then handed to the writer, which validates it once more against the live
+// table and applies every operation or none. Updates keep the runtime state
+// (counters, status, last check) unless they change what is being probed.
+enum ServiceOperationType {
+  OP_ADD,
+  OP_UPDATE,
+  OP_DELETE
+};
+
+struct ServiceOperation {
+  ServiceOperationType type;
+  uint64_t id;     // new id for adds, target for updates and deletes
+  Service config;  // complete configuration for adds and updates
+};
+
+// Upper bound on operations in one batch; keeps validation and the queued
+// command small.
+const int MAX_BATCH_OPERATIONS = 2 * MAX_SERVICES;
+
+// Parses the "operations" array of a batch body. Adds get freshly generated
+// ids; updates are merged onto the current config from `table`. On failure
+// `error` names the first offending operation and `operations` is unspecified.
+bool parseServiceBatch(JsonArrayConst array, const ServiceTable& table,
+                       std::vector<ServiceOperation>& operations, String& error);
+
+// Checks that every target id exists and is updated or deleted at most once
+// in the batch, and that the result fits in the table.
+bool validateServiceBatch(const ServiceTable& table, const std::vector<ServiceOperation>& operations,
+                          String& error);
+
+// Validates and then applies all operations to `table`, or none of them.
+bool applyServiceBatch(ServiceTable& table, const std::vector<ServiceOperation>& operations,
+                       String& error);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <FS.h>
+
+#include "service_table.hpp"
+
+// Binary on-flash format for the service table.
+//
+// Layout (all integers little-endian):
+//   header:  "UMSV" | u8 version | u8 reserved | u16 count
+//   record:  u64 id | u8 type | u16 port | u32 checkInterval |
+//            u16 passThreshold | u16 failThreshold | str name | str host |
+//            str path | str expectedResponse
+//   str:     u16 length | length bytes (no terminator)
+//   trailer: u32 CRC-32 of every byte after the header
+//
+// Records are decoded straight into Service entries, so loading does not
+// build an intermediate JSON document. JSON remains the import/export format.
+
+const uint8_t SERVICE_CODEC_VERSION = 2;
+
+// Writes the table's services in configuration order. Returns false on a short write.
+bool writeServicesBinary(fs::File& file, const ServiceTable& table);
+
+// Reads services from `file` into consecutive entries of `services` (at most
+// `maxCount`), resetting runtime state. Returns the number of services read,
+// or -1 if the file is not a valid service table of a supported version.
+int readServicesBinary(fs::File& file, Service* services, int maxCount);
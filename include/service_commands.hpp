@@ -0,0 +1,63 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <vector>
+
+#include "service_batch.hpp"
+
+// Config mutations requested by the web server. Handlers validate against the
+// published snapshot and enqueue a command; loop() is the single writer that
+// applies commands to the service table and persists the result. Commands are
+// counted as they are accepted and as they are applied, and the snapshot
+// carries the applied count, so a handler can tell whether its snapshot still
+// shows every change ahead of its command. Table slots are reserved when a
+// command that adds services is accepted, so the writer always has room.
+enum ServiceCommandType {
+  CMD_ADD_SERVICES,    // append `services` (one add or a whole import)
+  CMD_DELETE_SERVICE,  // remove the service with `serviceId`
+  CMD_APPLY_BATCH      // apply `operations` atomically
+};
+
+struct ServiceCommand {
+  ServiceCommandType type;
+  std::vector<Service> services;
+  uint64_t serviceId;
+  std::vector<ServiceOperation> operations;
+  bool requireVersion = false;  // accept only on top of `configVersion`
+  uint32_t configVersion = 0;   // ServiceSnapshot::configVersion validated against
+  int reservedSlots = 0;        // set when accepted: adds, less a batch's deletes
+};
+
+enum EnqueueResult {
+  ENQUEUE_OK,
+  ENQUEUE_BUSY,      // the queue is full
+  ENQUEUE_CONFLICT,  // other commands were accepted since `configVersion`
+  ENQUEUE_NO_ROOM    // the services added would not fit in the table
+};
+
+// Creates the command queue for a table that holds `services`. Call once
+// before the web server starts.
+bool initServiceCommandQueue(int services);
+
+// Hands `command` to the writer, which frees it after applying. On any other
+// result the caller keeps it. Web server task only.
+EnqueueResult enqueueServiceCommand(ServiceCommand* command);
+
+// Returns the next pending command, or nullptr. Caller takes ownership.
+ServiceCommand* dequeueServiceCommand();
+
+// Commands dequeued so far, for ServiceSnapshot::configVersion. Writer only.
+uint32_t appliedServiceCommands();
+
+// Table slots neither used nor reserved by an accepted command. Web server
+// task only; it can only grow until that task enqueues again.
+int freeServiceSlots();
+
+// Gives back `count` slots: a service removed, or reserved by a command the
+// writer could not apply (a negative count for one that freed slots).
+// Writer only.
+void releaseServiceSlots(int count);
+
+// Blocks until a command is queued or `timeout` passes, leaving the command
+// in the queue. Lets loop() sleep between checks without missing changes.
+bool waitForServiceCommand(TickType_t timeout);
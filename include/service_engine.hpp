@@ -0,0 +1,57 @@
+#pragma once
+
+#include "service_table.hpp"
+
+// Check scheduling and the UP/DOWN threshold state machine. No I/O happens
+// here: the caller supplies the time and the probe result and acts on the
+// returned transitions (notifications, history, display). Nothing in this
+// module calls the Arduino core, so it builds on a host compiler given a
+// String implementation.
+
+// Adaptive intervals. While a status change is unconfirmed (an UP service
+// has failed, or a DOWN service has passed, fewer times than its threshold)
+// it is re-checked at CHECK_RECHECK_PERCENT of its interval, but not sooner
+// than CHECK_RECHECK_MIN_MS. 100 turns this off.
+#ifndef CHECK_RECHECK_PERCENT
+#define CHECK_RECHECK_PERCENT 25
+#endif
+
+#ifndef CHECK_RECHECK_MIN_MS
+#define CHECK_RECHECK_MIN_MS 2000
+#endif
+
+// A service UP for CHECK_RELAX_AFTER_PASSES checks in a row has its interval
+// doubled, and doubled again after as many more, up to
+// CHECK_RELAX_MAX_INTERVAL_S. A failed check goes back to the configured
+// interval. 0 (the default) turns this off.
+#ifndef CHECK_RELAX_MAX_INTERVAL_S
+#define CHECK_RELAX_MAX_INTERVAL_S 0
+#endif
+
+#ifndef CHECK_RELAX_AFTER_PASSES
+#define CHECK_RELAX_AFTER_PASSES 10
+#endif
+
+// The interval `service` is checked at in its current state: checkInterval,
+// shortened or relaxed as above.
+unsigned long checkIntervalMs(const Service& service);
+
+// Milliseconds until `service` is due for a check, 0 if it is due now.
+unsigned long msUntilCheckDue(const Service& service, unsigned long now);
+
+// Smallest msUntilCheckDue() over the table, capped at `maxWait`.
+unsigned long msUntilNextCheck(const ServiceTable& table, unsigned long now, unsigned long maxWait);
+
+// Staggers the first checks after boot: service k of n in `table` falls due
+// k/n of its checkIntervalMs() after `now`. With equal intervals the table is probed
+// evenly over one interval instead of in a single round.
+void spreadFirstChecks(ServiceTable& table, unsigned long now);
+
+// The same for the services already due at `now` only, e.g. the backlog
+// after checks were paused. The others keep their schedule.
+void spreadDueChecks(ServiceTable& table, unsigned long now);
+
+// Applies one probe result taken at `now` to the consecutive counters, then
+// moves the service UP or DOWN once the pass or fail threshold is reached.
+// Returns true if isUp changed.
+bool applyCheckResult(Service& service, bool passed, unsigned long now);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "service.hpp"
+
+// Per-service check history for the on-device charts, kept in PSRAM and
+// indexed by table slot. Only loop() writes it; the render task reads it
+// without locking. Latency samples are appended at `samples` and readers stay
+// at least HISTORY_READ_MARGIN entries behind the write position, so a sample
+// is never overwritten while it is being read.
+const int LATENCY_HISTORY = 256;  // one sample per check
+const int HISTORY_READ_MARGIN = 16;
+const uint16_t LATENCY_FAILED = 0xFFFF;
+
+const int UPTIME_BUCKETS = 96;                         // 24 h ...
+const uint32_t UPTIME_BUCKET_MS = 15UL * 60 * 1000;    // ... in 15 min buckets
+
+struct UptimeBucket {
+  uint32_t index;  // millis() / UPTIME_BUCKET_MS of the interval it counts
+  uint16_t up;
+  uint16_t down;
+};
+
+struct ServiceHistory {
+  std::atomic<uint64_t> id;         // service the entry belongs to, 0 if unused
+  std::atomic<uint32_t> samples;    // latency samples written since reset
+  uint16_t latency[LATENCY_HISTORY];  // ms, LATENCY_FAILED for failed checks
+  UptimeBucket buckets[UPTIME_BUCKETS];
+};
+
+// Allocates one entry per table slot. Returns false if PSRAM is unavailable;
+// recording and reading then do nothing.
+bool initServiceHistory();
+
+// Appends one check result. A slot that now holds a different service starts
+// over. Writer (loop()) only.
+void recordServiceCheck(uint16_t slot, uint64_t id, bool up, uint32_t latencyMs, uint32_t nowMillis);
+
+// History of the service `id` in `slot`, or nullptr if there is none.
+const ServiceHistory* serviceHistory(uint16_t slot, uint64_t id);
+
+// Latency sample `n` (0 = first since reset). `n` must be within the readable
+// window of `samples`.
+inline uint16_t latencySample(const ServiceHistory& history, uint32_t n) {
+  return history.latency[n % LATENCY_HISTORY];
+}
+
+// Share of passing checks over the last 24 h, or -1 without data.
+float uptimePercent24h(const ServiceHistory& history, uint32_t nowMillis);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <vector>
+
+#include "service.hpp"
+
+// Incremental parser for /api/import bodies.
+//
+// The body arrives in TCP-sized chunks, so rather than buffering the whole
+// backup it scans the stream for the top-level "services" array and copies one
+// array element at a time into a small fixed buffer. Each complete object is
+// deserialized and validated on its own, which bounds memory to a single
+// service regardless of how large the backup is.
+class ServiceImportParser {
+ public:
+  // Largest single service object accepted; bigger objects are skipped.
+  static const size_t MAX_OBJECT_SIZE = 2048;
+
+  // `availableSlots` caps how many services are accepted; the rest are skipped.
+  explicit ServiceImportParser(int availableSlots);
+
+  // Feeds the next chunk of the body. Safe to call after a failure (no-op).
+  void feed(const uint8_t* data, size_t len);
+
+  // Call after the last chunk. Returns false if the body was not a complete
+  // JSON document with a "services" array; error() then describes why.
+  bool finish();
+
+  bool failed() const { return _error != nullptr; }
+  const char* error() const { return _error; }
+
+  // Accepted services with fresh ids and reset runtime state.
+  std::vector<Service>& services() { return _services; }
+  int importedCount() const { return (int)_services.size(); }
+  int skippedCount() const { return _skipped; }
+
+ private:
+  void handleObject();
+
+  int _availableSlots;
+  std::vector<Service> _services;
+  int _skipped = 0;
+  const char* _error = nullptr;
+
+  int _depth = 0;
+  bool _inString = false;
+  bool _escape = false;
+  bool _expectingKey = false;
+
+  // Most recent key at the root level, to spot the "services" array
+  char _key[16];
+  size_t _keyLen = 0;
+  bool _readingKey = false;
+
+  int _itemDepth = -1;  // depth of services array elements while inside it
+  bool _sawServices = false;
+
+  char _object[MAX_OBJECT_SIZE];
+  size_t _objectLen = 0;
+  bool _capturing = false;
+  bool _objectTooLarge = false;
+};
+
+// Builds a service from an exported JSON object, applying the same defaults and
+// limits as the web form. Returns false if a required field is missing or invalid.
+bool serviceFromImportJson(JsonObjectConst obj, Service& service);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "service.hpp"
+
+// Availability and latency over fixed windows, kept per table slot in PSRAM
+// like the chart history. Checks are counted into minute, hour and day
+// buckets. Each window also keeps running totals: a check adds to them, and
+// a bucket that falls out of the window is subtracted as the clock moves
+// past it. Recording and summarizing therefore cost the same however many
+// checks a window holds.
+//
+// Only loop() writes. The render task and the web server read without
+// locking and may see a total that is one check behind. Totals are brought
+// forward when a check is recorded, so they are as of the service's last
+// check.
+const int ROLLUP_MINUTES = 60;     // 1 h
+const int ROLLUP_HOURS = 7 * 24;   // 7 d
+const int ROLLUP_DAYS = 30;        // 30 d
+
+// Passing-check latency bins, upper bounds in ms; the last bin is open
+const int ROLLUP_LATENCY_BINS = 16;
+extern const uint16_t ROLLUP_LATENCY_BOUNDS[ROLLUP_LATENCY_BINS - 1];
+
+enum RollupWindow : uint8_t {
+  WINDOW_1H,    // minute buckets
+  WINDOW_24H,   // the latest 24 hour buckets
+  WINDOW_7D,    // all hour buckets
+  WINDOW_30D,   // day buckets
+  WINDOW_COUNT
+};
+
+struct RollupCounts {
+  uint32_t up;
+  uint32_t down;
+  uint64_t latencySum;  // passing checks only
+  uint32_t latency[ROLLUP_LATENCY_BINS];
+};
+
+struct RollupBucket {
+  uint32_t index;  // unix time / bucket length of the interval it counts
+  RollupCounts counts;
+};
+
+struct ServiceRollup {
+  std::atomic<uint64_t> id;  // service the entry belongs to, 0 if unused
+  RollupBucket minutes[ROLLUP_MINUTES];
+  RollupBucket hours[ROLLUP_HOURS];
+  RollupBucket days[ROLLUP_DAYS];
+  uint32_t currentMinute;
+  uint32_t currentHour;
+  uint32_t currentDay;
+  RollupCounts windows[WINDOW_COUNT];
+};
+
+struct RollupSummary {
+  uint32_t checks;
+  float availability;  // percent, -1 without checks
+  uint32_t meanMs;     // of passing checks, 0 without any
+  uint32_t p50Ms;
+  uint32_t p95Ms;
+  uint32_t p99Ms;
+};
+
+// Allocates one entry per table slot. Returns false if PSRAM is unavailable;
+// recording then does nothing and summaries are empty.
+bool initServiceRollups();
+
+// Counts one check at `unixTime`. A slot that now holds a different service
+// starts over. Writer (loop()) only.
+void recordRollup(uint16_t slot, uint64_t id, bool up, uint32_t latencyMs, uint32_t unixTime);
+
+// Rollup of the service `id` in `slot`, or nullptr if there is none.
+const ServiceRollup* serviceRollup(uint16_t slot, uint64_t id);
+
+// Availability and latency percentiles over `window`. Percentiles are
+// interpolated within a bin.
+RollupSummary summarizeRollup(const ServiceRollup& rollup, RollupWindow window);
+
+// "1h", "24h", "7d" or "30d".
+const char* rollupWindowName(RollupWindow window);
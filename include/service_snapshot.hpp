@@ -0,0 +1,40 @@
+#pragma once
+
+#include "service_table.hpp"
+
+// Immutable copy of the service table for readers outside loop().
+//
+// The web server callbacks run on the AsyncTCP task, so they must never touch
+// `services[]` directly. Instead loop() (the only writer) publishes a copy into
+// one of two buffers and flips the active index; readers pin whichever buffer
+// is active with a reference count. Neither side takes a lock: the writer simply
+// skips a publish while the back buffer is still pinned and retries next loop.
+struct ServiceSnapshot {
+  ServiceTable table;
+  uint32_t version;        // incremented on every publish
+  uint32_t configVersion;  // service commands applied to `table`
+};
+
+// Copies the service table into the back buffer and makes it current.
+// Returns false if a reader still holds the back buffer; call again later.
+// Must only be called from the writer task.
+bool publishServiceSnapshot(const ServiceTable& table, uint32_t configVersion);
+
+// Pins the current snapshot. Every acquire must be paired with a release.
+const ServiceSnapshot* acquireServiceSnapshot();
+void releaseServiceSnapshot(const ServiceSnapshot* snapshot);
+
+// Scoped acquire/release for handler bodies.
+class ServiceSnapshotGuard {
+ public:
+  ServiceSnapshotGuard() : _snapshot(acquireServiceSnapshot()) {}
+  ~ServiceSnapshotGuard() { releaseServiceSnapshot(_snapshot); }
+  ServiceSnapshotGuard(const ServiceSnapshotGuard&) = delete;
+  ServiceSnapshotGuard& operator=(const ServiceSnapshotGuard&) = delete;
+
+  const ServiceSnapshot* operator->() const { return _snapshot; }
+  const ServiceSnapshot& operator*() const { return *_snapshot; }
+
+ private:
+  const ServiceSnapshot* _snapshot;
+};
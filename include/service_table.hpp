@@ -0,0 +1,77 @@
+#pragma once
+
+#include "service.hpp"
+
+// Smallest power of two that keeps the id index at most half full.
+constexpr int serviceIndexCapacity(int n, int capacity = 1) {
+  return capacity >= 2 * n ? capacity : serviceIndexCapacity(n, capacity * 2);
+}
+
+// Open-addressing (linear probing) map from service id to table slot.
+// Id 0 marks an empty bucket. Removal shifts later entries of the probe run
+// back instead of leaving tombstones, so lookups never degrade over time.
+class ServiceIndex {
+ public:
+  static const int CAPACITY = serviceIndexCapacity(MAX_SERVICES);
+
+  void clear();
+  bool insert(uint64_t id, uint16_t slot);
+  int find(uint64_t id) const;  // slot, or -1
+  bool remove(uint64_t id);
+
+ private:
+  static uint32_t bucketFor(uint64_t id);
+
+  uint64_t _ids[CAPACITY];
+  uint16_t _slots[CAPACITY];
+};
+
+// Service storage with stable slots. A service keeps its slot for its whole
+// lifetime, so deleting one never moves the others; `order` lists the used
+// slots in configuration order for iteration and display.
+struct ServiceTable {
+  Service slots[MAX_SERVICES];
+  bool slotUsed[MAX_SERVICES];
+  uint16_t order[MAX_SERVICES];
+  int count;
+  ServiceIndex index;
+
+  ServiceTable() { clear(); }
+
+  void clear();
+
+  // Service at `position` in configuration order (0 <= position < count).
+  Service& at(int position) { return slots[order[position]]; }
+  const Service& at(int position) const { return slots[order[position]]; }
+
+  Service* find(uint64_t id);
+  const Service* find(uint64_t id) const;
+
+  // Copies `service` into a free slot. Returns nullptr if the table is full
+  // or the id is already present.
+  Service* add(const Service& service);
+  bool remove(uint64_t id);
+
+  // Marks slots 0..n-1 as used after they were filled in place (e.g. by the
+  // binary loader) and rebuilds the index. Missing or duplicate ids are
+  // replaced; returns how many were.
+  int adoptLoadedSlots(int n);
+
+  // Copies used slots, order and index from `other` (snapshot publishing).
+  void copyFrom(const ServiceTable& other);
+};
+
+// Renders an id as lowercase hex without leading zeros.
+String formatServiceId(uint64_t id);
+
+// Parses a hex id. Ids from older firmware were decimal digit strings, which
+// are valid hex and therefore round-trip unchanged. Returns false on 0,
+// overflow or non-hex input.
+bool parseServiceId(const String& text, uint64_t& id);
+
+// Seeds the id generator above every id in `table`. Call once after loading.
+void seedServiceIds(const ServiceTable& table);
+
+// Returns a new id, strictly greater than any id seen by seedServiceIds().
+// Safe to call from any task.
+uint64_t generateServiceId();
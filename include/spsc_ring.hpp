@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Fixed-size single-producer single-consumer ring. push() and pop() may run
+// on different tasks, or in an ISR and a task, without locks: each index is
+// written by one side only. One slot is kept empty to tell full from empty,
+// so the ring holds N - 1 items.
+template <typename T, size_t N>
+class SpscRing {
+ public:
+  // Producer side. Returns false (dropping `item`) when full.
+  bool push(const T& item) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % N;
+    if (next == _tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    _items[head] = item;
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when empty.
+  bool pop(T& item) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = _items[tail];
+    _tail.store((tail + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  T _items[N];
+  std::atomic<size_t> _head{0};
+  std::atomic<size_t> _tail{0};
+};
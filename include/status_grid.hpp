@@ -0,0 +1,97 @@
+#pragma once
+
+#include "display_ui.hpp"
+#include "service_table.hpp"
+
+// Status wall: every service as a colour-coded tile, DOWN services first.
+//
+// Tiles are composed in one PSRAM scratch sprite and pushed only when what a
+// tile shows (service, status, name) changed, so a round of checks that flips
+// nothing pushes nothing. Names are rasterised once into 1-bit label sprites,
+// cached per table slot, and stamped onto tiles instead of running the font
+// renderer on every repaint.
+//
+// The DOWN-first order is kept incrementally: a status change moves one entry
+// instead of re-sorting, and only config changes rebuild it. The grid works on
+// published snapshots and is only used from the render task.
+class StatusGrid {
+ public:
+  static const int COLUMNS = 3;
+  static const int ROWS = 5;
+  static const int TILES_PER_PAGE = COLUMNS * ROWS;
+
+  // Claims the rectangle x,y,w,h of the panel for tiles.
+  void begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t background);
+
+  // Brings the order up to date with `table`: rebuilt if services were added,
+  // removed or reordered, otherwise only services whose status changed move.
+  void sync(const ServiceTable& table);
+
+  // Called once per render() before the first tile is pushed.
+  void setBeforePush(void (*hook)()) { _beforePush = hook; }
+
+  int pageCount() const;
+  int downCount() const { return _downCount; }
+
+  // Configuration position of the service whose tile covers (x, y) on `page`,
+  // or -1 if there is none.
+  int positionAt(int page, int16_t x, int16_t y) const;
+
+  // Forces every tile to be repainted on the next render().
+  void invalidate();
+
+  // Pushes the tiles of `page` whose content changed. Returns pixels pushed.
+  uint32_t render(const ServiceTable& table, int page);
+
+ private:
+  enum Rank : uint8_t {
+    RANK_DOWN,
+    RANK_PENDING,
+    RANK_UP,
+    RANK_COUNT
+  };
+
+  // What a tile currently shows on the panel. id 0 is an empty tile.
+  struct TileState {
+    uint64_t id;
+    uint32_t nameHash;
+    uint8_t rank;
+    bool valid;
+  };
+
+  struct Label {
+    LGFX_Sprite* sprite;
+    uint64_t id;
+    uint32_t nameHash;
+  };
+
+  static Rank rankOf(const Service& service);
+  static uint32_t hashName(const String& name);
+
+  uint32_t sortKey(uint16_t slot) const { return ((uint32_t)_rank[slot] << 16) | _position[slot]; }
+  bool sameServices(const ServiceTable& table) const;
+  void rebuildOrder(const ServiceTable& table);
+  void move(uint16_t slot, uint8_t rank);
+  LGFX_Sprite* rasterise(LGFX_Sprite* sprite, const char* text);
+  LGFX_Sprite* labelFor(uint16_t slot, const Service& service, uint32_t nameHash);
+  void drawTile(lgfx::LovyanGFX& target, int16_t originX, int16_t originY,
+                const Service* service, uint16_t slot, const TileState& state);
+
+  lgfx::LGFX_Device* _display = nullptr;
+  uint16_t _background = 0;
+  int16_t _x = 0, _y = 0;
+  int16_t _tileW = 0, _tileH = 0;
+  LGFX_Sprite* _tile = nullptr;  // nullptr if PSRAM allocation failed; drawn directly instead
+
+  uint16_t _order[MAX_SERVICES] = {};     // slots, DOWN first, then pending, then UP
+  uint16_t _position[MAX_SERVICES] = {};  // by slot: position in configuration order
+  uint8_t _rank[MAX_SERVICES] = {};       // by slot
+  uint64_t _ids[MAX_SERVICES] = {};       // by slot, to notice reused slots
+  int _count = 0;
+  int _downCount = 0;
+
+  Label _labels[MAX_SERVICES] = {};
+  LGFX_Sprite* _statusLabels[RANK_COUNT] = {};
+  TileState _tiles[TILES_PER_PAGE] = {};
+  void (*_beforePush)() = nullptr;
+};
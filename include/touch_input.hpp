@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+#ifndef LGFX_USE_V1
+#define LGFX_USE_V1
+#endif
+#include <LovyanGFX.hpp>
+#include <freertos/FreeRTOS.h>
+
+enum TouchGestureType : uint8_t {
+  GESTURE_TAP,
+  GESTURE_LONG_PRESS,
+  GESTURE_SWIPE_LEFT,
+  GESTURE_SWIPE_RIGHT,
+  GESTURE_SWIPE_UP,
+  GESTURE_SWIPE_DOWN
+};
+
+struct TouchGesture {
+  TouchGestureType type;
+  int16_t x, y;     // where the finger went down
+  uint32_t micros;  // interrupt (or poll) of the sample that decided the gesture
+};
+
+// Counters for the touch path. Written by the touch task, read without locking.
+struct TouchStats {
+  uint32_t interrupts;
+  uint32_t samples;   // I2C reads of the controller
+  uint32_t gestures;
+  uint32_t dropped;   // gestures lost because the queue was full
+};
+
+// Turns raw touch samples into gestures. A contact shorter than the press
+// debounce is ignored, and a release followed by renewed contact within the
+// release debounce counts as one continuous touch.
+class GestureRecognizer {
+ public:
+  // Feeds one sample. Returns true and fills `gesture` when a gesture completed.
+  bool update(bool down, int16_t x, int16_t y, uint32_t nowMillis, uint32_t sampleMicros,
+              TouchGesture& gesture);
+
+  // True while a finger is down or a release is being debounced; keep
+  // sampling until it turns false.
+  bool active() const { return _state != IDLE; }
+
+ private:
+  enum State { IDLE, PRESSED, RELEASING };
+
+  void press(int16_t x, int16_t y, uint32_t nowMillis);
+  bool finish(TouchGesture& gesture) const;
+
+  State _state = IDLE;
+  int16_t _startX = 0, _startY = 0;
+  int16_t _lastX = 0, _lastY = 0;
+  uint32_t _downAt = 0;
+  uint32_t _releasedAt = 0;
+  uint32_t _releasedMicros = 0;
+  bool _longPressSent = false;
+};
+
+// Starts the touch task. With `intPin` >= 0 the task sleeps until the GT911
+// raises its interrupt and only reads the controller over I2C while a finger
+// is down; without it the task polls. `onGesture` runs on the touch task after
+// each gesture is queued.
+bool startTouchInput(lgfx::LGFX_Device* display, int intPin, int core, void (*onGesture)());
+
+// Makes the task also sample every `period` while no finger is down (or only
+// on interrupts again with portMAX_DELAY). Needed while the chip light-sleeps,
+// as the GT911 line on this board cannot wake it.
+void setTouchIdlePolling(TickType_t period);
+
+// Pops the next gesture. Single consumer only.
+bool nextTouchGesture(TouchGesture& gesture);
+
+const TouchStats& touchStats();
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// WiFi association as a state machine driven from loop(), so nothing ever
+// waits on the radio. An attempt that does not associate within
+// WIFI_CONNECT_TIMEOUT_MS, or a lost link, moves to a back-off wait before
+// the next attempt. The wait doubles from WIFI_RETRY_MIN_MS up to
+// WIFI_RETRY_MAX_MS and resets once connected.
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#endif
+
+#ifndef WIFI_RETRY_MIN_MS
+#define WIFI_RETRY_MIN_MS 2000
+#endif
+
+#ifndef WIFI_RETRY_MAX_MS
+#define WIFI_RETRY_MAX_MS 60000
+#endif
+
+// How often loop() polls the link while it is not up
+const uint32_t WIFI_LINK_POLL_MS = 250;
+
+enum WifiLinkState : uint8_t {
+  LINK_CONNECTING,
+  LINK_UP,
+  LINK_BACKOFF  // waiting before the next attempt
+};
+
+enum WifiLinkEvent : uint8_t {
+  LINK_EVENT_NONE,
+  LINK_EVENT_CONNECTED,
+  LINK_EVENT_LOST
+};
+
+struct WifiLinkStats {
+  WifiLinkState state;
+  uint32_t connects;     // associations since boot
+  uint32_t losses;       // of which later lost
+  uint32_t attempts;     // connection attempts since boot
+  uint64_t downMillis;   // time not connected, including the first connect
+  uint32_t retryInMillis;  // until the next attempt, in LINK_BACKOFF
+};
+
+// Puts the radio in station mode and starts the first attempt. Returns at
+// once.
+void beginWifiLink();
+
+// Advances the state machine. Returns what changed, for the caller to start
+// or pause whatever depends on the link. Writer (loop()) only.
+WifiLinkEvent updateWifiLink(uint32_t nowMillis);
+
+bool wifiLinkUp();
+
+// Readable from any task; fields may be one update apart.
+WifiLinkStats wifiLinkStats(uint32_t nowMillis);
+
+// Short status for the display header, e.g. "Connecting to WiFi...".
+String wifiLinkStatusText(uint32_t nowMillis);
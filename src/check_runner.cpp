@@ -0,0 +1,130 @@
+#include "check_runner.hpp"
+
+#include "probe_simulator.hpp"
+#include "service_engine.hpp"
+
+namespace {
+
+// Checks that the endpoint answers HTTP at all. Home Assistant returns 404
+// for /api/ without a token, but ANY status means the service is alive.
+// Could parse /api/states to make sure it is actually Home Assistant.
+ProbeError checkHomeAssistant(Service& service, CheckPlatform& platform) {
+  HttpProbeResult result = platform.http.get(service.host, service.port, "/api/", "*");
+
+  if (result.error != PROBE_OK) {
+    service.lastError = describeProbeError(result);
+  }
+  return result.error;
+}
+
+ProbeError checkJellyfin(Service& service, CheckPlatform& platform) {
+  HttpProbeResult result = platform.http.get(service.host, service.port, "/health", "*");
+
+  if (result.error == PROBE_OK && result.status != 200) {
+    result.error = PROBE_HTTP_STATUS;
+  }
+  if (result.error != PROBE_OK) {
+    service.lastError = describeProbeError(result);
+  }
+  return result.error;
+}
+
+ProbeError checkHttpGet(Service& service, CheckPlatform& platform) {
+  HttpProbeResult result = platform.http.get(service.host, service.port, service.path, service.expectedResponse);
+
+  if (result.error == PROBE_OK && result.status != 200) {
+    result.error = PROBE_HTTP_STATUS;
+  }
+  if (result.error != PROBE_OK) {
+    service.lastError = describeProbeError(result);
+  }
+  return result.error;
+}
+
+ProbeError checkPing(Service& service, CheckPlatform& platform) {
+  // Resolved first so a dead name server is not reported as a ping timeout
+  uint32_t address;
+  if (!platform.network.resolve(service.host.c_str(), address, PROBE_DEADLINE_MS)) {
+    service.lastError = "DNS lookup failed";
+    return PROBE_DNS_FAILED;
+  }
+
+  if (!platform.pinger.ping(address, 3)) {
+    service.lastError = "Ping timeout";
+    return PROBE_TIMEOUT;
+  }
+  return PROBE_OK;
+}
+
+}  // namespace
+
+ProbeError probeService(Service& service, CheckPlatform& platform) {
+#if SIMULATE_PROBES
+  (void)platform;
+  return simulatedProbe(service);
+#else
+  switch (service.type) {
+    case TYPE_HOME_ASSISTANT:
+      return checkHomeAssistant(service, platform);
+    case TYPE_JELLYFIN:
+      return checkJellyfin(service, platform);
+    case TYPE_HTTP_GET:
+      return checkHttpGet(service, platform);
+    case TYPE_PING:
+      return checkPing(service, platform);
+  }
+  return PROBE_OK;
+#endif
+}
+
+int runDueChecks(ServiceTable& table, CheckPlatform& platform, CheckCallback onCheck) {
+  uint32_t currentTime = platform.clock.millis();
+  int checks = 0;
+
+  for (int i = 0; i < table.count; i++) {
+    Service& service = table.at(i);
+    if (msUntilCheckDue(service, currentTime) > 0) {
+      continue;
+    }
+
+    CheckOutcome outcome = {};
+    outcome.slot = table.order[i];
+    outcome.firstCheck = neverChecked(service);
+    outcome.startMillis = currentTime;
+    if (!outcome.firstCheck) {
+      // How long past due the check starts: the wake-up delay plus any
+      // earlier probes in this round
+      outcome.lateness = platform.clock.millis() - (service.lastCheck + checkIntervalMs(service));
+    }
+    unsigned long previousCheck = service.lastCheck;
+    service.lastCheck = currentTime;
+    bool wasUp = service.isUp;
+
+    uint32_t probeStart = platform.clock.millis();
+    uint32_t probeStartMicros = platform.clock.micros();
+    outcome.error = probeService(service, platform);
+    bool passed = outcome.error == PROBE_OK;
+
+    // A probe that failed because the link dropped under it says nothing
+    // about the service. It runs again once the link is back.
+    if (!passed && !platform.network.linkUp()) {
+      service.lastCheck = previousCheck;
+      break;
+    }
+
+    service.lastLatency = platform.clock.millis() - probeStart;
+    outcome.probeMicros = platform.clock.micros() - probeStartMicros;
+    outcome.unixTime = platform.clock.unixTime();
+    outcome.changed = applyCheckResult(service, passed, currentTime);
+    checks++;
+    if (onCheck != nullptr) {
+      onCheck(service, outcome);
+    }
+
+    if (wasUp != service.isUp || outcome.firstCheck) {
+      platform.display.servicesChanged(table);
+    }
+  }
+
+  return checks;
+}
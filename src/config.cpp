@@ -12,6 +12,8 @@
 //   -DDISCORD_WEBHOOK_URL_VALUE=\"https://discord.com/api/webhooks/...\"
 //   -DWEB_AUTH_USERNAME_VALUE=\"admin\"
 //   -DWEB_AUTH_PASSWORD_VALUE=\"changeme\"
+//   -DSYSLOG_SERVER_VALUE=\"192.168.1.10\"
+//   -DNTP_SERVER_VALUE=\"192.168.1.1\"
 
 #ifndef WIFI_SSID_VALUE
 #define WIFI_SSID_VALUE "xxx"
@@ -81,6 +83,18 @@
 #define SMTP_TO_ADDRESS_VALUE ""
 #endif
 
+#ifndef SYSLOG_SERVER_VALUE
+#define SYSLOG_SERVER_VALUE ""
+#endif
+
+#ifndef SYSLOG_PORT_VALUE
+#define SYSLOG_PORT_VALUE 514
+#endif
+
+#ifndef NTP_SERVER_VALUE
+#define NTP_SERVER_VALUE "pool.ntp.org"
+#endif
+
 const char* WIFI_SSID = WIFI_SSID_VALUE;
 const char* WIFI_PASSWORD = WIFI_PASSWORD_VALUE;
 
@@ -102,3 +116,8 @@ const char* SMTP_USERNAME = SMTP_USERNAME_VALUE;
 const char* SMTP_PASSWORD = SMTP_PASSWORD_VALUE;
 const char* SMTP_FROM_ADDRESS = SMTP_FROM_ADDRESS_VALUE;
 const char* SMTP_TO_ADDRESS = SMTP_TO_ADDRESS_VALUE;
+
+const char* SYSLOG_SERVER = SYSLOG_SERVER_VALUE;
+const int SYSLOG_PORT = SYSLOG_PORT_VALUE;
+
+const char* NTP_SERVER = NTP_SERVER_VALUE;
@@ -0,0 +1,193 @@
+#include "diagnostics.hpp"
+
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+
+const uint32_t TimingHistogram::BOUNDS[TimingHistogram::BUCKETS - 1] = {
+  100, 200, 500,
+  1000, 2000, 5000,
+  10000, 20000, 50000,
+  100000, 200000, 500000,
+  1000000, 2000000, 5000000,
+  10000000
+};
+
+namespace {
+
+TimingHistogram loopHistogram = {};
+TimingHistogram checkHistogram = {};
+TimingHistogram probeHistogram = {};
+TimingHistogram latenessHistogram = {};
+uint32_t transitions = 0;
+uint32_t bootStages[BOOT_STAGE_COUNT] = {};
+
+const char* const BOOT_STAGE_NAMES[BOOT_STAGE_COUNT] = {
+  "firstFrame", "wifi", "server", "clock", "firstCheck"
+};
+
+#if configUSE_TRACE_FACILITY
+const int MAX_TASKS = 32;
+TaskStatus_t taskStatus[MAX_TASKS];
+
+// Runtime counters at the previous sample, by task number
+UBaseType_t previousNumbers[MAX_TASKS];
+uint32_t previousRuntime[MAX_TASKS];
+int previousCount = 0;
+uint32_t previousTotal = 0;
+#endif
+
+}  // namespace
+
+void TimingHistogram::record(uint32_t micros) {
+  int bucket = 0;
+  while (bucket < BUCKETS - 1 && micros >= BOUNDS[bucket]) {
+    bucket++;
+  }
+
+  counts[bucket]++;
+  count++;
+  lastMicros = micros;
+  totalMicros += micros;
+  if (micros > maxMicros) {
+    maxMicros = micros;
+  }
+}
+
+uint32_t TimingHistogram::percentileMicros(uint8_t percentile) const {
+  if (count == 0) return 0;
+
+  uint64_t rank = ((uint64_t)count * percentile + 99) / 100;
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < BUCKETS - 1; bucket++) {
+    seen += counts[bucket];
+    if (seen >= rank) {
+      return BOUNDS[bucket] < maxMicros ? BOUNDS[bucket] : maxMicros;
+    }
+  }
+  return maxMicros;
+}
+
+void recordLoopIteration(uint32_t micros) {
+  loopHistogram.record(micros);
+}
+
+void recordCheckRound(uint32_t micros) {
+  checkHistogram.record(micros);
+}
+
+void recordProbe(uint32_t micros, uint32_t latenessMillis) {
+  probeHistogram.record(micros);
+  latenessHistogram.record(latenessMillis > UINT32_MAX / 1000 ? UINT32_MAX : latenessMillis * 1000);
+}
+
+void recordStateTransition() {
+  transitions++;
+}
+
+void recordBootStage(BootStage stage) {
+  // Each stage has one writer, so a plain check-then-set is enough
+  if (stage < BOOT_STAGE_COUNT && bootStages[stage] == 0) {
+    uint32_t now = millis();
+    bootStages[stage] = now > 0 ? now : 1;
+  }
+}
+
+uint32_t bootStageMillis(BootStage stage) {
+  return stage < BOOT_STAGE_COUNT ? bootStages[stage] : 0;
+}
+
+const char* bootStageName(BootStage stage) {
+  return stage < BOOT_STAGE_COUNT ? BOOT_STAGE_NAMES[stage] : "";
+}
+
+const TimingHistogram& loopTiming() {
+  return loopHistogram;
+}
+
+const TimingHistogram& checkRoundTiming() {
+  return checkHistogram;
+}
+
+const TimingHistogram& probeTiming() {
+  return probeHistogram;
+}
+
+const TimingHistogram& scheduleLateness() {
+  return latenessHistogram;
+}
+
+uint32_t stateTransitions() {
+  return transitions;
+}
+
+HeapStats heapStats() {
+  HeapStats stats = {};
+  stats.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+  stats.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+  stats.internalMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+  stats.psramSize = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+  if (stats.psramSize > 0) {
+    stats.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    stats.psramLargest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    stats.psramMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+  }
+  return stats;
+}
+
+uint8_t fragmentationPercent(uint32_t free, uint32_t largest) {
+  if (free == 0 || largest >= free) return 0;
+  return (uint8_t)(100 - (uint64_t)largest * 100 / free);
+}
+
+int sampleTasks(TaskSample* samples, int max) {
+#if configUSE_TRACE_FACILITY
+  uint32_t total = 0;
+  int count = uxTaskGetSystemState(taskStatus, MAX_TASKS, &total);
+  if (count > max) count = max;
+
+  uint32_t elapsed = total - previousTotal;
+  bool haveWindow = previousCount > 0 && elapsed > 0;
+
+  for (int i = 0; i < count; i++) {
+    const TaskStatus_t& status = taskStatus[i];
+    TaskSample& sample = samples[i];
+
+    strncpy(sample.name, status.pcTaskName, sizeof(sample.name) - 1);
+    sample.name[sizeof(sample.name) - 1] = '\0';
+    sample.priority = status.uxCurrentPriority;
+    // ESP-IDF reports the high-water mark in bytes, not words
+    sample.stackFree = status.usStackHighWaterMark;
+#if configTASKLIST_INCLUDE_COREID
+    sample.core = status.xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status.xCoreID;
+#else
+    sample.core = -1;
+#endif
+
+    sample.cpuPercent = -1;
+#if configGENERATE_RUN_TIME_STATS
+    for (int p = 0; haveWindow && p < previousCount; p++) {
+      if (previousNumbers[p] != status.xTaskNumber) continue;
+
+      uint32_t used = status.ulRunTimeCounter - previousRuntime[p];
+      sample.cpuPercent = 100.0f * used / ((float)elapsed * portNUM_PROCESSORS);
+      break;
+    }
+#endif
+  }
+
+#if configGENERATE_RUN_TIME_STATS
+  previousCount = count;
+  previousTotal = total;
+  for (int i = 0; i < count; i++) {
+    previousNumbers[i] = taskStatus[i].xTaskNumber;
+    previousRuntime[i] = taskStatus[i].ulRunTimeCounter;
+  }
+#endif
+
+  return count;
+#else
+  return -1;
+#endif
+}
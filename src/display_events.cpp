@@ -0,0 +1,32 @@
+#include "display_events.hpp"
+
+#include <freertos/queue.h>
+
+namespace {
+
+const int EVENT_QUEUE_LENGTH = 8;
+QueueHandle_t eventQueue = nullptr;
+
+}  // namespace
+
+bool initDisplayEventQueue() {
+  if (eventQueue == nullptr) {
+    eventQueue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(DisplayEvent));
+  }
+  return eventQueue != nullptr;
+}
+
+void postDisplayEvent(DisplayEventType type) {
+  if (eventQueue == nullptr) return;
+
+  DisplayEvent event = {type, (uint32_t)micros()};
+  xQueueSend(eventQueue, &event, 0);
+}
+
+bool receiveDisplayEvent(DisplayEvent& event, TickType_t timeout) {
+  if (eventQueue == nullptr) {
+    vTaskDelay(timeout);
+    return false;
+  }
+  return xQueueReceive(eventQueue, &event, timeout) == pdTRUE;
+}
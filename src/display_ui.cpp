@@ -0,0 +1,136 @@
+#include "display_ui.hpp"
+
+int WidgetScreen::addWidget(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t textSize,
+                            bool hasPanel, uint16_t panelColor, int16_t textX, int16_t textY) {
+  if (_widgetCount >= MAX_WIDGETS) {
+    return -1;
+  }
+
+  Widget& widget = _widgets[_widgetCount];
+  widget.x = x;
+  widget.y = y;
+  widget.w = w;
+  widget.h = h;
+  widget.textX = textX;
+  widget.textY = textY;
+  widget.textSize = textSize;
+  widget.hasPanel = hasPanel;
+  widget.panelColor = panelColor;
+  widget.sprite = nullptr;
+  widget.text = "";
+  widget.color = 0;
+  widget.dirty = true;
+  widget.visible = true;
+  return _widgetCount++;
+}
+
+void WidgetScreen::begin(lgfx::LGFX_Device* display, uint16_t background) {
+  _display = display;
+  _background = background;
+
+  for (int i = 0; i < _widgetCount; i++) {
+    Widget& widget = _widgets[i];
+    if (widget.sprite != nullptr) continue;
+
+    LGFX_Sprite* sprite = new LGFX_Sprite(display);
+    sprite->setPsram(true);
+    sprite->setColorDepth(16);
+    if (sprite->createSprite(widget.w, widget.h) == nullptr) {
+      Serial.printf("Widget %d: sprite allocation failed, drawing directly\n", i);
+      delete sprite;
+      sprite = nullptr;
+    }
+    widget.sprite = sprite;
+  }
+
+  _display->fillScreen(_background);
+  invalidate();
+}
+
+void WidgetScreen::setText(int id, const String& text, uint16_t color) {
+  if (id < 0 || id >= _widgetCount) return;
+
+  Widget& widget = _widgets[id];
+  if (widget.text == text && widget.color == color) return;
+
+  widget.text = text;
+  widget.color = color;
+  widget.dirty = true;
+}
+
+void WidgetScreen::setVisible(int id, bool visible) {
+  if (id < 0 || id >= _widgetCount) return;
+
+  Widget& widget = _widgets[id];
+  if (widget.visible == visible) return;
+
+  widget.visible = visible;
+  widget.dirty = visible;
+}
+
+void WidgetScreen::invalidate() {
+  for (int i = 0; i < _widgetCount; i++) {
+    _widgets[i].dirty = true;
+  }
+}
+
+void WidgetScreen::draw(lgfx::LovyanGFX& target, const Widget& widget, int16_t originX, int16_t originY) {
+  target.fillRect(originX, originY, widget.w, widget.h, _background);
+
+  uint16_t textBackground = _background;
+  if (widget.hasPanel && widget.text.length() > 0) {
+    target.fillRoundRect(originX, originY, widget.w, widget.h, 12, widget.panelColor);
+    textBackground = widget.panelColor;
+  }
+
+  target.setTextSize(widget.textSize);
+  target.setTextColor(widget.color, textBackground);
+  target.setCursor(originX + widget.textX, originY + widget.textY);
+  target.print(widget.text.c_str());
+}
+
+uint32_t WidgetScreen::flush() {
+  if (_display == nullptr) return 0;
+
+  uint32_t start = micros();
+  uint32_t pixels = 0;
+  bool pushed = false;
+
+  _display->startWrite();
+  for (int i = 0; i < _widgetCount; i++) {
+    Widget& widget = _widgets[i];
+    if (!widget.dirty || !widget.visible) continue;
+
+    if (widget.sprite != nullptr) {
+      draw(*widget.sprite, widget, 0, 0);
+      if (!pushed && _beforePush != nullptr) _beforePush();
+      widget.sprite->pushSprite(widget.x, widget.y);
+    } else {
+      if (!pushed && _beforePush != nullptr) _beforePush();
+      _display->setClipRect(widget.x, widget.y, widget.w, widget.h);
+      draw(*_display, widget, widget.x, widget.y);
+      _display->clearClipRect();
+    }
+
+    widget.dirty = false;
+    pushed = true;
+    pixels += (uint32_t)widget.w * widget.h;
+  }
+  _display->endWrite();
+
+  recordFrame(pixels, micros() - start);
+  return pixels;
+}
+
+void WidgetScreen::recordFrame(uint32_t pixels, uint32_t elapsed) {
+  if (pixels == 0) return;
+
+  _stats.frames++;
+  _stats.pushedPixels += pixels;
+  _stats.lastFramePixels = pixels;
+  _stats.lastFrameMicros = elapsed;
+  _stats.totalFrameMicros += elapsed;
+  if (elapsed > _stats.maxFrameMicros) {
+    _stats.maxFrameMicros = elapsed;
+  }
+}
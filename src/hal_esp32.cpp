@@ -0,0 +1,146 @@
+#include "hal_esp32.hpp"
+
+#include <ESP32Ping.h>
+#include <freertos/semphr.h>
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#include <time.h>
+
+#include <atomic>
+#include <new>
+
+#include "config.hpp"
+
+namespace {
+
+// One lookup, shared by the caller and lwIP's callback. The caller may give
+// up before the answer arrives, so whichever lets go last frees it.
+struct Lookup {
+  SemaphoreHandle_t done;
+  std::atomic<int> owners;
+  bool found;
+  uint32_t address;
+};
+
+void releaseLookup(Lookup* lookup) {
+  if (--lookup->owners == 0) {
+    vSemaphoreDelete(lookup->done);
+    delete lookup;
+  }
+}
+
+// Runs in the lwIP thread; `resolved` is null if the lookup failed
+void lookupFinished(const char* name, const ip_addr_t* resolved, void* argument) {
+  (void)name;
+  Lookup* lookup = static_cast<Lookup*>(argument);
+  if (resolved != nullptr && IP_IS_V4(resolved)) {
+    lookup->address = ip4_addr_get_u32(ip_2_ip4(resolved));
+    lookup->found = true;
+  }
+  xSemaphoreGive(lookup->done);
+  releaseLookup(lookup);
+}
+
+}  // namespace
+
+uint32_t ArduinoClock::millis() {
+  return ::millis();
+}
+
+uint32_t ArduinoClock::micros() {
+  return ::micros();
+}
+
+void ArduinoClock::sleep(uint32_t ms) {
+  delay(ms);
+}
+
+uint32_t ArduinoClock::unixTime() {
+  time_t now = time(nullptr);
+  return now >= CLOCK_VALID_AFTER ? (uint32_t)now : 0;
+}
+
+Clock& systemClock() {
+  static ArduinoClock clock;
+  return clock;
+}
+
+bool WiFiSocket::connect(uint32_t address, uint16_t port, uint32_t timeoutMs) {
+  return _client.connect(IPAddress(address), port, timeoutMs);
+}
+
+size_t WiFiSocket::write(const uint8_t* data, size_t length) {
+  return _client.write(data, length);
+}
+
+int WiFiSocket::available() {
+  return _client.available();
+}
+
+int WiFiSocket::read(uint8_t* buffer, size_t size) {
+  if (_client.available() <= 0) return -1;
+  return _client.read(buffer, size);
+}
+
+bool WiFiSocket::connected() {
+  return _client.connected();
+}
+
+void WiFiSocket::stop() {
+  _client.stop();
+}
+
+bool WiFiNetwork::linkUp() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+// WiFi.hostByName() waits for lwIP's own retry schedule, which can outlast
+// the probe deadline when the name server does not answer. This asks lwIP
+// directly and stops waiting after `timeoutMs`; a late answer is dropped.
+bool WiFiNetwork::resolve(const char* host, uint32_t& address, uint32_t timeoutMs) {
+  IPAddress literal;
+  if (literal.fromString(host)) {
+    address = (uint32_t)literal;
+    return true;
+  }
+
+  Lookup* lookup = new (std::nothrow) Lookup();
+  if (lookup == nullptr) return false;
+  lookup->done = xSemaphoreCreateBinary();
+  if (lookup->done == nullptr) {
+    delete lookup;
+    return false;
+  }
+  lookup->owners = 2;
+
+  ip_addr_t resolved;
+  LOCK_TCPIP_CORE();
+  err_t started = dns_gethostbyname_addrtype(host, &resolved, lookupFinished, lookup, LWIP_DNS_ADDRTYPE_IPV4);
+  UNLOCK_TCPIP_CORE();
+
+  bool found = false;
+  if (started == ERR_OK) {
+    // Cached: answered at once and the callback will not run
+    address = ip4_addr_get_u32(ip_2_ip4(&resolved));
+    found = true;
+    lookup->owners--;
+  } else if (started == ERR_INPROGRESS) {
+    if (xSemaphoreTake(lookup->done, pdMS_TO_TICKS(timeoutMs)) == pdTRUE && lookup->found) {
+      address = lookup->address;
+      found = true;
+    }
+  } else {
+    lookup->owners--;  // refused; no callback either
+  }
+
+  releaseLookup(lookup);
+  return found;
+}
+
+std::unique_ptr<Socket> WiFiNetwork::newSocket() {
+  return std::unique_ptr<Socket>(new WiFiSocket());
+}
+
+bool IcmpPinger::ping(uint32_t address, int count) {
+  return Ping.ping(IPAddress(address), count);
+}
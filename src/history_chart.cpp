@@ -0,0 +1,192 @@
+#include "history_chart.hpp"
+
+namespace {
+
+// Chart scales in ms; the smallest one above the slowest visible check is used
+const uint32_t LATENCY_SCALES[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 65535};
+const int16_t FAILED_MARK_HEIGHT = 4;
+
+LGFX_Sprite* createChartSprite(lgfx::LGFX_Device* display, int16_t w, int16_t h, uint16_t background) {
+  LGFX_Sprite* sprite = new LGFX_Sprite(display);
+  sprite->setPsram(true);
+  sprite->setColorDepth(16);
+  if (sprite->createSprite(w, h) == nullptr) {
+    Serial.println("Chart sprite allocation failed, chart disabled");
+    delete sprite;
+    return nullptr;
+  }
+  // scroll() moves the whole sprite and fills the vacated columns with the
+  // base colour
+  sprite->setScrollRect(0, 0, w, h);
+  sprite->setBaseColor(background);
+  sprite->fillScreen(background);
+  return sprite;
+}
+
+}  // namespace
+
+void LatencySparkline::begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h,
+                             uint16_t background) {
+  _x = x;
+  _y = y;
+  _w = w;
+  _h = h;
+  _background = background;
+  if (_sprite == nullptr) {
+    _sprite = createChartSprite(display, w, h, background);
+  }
+  _valid = false;
+}
+
+uint32_t LatencySparkline::scaleFor(const ServiceHistory& history, uint32_t total, int visible) const {
+  uint32_t slowest = 0;
+  for (uint32_t n = total - visible; n < total; n++) {
+    uint16_t sample = latencySample(history, n);
+    if (sample != LATENCY_FAILED && sample > slowest) {
+      slowest = sample;
+    }
+  }
+
+  for (uint32_t scale : LATENCY_SCALES) {
+    if (slowest <= scale) return scale;
+  }
+  return LATENCY_SCALES[sizeof(LATENCY_SCALES) / sizeof(LATENCY_SCALES[0]) - 1];
+}
+
+void LatencySparkline::drawColumn(int column, uint16_t sample) {
+  int16_t x = column * COLUMN_WIDTH;
+  _sprite->fillRect(x, 0, COLUMN_WIDTH, _h, _background);
+
+  if (sample == LATENCY_FAILED) {
+    _sprite->fillRect(x, _h - FAILED_MARK_HEIGHT, COLUMN_WIDTH, FAILED_MARK_HEIGHT, TFT_RED);
+    return;
+  }
+
+  int16_t height = (int32_t)sample * _h / _scale;
+  if (height < 1) height = 1;
+  if (height > _h) height = _h;
+  _sprite->fillRect(x, _h - height, COLUMN_WIDTH, height, TFT_CYAN);
+}
+
+uint32_t LatencySparkline::render(const ServiceHistory* history, uint64_t id) {
+  if (_sprite == nullptr) return 0;
+
+  int columns = _w / COLUMN_WIDTH;
+  uint32_t total = history != nullptr ? history->samples.load(std::memory_order_acquire) : 0;
+  int visible = total < (uint32_t)columns ? (int)total : columns;
+  if (visible > LATENCY_HISTORY - HISTORY_READ_MARGIN) {
+    visible = LATENCY_HISTORY - HISTORY_READ_MARGIN;
+  }
+
+  uint32_t scale = visible > 0 ? scaleFor(*history, total, visible) : LATENCY_SCALES[0];
+  bool sameChart = _valid && id == _shownId && scale == _scale && total >= _shownSamples;
+  if (sameChart && total == _shownSamples) {
+    return 0;
+  }
+
+  _scale = scale;
+  uint32_t added = total - _shownSamples;
+  if (sameChart && added < (uint32_t)visible) {
+    // Blit the existing columns left and append the new ones
+    _sprite->scroll(-(int32_t)added * COLUMN_WIDTH, 0);
+    for (uint32_t n = total - added; n < total; n++) {
+      drawColumn(columns - (total - n), latencySample(*history, n));
+    }
+  } else {
+    _sprite->fillScreen(_background);
+    for (uint32_t n = total - visible; n < total; n++) {
+      drawColumn(columns - (total - n), latencySample(*history, n));
+    }
+  }
+
+  if (_beforePush != nullptr) _beforePush();
+  _sprite->pushSprite(_x, _y);
+
+  _valid = true;
+  _shownId = id;
+  _shownSamples = total;
+  return (uint32_t)_w * _h;
+}
+
+void UptimeBar::begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h,
+                      uint16_t background) {
+  _x = x;
+  _y = y;
+  _w = w;
+  _h = h;
+  _columnWidth = w / UPTIME_BUCKETS;
+  _background = background;
+  if (_sprite == nullptr) {
+    _sprite = createChartSprite(display, w, h, background);
+  }
+  _valid = false;
+}
+
+void UptimeBar::drawColumn(int column, const ServiceHistory* history, uint32_t bucketIndex) {
+  uint16_t color = TFT_DARKGREY;  // no checks in this interval
+  if (history != nullptr) {
+    const UptimeBucket& bucket = history->buckets[bucketIndex % UPTIME_BUCKETS];
+    if (bucket.index == bucketIndex && bucket.up + bucket.down > 0) {
+      if (bucket.down == 0) {
+        color = TFT_GREEN;
+      } else if (bucket.up == 0) {
+        color = TFT_RED;
+      } else {
+        color = TFT_ORANGE;
+      }
+    }
+  }
+
+  // One pixel gap between columns
+  int16_t x = _w - (UPTIME_BUCKETS - column) * _columnWidth;
+  _sprite->fillRect(x, 0, _columnWidth, _h, _background);
+  _sprite->fillRect(x, 0, _columnWidth > 1 ? _columnWidth - 1 : 1, _h, color);
+}
+
+uint32_t UptimeBar::render(const ServiceHistory* history, uint64_t id, uint32_t nowMillis) {
+  if (_sprite == nullptr || _columnWidth == 0) return 0;
+
+  uint32_t current = nowMillis / UPTIME_BUCKET_MS;
+  uint16_t up = 0;
+  uint16_t down = 0;
+  if (history != nullptr) {
+    const UptimeBucket& bucket = history->buckets[current % UPTIME_BUCKETS];
+    if (bucket.index == current) {
+      up = bucket.up;
+      down = bucket.down;
+    }
+  }
+
+  bool sameBar = _valid && id == _shownId && current >= _shownBucket;
+  if (sameBar && current == _shownBucket && up == _shownUp && down == _shownDown) {
+    return 0;
+  }
+
+  uint32_t advanced = current - _shownBucket;
+  if (sameBar && advanced < (uint32_t)UPTIME_BUCKETS) {
+    if (advanced > 0) {
+      _sprite->scroll(-(int32_t)advanced * _columnWidth, 0);
+    }
+    // The previous current bucket may have taken more checks before it closed
+    for (uint32_t n = 0; n <= advanced && n < (uint32_t)UPTIME_BUCKETS; n++) {
+      drawColumn(UPTIME_BUCKETS - 1 - n, history, current - n);
+    }
+  } else {
+    _sprite->fillScreen(_background);
+    for (int column = 0; column < UPTIME_BUCKETS; column++) {
+      uint32_t back = UPTIME_BUCKETS - 1 - column;
+      if (back > current) continue;  // before boot
+      drawColumn(column, history, current - back);
+    }
+  }
+
+  if (_beforePush != nullptr) _beforePush();
+  _sprite->pushSprite(_x, _y);
+
+  _valid = true;
+  _shownId = id;
+  _shownBucket = current;
+  _shownUp = up;
+  _shownDown = down;
+  return (uint32_t)_w * _h;
+}
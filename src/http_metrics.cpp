@@ -0,0 +1,143 @@
+#include "http_metrics.hpp"
+
+#include <string.h>
+
+namespace {
+
+const int MAX_ROUTES = 24;
+const int MAX_IN_FLIGHT = 8;
+const uint32_t IN_FLIGHT_EXPIRY_MICROS = 30 * 1000000UL;  // abandoned uploads
+
+RouteStats routes[MAX_ROUTES] = {};
+int routeTotal = 0;
+
+// Requests whose body is still arriving. The request pointer is only compared,
+// never dereferenced, so a stale entry is harmless until it expires.
+struct InFlight {
+  AsyncWebServerRequest* request;
+  uint32_t startMicros;
+  uint32_t busyMicros;
+};
+
+InFlight inFlight[MAX_IN_FLIGHT] = {};
+InFlightStats inFlightCounters = {};
+
+// Reads the protected body length through a member pointer formed in a
+// subclass, without changing the library.
+struct ResponseLength : AsyncWebServerResponse {
+  static size_t of(const AsyncWebServerResponse* response) {
+    return response->*(&ResponseLength::_contentLength);
+  }
+};
+
+RouteStats* routeFor(const char* name) {
+  for (int i = 0; i < routeTotal; i++) {
+    if (strcmp(routes[i].name, name) == 0) return &routes[i];
+  }
+  if (routeTotal == MAX_ROUTES) return nullptr;
+
+  RouteStats& route = routes[routeTotal++];
+  route.name = name;
+  return &route;
+}
+
+void expireInFlight(uint32_t now) {
+  for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+    if (inFlight[i].request != nullptr && now - inFlight[i].startMicros > IN_FLIGHT_EXPIRY_MICROS) {
+      inFlight[i].request = nullptr;
+      inFlightCounters.current--;
+      inFlightCounters.abandoned++;
+    }
+  }
+}
+
+InFlight* findInFlight(AsyncWebServerRequest* request) {
+  for (int i = 0; i < MAX_IN_FLIGHT; i++) {
+    if (inFlight[i].request == request) return &inFlight[i];
+  }
+  return nullptr;
+}
+
+InFlight* startInFlight(AsyncWebServerRequest* request, uint32_t now) {
+  expireInFlight(now);
+  InFlight* entry = findInFlight(nullptr);
+  if (entry == nullptr) return nullptr;
+
+  entry->request = request;
+  entry->startMicros = now;
+  entry->busyMicros = 0;
+  inFlightCounters.current++;
+  if (inFlightCounters.current > inFlightCounters.peak) {
+    inFlightCounters.peak = inFlightCounters.current;
+  }
+  return entry;
+}
+
+void finishRequest(RouteStats* route, AsyncWebServerRequest* request, uint32_t busyMicros) {
+  if (route == nullptr) return;
+
+  route->requests++;
+  route->latency.record(busyMicros);
+
+  AsyncWebServerResponse* response = request->getResponse();
+  if (response == nullptr) {
+    route->noResponse++;
+    return;
+  }
+
+  int statusClass = response->code() / 100;
+  if (statusClass >= 1 && statusClass <= 5) {
+    route->status[statusClass - 1]++;
+  }
+  route->bodyBytes += ResponseLength::of(response);
+}
+
+}  // namespace
+
+ArRequestHandlerFunction trackRoute(const char* name, ArRequestHandlerFunction handler) {
+  RouteStats* route = routeFor(name);
+
+  return [route, handler](AsyncWebServerRequest* request) {
+    uint32_t start = micros();
+    if (handler) handler(request);
+    uint32_t busy = micros() - start;
+
+    InFlight* entry = findInFlight(request);
+    if (entry != nullptr) {
+      busy += entry->busyMicros;
+      entry->request = nullptr;
+      inFlightCounters.current--;
+    }
+
+    finishRequest(route, request, busy);
+  };
+}
+
+ArBodyHandlerFunction trackRouteBody(ArBodyHandlerFunction handler) {
+  return [handler](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    uint32_t start = micros();
+    InFlight* entry = findInFlight(request);
+    if (entry == nullptr && index == 0) {
+      entry = startInFlight(request, start);
+    }
+
+    if (handler) handler(request, data, len, index, total);
+
+    if (entry != nullptr) {
+      entry->busyMicros += micros() - start;
+    }
+  };
+}
+
+int routeCount() {
+  return routeTotal;
+}
+
+const RouteStats& routeStats(int index) {
+  return routes[index];
+}
+
+InFlightStats inFlightStats() {
+  expireInFlight(micros());
+  return inFlightCounters;
+}
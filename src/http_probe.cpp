@@ -0,0 +1,214 @@
+#include "http_probe.hpp"
+
+#include <string.h>
+
+namespace {
+
+const size_t BODY_WINDOW = 512;
+const size_t MAX_EXPECTED = BODY_WINDOW / 2;  // longer needles are truncated
+
+enum LineResult {
+  LINE_OK,
+  LINE_TIMEOUT,
+  LINE_CLOSED
+};
+
+// One exchange: the socket, the clock and when the deadline started.
+struct Exchange {
+  Socket& socket;
+  Clock& clock;
+  uint32_t start;
+
+  uint32_t elapsed() { return clock.millis() - start; }
+  bool pastDeadline() { return elapsed() >= PROBE_DEADLINE_MS; }
+};
+
+// Waits for at least one byte. False once the peer has closed and nothing is
+// left, or at the deadline (`timedOut` set).
+bool waitForData(Exchange& exchange, bool& timedOut) {
+  while (exchange.socket.available() == 0) {
+    if (!exchange.socket.connected()) return false;
+    if (exchange.pastDeadline()) {
+      timedOut = true;
+      return false;
+    }
+    exchange.clock.sleep(1);
+  }
+  return true;
+}
+
+// Reads one header line into `line` (truncated to fit, without CR/LF) and
+// adds the bytes consumed to `headerBytes`. Stops early once the header
+// budget is spent.
+LineResult readLine(Exchange& exchange, char* line, size_t size, size_t& headerBytes) {
+  size_t length = 0;
+  bool timedOut = false;
+
+  while (headerBytes < PROBE_MAX_HEADER_BYTES) {
+    if (!waitForData(exchange, timedOut)) {
+      return timedOut ? LINE_TIMEOUT : LINE_CLOSED;
+    }
+
+    uint8_t c;
+    if (exchange.socket.read(&c, 1) <= 0) continue;
+    headerBytes++;
+
+    if (c == '\n') break;
+    if (c != '\r' && length < size - 1) {
+      line[length++] = (char)c;
+    }
+  }
+
+  line[length] = '\0';
+  return LINE_OK;
+}
+
+// Naive search; needles are short and the window small.
+bool contains(const char* haystack, size_t length, const char* needle, size_t needleLength) {
+  if (needleLength == 0) return true;
+  for (size_t i = 0; i + needleLength <= length; i++) {
+    if (memcmp(haystack + i, needle, needleLength) == 0) return true;
+  }
+  return false;
+}
+
+// Streams the body through a fixed window, keeping the tail of the previous
+// read so a match split across reads is still found.
+ProbeError scanBody(Exchange& exchange, const String& expected, uint32_t& bodyBytes) {
+  char window[BODY_WINDOW];
+  size_t needleLength = expected.length() < MAX_EXPECTED ? expected.length() : MAX_EXPECTED;
+  size_t kept = 0;
+  bool timedOut = false;
+
+  while (bodyBytes < PROBE_MAX_BODY_BYTES) {
+    if (!waitForData(exchange, timedOut)) {
+      return timedOut ? PROBE_TIMEOUT : PROBE_MISMATCH;
+    }
+
+    size_t room = sizeof(window) - kept;
+    if (room > PROBE_MAX_BODY_BYTES - bodyBytes) {
+      room = PROBE_MAX_BODY_BYTES - bodyBytes;
+    }
+    int read = exchange.socket.read(reinterpret_cast<uint8_t*>(window + kept), room);
+    if (read <= 0) continue;
+    bodyBytes += read;
+
+    size_t length = kept + read;
+    if (contains(window, length, expected.c_str(), needleLength)) {
+      return PROBE_OK;
+    }
+
+    kept = needleLength > 1 ? needleLength - 1 : 0;
+    if (kept > length) kept = length;
+    memmove(window, window + length - kept, kept);
+  }
+
+  return PROBE_MISMATCH;
+}
+
+}  // namespace
+
+HttpProbeResult BoundedHttpClient::get(const String& host, int port, const String& path, const String& expected) {
+  HttpProbeResult result = {PROBE_OK, 0, 0, 0};
+  uint32_t start = _clock.millis();
+
+  uint32_t address;
+  if (!_network.resolve(host.c_str(), address, PROBE_DEADLINE_MS)) {
+    result.error = PROBE_DNS_FAILED;
+    result.millis = _clock.millis() - start;
+    return result;
+  }
+
+  // A slow lookup leaves less time for the rest; never wait past the deadline
+  uint32_t spent = _clock.millis() - start;
+  uint32_t connectTimeout = spent < PROBE_DEADLINE_MS ? PROBE_DEADLINE_MS - spent : 0;
+  if (connectTimeout > PROBE_CONNECT_TIMEOUT_MS) connectTimeout = PROBE_CONNECT_TIMEOUT_MS;
+
+  if (connectTimeout == 0) {
+    result.error = PROBE_TIMEOUT;
+    result.millis = spent;
+    return result;
+  }
+
+  std::unique_ptr<Socket> socket = _network.newSocket();
+  if (!socket->connect(address, port, connectTimeout)) {
+    result.error = PROBE_CONNECT_FAILED;
+    result.millis = _clock.millis() - start;
+    return result;
+  }
+
+  String request = "GET " + (path.length() > 0 ? path : String("/")) + " HTTP/1.0\r\nHost: " + host +
+    "\r\nUser-Agent: esp32-uptime-monitor\r\nConnection: close\r\n\r\n";
+  socket->write(reinterpret_cast<const uint8_t*>(request.c_str()), request.length());
+
+  Exchange exchange = {*socket, _clock, start};
+
+  // Status line, e.g. "HTTP/1.1 200 OK"
+  char line[64];
+  size_t headerBytes = 0;
+  LineResult lineResult = readLine(exchange, line, sizeof(line), headerBytes);
+  if (lineResult == LINE_OK && (strncmp(line, "HTTP/", 5) != 0 || strchr(line, ' ') == nullptr)) {
+    result.error = PROBE_BAD_RESPONSE;
+  } else if (lineResult == LINE_OK) {
+    result.status = atoi(strchr(line, ' ') + 1);
+    if (result.status < 100 || result.status > 599) {
+      result.error = PROBE_BAD_RESPONSE;
+    }
+  }
+
+  // Headers up to the blank line; their content is not needed
+  while (lineResult == LINE_OK && result.error == PROBE_OK) {
+    if (headerBytes >= PROBE_MAX_HEADER_BYTES) {
+      result.error = PROBE_BAD_RESPONSE;
+      break;
+    }
+    lineResult = readLine(exchange, line, sizeof(line), headerBytes);
+    if (lineResult == LINE_OK && line[0] == '\0') break;
+  }
+
+  if (lineResult == LINE_TIMEOUT) {
+    result.error = PROBE_TIMEOUT;
+  } else if (lineResult == LINE_CLOSED) {
+    result.error = PROBE_CONNECTION_CLOSED;
+  }
+
+  bool wantBody = expected.length() > 0 && expected != "*";
+  if (result.error == PROBE_OK && result.status == 200 && wantBody) {
+    result.error = scanBody(exchange, expected, result.bodyBytes);
+  }
+
+  socket->stop();
+  result.millis = _clock.millis() - start;
+  return result;
+}
+
+String describeProbeError(const HttpProbeResult& result) {
+  switch (result.error) {
+    case PROBE_OK:
+      return "";
+    case PROBE_DNS_FAILED:
+      return "DNS lookup failed";
+    case PROBE_CONNECT_FAILED:
+      return "Connection failed";
+    case PROBE_TIMEOUT:
+      return "Timed out after " + String(result.millis) + " ms";
+    case PROBE_CONNECTION_CLOSED:
+      return "Connection closed before response";
+    case PROBE_BAD_RESPONSE:
+      return "Invalid HTTP response";
+    case PROBE_HTTP_STATUS:
+      return "HTTP " + String(result.status);
+    case PROBE_MISMATCH:
+      return result.bodyBytes >= PROBE_MAX_BODY_BYTES
+        ? "Response mismatch (first " + String(PROBE_MAX_BODY_BYTES / 1024) + " KB)"
+        : String("Response mismatch");
+  }
+  return "Unknown error";
+}
+
+const char* probeErrorName(uint8_t error) {
+  static const char* const NAMES[] = {
+    "ok", "dns", "connect", "timeout", "closed", "bad_response", "http_status", "mismatch"
+  };
+  return error < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[error] : "unknown";
+}
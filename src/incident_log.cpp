@@ -0,0 +1,401 @@
+#include "incident_log.hpp"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#include "config.hpp"
+#include "hal.hpp"
+#include "logger.hpp"
+
+static_assert(INCIDENT_FILE_RECORDS % INCIDENT_INDEX_EVERY == 0,
+  "INCIDENT_FILE_RECORDS must be a multiple of INCIDENT_INDEX_EVERY");
+
+namespace {
+
+const char* INCIDENT_FILE = "/incidents.bin";
+const char* INCIDENT_INDEX_FILE = "/incidents.idx";
+const char* OLD_INCIDENT_FILE = "/incidents.old.bin";
+const char* OLD_INCIDENT_INDEX_FILE = "/incidents.old.idx";
+const char* INCIDENT_TEMP_FILE = "/incidents.tmp";
+
+// Failure run or outage of one table slot, not yet in the file
+struct OpenIncident {
+  uint64_t id;
+  bool failing;  // the latest probes failed, or the service is DOWN
+  bool down;     // the service was DOWN during the run
+  uint32_t startMillis;
+  uint32_t startUnix;  // 0 if the clock was unset at the first failure
+  uint32_t failedProbes;
+  uint8_t firstError;
+};
+
+// Guards the files, the counters below and the open incidents against
+// IncidentCursor from the web server
+SemaphoreHandle_t incidentLock = nullptr;
+OpenIncident openIncidents[MAX_SERVICES];
+
+// Files are numbered for the cursors: `generation` is the current file and
+// `generation - 1` the old one. Rotating moves both numbers on, so a cursor
+// keeps reading the file it started, under its new name.
+uint32_t generation = 1;
+uint32_t recordCount = 0;  // in the current file
+IncidentIndexEntry tail;   // of the block being filled
+
+void clearTail() {
+  tail.minStart = UINT32_MAX;
+  tail.maxEnd = 0;
+}
+
+void includeInEntry(IncidentIndexEntry& entry, const IncidentRecord& record) {
+  if (record.start < entry.minStart) entry.minStart = record.start;
+  if (record.end > entry.maxEnd) entry.maxEnd = record.end;
+}
+
+bool overlaps(const IncidentIndexEntry& entry, uint32_t from, uint32_t to) {
+  return entry.minStart <= to && entry.maxEnd >= from;
+}
+
+// Unix start of `incident`. Without the clock at the first failure it is
+// worked back from `unixTime`, 0 if that is unset as well.
+uint32_t startTime(const OpenIncident& incident, uint32_t nowMillis, uint32_t unixTime) {
+  if (incident.startUnix != 0) return incident.startUnix;
+  if (unixTime == 0) return 0;
+  return unixTime - (nowMillis - incident.startMillis) / 1000;
+}
+
+uint32_t currentUnixTime() {
+  return systemClock().unixTime();
+}
+
+size_t fileSize(const char* path) {
+  if (!LittleFS.exists(path)) return 0;
+  File file = LittleFS.open(path, "r");
+  if (!file) return 0;
+  size_t size = file.size();
+  file.close();
+  return size;
+}
+
+// Drops a partly written record at the end of the current file
+bool trimPartialRecord() {
+  File source = LittleFS.open(INCIDENT_FILE, "r");
+  File target = LittleFS.open(INCIDENT_TEMP_FILE, "w");
+  bool ok = source && target;
+
+  IncidentRecord record;
+  for (uint32_t i = 0; ok && i < recordCount; i++) {
+    ok = source.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record) &&
+      target.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record)) == sizeof(record);
+  }
+  source.close();
+  target.close();
+
+  if (ok) {
+    LittleFS.remove(INCIDENT_FILE);
+    ok = LittleFS.rename(INCIDENT_TEMP_FILE, INCIDENT_FILE);
+  } else {
+    LittleFS.remove(INCIDENT_TEMP_FILE);
+  }
+  return ok;
+}
+
+// Recomputes the index of the current file and the tail entry
+bool rebuildIndex() {
+  clearTail();
+  if (recordCount == 0) {
+    LittleFS.remove(INCIDENT_INDEX_FILE);
+    return true;
+  }
+
+  File data = LittleFS.open(INCIDENT_FILE, "r");
+  File index = LittleFS.open(INCIDENT_INDEX_FILE, "w");
+  if (!data || !index) return false;
+
+  bool ok = true;
+  IncidentRecord record;
+  for (uint32_t i = 0; ok && i < recordCount; i++) {
+    ok = data.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record);
+    if (!ok) break;
+    includeInEntry(tail, record);
+    if ((i + 1) % INCIDENT_INDEX_EVERY == 0) {
+      ok = index.write(reinterpret_cast<const uint8_t*>(&tail), sizeof(tail)) == sizeof(tail);
+      clearTail();
+    }
+  }
+  data.close();
+  index.close();
+  return ok;
+}
+
+// Reads the records of the block being filled into the tail entry
+bool loadTail() {
+  clearTail();
+  uint32_t first = recordCount / INCIDENT_INDEX_EVERY * INCIDENT_INDEX_EVERY;
+  if (first == recordCount) return true;
+
+  File data = LittleFS.open(INCIDENT_FILE, "r");
+  bool ok = data && data.seek(first * sizeof(IncidentRecord));
+  IncidentRecord record;
+  for (uint32_t i = first; ok && i < recordCount; i++) {
+    ok = data.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record);
+    if (ok) includeInEntry(tail, record);
+  }
+  data.close();
+  return ok;
+}
+
+// Moves the full current file aside. Caller holds incidentLock.
+bool rotate() {
+  LittleFS.remove(OLD_INCIDENT_FILE);
+  LittleFS.remove(OLD_INCIDENT_INDEX_FILE);
+  if (!LittleFS.rename(INCIDENT_FILE, OLD_INCIDENT_FILE)) return false;
+  // Without its index the old file is read in full, which still works
+  LittleFS.rename(INCIDENT_INDEX_FILE, OLD_INCIDENT_INDEX_FILE);
+  generation++;
+  recordCount = 0;
+  clearTail();
+  return true;
+}
+
+void append(const IncidentRecord& record) {
+  xSemaphoreTake(incidentLock, portMAX_DELAY);
+  bool ok = recordCount < INCIDENT_FILE_RECORDS || rotate();
+
+  if (ok) {
+    File data = LittleFS.open(INCIDENT_FILE, "a");
+    ok = data && data.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record)) == sizeof(record);
+    data.close();
+  }
+  if (ok) {
+    recordCount++;
+    includeInEntry(tail, record);
+    if (recordCount % INCIDENT_INDEX_EVERY == 0) {
+      File index = LittleFS.open(INCIDENT_INDEX_FILE, "a");
+      ok = index && index.write(reinterpret_cast<const uint8_t*>(&tail), sizeof(tail)) == sizeof(tail);
+      index.close();
+      clearTail();
+    }
+  }
+  xSemaphoreGive(incidentLock);
+
+  // A missing index entry is rebuilt at the next boot
+  if (!ok) {
+    logPrintf(LOG_ERROR, "Incident log: write failed");
+  }
+}
+
+}  // namespace
+
+IncidentCursor::IncidentCursor(uint32_t from, uint32_t to, uint64_t id)
+  : _from(from), _to(to), _id(id), _generation(generation - 1), _block(0), _count(0), _position(0),
+    _openSlot(-1) {}
+
+bool IncidentCursor::matches(const IncidentRecord& record) const {
+  return (_id == 0 || record.id == _id) && record.start <= _to && (record.end == 0 || record.end >= _from);
+}
+
+// Reads the next block that the index says can hold a match. Blocks of the
+// old file come first; a file rotated away meanwhile is skipped.
+bool IncidentCursor::loadBlock() {
+  bool loaded = false;
+  xSemaphoreTake(incidentLock, portMAX_DELAY);
+
+  while (!loaded && _generation <= generation) {
+    const char* dataPath = nullptr;
+    const char* indexPath = nullptr;
+    uint32_t records = 0;
+    if (_generation == generation) {
+      dataPath = INCIDENT_FILE;
+      indexPath = INCIDENT_INDEX_FILE;
+      records = recordCount;
+    } else if (_generation == generation - 1 && LittleFS.exists(OLD_INCIDENT_FILE)) {
+      dataPath = OLD_INCIDENT_FILE;
+      indexPath = OLD_INCIDENT_INDEX_FILE;
+      records = fileSize(OLD_INCIDENT_FILE) / sizeof(IncidentRecord);
+    }
+
+    uint32_t blocks = (records + INCIDENT_INDEX_EVERY - 1) / INCIDENT_INDEX_EVERY;
+    if (_block >= blocks) {
+      _generation++;
+      _block = 0;
+      continue;
+    }
+
+    // Skip blocks the index rules out; the block being filled has no entry
+    File index = LittleFS.exists(indexPath) ? LittleFS.open(indexPath, "r") : File();
+    uint32_t indexed = index ? index.size() / sizeof(IncidentIndexEntry) : 0;
+    if (index && _block < indexed) {
+      index.seek(_block * sizeof(IncidentIndexEntry));
+      IncidentIndexEntry entry;
+      while (_block < indexed &&
+             index.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry)) == sizeof(entry) &&
+             !overlaps(entry, _from, _to)) {
+        _block++;
+      }
+    }
+    index.close();
+    if (_block >= blocks) continue;
+
+    uint32_t first = _block * INCIDENT_INDEX_EVERY;
+    uint32_t count = records - first < INCIDENT_INDEX_EVERY ? records - first : INCIDENT_INDEX_EVERY;
+    File data = LittleFS.open(dataPath, "r");
+    size_t bytes = count * sizeof(IncidentRecord);
+    if (data && data.seek(first * sizeof(IncidentRecord)) &&
+        data.read(reinterpret_cast<uint8_t*>(_records), bytes) == bytes) {
+      _count = count;
+      _position = 0;
+      loaded = true;
+    }
+    data.close();
+    _block++;
+  }
+
+  xSemaphoreGive(incidentLock);
+  return loaded;
+}
+
+bool IncidentCursor::next(IncidentRecord& record) {
+  if (incidentLock == nullptr) return false;
+
+  while (_openSlot < 0) {
+    while (_position < _count) {
+      record = _records[_position++];
+      if (matches(record)) return true;
+    }
+    if (!loadBlock()) {
+      _openSlot = 0;
+    }
+  }
+
+  // Then the outages still going on
+  uint32_t nowMillis = millis();
+  uint32_t unixTime = currentUnixTime();
+  while (_openSlot < MAX_SERVICES) {
+    xSemaphoreTake(incidentLock, portMAX_DELAY);
+    OpenIncident incident = openIncidents[_openSlot++];
+    xSemaphoreGive(incidentLock);
+
+    if (!incident.down) continue;
+    memset(&record, 0, sizeof(record));
+    record.id = incident.id;
+    record.start = startTime(incident, nowMillis, unixTime);
+    record.end = 0;
+    record.failedProbes = incident.failedProbes;
+    record.firstError = incident.firstError;
+    if (record.start != 0 && matches(record)) return true;
+  }
+  return false;
+}
+
+bool initIncidentLog() {
+  if (incidentLock != nullptr) return true;
+
+  size_t size = fileSize(INCIDENT_FILE);
+  recordCount = size / sizeof(IncidentRecord);
+  if (size % sizeof(IncidentRecord) != 0 && !trimPartialRecord()) {
+    logPrintf(LOG_ERROR, "Incident log: failed to repair %s", INCIDENT_FILE);
+    return false;
+  }
+
+  // Entries are written after their block's last record, so a reset can
+  // leave the index one short. Rebuilding costs one read of the file.
+  bool indexed = fileSize(INCIDENT_INDEX_FILE) == recordCount / INCIDENT_INDEX_EVERY * sizeof(IncidentIndexEntry);
+  if (!(indexed ? loadTail() : rebuildIndex())) {
+    logPrintf(LOG_ERROR, "Incident log: failed to index %s", INCIDENT_FILE);
+    return false;
+  }
+
+  incidentLock = xSemaphoreCreateMutex();
+  if (incidentLock == nullptr) return false;
+
+  logPrintf(LOG_INFO, "Incident log: %u incidents in the current file", (unsigned)recordCount);
+  return true;
+}
+
+bool openIncidentState(uint16_t slot, uint64_t id, OpenIncidentState& state) {
+  if (slot >= MAX_SERVICES) return false;
+
+  if (incidentLock != nullptr) xSemaphoreTake(incidentLock, portMAX_DELAY);
+  OpenIncident incident = openIncidents[slot];
+  if (incidentLock != nullptr) xSemaphoreGive(incidentLock);
+
+  if (incident.id != id || !incident.failing) return false;
+  state.start = startTime(incident, millis(), currentUnixTime());
+  state.failedProbes = incident.failedProbes;
+  state.firstError = incident.firstError;
+  state.down = incident.down;
+  return true;
+}
+
+void restoreOpenIncident(uint16_t slot, uint64_t id, const OpenIncidentState& state) {
+  if (slot >= MAX_SERVICES) return;
+
+  OpenIncident incident = {};
+  incident.id = id;
+  incident.failing = true;
+  incident.down = state.down;
+  // Without a saved start the run is dated from the restart, the best
+  // estimate left
+  incident.startMillis = millis();
+  incident.startUnix = state.start;
+  incident.failedProbes = state.failedProbes;
+  incident.firstError = state.firstError;
+
+  if (incidentLock != nullptr) xSemaphoreTake(incidentLock, portMAX_DELAY);
+  openIncidents[slot] = incident;
+  if (incidentLock != nullptr) xSemaphoreGive(incidentLock);
+}
+
+void trackIncident(uint16_t slot, const Service& service, bool passed, uint8_t error, uint32_t nowMillis,
+    uint32_t unixTime) {
+  if (incidentLock == nullptr || slot >= MAX_SERVICES) return;
+
+  IncidentRecord closed;
+  bool close = false;
+
+  xSemaphoreTake(incidentLock, portMAX_DELAY);
+  OpenIncident& incident = openIncidents[slot];
+  if (incident.id != service.id) {
+    memset(&incident, 0, sizeof(incident));
+    incident.id = service.id;
+  }
+
+  if (!passed) {
+    if (!incident.failing) {
+      incident.failing = true;
+      incident.startMillis = nowMillis;
+      incident.startUnix = unixTime;
+      incident.failedProbes = 0;
+      incident.firstError = error;
+    }
+    incident.failedProbes++;
+    if (!service.isUp) {
+      incident.down = true;
+    }
+  } else if (incident.down && service.isUp) {
+    memset(&closed, 0, sizeof(closed));
+    closed.id = incident.id;
+    closed.start = startTime(incident, nowMillis, unixTime);
+    closed.end = unixTime;
+    closed.failedProbes = incident.failedProbes;
+    closed.firstError = incident.firstError;
+    close = true;
+    incident.failing = false;
+    incident.down = false;
+  } else if (!incident.down) {
+    // Failures that did not reach the threshold are not an incident
+    incident.failing = false;
+  }
+  xSemaphoreGive(incidentLock);
+
+  if (!close) return;
+  if (closed.end == 0) {
+    logPrintf(LOG_WARN, "Incident log: '%s' recovered before the clock was set, not recorded",
+      service.name.c_str());
+    return;
+  }
+  append(closed);
+}
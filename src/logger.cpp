@@ -0,0 +1,162 @@
+#include "logger.hpp"
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "config.hpp"
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+// Syslog severities for LogLevel, facility "user"
+const uint8_t SYSLOG_SEVERITY[] = {7, 6, 4, 3};
+const uint8_t SYSLOG_FACILITY_USER = 1;
+
+portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
+LogRecord* ring = nullptr;
+uint32_t nextSequence = 1;
+LoggerStats stats = {};
+TaskHandle_t writerTaskHandle = nullptr;
+WiFiUDP syslog;
+
+void sendSyslog(const LogRecord& record) {
+  if (strlen(SYSLOG_SERVER) == 0 || WiFi.status() != WL_CONNECTED) return;
+
+  int priority = SYSLOG_FACILITY_USER * 8 + SYSLOG_SEVERITY[record.level];
+  if (!syslog.beginPacket(SYSLOG_SERVER, SYSLOG_PORT)) {
+    stats.syslogFailed++;
+    return;
+  }
+  syslog.printf("<%d>uptime-monitor: %s", priority, record.text);
+  if (!syslog.endPacket()) {
+    stats.syslogFailed++;
+  }
+}
+
+// Writes everything logged since the last pass. Only this task does I/O.
+void writerTask(void* parameter) {
+  uint32_t next = 1;
+  LogRecord record;
+  char line[160];
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    while (next <= logNewestSequence()) {
+      if (!readLogRecord(next, record)) {
+        // Overwritten while we were blocked on Serial
+        uint32_t oldest = logOldestSequence();
+        portENTER_CRITICAL(&logLock);
+        stats.dropped += oldest - next;
+        portEXIT_CRITICAL(&logLock);
+        next = oldest;
+        continue;
+      }
+
+      formatLogRecord(record, line, sizeof(line));
+      Serial.print(line);
+      sendSyslog(record);
+      next++;
+    }
+  }
+}
+
+}  // namespace
+
+bool initLogger() {
+  if (ring != nullptr) return true;
+
+  LogRecord* records = static_cast<LogRecord*>(ps_malloc(sizeof(LogRecord) * LOG_CAPACITY));
+  if (records == nullptr) {
+    records = static_cast<LogRecord*>(malloc(sizeof(LogRecord) * LOG_CAPACITY));
+  }
+  if (records == nullptr) {
+    Serial.println("Logger: ring allocation failed, logging to Serial directly");
+    return false;
+  }
+  memset(records, 0, sizeof(LogRecord) * LOG_CAPACITY);
+
+  if (xTaskCreate(writerTask, "log", 4096, nullptr, tskIDLE_PRIORITY + 1, &writerTaskHandle) != pdPASS) {
+    Serial.println("Logger: failed to start writer task, logging to Serial directly");
+    free(records);
+    return false;
+  }
+
+  ring = records;
+  return true;
+}
+
+void logPrintf(LogLevel level, const char* format, ...) {
+  char text[sizeof(LogRecord::text)];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+
+  if (ring == nullptr) {
+    Serial.println(text);
+    return;
+  }
+
+  portENTER_CRITICAL(&logLock);
+  uint32_t sequence = nextSequence++;
+  LogRecord& record = ring[sequence % LOG_CAPACITY];
+  record.sequence = sequence;
+  record.millis = millis();
+  record.level = level;
+  memcpy(record.text, text, sizeof(text));
+  stats.written++;
+  portEXIT_CRITICAL(&logLock);
+
+  xTaskNotifyGive(writerTaskHandle);
+}
+
+uint32_t logNewestSequence() {
+  portENTER_CRITICAL(&logLock);
+  uint32_t newest = nextSequence - 1;
+  portEXIT_CRITICAL(&logLock);
+  return newest;
+}
+
+uint32_t logOldestSequence() {
+  portENTER_CRITICAL(&logLock);
+  uint32_t oldest = nextSequence > LOG_CAPACITY ? nextSequence - LOG_CAPACITY : 1;
+  portEXIT_CRITICAL(&logLock);
+  return oldest;
+}
+
+bool readLogRecord(uint32_t sequence, LogRecord& record) {
+  if (ring == nullptr || sequence == 0) return false;
+
+  portENTER_CRITICAL(&logLock);
+  bool held = sequence < nextSequence && nextSequence - sequence <= LOG_CAPACITY;
+  if (held) {
+    record = ring[sequence % LOG_CAPACITY];
+  }
+  portEXIT_CRITICAL(&logLock);
+  return held;
+}
+
+size_t formatLogRecord(const LogRecord& record, char* out, size_t size) {
+  int length = snprintf(out, size, "%lu %s %s\n",
+    (unsigned long)record.millis, LEVEL_NAMES[record.level], record.text);
+  if (length < 0) return 0;
+  if ((size_t)length >= size) {
+    // Keep the line terminated even when truncated
+    length = size - 1;
+    out[length - 1] = '\n';
+  }
+  return length;
+}
+
+LoggerStats loggerStats() {
+  portENTER_CRITICAL(&logLock);
+  LoggerStats copy = stats;
+  portEXIT_CRITICAL(&logLock);
+  return copy;
+}
@@ -6,14 +6,44 @@
 #include <FS.h>
 #include <LittleFS.h>
 #include <HTTPClient.h>
-#include <ESP32Ping.h>
 #include <mbedtls/base64.h>
+#include <memory>
+#include <vector>
+#include <driver/gpio.h>
+#include <soc/gpio_periph.h>
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 #include <lgfx/v1/platforms/esp32s3/Panel_RGB.hpp>
 #include <lgfx/v1/platforms/esp32s3/Bus_RGB.hpp>
 
+#include "check_runner.hpp"
 #include "config.hpp"
+#include "diagnostics.hpp"
+#include "display_events.hpp"
+#include "display_ui.hpp"
+#include "hal_esp32.hpp"
+#include "history_chart.hpp"
+#include "http_metrics.hpp"
+#include "http_probe.hpp"
+#include "incident_log.hpp"
+#include "logger.hpp"
+#include "power.hpp"
+#include "probe_simulator.hpp"
+#include "probe_trace.hpp"
+#include "runtime_state.hpp"
+#include "series_store.hpp"
+#include "service.hpp"
+#include "service_codec.hpp"
+#include "service_commands.hpp"
+#include "service_engine.hpp"
+#include "service_history.hpp"
+#include "service_import.hpp"
+#include "service_rollup.hpp"
+#include "service_snapshot.hpp"
+#include "service_table.hpp"
+#include "status_grid.hpp"
+#include "touch_input.hpp"
+#include "wifi_link.hpp"
 
 // --- Display and touch configuration ---
 #ifndef TFT_WIDTH
@@ -48,6 +78,10 @@
 #define TFT_RST_PIN -1  // No hardware reset pin - ESP32-4848S040 uses software reset via SPI init commands
 #endif
 
+#ifndef TFT_VSYNC_PIN
+#define TFT_VSYNC_PIN 17  // RGB bus VSYNC; also sampled to start pushes on vertical blank
+#endif
+
 #ifndef TFT_BL_PIN
 #define TFT_BL_PIN 38   // Backlight control pin for ESP32-4848S040
 #endif
@@ -169,7 +203,7 @@ class LGFX : public lgfx::LGFX_Device {
 
       // Control / timing pins
       cfg.pin_henable = GPIO_NUM_18;  // DE    -> IO18
-      cfg.pin_vsync   = GPIO_NUM_17;  // VSYNC -> IO17
+      cfg.pin_vsync   = TFT_VSYNC_PIN;  // VSYNC -> IO17
       cfg.pin_hsync   = GPIO_NUM_16;  // HSYNC -> IO16
       cfg.pin_pclk    = GPIO_NUM_21;  // PCLK  -> IO21
 
@@ -233,128 +267,293 @@ bool touchReady = false;
 int currentServiceIndex = 0;
 bool displayNeedsUpdate = true;
 unsigned long lastDisplaySwitch = 0;
+unsigned long lastDisplayRefresh = 0;
 const unsigned long DISPLAY_ROTATION_INTERVAL = 8000;
 
-// Service types
-// Right now the behavior for each is rudimentary
-// However, you can use this to expand and add services with more complex checks
-enum ServiceType {
-  TYPE_HOME_ASSISTANT,
-  TYPE_JELLYFIN,
-  TYPE_HTTP_GET,
-  TYPE_PING
+// Display state above and below is owned by the render task, which reads
+// services from the published snapshot and is woken by display events.
+#ifndef DISPLAY_MAX_FPS
+#define DISPLAY_MAX_FPS 30
+#endif
+
+#ifndef DISPLAY_TASK_CORE
+#define DISPLAY_TASK_CORE 1  // WiFi and lwIP run on core 0
+#endif
+
+const unsigned long DISPLAY_FRAME_INTERVAL = 1000 / DISPLAY_MAX_FPS;
+const TickType_t DISPLAY_IDLE_TICKS = pdMS_TO_TICKS(100);  // rotation and refresh granularity
+const TickType_t VSYNC_TIMEOUT_TICKS = pdMS_TO_TICKS(40);
+TaskHandle_t displayTaskHandle = nullptr;
+bool vsyncReady = false;
+bool frameSynced = false;
+uint32_t frameRequestedMicros = 0;  // oldest unrendered event, 0 if none
+uint32_t touchRequestedMicros = 0;  // oldest unrendered gesture, 0 if none
+uint32_t renderedSnapshotVersion = 0;
+FrameStats frameStats = {};
+
+// Backlight policy: full brightness while in use, dimmed after
+// DISPLAY_DIM_AFTER_MS without a touch and off after DISPLAY_OFF_AFTER_MS
+// (0 disables either step). A touch or a service going DOWN lights it again.
+#ifndef DISPLAY_BRIGHTNESS
+#define DISPLAY_BRIGHTNESS 200
+#endif
+
+#ifndef DISPLAY_DIM_BRIGHTNESS
+#define DISPLAY_DIM_BRIGHTNESS 40
+#endif
+
+#ifndef DISPLAY_DIM_AFTER_MS
+#define DISPLAY_DIM_AFTER_MS 60000
+#endif
+
+#ifndef DISPLAY_OFF_AFTER_MS
+#define DISPLAY_OFF_AFTER_MS 300000
+#endif
+
+// How often the touch task samples while light sleep has the screen off
+const TickType_t TOUCH_SLEEP_POLL_TICKS = pdMS_TO_TICKS(200);
+uint8_t backlightLevel = 0;
+unsigned long lastUserActivity = 0;
+int shownDownCount = 0;
+
+// Start on the status wall instead of the single-service screen
+#ifndef DISPLAY_START_IN_GRID
+#define DISPLAY_START_IN_GRID 0
+#endif
+
+enum DisplayMode {
+  DISPLAY_MODE_DETAIL,
+  DISPLAY_MODE_GRID,
+  DISPLAY_MODE_DIAG
 };
 
-// Service structure
-struct Service {
-  String id;
-  String name;
-  ServiceType type;
-  String host;
-  int port;
-  String path;
-  String expectedResponse;
-  int checkInterval;
-  int passThreshold;      // Number of consecutive passes required to mark as UP
-  int failThreshold;      // Number of consecutive fails required to mark as DOWN
-  int consecutivePasses;  // Current count of consecutive passes
-  int consecutiveFails;   // Current count of consecutive fails
-  bool isUp;
-  unsigned long lastCheck;
-  unsigned long lastUptime;
-  String lastError;
-  int secondsSinceLastCheck;
+DisplayMode displayMode = DISPLAY_START_IN_GRID ? DISPLAY_MODE_GRID : DISPLAY_MODE_DETAIL;
+int gridPage = 0;
+StatusGrid statusGrid;
+
+// Body area between the header and the footer widgets
+const int16_t DISPLAY_BODY_TOP = 40;
+const int16_t DISPLAY_BODY_HEIGHT = TFT_HEIGHT - 100;
+const int16_t CHART_X = 86;  // charts start right of their label widgets
+
+WidgetScreen screen;
+int headerWidget;
+int titleWidget;
+int statusWidget;
+int typeWidget;
+int hostWidget;
+int lastCheckWidget;
+int errorWidget;
+int footerWidget;
+int rotationWidget;
+int latencyLabelWidget;
+int uptimeLabelWidget;
+LatencySparkline latencyChart;
+UptimeBar uptimeBar;
+
+// Owned by the loop() task. Other tasks read the published snapshot and
+// request changes through the service command queue.
+ServiceTable serviceTable;
+bool serviceSnapshotDirty = true;
+
+// What the checks run on; see hal.hpp
+class ScreenDisplay : public StatusDisplay {
+ public:
+  void servicesChanged(const ServiceTable& table) override;
 };
 
-// Store up to 20 services
-const int MAX_SERVICES = 20;
-Service services[MAX_SERVICES];
-int serviceCount = 0;
+WiFiNetwork wifiNetwork;
+BoundedHttpClient httpClient(wifiNetwork, systemClock());
+IcmpPinger icmpPinger;
+ScreenDisplay screenDisplay;
+CheckPlatform checkPlatform = {systemClock(), wifiNetwork, httpClient, icmpPinger, screenDisplay};
+
+// Longest loop() sleeps without a check falling due, so config edits made
+// while every interval is long still get a prompt first check
+const unsigned long MAX_LOOP_WAIT_MS = 60000;
+
+const size_t MAX_SERVICE_BYTES = 4 * 1024;
+const size_t MAX_BATCH_BYTES = 32 * 1024;
+
+// Alerts raised while WiFi is down, sent once it is back. Beyond this many
+// the oldest are dropped.
+#ifndef ALERT_QUEUE_SIZE
+#define ALERT_QUEUE_SIZE 16
+#endif
+
+struct PendingAlert {
+  String title;
+  String message;
+  String tags;
+  uint32_t raisedMillis;
+};
+
+// Owned by the loop() task
+PendingAlert pendingAlerts[ALERT_QUEUE_SIZE];
+int pendingAlertFirst = 0;
+int pendingAlertCount = 0;
+uint32_t droppedAlerts = 0;
+
+// Import in progress, if any. Only touched from AsyncTCP callbacks.
+const size_t MAX_IMPORT_BYTES = 512 * 1024;
+ServiceImportParser* importSession = nullptr;
+AsyncWebServerRequest* importRequest = nullptr;
 
 // prototype declarations
-void initWiFi();
+void handleWifiConnected();
+void sendAlert(const String& title, const String& message, const String& tags);
+void sendPendingAlerts();
 void initWebServer();
 void initFileSystem();
 void initDisplay();
 void loadServices();
+bool loadServicesFromJson();
 void saveServices();
-String generateServiceId();
+void applyServiceCommands();
 void checkServices();
+void recordCheck(Service& service, const CheckOutcome& outcome);
 void sendOfflineNotification(const Service& service);
 void sendOnlineNotification(const Service& service);
 void sendSmtpNotification(const String& title, const String& message);
-bool checkHomeAssistant(Service& service);
-bool checkJellyfin(Service& service);
-bool checkHttpGet(Service& service);
-bool checkPing(Service& service);
 String getWebPage();
-String getServiceTypeString(ServiceType type);
 String base64Encode(const String& input);
 bool readSmtpResponse(WiFiClient& client, int expectedCode);
 bool sendSmtpCommand(WiFiClient& client, const String& command, int expectedCode);
-void renderServiceOnDisplay();
+void publishServicesIfDirty();
+void writeTimingHistogram(JsonObject out, const TimingHistogram& histogram);
+void initDisplayWidgets();
+bool initVsyncInterrupt();
+void syncFrameToVsync();
+void displayTask(void* parameter);
+void requestFrame(uint32_t requestedMicros);
+void notifyTouchGesture();
+bool handleTouchGesture(const TouchGesture& gesture, int serviceCount);
+void stepDisplay(int direction, int serviceCount);
+void setDisplayMode(DisplayMode mode);
+void renderServiceOnDisplay(const ServiceTable& table);
+void renderStatusGrid(const ServiceTable& table);
+void renderDiagnostics();
+void renderHistoryCharts(const ServiceHistory* history, uint64_t id);
+String slaLine(uint16_t slot, uint64_t id);
 void handleDisplayLoop();
+void setBacklight(uint8_t level);
+void updateBacklight(unsigned long now);
 
+// Nothing here waits on the network. The services and their saved state
+// come first so the first frame shows them; WiFi, SNTP and the web server
+// then come up from loop() (see handleWifiConnected()).
 void setup() {
   Serial.begin(115200);
-  delay(1000);
 
   Serial.println("Starting ESP32 Uptime Monitor...");
+  initLogger();
 
   // Initialize filesystem
   initFileSystem();
 
-  // Initialize WiFi
-  initWiFi();
-
   // Load saved services
   loadServices();
-
-  // Initialize web server
-  initWebServer();
+#if SIMULATE_PROBES
+  Serial.printf("Probe simulation: %d services generated\n",
+    addSimulatedServices(serviceTable, SIMULATED_SERVICE_COUNT));
+#endif
+  int restored = restoreRuntimeState(serviceTable);
+  Serial.printf("Restored the state of %d of %d services\n", restored, serviceTable.count);
+  initServiceHistory();
+  initServiceRollups();
+  publishServiceSnapshot(serviceTable, appliedServiceCommands());
+  serviceSnapshotDirty = false;
+  initServiceCommandQueue(serviceTable.count);
+  initDisplayEventQueue();
 
   // Initialize display and touch controller (if connected)
   initDisplay();
 
-  Serial.println("System ready!");
-  Serial.print("Access web interface at: http://");
-  Serial.println(WiFi.localIP());
+  beginWifiLink();
+  initPowerManagement();
+
+  if (initProbeTrace()) {
+    traceServiceConfigs(serviceTable, millis());
+    traceRestoredState(serviceTable, millis());
+  }
+  initIncidentLog();
+  if (initSeriesStore()) {
+    pruneSeriesStore(serviceTable);
+  }
+
+  // Routes only; the server starts listening once WiFi is up
+  initWebServer();
+
+  Serial.printf("Setup done in %lu ms, connecting to WiFi in the background\n", millis());
 }
 
 void loop() {
-  static unsigned long lastCheckTime = 0;
-  unsigned long currentTime = millis();
+  uint32_t iterationStart = micros();
+  switch (updateWifiLink(millis())) {
+    case LINK_EVENT_CONNECTED:
+      handleWifiConnected();
+      break;
+    case LINK_EVENT_LOST:
+      logPrintf(LOG_WARN, "WiFi lost, checks paused");
+      break;
+    default:
+      break;
+  }
+  if (bootStageMillis(BOOT_CLOCK) == 0 && time(nullptr) >= CLOCK_VALID_AFTER) {
+    recordBootStage(BOOT_CLOCK);
+  }
+  applyServiceCommands();
 
-  // Check services every 5 seconds
-  if (currentTime - lastCheckTime >= 5000) {
+  // Without the link every probe would fail and mark its service DOWN
+  if (wifiLinkUp() && msUntilNextCheck(serviceTable, millis(), MAX_LOOP_WAIT_MS) == 0) {
+    uint32_t checkStart = micros();
     checkServices();
-    lastCheckTime = currentTime;
+    recordCheckRound(micros() - checkStart);
   }
-
-  handleDisplayLoop();
-
-  delay(10);
+  flushProbeTrace(millis());
+  flushSeriesStore(millis());
+  saveRuntimeStateIfDue(serviceTable, millis());
+
+  // Retried every iteration until no reader still holds the back buffer
+  publishServicesIfDirty();
+  recordLoopIteration(micros() - iterationStart);
+
+  // Block until the next check falls due or the web server queues a change.
+  // With every task blocked the chip can light-sleep here (see power.hpp).
+  // While the link is down checks wait for it, and it is polled instead.
+  unsigned long wait = serviceSnapshotDirty ? 10
+    : wifiLinkUp() ? msUntilNextCheck(serviceTable, millis(), MAX_LOOP_WAIT_MS)
+    : WIFI_LINK_POLL_MS;
+  if (wait == 0) return;
+
+  unsigned long idleStart = millis();
+  waitForServiceCommand(pdMS_TO_TICKS(wait));
+  recordLoopIdle(millis() - idleStart);
 }
 
-void initWiFi() {
-  Serial.println("Connecting to WiFi...");
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+// The first connection finishes the boot: SNTP and the web server start,
+// and the first checks are spread over their intervals. After a reconnect,
+// the checks that fell due while the link was down are spread the same way.
+// Either way, alerts held back meanwhile go out.
+void handleWifiConnected() {
+  static bool started = false;
+  if (!started) {
+    started = true;
+    recordBootStage(BOOT_WIFI);
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 30) {
-    delay(1000);
-    Serial.print(".");
-    attempts++;
-  }
+    // The clock is only needed for stored history; SNTP keeps retrying in the background
+    configTime(0, 0, NTP_SERVER);
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nWiFi connected!");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
+    server.begin();
+    recordBootStage(BOOT_SERVER);
+    logPrintf(LOG_INFO, "Web interface at http://%s/", WiFi.localIP().toString().c_str());
+
+    spreadFirstChecks(serviceTable, millis());
   } else {
-    Serial.println("\nFailed to connect to WiFi!");
+    spreadDueChecks(serviceTable, millis());
   }
+
+  sendPendingAlerts();
 }
 
 void initFileSystem() {
@@ -406,9 +605,8 @@ void initDisplay() {
   display.setTextSize(2);
   display.setTextColor(TFT_WHITE, TFT_BLACK);
 
-  if (TFT_BL_PIN >= 0) {
-    display.setBrightness(200);
-  }
+  setBacklight(DISPLAY_BRIGHTNESS);
+  lastUserActivity = millis();
 
   // Touch controller is now initialized as part of the LGFX class (GT911)
   // Check if touch is available through the display panel
@@ -416,76 +614,149 @@ void initDisplay() {
 
   if (touchReady) {
     Serial.println("Touch controller (GT911) ready");
+    if (!startTouchInput(&display, TOUCH_INT_PIN, DISPLAY_TASK_CORE, notifyTouchGesture)) {
+      Serial.println("Failed to start touch task");
+      touchReady = false;
+    }
   } else {
     Serial.println("Touch controller not detected");
   }
 
   if (displayReady) {
-    display.fillScreen(TFT_BLACK);
-    renderServiceOnDisplay();
+    initDisplayWidgets();
+    screen.begin(&display, TFT_BLACK);
+    statusGrid.begin(&display, 0, DISPLAY_BODY_TOP, TFT_WIDTH, DISPLAY_BODY_HEIGHT, TFT_BLACK);
+    latencyChart.begin(&display, CHART_X, 304, TFT_WIDTH - CHART_X - 10, 70, TFT_BLACK);
+    uptimeBar.begin(&display, CHART_X, 382, TFT_WIDTH - CHART_X - 10, 28, TFT_BLACK);
+    setDisplayMode(displayMode);
     lastDisplaySwitch = millis();
+
+    vsyncReady = initVsyncInterrupt();
+    if (vsyncReady) {
+      screen.setBeforePush(syncFrameToVsync);
+      statusGrid.setBeforePush(syncFrameToVsync);
+      latencyChart.setBeforePush(syncFrameToVsync);
+      uptimeBar.setBeforePush(syncFrameToVsync);
+    } else {
+      Serial.println("VSYNC interrupt unavailable, pushing frames unsynchronised");
+    }
+
+    // Above the loop() task's priority so slow probes never hold up a frame
+    if (xTaskCreatePinnedToCore(displayTask, "display", 8192, nullptr, 2,
+                                &displayTaskHandle, DISPLAY_TASK_CORE) != pdPASS) {
+      Serial.println("Failed to start display task");
+      displayReady = false;
+    }
   } else {
     Serial.println("Display initialization failed");
+    setDisplayPowered(false);
   }
 }
 
 void initWebServer() {
 
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/", HTTP_GET, trackRoute("GET /", [](AsyncWebServerRequest *request) {
     request->send(200, "text/html", getWebPage());
-  });
+  }));
 
   // get services
-  server.on("/api/services", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/api/services", HTTP_GET, trackRoute("GET /api/services", [](AsyncWebServerRequest *request) {
     JsonDocument doc;
     JsonArray array = doc["services"].to<JsonArray>();
 
     unsigned long currentTime = millis();
+    ServiceSnapshotGuard snapshot;
 
-    for (int i = 0; i < serviceCount; i++) {
-      if (services[i].lastCheck > 0) {
-        services[i].secondsSinceLastCheck = (currentTime - services[i].lastCheck) / 1000;
-      } else {
-        services[i].secondsSinceLastCheck = -1; // Never checked
+    for (int i = 0; i < snapshot->table.count; i++) {
+      const Service& service = snapshot->table.at(i);
+      int secondsSinceLastCheck = -1; // Never checked
+      if (!neverChecked(service)) {
+        secondsSinceLastCheck = (currentTime - service.lastCheck) / 1000;
       }
 
       JsonObject obj = array.add<JsonObject>();
-      obj["id"] = services[i].id;
-      obj["name"] = services[i].name;
-      obj["type"] = getServiceTypeString(services[i].type);
-      obj["host"] = services[i].host;
-      obj["port"] = services[i].port;
-      obj["path"] = services[i].path;
-      obj["expectedResponse"] = services[i].expectedResponse;
-      obj["checkInterval"] = services[i].checkInterval;
-      obj["passThreshold"] = services[i].passThreshold;
-      obj["failThreshold"] = services[i].failThreshold;
-      obj["consecutivePasses"] = services[i].consecutivePasses;
-      obj["consecutiveFails"] = services[i].consecutiveFails;
-      obj["isUp"] = services[i].isUp;
-      obj["secondsSinceLastCheck"] = services[i].secondsSinceLastCheck;
-      obj["lastError"] = services[i].lastError;
+      obj["id"] = formatServiceId(service.id);
+      obj["name"] = service.name;
+      obj["type"] = getServiceTypeString(service.type);
+      obj["host"] = service.host;
+      obj["port"] = service.port;
+      obj["path"] = service.path;
+      obj["expectedResponse"] = service.expectedResponse;
+      obj["checkInterval"] = service.checkInterval;
+      obj["effectiveIntervalMs"] = checkIntervalMs(service);
+      obj["passThreshold"] = service.passThreshold;
+      obj["failThreshold"] = service.failThreshold;
+      obj["consecutivePasses"] = service.consecutivePasses;
+      obj["consecutiveFails"] = service.consecutiveFails;
+      obj["isUp"] = service.isUp;
+      obj["secondsSinceLastCheck"] = secondsSinceLastCheck;
+      obj["lastError"] = service.lastError;
+      obj["latency"] = service.lastLatency;
+
+      const ServiceRollup* rollup = serviceRollup(snapshot->table.order[i], service.id);
+      if (rollup != nullptr) {
+        JsonObject sla = obj["sla"].to<JsonObject>();
+        for (int w = 0; w < WINDOW_COUNT; w++) {
+          RollupSummary summary = summarizeRollup(*rollup, (RollupWindow)w);
+          JsonObject window = sla[rollupWindowName((RollupWindow)w)].to<JsonObject>();
+          window["checks"] = summary.checks;
+          if (summary.availability >= 0) {
+            window["availability"] = serialized(String(summary.availability, 3));
+          } else {
+            window["availability"] = nullptr;
+          }
+          window["meanMs"] = summary.meanMs;
+          window["p50Ms"] = summary.p50Ms;
+          window["p95Ms"] = summary.p95Ms;
+          window["p99Ms"] = summary.p99Ms;
+        }
+      }
     }
 
     String response;
     serializeJson(doc, response);
     request->send(200, "application/json", response);
-  });
+  }));
 
   // add service
-  server.on("/api/services", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL,
-    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      if (!ensureAuthenticated(request)) {
+  server.on("/api/services", HTTP_POST, trackRoute("POST /api/services", [](AsyncWebServerRequest *request) {}), NULL,
+    trackRouteBody([](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      if (index == 0) {
+        if (!ensureAuthenticated(request)) {
+          return;
+        }
+
+        if (freeServiceSlots() <= 0) {
+          request->send(400, "application/json", "{\"error\":\"Maximum services reached\"}");
+          return;
+        }
+
+        if (total > MAX_SERVICE_BYTES) {
+          request->send(400, "application/json", "{\"error\":\"Payload too large\"}");
+          return;
+        }
+
+        // Freed by the request when it is destroyed
+        request->_tempObject = malloc(total);
+        if (request->_tempObject == nullptr) {
+          request->send(503, "application/json", "{\"error\":\"Out of memory\"}");
+          return;
+        }
+      }
+
+      if (request->_tempObject == nullptr) {
         return;
       }
 
-      if (serviceCount >= MAX_SERVICES) {
-        request->send(400, "application/json", "{\"error\":\"Maximum services reached\"}");
+      memcpy(static_cast<uint8_t*>(request->_tempObject) + index, data, len);
+      if (index + len < total) {
         return;
       }
 
       JsonDocument doc;
-      DeserializationError error = deserializeJson(doc, data, len);
+      DeserializationError error = deserializeJson(doc, static_cast<const char*>(request->_tempObject), total);
+      free(request->_tempObject);
+      request->_tempObject = nullptr;
 
       if (error) {
         request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
@@ -496,16 +767,7 @@ void initWebServer() {
       newService.id = generateServiceId();
       newService.name = doc["name"].as<String>();
 
-      String typeStr = doc["type"].as<String>();
-      if (typeStr == "home_assistant") {
-        newService.type = TYPE_HOME_ASSISTANT;
-      } else if (typeStr == "jellyfin") {
-        newService.type = TYPE_JELLYFIN;
-      } else if (typeStr == "http_get") {
-        newService.type = TYPE_HTTP_GET;
-      } else if (typeStr == "ping") {
-        newService.type = TYPE_PING;
-      } else {
+      if (!parseServiceType(doc["type"].as<String>(), newService.type)) {
         request->send(400, "application/json", "{\"error\":\"Invalid service type\"}");
         return;
       }
@@ -524,75 +786,722 @@ void initWebServer() {
       if (failThreshold < 1) failThreshold = 1;
       newService.failThreshold = failThreshold;
 
-      newService.consecutivePasses = 0;
-      newService.consecutiveFails = 0;
-      newService.isUp = false;
-      newService.lastCheck = 0;
-      newService.lastUptime = 0;
-      newService.lastError = "";
-      newService.secondsSinceLastCheck = -1;
+      resetServiceRuntime(newService);
 
-      services[serviceCount++] = newService;
-      saveServices();
+      ServiceCommand* command = new ServiceCommand();
+      command->type = CMD_ADD_SERVICES;
+      command->services.push_back(newService);
+      EnqueueResult queued = enqueueServiceCommand(command);
+      if (queued != ENQUEUE_OK) {
+        delete command;
+        if (queued == ENQUEUE_NO_ROOM) {
+          request->send(400, "application/json", "{\"error\":\"Maximum services reached\"}");
+        } else {
+          request->send(503, "application/json", "{\"error\":\"Busy, try again\"}");
+        }
+        return;
+      }
 
       JsonDocument response;
       response["success"] = true;
-      response["id"] = newService.id;
+      response["id"] = formatServiceId(newService.id);
 
       String responseStr;
       serializeJson(response, responseStr);
       request->send(200, "application/json", responseStr);
-    }
+    })
   );
 
   // delete service
-  server.on("/api/services/*", HTTP_DELETE, [](AsyncWebServerRequest *request) {
+  server.on("/api/services/*", HTTP_DELETE, trackRoute("DELETE /api/services/*", [](AsyncWebServerRequest *request) {
     if (!ensureAuthenticated(request)) {
       return;
     }
 
     String path = request->url();
-    String serviceId = path.substring(path.lastIndexOf('/') + 1);
+    uint64_t serviceId = 0;
+    bool found = parseServiceId(path.substring(path.lastIndexOf('/') + 1), serviceId);
 
-    int foundIndex = -1;
-    for (int i = 0; i < serviceCount; i++) {
-      if (services[i].id == serviceId) {
-        foundIndex = i;
-        break;
-      }
+    if (found) {
+      ServiceSnapshotGuard snapshot;
+      found = snapshot->table.find(serviceId) != nullptr;
     }
 
-    if (foundIndex == -1) {
+    if (!found) {
       request->send(404, "application/json", "{\"error\":\"Service not found\"}");
       return;
     }
 
-    // Shift services array
-    for (int i = foundIndex; i < serviceCount - 1; i++) {
-      services[i] = services[i + 1];
+    ServiceCommand* command = new ServiceCommand();
+    command->type = CMD_DELETE_SERVICE;
+    command->serviceId = serviceId;
+    if (enqueueServiceCommand(command) != ENQUEUE_OK) {
+      delete command;
+      request->send(503, "application/json", "{\"error\":\"Busy, try again\"}");
+      return;
     }
-    serviceCount--;
 
-    saveServices();
     request->send(200, "application/json", "{\"success\":true}");
-  });
+  }));
+
+  // apply several add/update/delete operations with a single save
+  server.on("/api/batch", HTTP_POST, trackRoute("POST /api/batch", [](AsyncWebServerRequest *request) {}), NULL,
+    trackRouteBody([](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      if (index == 0) {
+        if (!ensureAuthenticated(request)) {
+          return;
+        }
+
+        if (total > MAX_BATCH_BYTES) {
+          request->send(400, "application/json", "{\"error\":\"Payload too large\"}");
+          return;
+        }
+
+        // Freed by the request when it is destroyed
+        request->_tempObject = malloc(total);
+        if (request->_tempObject == nullptr) {
+          request->send(503, "application/json", "{\"error\":\"Out of memory\"}");
+          return;
+        }
+      }
+
+      if (request->_tempObject == nullptr) {
+        return;
+      }
+
+      memcpy(static_cast<uint8_t*>(request->_tempObject) + index, data, len);
+      if (index + len < total) {
+        return;
+      }
+
+      JsonDocument doc;
+      DeserializationError jsonError = deserializeJson(doc, static_cast<const char*>(request->_tempObject), total);
+      free(request->_tempObject);
+      request->_tempObject = nullptr;
+
+      if (jsonError) {
+        request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+      }
+
+      ServiceCommand* command = new ServiceCommand();
+      command->type = CMD_APPLY_BATCH;
+
+      String error;
+      bool valid;
+      {
+        ServiceSnapshotGuard snapshot;
+        valid = parseServiceBatch(doc["operations"].as<JsonArrayConst>(), snapshot->table, command->operations, error);
+        command->requireVersion = true;
+        command->configVersion = snapshot->configVersion;
+      }
+
+      if (!valid) {
+        delete command;
+        JsonDocument response;
+        response["error"] = error;
+
+        String responseStr;
+        serializeJson(response, responseStr);
+        request->send(400, "application/json", responseStr);
+        return;
+      }
+
+      JsonDocument response;
+      response["success"] = true;
+      JsonArray ids = response["added"].to<JsonArray>();
+      for (const ServiceOperation& operation : command->operations) {
+        if (operation.type == OP_ADD) {
+          ids.add(formatServiceId(operation.id));
+        }
+      }
+      response["operations"] = command->operations.size();
+
+      // Accepted only if nothing changed since the snapshot it was validated
+      // and merged against, so the writer applies it as checked
+      EnqueueResult queued = enqueueServiceCommand(command);
+      if (queued != ENQUEUE_OK) {
+        delete command;
+        if (queued == ENQUEUE_CONFLICT) {
+          request->send(409, "application/json", "{\"error\":\"Services changed meanwhile, try again\"}");
+        } else if (queued == ENQUEUE_NO_ROOM) {
+          request->send(400, "application/json", "{\"error\":\"Maximum services reached\"}");
+        } else {
+          request->send(503, "application/json", "{\"error\":\"Busy, try again\"}");
+        }
+        return;
+      }
+
+      String responseStr;
+      serializeJson(response, responseStr);
+      request->send(200, "application/json", responseStr);
+    })
+  );
+
+  // display pipeline counters, for tuning the renderer
+  server.on("/api/display", HTTP_GET, trackRoute("GET /api/display", [](AsyncWebServerRequest *request) {
+    const DisplayStats& stats = screen.stats();
+
+    JsonDocument doc;
+    doc["ready"] = displayReady;
+    doc["frames"] = stats.frames;
+    doc["pushedPixels"] = stats.pushedPixels;
+    doc["lastFramePixels"] = stats.lastFramePixels;
+    doc["lastFrameMicros"] = stats.lastFrameMicros;
+    doc["maxFrameMicros"] = stats.maxFrameMicros;
+    doc["avgFrameMicros"] = stats.frames > 0 ? (uint32_t)(stats.totalFrameMicros / stats.frames) : 0;
+
+    // whole frames of the render task, including the wait for vertical blank
+    JsonObject frame = doc["renderTask"].to<JsonObject>();
+    frame["maxFps"] = DISPLAY_MAX_FPS;
+    frame["core"] = DISPLAY_TASK_CORE;
+    frame["vsync"] = vsyncReady;
+    frame["frames"] = frameStats.frames;
+    frame["lastFrameMicros"] = frameStats.lastFrameMicros;
+    frame["maxFrameMicros"] = frameStats.maxFrameMicros;
+    frame["avgFrameMicros"] = frameStats.frames > 0 ? (uint32_t)(frameStats.totalFrameMicros / frameStats.frames) : 0;
+    frame["lastVsyncWaitMicros"] = frameStats.lastVsyncWaitMicros;
+    frame["vsyncTimeouts"] = frameStats.vsyncTimeouts;
+    frame["lastLatencyMicros"] = frameStats.lastLatencyMicros;
+    frame["maxLatencyMicros"] = frameStats.maxLatencyMicros;
+    frame["lastTouchLatencyMicros"] = frameStats.lastTouchLatencyMicros;
+    frame["maxTouchLatencyMicros"] = frameStats.maxTouchLatencyMicros;
+
+    const TouchStats& touch = touchStats();
+    JsonObject touchDoc = doc["touch"].to<JsonObject>();
+    touchDoc["ready"] = touchReady;
+    touchDoc["interrupts"] = touch.interrupts;
+    touchDoc["samples"] = touch.samples;
+    touchDoc["gestures"] = touch.gestures;
+    touchDoc["dropped"] = touch.dropped;
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  }));
+
+  // power policy and estimated draw
+  server.on("/api/power", HTTP_GET, trackRoute("GET /api/power", [](AsyncWebServerRequest *request) {
+    PowerStats stats = powerStats();
+
+    JsonDocument doc;
+    doc["dynamicFrequency"] = stats.dynamicFrequency;
+    doc["lightSleep"] = stats.lightSleep;
+    doc["backlight"] = backlightLevel;
+    doc["uptimeMillis"] = stats.uptimeMillis;
+    doc["idleMillis"] = stats.idleMillis;
+    doc["sleepableMillis"] = stats.sleepableMillis;
+    doc["backlightMillis"] = stats.backlightMillis;
+    doc["estimatedCurrentMa"] = estimatedCurrentMa(stats);
+
+    // how late checks start after falling due, i.e. the cost of sleeping
+    JsonObject checks = doc["checkLateness"].to<JsonObject>();
+    checks["checks"] = stats.checks;
+    checks["lastMillis"] = stats.lastCheckLateness;
+    checks["maxMillis"] = stats.maxCheckLateness;
+    checks["avgMillis"] = stats.checks > 0 ? (uint32_t)(stats.totalCheckLateness / stats.checks) : 0;
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  }));
+
+  // heap, task and loop timing diagnostics
+  server.on("/api/diag", HTTP_GET, trackRoute("GET /api/diag", [](AsyncWebServerRequest *request) {
+    HeapStats heap = heapStats();
+
+    JsonDocument doc;
+    doc["uptimeMillis"] = millis();
+
+    JsonObject internal = doc["heap"].to<JsonObject>();
+    internal["free"] = heap.internalFree;
+    internal["largestFreeBlock"] = heap.internalLargest;
+    internal["minFree"] = heap.internalMinFree;
+    internal["fragmentationPercent"] = fragmentationPercent(heap.internalFree, heap.internalLargest);
+
+    JsonObject psram = doc["psram"].to<JsonObject>();
+    psram["size"] = heap.psramSize;
+    psram["free"] = heap.psramFree;
+    psram["largestFreeBlock"] = heap.psramLargest;
+    psram["minFree"] = heap.psramMinFree;
+    psram["fragmentationPercent"] = fragmentationPercent(heap.psramFree, heap.psramLargest);
+
+    writeTimingHistogram(doc["loop"].to<JsonObject>(), loopTiming());
+    writeTimingHistogram(doc["checkServices"].to<JsonObject>(), checkRoundTiming());
+    writeTimingHistogram(doc["probe"].to<JsonObject>(), probeTiming());
+    writeTimingHistogram(doc["scheduleLateness"].to<JsonObject>(), scheduleLateness());
+
+    uint32_t probes = probeTiming().count;
+    doc["checksPerSecond"] = millis() > 0 ? probes * 1000.0f / millis() : 0;
+    doc["stateTransitions"] = stateTransitions();
+#if SIMULATE_PROBES
+    JsonObject simulation = doc["simulation"].to<JsonObject>();
+    simulation["checks"] = simulatedChecks();
+    simulation["failures"] = simulatedFailures();
+    simulation["latencyMs"] = SIMULATED_LATENCY_MS;
+    simulation["slowPercent"] = SIMULATED_SLOW_PERCENT;
+    simulation["slowMs"] = SIMULATED_SLOW_MS;
+    simulation["errorPercent"] = SIMULATED_ERROR_PERCENT;
+#endif
+
+    LoggerStats log = loggerStats();
+    JsonObject logDoc = doc["log"].to<JsonObject>();
+    logDoc["written"] = log.written;
+    logDoc["dropped"] = log.dropped;
+    logDoc["syslogFailed"] = log.syslogFailed;
+
+    // Milliseconds from boot to each stage, null until reached
+    JsonObject boot = doc["boot"].to<JsonObject>();
+    for (int stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+      uint32_t at = bootStageMillis((BootStage)stage);
+      if (at > 0) {
+        boot[bootStageName((BootStage)stage)] = at;
+      } else {
+        boot[bootStageName((BootStage)stage)] = nullptr;
+      }
+    }
+
+    WifiLinkStats link = wifiLinkStats(millis());
+    JsonObject wifi = doc["wifi"].to<JsonObject>();
+    wifi["state"] = link.state == LINK_UP ? "up" : link.state == LINK_CONNECTING ? "connecting" : "backoff";
+    wifi["rssi"] = WiFi.RSSI();
+    wifi["attempts"] = link.attempts;
+    wifi["connects"] = link.connects;
+    wifi["losses"] = link.losses;
+    wifi["downMillis"] = link.downMillis;
+    wifi["queuedAlerts"] = pendingAlertCount;
+    wifi["droppedAlerts"] = droppedAlerts;
+
+    SeriesStats series = seriesStats();
+    JsonObject seriesDoc = doc["series"].to<JsonObject>();
+    seriesDoc["samples"] = series.samples;
+    seriesDoc["skippedNoClock"] = series.skippedNoClock;
+    seriesDoc["blocksWritten"] = series.blocksWritten;
+    seriesDoc["writeErrors"] = series.writeErrors;
+    seriesDoc["blocksPerService"] = SERIES_BLOCKS_PER_SERVICE;
+    seriesDoc["fsUsedBytes"] = LittleFS.usedBytes();
+    seriesDoc["fsTotalBytes"] = LittleFS.totalBytes();
+
+    // CPU share covers the time since the previous /api/diag request
+    static TaskSample tasks[24];
+    int taskCount = sampleTasks(tasks, 24);
+    doc["taskStats"] = taskCount >= 0;
+    JsonArray taskArray = doc["tasks"].to<JsonArray>();
+    for (int i = 0; i < taskCount; i++) {
+      JsonObject task = taskArray.add<JsonObject>();
+      task["name"] = tasks[i].name;
+      task["priority"] = tasks[i].priority;
+      task["core"] = tasks[i].core;
+      task["stackFreeMin"] = tasks[i].stackFree;
+      if (tasks[i].cpuPercent >= 0) {
+        task["cpuPercent"] = roundf(tasks[i].cpuPercent * 10) / 10;
+      }
+    }
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  }));
+
+  // per-route request counters, for sizing how many clients one device serves
+  server.on("/api/http", HTTP_GET, trackRoute("GET /api/http", [](AsyncWebServerRequest *request) {
+    InFlightStats inFlight = inFlightStats();
+
+    JsonDocument doc;
+    doc["uptimeMillis"] = millis();
+    doc["inFlight"] = inFlight.current;
+    doc["peakInFlight"] = inFlight.peak;
+    doc["abandoned"] = inFlight.abandoned;
+
+    JsonArray routes = doc["routes"].to<JsonArray>();
+    for (int i = 0; i < routeCount(); i++) {
+      const RouteStats& stats = routeStats(i);
+      JsonObject route = routes.add<JsonObject>();
+      route["route"] = stats.name;
+      route["requests"] = stats.requests;
+      route["bodyBytes"] = stats.bodyBytes;
+      route["noResponse"] = stats.noResponse;
+
+      JsonObject status = route["status"].to<JsonObject>();
+      for (int c = 0; c < 5; c++) {
+        if (stats.status[c] == 0) continue;
+        char key[4];
+        snprintf(key, sizeof(key), "%dxx", c + 1);
+        status[key] = stats.status[c];
+      }
+
+      writeTimingHistogram(route["latency"].to<JsonObject>(), stats.latency);
+    }
+
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+  }));
+
+  // most recent log records as plain text, oldest first; ?count=N limits them
+  server.on("/api/logs", HTTP_GET, trackRoute("GET /api/logs", [](AsyncWebServerRequest *request) {
+    if (!ensureAuthenticated(request)) {
+      return;
+    }
+
+    uint32_t count = LOG_CAPACITY;
+    if (request->hasParam("count")) {
+      long requested = request->getParam("count")->value().toInt();
+      if (requested > 0 && requested < LOG_CAPACITY) {
+        count = requested;
+      }
+    }
+
+    // Streamed a record at a time straight from the ring; records overwritten
+    // while the response is being sent are skipped
+    struct LogStream {
+      uint32_t next;
+      uint32_t newest;
+      char pending[160];  // formatted but not yet sent, from `offset`
+      size_t pendingLength = 0;
+      size_t offset = 0;
+
+      // Formats the next record still in the ring into `pending`
+      bool advance() {
+        LogRecord record;
+        while (next <= newest) {
+          if (!readLogRecord(next, record)) {
+            uint32_t oldest = logOldestSequence();
+            next = oldest > next ? oldest : next + 1;
+            continue;
+          }
+          next++;
+          offset = 0;
+          pendingLength = formatLogRecord(record, pending, sizeof(pending));
+          return true;
+        }
+        return false;
+      }
+    };
+
+    std::shared_ptr<LogStream> stream = std::make_shared<LogStream>();
+    stream->newest = logNewestSequence();
+    stream->next = stream->newest >= count ? stream->newest - count + 1 : 1;
+
+    // Never returns 0 before the end: that would end the chunked response.
+    // A line longer than the room left is split across calls.
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain",
+      [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t written = 0;
+        while (written < maxLen && (stream->offset < stream->pendingLength || stream->advance())) {
+          size_t length = stream->pendingLength - stream->offset;
+          if (length > maxLen - written) length = maxLen - written;
+          memcpy(buffer + written, stream->pending + stream->offset, length);
+          written += length;
+          stream->offset += length;
+        }
+        return written;
+      });
+    request->send(response);
+  }));
+
+  // outages in a time range, for reports
+  server.on("/api/incidents", HTTP_GET, trackRoute("GET /api/incidents", [](AsyncWebServerRequest *request) {
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    uint64_t serviceId = 0;
+    if (request->hasParam("from")) {
+      from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("to")) {
+      to = strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+    }
+    if (request->hasParam("service") && !parseServiceId(request->getParam("service")->value(), serviceId)) {
+      request->send(400, "application/json", "{\"error\":\"Invalid service\"}");
+      return;
+    }
+    bool csv = request->hasParam("format") && request->getParam("format")->value() == "csv";
+
+    // Formatted one incident at a time while the response is sent. Names
+    // are taken now; a deleted service's incidents have an empty name.
+    struct IncidentStream {
+      IncidentCursor cursor;
+      bool csv;
+      std::vector<std::pair<uint64_t, String>> names;
+      String pending;  // formatted but not yet sent, from `offset`
+      size_t offset = 0;
+      bool started = false;
+      bool first = true;
+      bool finished = false;
+
+      IncidentStream(uint32_t from, uint32_t to, uint64_t id) : cursor(from, to, id) {}
+
+      String nameOf(uint64_t id) const {
+        for (const auto& entry : names) {
+          if (entry.first == id) return entry.second;
+        }
+        return String();
+      }
+
+      static String isoTime(uint32_t unixTime) {
+        time_t seconds = unixTime;
+        struct tm parts;
+        gmtime_r(&seconds, &parts);
+        char text[24];
+        strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &parts);
+        return String(text);
+      }
+
+      // Formats the next element of the document into `pending`
+      bool advance() {
+        offset = 0;
+        if (!started) {
+          started = true;
+          pending = csv ? "id,name,start,end,duration_s,failed_probes,first_error\n" : "{\"incidents\":[";
+          return true;
+        }
+
+        IncidentRecord record;
+        if (cursor.next(record)) {
+          uint32_t duration = (record.end != 0 ? record.end : (uint32_t)time(nullptr)) - record.start;
+          String name = nameOf(record.id);
+          if (csv) {
+            name.replace("\"", "\"\"");
+            pending = formatServiceId(record.id) + ",\"" + name + "\"," + isoTime(record.start) + "," +
+              (record.end != 0 ? isoTime(record.end) : String()) + "," + String(duration) + "," +
+              String(record.failedProbes) + "," + probeErrorName(record.firstError) + "\n";
+          } else {
+            JsonDocument doc;
+            doc["id"] = formatServiceId(record.id);
+            doc["name"] = name;
+            doc["start"] = record.start;
+            if (record.end != 0) {
+              doc["end"] = record.end;
+            } else {
+              doc["end"] = nullptr;  // still DOWN
+            }
+            doc["durationS"] = duration;
+            doc["failedProbes"] = record.failedProbes;
+            doc["firstError"] = probeErrorName(record.firstError);
+            pending = first ? "" : ",";
+            serializeJson(doc, pending);
+          }
+          first = false;
+          return true;
+        }
+
+        if (finished) return false;
+        finished = true;
+        pending = csv ? "" : "]}";
+        return true;
+      }
+    };
+
+    std::shared_ptr<IncidentStream> stream = std::make_shared<IncidentStream>(from, to, serviceId);
+    stream->csv = csv;
+    {
+      ServiceSnapshotGuard snapshot;
+      for (int i = 0; i < snapshot->table.count; i++) {
+        const Service& service = snapshot->table.at(i);
+        stream->names.emplace_back(service.id, service.name);
+      }
+    }
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(csv ? "text/csv" : "application/json",
+      [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t written = 0;
+        while (written < maxLen && (stream->offset < stream->pending.length() || stream->advance())) {
+          size_t length = stream->pending.length() - stream->offset;
+          if (length > maxLen - written) length = maxLen - written;
+          memcpy(buffer + written, stream->pending.c_str() + stream->offset, length);
+          written += length;
+          stream->offset += length;
+        }
+        return written;
+      });
+    if (csv) {
+      response->addHeader("Content-Disposition", "attachment; filename=\"incidents.csv\"");
+    }
+    request->send(response);
+  }));
+
+  // download the probe trace for tools/trace_replay
+  server.on("/api/trace", HTTP_GET, trackRoute("GET /api/trace", [](AsyncWebServerRequest *request) {
+    if (!ensureAuthenticated(request)) {
+      return;
+    }
+
+    // A header, then records streamed oldest first. Records deleted with
+    // their segment while the response is being sent are skipped; the
+    // replayer sees the gap in the timestamps.
+    struct TraceStream {
+      uint32_t next;
+      uint32_t newest;
+      uint8_t pending[sizeof(TraceRecord)];  // header or record not yet sent, from `offset`
+      size_t pendingLength = 0;
+      size_t offset = 0;
+
+      size_t sendPending(uint8_t* buffer, size_t room) {
+        size_t length = pendingLength - offset;
+        if (length > room) length = room;
+        memcpy(buffer, pending + offset, length);
+        offset += length;
+        return length;
+      }
+    };
+
+    std::shared_ptr<TraceStream> stream = std::make_shared<TraceStream>();
+    stream->next = traceOldestSequence();
+    stream->newest = traceNewestSequence();
+    TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), TRACE_CAPACITY, stream->next};
+    static_assert(sizeof(header) <= sizeof(TraceStream::pending), "trace header must fit the pending buffer");
+    memcpy(stream->pending, &header, sizeof(header));
+    stream->pendingLength = sizeof(header);
+
+    // Never returns 0 before the end: that would end the chunked response.
+    // With less than a record of room, the record is split across calls.
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/octet-stream",
+      [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t written = stream->sendPending(buffer, maxLen);
+
+        TraceRecord records[32];
+        while (stream->offset == stream->pendingLength && stream->next <= stream->newest && written < maxLen) {
+          int fit = (maxLen - written) / sizeof(TraceRecord);
+          int max = fit > 32 ? 32 : fit > 0 ? fit : 1;
+          if ((uint32_t)max > stream->newest - stream->next + 1) max = stream->newest - stream->next + 1;
+
+          int read = readTrace(stream->next, records, max);
+          if (read == 0) {
+            uint32_t oldest = traceOldestSequence();
+            stream->next = oldest > stream->next ? oldest : stream->next + 1;
+            continue;
+          }
+          stream->next += read;
+
+          if (fit == 0) {
+            memcpy(stream->pending, records, sizeof(TraceRecord));
+            stream->pendingLength = sizeof(TraceRecord);
+            stream->offset = 0;
+            written += stream->sendPending(buffer + written, maxLen - written);
+          } else {
+            memcpy(buffer + written, records, read * sizeof(TraceRecord));
+            written += read * sizeof(TraceRecord);
+          }
+        }
+        return written;
+      });
+    response->addHeader("Content-Disposition", "attachment; filename=\"trace.bin\"");
+    request->send(response);
+  }));
+
+  // stored check history of one service
+  server.on("/api/history", HTTP_GET, trackRoute("GET /api/history", [](AsyncWebServerRequest *request) {
+    uint64_t serviceId = 0;
+    if (!request->hasParam("id") || !parseServiceId(request->getParam("id")->value(), serviceId)) {
+      request->send(400, "application/json", "{\"error\":\"Missing or invalid id\"}");
+      return;
+    }
+
+    uint32_t from = 0;
+    if (request->hasParam("from")) {
+      from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+    }
+
+    // Decoded a block at a time while the response is sent. Each sample is
+    // [unix time, up, ProbeError, latency ms].
+    struct HistoryStream {
+      uint64_t id;
+      uint32_t from;
+      uint32_t next;    // block sequence to load next
+      uint32_t newest;
+      SeriesBlock block;
+      SeriesDecoder* decoder = nullptr;
+      char pending[48];  // formatted but not yet sent, from `offset`
+      size_t pendingLength = 0;
+      size_t offset = 0;
+      bool started = false;
+      bool first = true;
+      bool finished = false;
+
+      ~HistoryStream() { delete decoder; }
+
+      // Formats the next element of the document into `pending`
+      bool advance() {
+        offset = 0;
+        if (!started) {
+          started = true;
+          pendingLength = snprintf(pending, sizeof(pending), "{\"id\":\"%s\",\"samples\":[",
+            formatServiceId(id).c_str());
+          return true;
+        }
+
+        SeriesSample sample;
+        for (;;) {
+          if (decoder != nullptr && decoder->next(sample)) {
+            if (sample.time < from) continue;
+            pendingLength = snprintf(pending, sizeof(pending), "%s[%lu,%d,%u,%lu]", first ? "" : ",",
+              (unsigned long)sample.time, sample.up ? 1 : 0, sample.error, (unsigned long)sample.latencyMs);
+            first = false;
+            return true;
+          }
+
+          delete decoder;
+          decoder = nullptr;
+          if (next > newest) break;
+
+          // Missing blocks (deleted meanwhile, or lost to a power cut) are skipped
+          uint32_t sequence = next++;
+          if (readSeriesBlock(id, sequence, block)) {
+            decoder = new SeriesDecoder(block);
+          }
+        }
+
+        if (finished) return false;
+        finished = true;
+        pendingLength = snprintf(pending, sizeof(pending), "]}");
+        return true;
+      }
+    };
+
+    std::shared_ptr<HistoryStream> stream = std::make_shared<HistoryStream>();
+    stream->id = serviceId;
+    stream->from = from;
+    seriesBlockRange(serviceId, stream->next, stream->newest);
+    if (from != 0) {
+      stream->next = seriesBlockFrom(serviceId, stream->next, stream->newest, from);
+    }
+
+    // Never returns 0 before the end: that would end the chunked response
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+      [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t written = 0;
+        while (written < maxLen && (stream->offset < stream->pendingLength || stream->advance())) {
+          size_t length = stream->pendingLength - stream->offset;
+          if (length > maxLen - written) length = maxLen - written;
+          memcpy(buffer + written, stream->pending + stream->offset, length);
+          written += length;
+          stream->offset += length;
+        }
+        return written;
+      });
+    request->send(response);
+  }));
 
   // export services configuration
-  server.on("/api/export", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/api/export", HTTP_GET, trackRoute("GET /api/export", [](AsyncWebServerRequest *request) {
     JsonDocument doc;
     JsonArray array = doc["services"].to<JsonArray>();
 
-    for (int i = 0; i < serviceCount; i++) {
-      JsonObject obj = array.add<JsonObject>();
-      obj["name"] = services[i].name;
-      obj["type"] = getServiceTypeString(services[i].type);
-      obj["host"] = services[i].host;
-      obj["port"] = services[i].port;
-      obj["path"] = services[i].path;
-      obj["expectedResponse"] = services[i].expectedResponse;
-      obj["checkInterval"] = services[i].checkInterval;
-      obj["passThreshold"] = services[i].passThreshold;
-      obj["failThreshold"] = services[i].failThreshold;
+    {
+      ServiceSnapshotGuard snapshot;
+      for (int i = 0; i < snapshot->table.count; i++) {
+        const Service& service = snapshot->table.at(i);
+        JsonObject obj = array.add<JsonObject>();
+        obj["name"] = service.name;
+        obj["type"] = getServiceTypeString(service.type);
+        obj["host"] = service.host;
+        obj["port"] = service.port;
+        obj["path"] = service.path;
+        obj["expectedResponse"] = service.expectedResponse;
+        obj["checkInterval"] = service.checkInterval;
+        obj["passThreshold"] = service.passThreshold;
+        obj["failThreshold"] = service.failThreshold;
+      }
     }
 
     String response;
@@ -601,100 +1510,79 @@ void initWebServer() {
     AsyncWebServerResponse *res = request->beginResponse(200, "application/json", response);
     res->addHeader("Content-Disposition", "attachment; filename=\"monitors-backup.json\"");
     request->send(res);
-  });
+  }));
 
   // import services configuration
-  server.on("/api/import", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL,
-    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-      // Limit payload size to 16KB to prevent DoS
-      if (total > 16384) {
-        request->send(400, "application/json", "{\"error\":\"Payload too large\"}");
+  server.on("/api/import", HTTP_POST, trackRoute("POST /api/import", [](AsyncWebServerRequest *request) {}), NULL,
+    trackRouteBody([](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      if (index == 0) {
+        if (importSession != nullptr) {
+          request->send(409, "application/json", "{\"error\":\"Another import is in progress\"}");
+          return;
+        }
+
+        // Memory use is bounded by the parser, so this only guards against runaway uploads
+        if (total > MAX_IMPORT_BYTES) {
+          request->send(400, "application/json", "{\"error\":\"Payload too large\"}");
+          return;
+        }
+
+        importSession = new ServiceImportParser(freeServiceSlots());
+        importRequest = request;
+        request->onDisconnect([request]() {
+          if (importRequest == request) {
+            delete importSession;
+            importSession = nullptr;
+            importRequest = nullptr;
+          }
+        });
+      }
+
+      if (request != importRequest) {
         return;
       }
 
-      JsonDocument doc;
-      DeserializationError error = deserializeJson(doc, data, len);
+      importSession->feed(data, len);
 
-      if (error) {
-        request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      if (index + len < total) {
         return;
       }
 
-      JsonArray array = doc["services"];
-      if (array.isNull()) {
-        request->send(400, "application/json", "{\"error\":\"Missing services array\"}");
+      ServiceImportParser* parser = importSession;
+      importSession = nullptr;
+      importRequest = nullptr;
+
+      if (!parser->finish()) {
+        JsonDocument response;
+        response["error"] = parser->error();
+        delete parser;
+
+        String responseStr;
+        serializeJson(response, responseStr);
+        request->send(400, "application/json", responseStr);
         return;
       }
 
-      int importedCount = 0;
-      int skippedCount = 0;
-
-      for (JsonObject obj : array) {
-        if (serviceCount >= MAX_SERVICES) {
-          skippedCount++;
-          continue;
-        }
-
-        // Validate required fields
-        String name = obj["name"].as<String>();
-        String host = obj["host"].as<String>();
-        if (name.length() == 0 || host.length() == 0) {
-          skippedCount++;
-          continue;
-        }
-
-        String typeStr = obj["type"].as<String>();
-        ServiceType type;
-        if (typeStr == "home_assistant") {
-          type = TYPE_HOME_ASSISTANT;
-        } else if (typeStr == "jellyfin") {
-          type = TYPE_JELLYFIN;
-        } else if (typeStr == "http_get") {
-          type = TYPE_HTTP_GET;
-        } else if (typeStr == "ping") {
-          type = TYPE_PING;
-        } else {
-          skippedCount++;
-          continue;
-        }
-
-        // Validate and constrain numeric values
-        int port = obj["port"] | 80;
-        if (port < 1 || port > 65535) port = 80;
-
-        int checkInterval = obj["checkInterval"] | 60;
-        if (checkInterval < 10) checkInterval = 10;
-
-        int passThreshold = obj["passThreshold"] | 1;
-        if (passThreshold < 1) passThreshold = 1;
-
-        int failThreshold = obj["failThreshold"] | 1;
-        if (failThreshold < 1) failThreshold = 1;
-
-        Service newService;
-        newService.id = generateServiceId();
-        newService.name = name;
-        newService.type = type;
-        newService.host = host;
-        newService.port = port;
-        newService.path = obj["path"] | "/";
-        newService.expectedResponse = obj["expectedResponse"] | "*";
-        newService.checkInterval = checkInterval;
-        newService.passThreshold = passThreshold;
-        newService.failThreshold = failThreshold;
-        newService.consecutivePasses = 0;
-        newService.consecutiveFails = 0;
-        newService.isUp = false;
-        newService.lastCheck = 0;
-        newService.lastUptime = 0;
-        newService.lastError = "";
-        newService.secondsSinceLastCheck = -1;
-
-        services[serviceCount++] = newService;
-        importedCount++;
+      // All imported services are applied and saved together by the writer.
+      // Services added during the upload may have taken some of the room.
+      ServiceCommand* command = new ServiceCommand();
+      command->type = CMD_ADD_SERVICES;
+      command->services.swap(parser->services());
+      int skippedCount = parser->skippedCount();
+      delete parser;
+
+      int room = freeServiceSlots();
+      if ((int)command->services.size() > room) {
+        skippedCount += command->services.size() - room;
+        command->services.resize(room);
       }
+      int importedCount = command->services.size();
 
-      saveServices();
+      if (enqueueServiceCommand(command) != ENQUEUE_OK) {
+        delete command;
+        request->send(503, "application/json", "{\"error\":\"Busy, try again\"}");
+        return;
+      }
 
       JsonDocument response;
       response["success"] = true;
@@ -704,289 +1592,643 @@ void initWebServer() {
       String responseStr;
       serializeJson(response, responseStr);
       request->send(200, "application/json", responseStr);
-    }
+    })
   );
 
-  server.begin();
-  Serial.println("Web server started");
 }
 
-String generateServiceId() {
-  return String(millis()) + String(random(1000, 9999));
-}
+// Applies config changes queued by the web server. Runs on the loop() task,
+// which is the only writer of serviceTable.
+void applyServiceCommands() {
+  bool changed = false;
+  ServiceCommand* command;
+
+  while ((command = dequeueServiceCommand()) != nullptr) {
+    serviceSnapshotDirty = true;  // publishes the applied count even if nothing changed
+    switch (command->type) {
+      case CMD_ADD_SERVICES:
+        for (const Service& service : command->services) {
+          // Room was reserved when the command was accepted
+          if (serviceTable.add(service) == nullptr) {
+            logPrintf(LOG_WARN, "Dropping service '%s': table full", service.name.c_str());
+            releaseServiceSlots(1);
+            continue;
+          }
+          changed = true;
+        }
+        break;
 
-void checkServices() {
-  unsigned long currentTime = millis();
+      case CMD_DELETE_SERVICE:
+        if (!serviceTable.remove(command->serviceId)) {
+          break;
+        }
 
-  for (int i = 0; i < serviceCount; i++) {
-    // Check if it's time to check this service
-    if (currentTime - services[i].lastCheck < services[i].checkInterval * 1000) {
-      continue;
-    }
+        releaseServiceSlots(1);
+        changed = true;
+        break;
 
-    bool firstCheck = services[i].lastCheck == 0;
-    services[i].lastCheck = currentTime;
-    bool wasUp = services[i].isUp;
+      case CMD_APPLY_BATCH: {
+        // The handler made sure no other command came between its snapshot
+        // and this one; checked again so a bug cannot half-apply a batch
+        String error;
+        if (!applyServiceBatch(serviceTable, command->operations, error)) {
+          logPrintf(LOG_WARN, "Discarding batch of %d operations: %s",
+            (int)command->operations.size(), error.c_str());
+          releaseServiceSlots(command->reservedSlots);
+          break;
+        }
 
-    // Perform the actual check
-    bool checkResult = false;
-    switch (services[i].type) {
-      case TYPE_HOME_ASSISTANT:
-        checkResult = checkHomeAssistant(services[i]);
-        break;
-      case TYPE_JELLYFIN:
-        checkResult = checkJellyfin(services[i]);
-        break;
-      case TYPE_HTTP_GET:
-        checkResult = checkHttpGet(services[i]);
-        break;
-      case TYPE_PING:
-        checkResult = checkPing(services[i]);
+        changed = true;
         break;
+      }
     }
 
-    // Update consecutive counters based on check result
-    if (checkResult) {
-      services[i].consecutivePasses++;
-      services[i].consecutiveFails = 0;
-      services[i].lastUptime = currentTime;
-      services[i].lastError = "";
+    delete command;
+  }
+
+  if (changed) {
+    saveServices();
+    traceServiceConfigs(serviceTable, millis());
+    pruneSeriesStore(serviceTable);
+    serviceSnapshotDirty = true;
+  }
+}
+
+void writeTimingHistogram(JsonObject out, const TimingHistogram& histogram) {
+  out["count"] = histogram.count;
+  out["lastMicros"] = histogram.lastMicros;
+  out["maxMicros"] = histogram.maxMicros;
+  out["avgMicros"] = histogram.averageMicros();
+  out["p50Micros"] = histogram.percentileMicros(50);
+  out["p90Micros"] = histogram.percentileMicros(90);
+  out["p99Micros"] = histogram.percentileMicros(99);
+
+  // Bucket counts, each labelled with its upper bound in microseconds
+  JsonArray buckets = out["buckets"].to<JsonArray>();
+  for (int i = 0; i < TimingHistogram::BUCKETS; i++) {
+    JsonObject bucket = buckets.add<JsonObject>();
+    if (i < TimingHistogram::BUCKETS - 1) {
+      bucket["le"] = TimingHistogram::BOUNDS[i];
     } else {
-      services[i].consecutiveFails++;
-      services[i].consecutivePasses = 0;
+      bucket["le"] = "inf";
     }
+    bucket["count"] = histogram.counts[i];
+  }
+}
 
-    // Determine new state based on thresholds
-    if (!services[i].isUp && services[i].consecutivePasses >= services[i].passThreshold) {
-      // Service has passed enough times to be considered UP
-      services[i].isUp = true;
-    } else if (services[i].isUp && services[i].consecutiveFails >= services[i].failThreshold) {
-      // Service has failed enough times to be considered DOWN
-      services[i].isUp = false;
-    }
+// Publishes the table for the web server and the render task. A failed
+// publish leaves the flag set so the next call retries.
+void publishServicesIfDirty() {
+  if (!serviceSnapshotDirty || !publishServiceSnapshot(serviceTable, appliedServiceCommands())) return;
 
-    // Log and notify on state changes
-    if (wasUp != services[i].isUp) {
-      Serial.printf("Service '%s' is now %s (after %d consecutive %s)\n",
-        services[i].name.c_str(),
-        services[i].isUp ? "UP" : "DOWN",
-        services[i].isUp ? services[i].consecutivePasses : services[i].consecutiveFails,
-        services[i].isUp ? "passes" : "fails");
-
-      if (!services[i].isUp) {
-        sendOfflineNotification(services[i]);
-      } else if (!firstCheck) {
-        sendOnlineNotification(services[i]);
-      }
+  serviceSnapshotDirty = false;
+  postDisplayEvent(DISPLAY_EVENT_SERVICES_CHANGED);
+}
 
-      displayNeedsUpdate = true;
-    }
+// The probes run at the moment they are due; the screen is updated as soon
+// as a status changes (ScreenDisplay) and each result is recorded below.
+void checkServices() {
+  runDueChecks(serviceTable, checkPlatform, recordCheck);
 
-    if (i == currentServiceIndex) {
-      displayNeedsUpdate = true;
+  if (traceConfigDue()) {
+    traceServiceConfigs(serviceTable, millis());
+  }
+}
+
+void ScreenDisplay::servicesChanged(const ServiceTable& table) {
+  (void)table;  // always serviceTable
+  publishServicesIfDirty();
+}
+
+// Records one check everywhere it is kept, then logs and notifies on state
+// changes.
+void recordCheck(Service& service, const CheckOutcome& outcome) {
+  bool passed = outcome.error == PROBE_OK;
+  serviceSnapshotDirty = true;
+
+  if (!outcome.firstCheck) {
+    recordCheckLateness(outcome.lateness);
+  }
+  recordBootStage(BOOT_FIRST_CHECK);
+  recordProbe(outcome.probeMicros, outcome.lateness);
+  recordServiceCheck(outcome.slot, service.id, passed, service.lastLatency, millis());
+  traceProbe(service, passed, outcome.error, service.lastLatency, outcome.startMillis);
+  recordSeriesSample(outcome.slot, service.id, passed, outcome.error, service.lastLatency);
+  if (outcome.unixTime != 0) {
+    recordRollup(outcome.slot, service.id, passed, service.lastLatency, outcome.unixTime);
+  }
+
+  markRuntimeStateDirty(outcome.changed);
+  if (outcome.changed) {
+    recordStateTransition();
+    logPrintf(service.isUp ? LOG_INFO : LOG_WARN, "Service '%s' is now %s (after %d consecutive %s)",
+      service.name.c_str(),
+      service.isUp ? "UP" : "DOWN",
+      service.isUp ? service.consecutivePasses : service.consecutiveFails,
+      service.isUp ? "passes" : "fails");
+
+    if (!service.isUp) {
+      sendOfflineNotification(service);
+    } else if (!outcome.firstCheck) {
+      sendOnlineNotification(service);
     }
   }
+  trackIncident(outcome.slot, service, passed, outcome.error, millis(), outcome.unixTime);
 }
 
-void renderServiceOnDisplay() {
+// Lays out the service screen. Positions match the original full-redraw
+// layout, with the error area shortened to make room for the history charts.
+void initDisplayWidgets() {
+  const int16_t width = TFT_WIDTH;
+  const int16_t height = TFT_HEIGHT;
+
+  headerWidget = screen.addWidget(0, 0, width, 40, 2, false, 0, 10, 10);
+  titleWidget = screen.addWidget(0, 40, width, 50, 3, false, 0, 10, 10);
+  statusWidget = screen.addWidget(10, 90, width - 20, 60, 2, true, TFT_NAVY, 10, 20);
+  typeWidget = screen.addWidget(0, 150, width, 30, 2, false, 0, 20, 0);
+  hostWidget = screen.addWidget(0, 180, width, 30, 2, false, 0, 20, 0);
+  lastCheckWidget = screen.addWidget(0, 210, width, 30, 2, false, 0, 20, 0);
+  errorWidget = screen.addWidget(0, 240, width, 60, 2, false, 0, 20, 0);
+  latencyLabelWidget = screen.addWidget(0, 304, CHART_X, 70, 2, false, 0, 10, 0);
+  uptimeLabelWidget = screen.addWidget(0, 382, CHART_X, 28, 2, false, 0, 10, 6);
+  footerWidget = screen.addWidget(0, height - 60, width, 30, 2, false, 0, 10, 0);
+  rotationWidget = screen.addWidget(0, height - 30, width, 30, 2, false, 0, 10, 0);
+}
+
+// Switches between the single-service screen, the status wall and the
+// diagnostics page. All draw into the same body area, so it is cleared and
+// fully repainted. The diagnostics page reuses the service screen's text
+// widgets.
+void setDisplayMode(DisplayMode mode) {
+  displayMode = mode;
+  displayNeedsUpdate = true;
   if (!displayReady) return;
 
-  display.fillScreen(TFT_BLACK);
+  bool detail = mode == DISPLAY_MODE_DETAIL;
+  bool text = detail || mode == DISPLAY_MODE_DIAG;
+  screen.setVisible(titleWidget, text);
+  screen.setVisible(statusWidget, text);
+  screen.setVisible(typeWidget, text);
+  screen.setVisible(hostWidget, text);
+  screen.setVisible(lastCheckWidget, text);
+  screen.setVisible(errorWidget, text);
+  screen.setVisible(latencyLabelWidget, detail);
+  screen.setVisible(uptimeLabelWidget, detail);
+
+  display.fillRect(0, DISPLAY_BODY_TOP, TFT_WIDTH, DISPLAY_BODY_HEIGHT, TFT_BLACK);
+  screen.invalidate();
+  statusGrid.invalidate();
+  latencyChart.invalidate();
+  uptimeBar.invalidate();
+}
 
-  int16_t width = display.width();
-  int16_t height = display.height();
+// Updates widget contents from the current service. Only widgets whose text or
+// colour changed are recomposed and pushed, so calling this every second to
+// advance "Last check" costs one small rectangle.
+void renderServiceOnDisplay(const ServiceTable& table) {
+  // Boot progress until the clock is set, then the address
+  String header = "ESP32 Monitor - " + wifiLinkStatusText(millis());
+  if (wifiLinkUp() && bootStageMillis(BOOT_CLOCK) == 0) {
+    header += ", syncing clock";
+  }
+  screen.setText(headerWidget, header, wifiLinkUp() ? TFT_CYAN : TFT_ORANGE);
 
-  display.setTextColor(TFT_CYAN, TFT_BLACK);
-  display.setCursor(10, 10);
-  display.setTextSize(2);
-  if (WiFi.status() == WL_CONNECTED) {
-    String header = "ESP32 Monitor - " + WiFi.localIP().toString();
-    display.println(header);
-  } else {
-    display.println("ESP32 Monitor - No WiFi");
+  if (displayMode == DISPLAY_MODE_GRID) {
+    renderStatusGrid(table);
+    return;
   }
 
-  if (serviceCount == 0) {
-    display.setCursor(10, 60);
-    display.setTextColor(TFT_WHITE, TFT_BLACK);
-    display.println("No services configured.");
-    display.println("Add services via web UI.");
+  if (displayMode == DISPLAY_MODE_DIAG) {
+    renderDiagnostics();
     return;
   }
 
-  if (currentServiceIndex >= serviceCount) {
-    currentServiceIndex = 0;
+  if (table.count == 0) {
+    screen.setText(titleWidget, "", TFT_WHITE);
+    screen.setText(statusWidget, "", TFT_WHITE);
+    screen.setText(typeWidget, "No services configured.", TFT_WHITE);
+    screen.setText(hostWidget, "Add services via web UI.", TFT_WHITE);
+    screen.setText(lastCheckWidget, "", TFT_WHITE);
+    screen.setText(errorWidget, "", TFT_RED);
+    screen.setText(latencyLabelWidget, "", TFT_LIGHTGREY);
+    screen.setText(uptimeLabelWidget, "", TFT_LIGHTGREY);
+    screen.setText(footerWidget, "", TFT_LIGHTGREY);
+    screen.setText(rotationWidget, "", TFT_LIGHTGREY);
+    screen.flush();
+    renderHistoryCharts(nullptr, 0);
+    return;
   }
 
-  Service& svc = services[currentServiceIndex];
-  String status = svc.isUp ? "UP" : "DOWN";
-  uint16_t statusColor = svc.isUp ? TFT_GREEN : TFT_RED;
+  if (currentServiceIndex >= table.count) {
+    currentServiceIndex = 0;
+  }
 
-  display.setTextSize(3);
-  display.setTextColor(TFT_WHITE, TFT_BLACK);
-  display.setCursor(10, 50);
-  display.printf("%s (%d/%d)", svc.name.c_str(), currentServiceIndex + 1, serviceCount);
+  const Service& svc = table.at(currentServiceIndex);
+  char line[96];
 
-  display.fillRoundRect(10, 90, width - 20, 60, 12, TFT_NAVY);
-  display.setTextSize(2);
-  display.setCursor(20, 110);
-  display.setTextColor(statusColor, TFT_NAVY);
-  display.printf("Status: %s", status.c_str());
+  snprintf(line, sizeof(line), "%s (%d/%d)", svc.name.c_str(), currentServiceIndex + 1, table.count);
+  screen.setText(titleWidget, line, TFT_WHITE);
 
-  display.setCursor(20, 150);
-  display.setTextColor(TFT_YELLOW, TFT_BLACK);
-  display.printf("Type: %s", getServiceTypeString(svc.type).c_str());
+  screen.setText(statusWidget, svc.isUp ? "Status: UP" : "Status: DOWN", svc.isUp ? TFT_GREEN : TFT_RED);
+  screen.setText(typeWidget, "Type: " + getServiceTypeString(svc.type), TFT_YELLOW);
 
-  display.setCursor(20, 180);
-  display.setTextColor(TFT_WHITE, TFT_BLACK);
-  display.printf("Host: %s:%d", svc.host.c_str(), svc.port);
+  snprintf(line, sizeof(line), "Host: %s:%d", svc.host.c_str(), svc.port);
+  screen.setText(hostWidget, line, TFT_WHITE);
 
-  unsigned long sinceCheck = svc.lastCheck > 0 ? (millis() - svc.lastCheck) / 1000 : 0;
-  display.setCursor(20, 210);
-  if (svc.lastCheck == 0) {
-    display.println("Last check: pending");
+  if (neverChecked(svc)) {
+    screen.setText(lastCheckWidget, "Last check: pending", TFT_WHITE);
   } else {
-    display.printf("Last check: %lus ago", sinceCheck);
+    snprintf(line, sizeof(line), "Last check: %lus ago (%lu ms)",
+      (millis() - svc.lastCheck) / 1000, (unsigned long)svc.lastLatency);
+    screen.setText(lastCheckWidget, line, TFT_WHITE);
   }
 
   if (svc.lastError.length() > 0) {
-    display.setCursor(20, 240);
-    display.setTextColor(TFT_RED, TFT_BLACK);
-    display.printf("Error: %s", svc.lastError.c_str());
+    screen.setText(errorWidget, "Error: " + svc.lastError, TFT_RED);
+  } else {
+    screen.setText(errorWidget, slaLine(table.order[currentServiceIndex], svc.id), TFT_LIGHTGREY);
+  }
+
+  const ServiceHistory* history = serviceHistory(table.order[currentServiceIndex], svc.id);
+  renderHistoryCharts(history, svc.id);
+
+  // Chart labels: the latency at the top of the sparkline and 24 h uptime
+  snprintf(line, sizeof(line), "%lums", (unsigned long)latencyChart.scaleMs());
+  screen.setText(latencyLabelWidget, line, TFT_CYAN);
+  float uptime = history != nullptr ? uptimePercent24h(*history, millis()) : -1.0f;
+  if (uptime < 0) {
+    screen.setText(uptimeLabelWidget, "24h", TFT_LIGHTGREY);
+  } else {
+    snprintf(line, sizeof(line), "%.1f%%", uptime);
+    screen.setText(uptimeLabelWidget, line, uptime >= 99.0f ? TFT_GREEN : TFT_ORANGE);
   }
 
-  display.setTextColor(TFT_LIGHTGREY, TFT_BLACK);
-  display.setCursor(10, height - 60);
-  display.println("Tap left/right to switch");
-  display.setCursor(10, height - 30);
-  display.printf("Auto-rotate every %lus", DISPLAY_ROTATION_INTERVAL / 1000);
+  screen.setText(footerWidget, "Tap left/right to switch, header: grid", TFT_LIGHTGREY);
+  snprintf(line, sizeof(line), "Auto-rotate every %lus", DISPLAY_ROTATION_INTERVAL / 1000);
+  screen.setText(rotationWidget, line, TFT_LIGHTGREY);
+
+  screen.flush();
 }
 
-void handleDisplayLoop() {
-  if (!displayReady) return;
+// Brings the latency sparkline and uptime bar up to date. Usually that is a
+// one-column scroll per new check, or nothing at all.
+void renderHistoryCharts(const ServiceHistory* history, uint64_t id) {
+  uint32_t start = micros();
+  uint32_t pixels = latencyChart.render(history, id) + uptimeBar.render(history, id, millis());
+  screen.recordFrame(pixels, micros() - start);
+}
 
-  unsigned long now = millis();
+// Availability over the rollup windows and the 24 h p95 for the error area
+// of a healthy service. Empty until the clock is set and a check counted.
+String slaLine(uint16_t slot, uint64_t id) {
+  const ServiceRollup* rollup = serviceRollup(slot, id);
+  if (rollup == nullptr) return String();
+
+  RollupSummary day = summarizeRollup(*rollup, WINDOW_24H);
+  RollupSummary week = summarizeRollup(*rollup, WINDOW_7D);
+  RollupSummary month = summarizeRollup(*rollup, WINDOW_30D);
+  char line[96];
+  snprintf(line, sizeof(line), "SLA 24h %.2f%% 7d %.2f%%\n30d %.2f%% p95 %lums",
+    day.availability, week.availability, month.availability, (unsigned long)day.p95Ms);
+  return String(line);
+}
 
-  if (serviceCount > 0 && now - lastDisplaySwitch >= DISPLAY_ROTATION_INTERVAL) {
-    currentServiceIndex = (currentServiceIndex + 1) % serviceCount;
-    displayNeedsUpdate = true;
-    lastDisplaySwitch = now;
+// Status wall. Tiles only repaint when a service's status or name changed, so
+// the once-a-second refresh usually pushes nothing but the footer.
+void renderStatusGrid(const ServiceTable& table) {
+  int pages = statusGrid.pageCount();
+  if (gridPage >= pages) {
+    gridPage = 0;
   }
 
-  // Use LovyanGFX's touch API (GT911)
-  if (touchReady && serviceCount > 0) {
-    lgfx::touch_point_t tp;
-    int touchCount = display.getTouch(&tp, 1);
-    
-    if (touchCount > 0) {
-      int16_t x = tp.x;
-      int16_t y = tp.y;
+  uint32_t start = micros();
+  uint32_t pixels = statusGrid.render(table, gridPage);
+  screen.recordFrame(pixels, micros() - start);
 
-      if (y > 20) {
-        if (x < display.width() / 2) {
-          currentServiceIndex = (currentServiceIndex - 1 + serviceCount) % serviceCount;
-        } else {
-          currentServiceIndex = (currentServiceIndex + 1) % serviceCount;
-        }
-        displayNeedsUpdate = true;
-        lastDisplaySwitch = now;
-        // Wait for touch release
-        while (display.getTouch(&tp, 1) > 0) {
-          delay(50);
-        }
-      }
-    }
+  char line[96];
+  if (table.count == 0) {
+    screen.setText(footerWidget, "No services configured.", TFT_LIGHTGREY);
+  } else {
+    snprintf(line, sizeof(line), "%d of %d services down", statusGrid.downCount(), table.count);
+    screen.setText(footerWidget, line, statusGrid.downCount() > 0 ? TFT_RED : TFT_GREEN);
   }
 
-  if (displayNeedsUpdate) {
-    renderServiceOnDisplay();
-    displayNeedsUpdate = false;
+  if (pages > 1) {
+    snprintf(line, sizeof(line), "Page %d/%d - tap here to flip", gridPage + 1, pages);
+    screen.setText(rotationWidget, line, TFT_LIGHTGREY);
+  } else {
+    screen.setText(rotationWidget, "Tap a tile for details", TFT_LIGHTGREY);
   }
+
+  screen.flush();
 }
 
-// technically just detectes any endpoint, so would be good to support auth and check if it's actually home assistant
-// could parse /api/states or something to check there are valid entities and that it's actually HA
-bool checkHomeAssistant(Service& service) {
-  HTTPClient http;
-  String url = "http://" + service.host + ":" + String(service.port) + "/api/";
+// Resource pressure at a glance; the full picture is at /api/diag. Redrawn
+// with the once-a-second refresh.
+void renderDiagnostics() {
+  HeapStats heap = heapStats();
+  const TimingHistogram& loopStats = loopTiming();
+  const TimingHistogram& checkStats = checkRoundTiming();
+  char line[96];
 
-  http.begin(url);
-  http.setTimeout(5000);
+  screen.setText(titleWidget, "Diagnostics", TFT_WHITE);
 
-  int httpCode = http.GET();
-  bool isUp = false;
+  uint8_t fragmentation = fragmentationPercent(heap.internalFree, heap.internalLargest);
+  snprintf(line, sizeof(line), "Heap %luk free, %u%% fragmented",
+    (unsigned long)heap.internalFree / 1024, fragmentation);
+  screen.setText(statusWidget, line, heap.internalMinFree < 16 * 1024 ? TFT_ORANGE : TFT_GREEN);
 
-  if (httpCode > 0) {
-      // HA returns 404 for /api/, but ANY positive HTTP status means the service is alive
-      isUp = true;
+  snprintf(line, sizeof(line), "Heap low-water: %luk", (unsigned long)heap.internalMinFree / 1024);
+  screen.setText(typeWidget, line, TFT_YELLOW);
+
+  if (heap.psramSize > 0) {
+    snprintf(line, sizeof(line), "PSRAM: %luk free, block %luk",
+      (unsigned long)heap.psramFree / 1024, (unsigned long)heap.psramLargest / 1024);
   } else {
-      service.lastError = "Connection failed: " + String(httpCode);
+    snprintf(line, sizeof(line), "PSRAM: none");
   }
+  screen.setText(hostWidget, line, TFT_WHITE);
 
-  http.end();
-  return isUp;
+  snprintf(line, sizeof(line), "Loop: avg %lu us, max %lu us",
+    (unsigned long)loopStats.averageMicros(), (unsigned long)loopStats.maxMicros);
+  screen.setText(lastCheckWidget, line, TFT_WHITE);
+
+  snprintf(line, sizeof(line), "Checks: last %lu ms, max %lu ms",
+    (unsigned long)checkStats.lastMicros / 1000, (unsigned long)checkStats.maxMicros / 1000);
+  screen.setText(errorWidget, line, TFT_WHITE);
+
+  snprintf(line, sizeof(line), "Up %lus, tasks at /api/diag", millis() / 1000);
+  screen.setText(footerWidget, line, TFT_LIGHTGREY);
+  screen.setText(rotationWidget, "Long press for the next view", TFT_LIGHTGREY);
+
+  screen.flush();
 }
 
-bool checkJellyfin(Service& service) {
-  HTTPClient http;
-  String url = "http://" + service.host + ":" + String(service.port) + "/health";
+// Wakes the render task on every vertical sync pulse. The task only waits
+// for the notification right before pushing, so idle pulses cost one ISR.
+void IRAM_ATTR onPanelVsync(void* arg) {
+  if (displayTaskHandle == nullptr) return;
+
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(displayTaskHandle, &woken);
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
 
-  http.begin(url);
-  http.setTimeout(5000);
+// The LCD peripheral keeps driving VSYNC; enabling the pad's input buffer
+// lets the GPIO block see the same edges.
+bool initVsyncInterrupt() {
+  if (TFT_VSYNC_PIN < 0) return false;
 
-  int httpCode = http.GET();
-  bool isUp = false;
+  gpio_num_t pin = (gpio_num_t)TFT_VSYNC_PIN;
+  esp_err_t err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    return false;
+  }
 
-  if (httpCode > 0) {
-    if (httpCode == 200) {
-      isUp = true;
+  PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[pin]);
+  gpio_set_intr_type(pin, GPIO_INTR_NEGEDGE);  // VSYNC is active low
+  return gpio_isr_handler_add(pin, onPanelVsync, nullptr) == ESP_OK &&
+         gpio_intr_enable(pin) == ESP_OK;
+}
+
+// Called by the renderers right before their first push of a frame, so the
+// frame buffer is written just after the panel started a new scan instead of
+// at a random point where the scan would show half-old, half-new widgets.
+void syncFrameToVsync() {
+  if (frameSynced) return;
+  frameSynced = true;
+
+  uint32_t start = micros();
+  ulTaskNotifyTake(pdTRUE, 0);  // drop pulses from before this frame
+  if (ulTaskNotifyTake(pdTRUE, VSYNC_TIMEOUT_TICKS) == 0) {
+    frameStats.vsyncTimeouts++;
+  }
+  frameStats.lastVsyncWaitMicros = micros() - start;
+}
+
+// Marks the screen for redraw. `requestedMicros` is when the cause happened
+// and is kept for the oldest pending request.
+void requestFrame(uint32_t requestedMicros) {
+  if (frameRequestedMicros == 0) {
+    frameRequestedMicros = requestedMicros != 0 ? requestedMicros : 1;
+  }
+  displayNeedsUpdate = true;
+}
+
+// Runs on the touch task; wakes the render task to take the gesture.
+void notifyTouchGesture() {
+  postDisplayEvent(DISPLAY_EVENT_TOUCH);
+}
+
+// Render task: sleeps until a display event arrives or a frame is due, then
+// runs one display iteration. Pinned away from the WiFi core and independent
+// of loop(), so probe timeouts never freeze the screen.
+void displayTask(void* parameter) {
+  for (;;) {
+    // A pending frame held back by the frame cap only needs one interval.
+    // With the backlight off only an event can change anything.
+    TickType_t wait = displayNeedsUpdate ? pdMS_TO_TICKS(DISPLAY_FRAME_INTERVAL) : DISPLAY_IDLE_TICKS;
+    if (backlightLevel == 0) {
+      wait = portMAX_DELAY;
     }
-  } else {
-    service.lastError = "Connection failed: " + String(httpCode);
+
+    DisplayEvent event;
+    if (receiveDisplayEvent(event, wait)) {
+      do {
+        requestFrame(event.postedMicros);
+      } while (receiveDisplayEvent(event, 0));
+    }
+
+    handleDisplayLoop();
   }
+}
 
-  http.end();
-  return isUp;
+// Sets the panel backlight. Turning it off releases the power management
+// locks held for the panel; turning it back on repaints everything, since
+// nothing was drawn while it was dark.
+void setBacklight(uint8_t level) {
+  if (level == backlightLevel) return;
+
+  bool wasOff = backlightLevel == 0;
+  if (level > 0) {
+    setDisplayPowered(true);
+    if (lightSleepEnabled()) setTouchIdlePolling(portMAX_DELAY);
+  }
+  if (TFT_BL_PIN >= 0) {
+    display.setBrightness(level);
+  }
+  if (level == 0) {
+    setDisplayPowered(false);
+    if (lightSleepEnabled()) setTouchIdlePolling(TOUCH_SLEEP_POLL_TICKS);
+  }
+
+  backlightLevel = level;
+  recordBacklight(level);
+
+  if (wasOff && level > 0 && displayReady) {
+    setDisplayMode(displayMode);
+    lastDisplaySwitch = millis();
+  }
 }
 
-bool checkHttpGet(Service& service) {
-  HTTPClient http;
-  String url = "http://" + service.host + ":" + String(service.port) + service.path;
+// Without a backlight pin the panel simply stays lit.
+void updateBacklight(unsigned long now) {
+  if (TFT_BL_PIN < 0) return;
 
-  http.begin(url);
-  http.setTimeout(5000);
+  unsigned long idle = now - lastUserActivity;
+  uint8_t level = DISPLAY_BRIGHTNESS;
+  if (DISPLAY_OFF_AFTER_MS > 0 && idle >= DISPLAY_OFF_AFTER_MS) {
+    level = 0;
+  } else if (DISPLAY_DIM_AFTER_MS > 0 && idle >= DISPLAY_DIM_AFTER_MS) {
+    level = DISPLAY_DIM_BRIGHTNESS;
+  }
+  setBacklight(level);
+}
 
-  int httpCode = http.GET();
-  bool isUp = false;
+// Advances the current view: next/previous page on the grid, next/previous
+// service on the single-service screen.
+void stepDisplay(int direction, int serviceCount) {
+  if (displayMode == DISPLAY_MODE_GRID) {
+    int pages = statusGrid.pageCount();
+    gridPage = (gridPage + direction + pages) % pages;
+  } else if (displayMode == DISPLAY_MODE_DETAIL && serviceCount > 0) {
+    currentServiceIndex = (currentServiceIndex + direction + serviceCount) % serviceCount;
+  }
+  displayNeedsUpdate = true;
+}
 
-  if (httpCode > 0) {
-    if (httpCode == 200) {
-      if (service.expectedResponse == "*") {
-        isUp = true;
-      } else {
-        String payload = http.getString();
-        isUp = payload.indexOf(service.expectedResponse) >= 0;
-        if (!isUp) {
-          service.lastError = "Response mismatch";
+// Taps work as before (header toggles the view, tiles open a service, the
+// sides or the grid footer step). Swiping left/right steps, and a long press
+// anywhere cycles service screen, status wall and diagnostics. Returns false
+// if the gesture did nothing.
+bool handleTouchGesture(const TouchGesture& gesture, int serviceCount) {
+  bool leftHalf = gesture.x < display.width() / 2;
+
+  switch (gesture.type) {
+    case GESTURE_TAP:
+      if (gesture.y < DISPLAY_BODY_TOP) {
+        setDisplayMode(displayMode == DISPLAY_MODE_GRID ? DISPLAY_MODE_DETAIL : DISPLAY_MODE_GRID);
+      } else if (displayMode == DISPLAY_MODE_GRID) {
+        int position = statusGrid.positionAt(gridPage, gesture.x, gesture.y);
+        if (position >= 0) {
+          currentServiceIndex = position;
+          setDisplayMode(DISPLAY_MODE_DETAIL);
+        } else if (gesture.y >= DISPLAY_BODY_TOP + DISPLAY_BODY_HEIGHT) {
+          stepDisplay(leftHalf ? -1 : 1, serviceCount);
+        } else {
+          return false;
         }
+      } else {
+        stepDisplay(leftHalf ? -1 : 1, serviceCount);
       }
-    } else {
-      service.lastError = "HTTP " + String(httpCode);
+      return true;
+
+    case GESTURE_LONG_PRESS:
+      setDisplayMode(displayMode == DISPLAY_MODE_DETAIL ? DISPLAY_MODE_GRID
+                     : displayMode == DISPLAY_MODE_GRID ? DISPLAY_MODE_DIAG
+                     : DISPLAY_MODE_DETAIL);
+      return true;
+
+    case GESTURE_SWIPE_LEFT:
+      stepDisplay(1, serviceCount);
+      return true;
+
+    case GESTURE_SWIPE_RIGHT:
+      stepDisplay(-1, serviceCount);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void handleDisplayLoop() {
+  if (!displayReady) return;
+
+  unsigned long now = millis();
+
+  int serviceCount;
+  {
+    ServiceSnapshotGuard snapshot;
+    if (snapshot->version != renderedSnapshotVersion) {
+      statusGrid.sync(snapshot->table);
+      renderedSnapshotVersion = snapshot->version;
+      displayNeedsUpdate = true;
     }
-  } else {
-    service.lastError = "Connection failed: " + String(httpCode);
+    serviceCount = snapshot->table.count;
   }
 
-  http.end();
-  return isUp;
-}
+  // A service newly DOWN counts as activity so the screen shows it
+  if (statusGrid.downCount() > shownDownCount) {
+    lastUserActivity = now;
+  }
+  shownDownCount = statusGrid.downCount();
+
+  TouchGesture gesture;
+  while (nextTouchGesture(gesture)) {
+    // The touch that wakes a dark screen does nothing else
+    bool wasOff = backlightLevel == 0;
+    lastUserActivity = now;
+    if (wasOff || !handleTouchGesture(gesture, serviceCount)) continue;
 
-bool checkPing(Service& service) {
-  bool success = Ping.ping(service.host.c_str(), 3);
-  if (!success) {
-    service.lastError = "Ping timeout";
+    if (touchRequestedMicros == 0) {
+      touchRequestedMicros = gesture.micros != 0 ? gesture.micros : 1;
+    }
+    lastDisplaySwitch = now;
+  }
+
+  updateBacklight(now);
+  if (backlightLevel == 0) return;
+
+  if (now - lastDisplaySwitch >= DISPLAY_ROTATION_INTERVAL) {
+    stepDisplay(1, serviceCount);
+    lastDisplaySwitch = now;
+  }
+
+  // Refresh once a second so the "Last check" counter advances in place, but
+  // never faster than the frame cap however many events arrive
+  bool due = displayNeedsUpdate || now - lastDisplayRefresh >= 1000;
+  if (!due || now - lastDisplayRefresh < DISPLAY_FRAME_INTERVAL) return;
+
+  uint32_t start = micros();
+  frameSynced = false;
+  {
+    ServiceSnapshotGuard snapshot;
+    renderServiceOnDisplay(snapshot->table);
+  }
+  uint32_t end = micros();
+
+  uint32_t elapsed = end - start;
+  frameStats.frames++;
+  frameStats.lastFrameMicros = elapsed;
+  frameStats.totalFrameMicros += elapsed;
+  if (elapsed > frameStats.maxFrameMicros) {
+    frameStats.maxFrameMicros = elapsed;
+  }
+
+  if (frameRequestedMicros != 0) {
+    uint32_t latency = end - frameRequestedMicros;
+    frameStats.lastLatencyMicros = latency;
+    if (latency > frameStats.maxLatencyMicros) {
+      frameStats.maxLatencyMicros = latency;
+    }
+    frameRequestedMicros = 0;
+  }
+
+  if (touchRequestedMicros != 0) {
+    uint32_t latency = end - touchRequestedMicros;
+    frameStats.lastTouchLatencyMicros = latency;
+    if (latency > frameStats.maxTouchLatencyMicros) {
+      frameStats.maxTouchLatencyMicros = latency;
+    }
+    touchRequestedMicros = 0;
   }
-  return success;
+
+  displayNeedsUpdate = false;
+  lastDisplayRefresh = now;
+  recordBootStage(BOOT_FIRST_FRAME);
 }
 
 void sendOfflineNotification(const Service& service) {
@@ -994,11 +2236,6 @@ void sendOfflineNotification(const Service& service) {
     return;
   }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Skipping notifications: WiFi not connected");
-    return;
-  }
-
   String title = "Service DOWN: " + service.name;
   String message = "Service '" + service.name + "' at " + service.host;
   if (service.port > 0) {
@@ -1010,17 +2247,7 @@ void sendOfflineNotification(const Service& service) {
     message += " Error: " + service.lastError;
   }
 
-  if (isNtfyConfigured()) {
-    sendNtfyNotification(title, message, "warning,monitor");
-  }
-
-  if (isDiscordConfigured()) {
-    sendDiscordNotification(title, message);
-  }
-
-  if (isSmtpConfigured()) {
-    sendSmtpNotification(title, message);
-  }
+  sendAlert(title, message, "warning,monitor");
 }
 
 void sendOnlineNotification(const Service& service) {
@@ -1028,11 +2255,6 @@ void sendOnlineNotification(const Service& service) {
     return;
   }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Skipping notifications: WiFi not connected");
-    return;
-  }
-
   String title = "Service UP: " + service.name;
   String message = "Service '" + service.name + "' at " + service.host;
   if (service.port > 0) {
@@ -1040,8 +2262,29 @@ void sendOnlineNotification(const Service& service) {
   }
   message += " is back online.";
 
+  sendAlert(title, message, "ok,monitor");
+}
+
+// Sends to every configured channel, or queues the alert while WiFi is down
+void sendAlert(const String& title, const String& message, const String& tags) {
+  if (!wifiLinkUp()) {
+    if (pendingAlertCount == ALERT_QUEUE_SIZE) {
+      pendingAlertFirst = (pendingAlertFirst + 1) % ALERT_QUEUE_SIZE;
+      pendingAlertCount--;
+      droppedAlerts++;
+    }
+    PendingAlert& alert = pendingAlerts[(pendingAlertFirst + pendingAlertCount) % ALERT_QUEUE_SIZE];
+    alert.title = title;
+    alert.message = message;
+    alert.tags = tags;
+    alert.raisedMillis = millis();
+    pendingAlertCount++;
+    logPrintf(LOG_WARN, "WiFi down, alert queued: %s", title.c_str());
+    return;
+  }
+
   if (isNtfyConfigured()) {
-    sendNtfyNotification(title, message, "ok,monitor");
+    sendNtfyNotification(title, message, tags);
   }
 
   if (isDiscordConfigured()) {
@@ -1053,6 +2296,20 @@ void sendOnlineNotification(const Service& service) {
   }
 }
 
+void sendPendingAlerts() {
+  while (pendingAlertCount > 0 && wifiLinkUp()) {
+    PendingAlert& alert = pendingAlerts[pendingAlertFirst];
+    String message = alert.message + " (delayed " + String((millis() - alert.raisedMillis) / 1000) +
+      "s while WiFi was down)";
+    String title = alert.title;
+    String tags = alert.tags;
+    alert = PendingAlert();  // frees the strings
+    pendingAlertFirst = (pendingAlertFirst + 1) % ALERT_QUEUE_SIZE;
+    pendingAlertCount--;
+    sendAlert(title, message, tags);
+  }
+}
+
 void sendNtfyNotification(const String& title, const String& message, const String& tags) {
   HTTPClient http;
   String url = String(NTFY_SERVER) + "/" + NTFY_TOPIC;
@@ -1078,9 +2335,9 @@ void sendNtfyNotification(const String& title, const String& message, const Stri
   int httpCode = http.POST(message);
 
   if (httpCode > 0) {
-    Serial.printf("ntfy notification sent: %d\n", httpCode);
+    logPrintf(LOG_INFO, "ntfy notification sent: %d", httpCode);
   } else {
-    Serial.printf("Failed to send ntfy notification: %d\n", httpCode);
+    logPrintf(LOG_ERROR, "Failed to send ntfy notification: %d", httpCode);
   }
 
   http.end();
@@ -1110,9 +2367,9 @@ void sendDiscordNotification(const String& title, const String& message) {
   int httpCode = http.POST(payload);
 
   if (httpCode > 0) {
-    Serial.printf("Discord notification sent: %d\n", httpCode);
+    logPrintf(LOG_INFO, "Discord notification sent: %d", httpCode);
   } else {
-    Serial.printf("Failed to send Discord notification: %d\n", httpCode);
+    logPrintf(LOG_ERROR, "Failed to send Discord notification: %d", httpCode);
   }
 
   http.end();
@@ -1151,7 +2408,7 @@ bool readSmtpResponse(WiFiClient& client, int expectedCode) {
     }
 
     if (!client.available()) {
-      Serial.println("SMTP response timeout");
+      logPrintf(LOG_ERROR, "SMTP response timeout");
       return false;
     }
 
@@ -1163,7 +2420,7 @@ bool readSmtpResponse(WiFiClient& client, int expectedCode) {
   } while (line.length() >= 4 && line.charAt(3) == '-');
 
   if (code != expectedCode) {
-    Serial.printf("SMTP unexpected response (expected %d): %s\n", expectedCode, line.c_str());
+    logPrintf(LOG_ERROR, "SMTP unexpected response (expected %d): %s", expectedCode, line.c_str());
     return false;
   }
 
@@ -1186,7 +2443,7 @@ void sendSmtpNotification(const String& title, const String& message) {
   }
 
   if (!client->connect(SMTP_SERVER, SMTP_PORT)) {
-    Serial.println("Failed to connect to SMTP server");
+    logPrintf(LOG_ERROR, "Failed to connect to SMTP server");
     return;
   }
 
@@ -1227,45 +2484,46 @@ void sendSmtpNotification(const String& title, const String& message) {
   sendSmtpCommand(*client, "QUIT", 221);
   client->stop();
 
-  Serial.println("SMTP notification sent");
+  logPrintf(LOG_INFO, "SMTP notification sent");
 }
 
+const char* SERVICES_FILE = "/services.bin";
+const char* SERVICES_TEMP_FILE = "/services.bin.tmp";
+const char* LEGACY_SERVICES_FILE = "/services.json";
+
 void saveServices() {
-  File file = LittleFS.open("/services.json", "w");
+  // Write to a temporary file first so a power loss mid-write never leaves a truncated table
+  File file = LittleFS.open(SERVICES_TEMP_FILE, "w");
   if (!file) {
-    Serial.println("Failed to open services.json for writing");
+    logPrintf(LOG_ERROR, "Failed to open services.bin.tmp for writing");
     return;
   }
 
-  JsonDocument doc;
-  JsonArray array = doc["services"].to<JsonArray>();
+  bool written = writeServicesBinary(file, serviceTable);
+  file.close();
 
-  for (int i = 0; i < serviceCount; i++) {
-    JsonObject obj = array.add<JsonObject>();
-    obj["id"] = services[i].id;
-    obj["name"] = services[i].name;
-    obj["type"] = (int)services[i].type;
-    obj["host"] = services[i].host;
-    obj["port"] = services[i].port;
-    obj["path"] = services[i].path;
-    obj["expectedResponse"] = services[i].expectedResponse;
-    obj["checkInterval"] = services[i].checkInterval;
-    obj["passThreshold"] = services[i].passThreshold;
-    obj["failThreshold"] = services[i].failThreshold;
+  if (!written) {
+    logPrintf(LOG_ERROR, "Failed to write services.bin");
+    LittleFS.remove(SERVICES_TEMP_FILE);
+    return;
   }
 
-  if (serializeJson(doc, file) == 0) {
-    Serial.println("Failed to serialize services.json");
+  if (!LittleFS.rename(SERVICES_TEMP_FILE, SERVICES_FILE)) {
+    LittleFS.remove(SERVICES_FILE);
+    if (!LittleFS.rename(SERVICES_TEMP_FILE, SERVICES_FILE)) {
+      logPrintf(LOG_ERROR, "Failed to replace services.bin");
+      return;
+    }
   }
-  file.close();
-  Serial.println("Services saved");
+
+  logPrintf(LOG_INFO, "Services saved");
 }
 
-void loadServices() {
-  File file = LittleFS.open("/services.json", "r");
+// Reads the pre-binary services.json layout. Only used to migrate existing installs.
+bool loadServicesFromJson() {
+  File file = LittleFS.open(LEGACY_SERVICES_FILE, "r");
   if (!file) {
-    Serial.println("No services.json found, starting fresh");
-    return;
+    return false;
   }
 
   JsonDocument doc;
@@ -1274,46 +2532,68 @@ void loadServices() {
 
   if (error) {
     Serial.println("Failed to parse services.json");
-    return;
+    return false;
   }
 
   JsonArray array = doc["services"];
-  serviceCount = 0;
+  int loaded = 0;
 
   for (JsonObject obj : array) {
-    if (serviceCount >= MAX_SERVICES) break;
-
-    services[serviceCount].id = obj["id"].as<String>();
-    services[serviceCount].name = obj["name"].as<String>();
-    services[serviceCount].type = (ServiceType)obj["type"].as<int>();
-    services[serviceCount].host = obj["host"].as<String>();
-    services[serviceCount].port = obj["port"];
-    services[serviceCount].path = obj["path"].as<String>();
-    services[serviceCount].expectedResponse = obj["expectedResponse"].as<String>();
-    services[serviceCount].checkInterval = obj["checkInterval"];
-    services[serviceCount].passThreshold = obj["passThreshold"] | 1;
-    services[serviceCount].failThreshold = obj["failThreshold"] | 1;
-    services[serviceCount].consecutivePasses = 0;
-    services[serviceCount].consecutiveFails = 0;
-    services[serviceCount].isUp = false;
-    services[serviceCount].lastCheck = 0;
-    services[serviceCount].lastUptime = 0;
-    services[serviceCount].lastError = "";
-    services[serviceCount].secondsSinceLastCheck = -1;
-
-    serviceCount++;
-  }
-
-  Serial.printf("Loaded %d services\n", serviceCount);
+    if (loaded >= MAX_SERVICES) break;
+
+    Service& service = serviceTable.slots[loaded];
+    service.id = 0;
+    parseServiceId(obj["id"].as<String>(), service.id);
+    service.name = obj["name"].as<String>();
+    service.type = (ServiceType)obj["type"].as<int>();
+    service.host = obj["host"].as<String>();
+    service.port = obj["port"];
+    service.path = obj["path"].as<String>();
+    service.expectedResponse = obj["expectedResponse"].as<String>();
+    service.checkInterval = obj["checkInterval"];
+    service.passThreshold = obj["passThreshold"] | 1;
+    service.failThreshold = obj["failThreshold"] | 1;
+    resetServiceRuntime(service);
+
+    loaded++;
+  }
+
+  serviceTable.adoptLoadedSlots(loaded);
+  return true;
 }
 
-String getServiceTypeString(ServiceType type) {
-  switch (type) {
-    case TYPE_HOME_ASSISTANT: return "home_assistant";
-    case TYPE_JELLYFIN: return "jellyfin";
-    case TYPE_HTTP_GET: return "http_get";
-    case TYPE_PING: return "ping";
-    default: return "unknown";
+void loadServices() {
+  File file = LittleFS.open(SERVICES_FILE, "r");
+  if (file) {
+    int count = readServicesBinary(file, serviceTable.slots, MAX_SERVICES);
+    file.close();
+
+    if (count >= 0) {
+      int reassigned = serviceTable.adoptLoadedSlots(count);
+      seedServiceIds(serviceTable);
+      Serial.printf("Loaded %d services\n", serviceTable.count);
+      if (reassigned > 0) {
+        saveServices();
+      }
+      return;
+    }
+
+    Serial.println("services.bin is corrupt or from an unsupported version");
+    serviceTable.clear();
+  }
+
+  bool migrated = loadServicesFromJson();
+  seedServiceIds(serviceTable);
+
+  if (!migrated) {
+    Serial.println("No services file found, starting fresh");
+    return;
+  }
+
+  Serial.printf("Loaded %d services from services.json, migrating to binary format\n", serviceTable.count);
+  saveServices();
+  if (LittleFS.exists(SERVICES_FILE)) {
+    LittleFS.remove(LEGACY_SERVICES_FILE);
   }
 }
 
@@ -0,0 +1,144 @@
+#include "power.hpp"
+
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+
+namespace {
+
+portMUX_TYPE powerLock = portMUX_INITIALIZER_UNLOCKED;
+PowerStats stats = {};
+bool displayPowered = true;
+uint8_t brightness = 0;
+unsigned long brightnessSince = 0;
+
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t frequencyLock = nullptr;
+esp_pm_lock_handle_t sleepLock = nullptr;
+#endif
+
+// Adds the time since the last brightness change. Call with powerLock held.
+void accountBacklight(unsigned long now) {
+  unsigned long elapsed = now - brightnessSince;
+  if (brightness > 0) {
+    stats.backlightMillis += elapsed;
+    stats.brightnessMillis += (uint64_t)brightness * elapsed;
+  }
+  brightnessSince = now;
+}
+
+}  // namespace
+
+void initPowerManagement() {
+  // Modem sleep keeps the AP association while the radio naps between beacons
+  WiFi.setSleep(WIFI_PS_MIN_MODEM);
+
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t config = {};
+#else
+  esp_pm_config_esp32s3_t config = {};
+#endif
+  config.max_freq_mhz = 240;
+  config.min_freq_mhz = 80;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  config.light_sleep_enable = true;
+#endif
+
+  esp_err_t err = esp_pm_configure(&config);
+  if (err == ESP_OK) {
+    stats.dynamicFrequency = true;
+    stats.lightSleep = config.light_sleep_enable;
+    esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "display", &frequencyLock);
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "display", &sleepLock);
+    // The display may already have been switched off, e.g. when its init
+    // failed; the locks then stay released until it is powered again
+    portENTER_CRITICAL(&powerLock);
+    bool on = displayPowered;
+    portEXIT_CRITICAL(&powerLock);
+    if (on && frequencyLock != nullptr) esp_pm_lock_acquire(frequencyLock);
+    if (on && sleepLock != nullptr) esp_pm_lock_acquire(sleepLock);
+  } else {
+    Serial.printf("Power management unavailable: %s\n", esp_err_to_name(err));
+  }
+#endif
+
+  Serial.printf("Power: frequency scaling %s, light sleep %s\n",
+    stats.dynamicFrequency ? "on" : "off", stats.lightSleep ? "on" : "off");
+}
+
+bool lightSleepEnabled() {
+  return stats.lightSleep;
+}
+
+void setDisplayPowered(bool on) {
+  portENTER_CRITICAL(&powerLock);
+  bool changed = displayPowered != on;
+  displayPowered = on;
+  portEXIT_CRITICAL(&powerLock);
+  if (!changed) return;
+
+#if CONFIG_PM_ENABLE
+  if (frequencyLock == nullptr || sleepLock == nullptr) return;
+
+  if (on) {
+    esp_pm_lock_acquire(frequencyLock);
+    esp_pm_lock_acquire(sleepLock);
+  } else {
+    esp_pm_lock_release(sleepLock);
+    esp_pm_lock_release(frequencyLock);
+  }
+#endif
+}
+
+void recordBacklight(uint8_t level) {
+  portENTER_CRITICAL(&powerLock);
+  accountBacklight(millis());
+  brightness = level;
+  portEXIT_CRITICAL(&powerLock);
+}
+
+void recordLoopIdle(uint32_t idle) {
+  portENTER_CRITICAL(&powerLock);
+  stats.idleMillis += idle;
+  if (!displayPowered) {
+    stats.sleepableMillis += idle;
+  }
+  portEXIT_CRITICAL(&powerLock);
+}
+
+void recordCheckLateness(uint32_t lateness) {
+  portENTER_CRITICAL(&powerLock);
+  stats.checks++;
+  stats.lastCheckLateness = lateness;
+  stats.totalCheckLateness += lateness;
+  if (lateness > stats.maxCheckLateness) {
+    stats.maxCheckLateness = lateness;
+  }
+  portEXIT_CRITICAL(&powerLock);
+}
+
+PowerStats powerStats() {
+  portENTER_CRITICAL(&powerLock);
+  unsigned long now = millis();
+  accountBacklight(now);
+  PowerStats copy = stats;
+  portEXIT_CRITICAL(&powerLock);
+
+  copy.uptimeMillis = now;
+  return copy;
+}
+
+float estimatedCurrentMa(const PowerStats& stats) {
+  if (stats.uptimeMillis == 0) return 0;
+
+  double uptime = (double)stats.uptimeMillis;
+  double sleeping = stats.lightSleep ? (double)stats.sleepableMillis : 0;
+  double idle = (double)stats.idleMillis - sleeping;
+  double active = uptime - idle - sleeping;
+  if (active < 0) active = 0;
+
+  double charge = active * POWER_ACTIVE_MA + idle * POWER_IDLE_MA + sleeping * POWER_LIGHT_SLEEP_MA +
+                  (double)stats.brightnessMillis / 255.0 * POWER_BACKLIGHT_MA;
+  return (float)(charge / uptime);
+}
@@ -0,0 +1,98 @@
+#include "probe_simulator.hpp"
+
+namespace {
+
+// Checks made per service id, so each service has its own reproducible
+// sequence regardless of how checks interleave
+uint64_t counterIds[MAX_SERVICES] = {};
+uint32_t counterValues[MAX_SERVICES] = {};
+uint32_t checks = 0;
+uint32_t failures = 0;
+
+uint32_t nextCheckNumber(uint64_t id) {
+  int free = -1;
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    if (counterIds[i] == id) return ++counterValues[i];
+    if (counterIds[i] == 0 && free < 0) free = i;
+  }
+  if (free < 0) return checks;  // more ids than slots over time; stop tracking
+
+  counterIds[free] = id;
+  counterValues[free] = 1;
+  return 1;
+}
+
+// Ids start at a random value each boot, so draws are keyed on the name
+uint64_t nameKey(const String& name) {
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+  for (size_t i = 0; i < name.length(); i++) {
+    hash = (hash ^ (uint8_t)name[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// SplitMix64 finaliser; uniform enough for percentages
+uint32_t draw(uint64_t key, uint32_t checkNumber, uint32_t salt) {
+  uint64_t x = key ^ ((uint64_t)checkNumber << 32) ^ salt;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return (uint32_t)x;
+}
+
+}  // namespace
+
+ProbeError simulatedProbe(Service& service) {
+  checks++;
+  uint32_t checkNumber = nextCheckNumber(service.id);
+  uint64_t key = nameKey(service.name);
+
+  bool slow = draw(key, checkNumber, 1) % 100 < SIMULATED_SLOW_PERCENT;
+  bool failed = draw(key, checkNumber, 2) % 100 < SIMULATED_ERROR_PERCENT;
+
+  // +/- 50% jitter around the typical latency
+  uint32_t latency = SIMULATED_LATENCY_MS / 2 + draw(key, checkNumber, 3) % (SIMULATED_LATENCY_MS + 1);
+  if (slow) {
+    latency = SIMULATED_SLOW_MS;
+  }
+  delay(latency);
+
+  if (failed) {
+    failures++;
+    service.lastError = slow ? "Simulated timeout" : "Simulated failure";
+    return slow ? PROBE_TIMEOUT : PROBE_CONNECT_FAILED;
+  }
+  return PROBE_OK;
+}
+
+int addSimulatedServices(ServiceTable& table, int count) {
+  if (table.count > 0) return 0;
+
+  int added = 0;
+  for (int i = 0; i < count; i++) {
+    Service service;
+    service.id = generateServiceId();
+    service.name = "sim-" + String(i + 1);
+    service.type = TYPE_HTTP_GET;
+    service.host = "simulated";
+    service.port = 80;
+    service.path = "/";
+    service.expectedResponse = "*";
+    service.checkInterval = SIMULATED_CHECK_INTERVAL;
+    service.passThreshold = 1;
+    service.failThreshold = 2;
+    resetServiceRuntime(service);
+
+    if (table.add(service) == nullptr) break;
+    added++;
+  }
+  return added;
+}
+
+uint32_t simulatedChecks() {
+  return checks;
+}
+
+uint32_t simulatedFailures() {
+  return failures;
+}
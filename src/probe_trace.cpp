@@ -0,0 +1,325 @@
+#include "probe_trace.hpp"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#include "logger.hpp"
+
+namespace {
+
+const char* LEGACY_TRACE_FILE = "/trace.bin";  // the single ring file of earlier builds
+const uint32_t TRACE_SEGMENTS = TRACE_CAPACITY / TRACE_SEGMENT_RECORDS;
+
+// Guards the segment files and the buffer against readTrace() from the web
+// server. Held for one batch write at most.
+SemaphoreHandle_t traceLock = nullptr;
+File segmentFile;           // newest segment, open for appending
+uint32_t segmentFirst = 0;  // sequence of its first record, 0 if none is open
+
+uint32_t stored = 0;  // sequence of the newest record written
+uint32_t oldest = 1;  // sequence of the oldest record kept
+TraceRecord pending[TRACE_FLUSH_RECORDS];
+int pendingCount = 0;
+uint32_t pendingSince = 0;
+uint32_t sinceConfigs = 0;
+
+// First sequence of the segment holding `sequence`
+uint32_t segmentStart(uint32_t sequence) {
+  return sequence - (sequence - 1) % TRACE_SEGMENT_RECORDS;
+}
+
+// Segments are numbered in turn, so the file of the next one is always that
+// of the oldest
+uint32_t segmentIndex(uint32_t first) {
+  return (first - 1) / TRACE_SEGMENT_RECORDS % TRACE_SEGMENTS;
+}
+
+void segmentPath(uint32_t index, char* path, size_t size) {
+  snprintf(path, size, "/trace.%u.bin", (unsigned)index);
+}
+
+// Reads the header of the segment file `index`. False if there is none or
+// its layout does not match this build; `torn` if a cut-short write left
+// part of a record at the end.
+bool readSegment(uint32_t index, uint32_t& first, uint32_t& records, bool& torn) {
+  char path[24];
+  segmentPath(index, path, sizeof(path));
+  if (!LittleFS.exists(path)) return false;
+
+  File file = LittleFS.open(path, "r");
+  if (!file) return false;
+
+  TraceHeader header;
+  size_t read = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+  size_t size = file.size();
+  file.close();
+
+  if (read != sizeof(header) || header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+      header.recordSize != sizeof(TraceRecord) || header.capacity != TRACE_CAPACITY ||
+      header.sequence == 0 || segmentStart(header.sequence) != header.sequence ||
+      segmentIndex(header.sequence) != index) {
+    return false;
+  }
+  first = header.sequence;
+  records = (size - sizeof(header)) / sizeof(TraceRecord);
+  torn = (size - sizeof(header)) % sizeof(TraceRecord) != 0 || records > TRACE_SEGMENT_RECORDS;
+  return true;
+}
+
+void removeSegment(uint32_t index) {
+  char path[24];
+  segmentPath(index, path, sizeof(path));
+  if (LittleFS.exists(path)) LittleFS.remove(path);
+}
+
+// Opens the segment that starts at `first` for the next record. A new one
+// replaces the oldest; an unfinished one must end where `stored` says, or
+// it is dropped and started again. Caller holds traceLock.
+bool openSegment(uint32_t first) {
+  if (segmentFile) segmentFile.close();
+  segmentFirst = 0;
+
+  uint32_t index = segmentIndex(first);
+  char path[24];
+  segmentPath(index, path, sizeof(path));
+
+  if (stored + 1 != first) {
+    uint32_t fileFirst, records;
+    bool torn;
+    if (readSegment(index, fileFirst, records, torn) && fileFirst == first && !torn &&
+        records == stored + 1 - first) {
+      segmentFile = LittleFS.open(path, "a");
+      if (!segmentFile) return false;
+      segmentFirst = first;
+      return true;
+    }
+    logPrintf(LOG_ERROR, "Probe trace: dropping damaged %s", path);
+    stored = first - 1;
+  }
+
+  removeSegment(index);
+  if (first > (TRACE_SEGMENTS - 1) * TRACE_SEGMENT_RECORDS) {
+    uint32_t kept = first - (TRACE_SEGMENTS - 1) * TRACE_SEGMENT_RECORDS;
+    if (oldest < kept) oldest = kept;
+  }
+
+  TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, sizeof(TraceRecord), TRACE_CAPACITY, first};
+  segmentFile = LittleFS.open(path, "w");
+  if (!segmentFile || segmentFile.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+    segmentFile.close();
+    return false;
+  }
+  segmentFirst = first;
+  return true;
+}
+
+// Appends the buffer to the newest segment, starting the next one where
+// the current one fills up. Caller holds traceLock.
+bool writePending() {
+  while (pendingCount > 0) {
+    uint32_t sequence = stored + 1;
+    uint32_t first = segmentStart(sequence);
+    if (segmentFirst != first && !openSegment(first)) return false;
+
+    int run = TRACE_SEGMENT_RECORDS - (sequence - first);
+    if (run > pendingCount) run = pendingCount;
+
+    size_t bytes = run * sizeof(TraceRecord);
+    bool ok = segmentFile.write(reinterpret_cast<const uint8_t*>(pending), bytes) == bytes;
+    segmentFile.flush();
+    if (!ok) {
+      // How much of the run landed is unknown; openSegment() checks
+      segmentFile.close();
+      segmentFirst = 0;
+      return false;
+    }
+
+    stored += run;
+    pendingCount -= run;
+    memmove(pending, pending + run, sizeof(TraceRecord) * pendingCount);
+  }
+  return true;
+}
+
+void append(const TraceRecord& record, uint32_t nowMillis) {
+  if (traceLock == nullptr) return;
+
+  // A full buffer means the previous write failed; make room for the newest
+  if (pendingCount == TRACE_FLUSH_RECORDS) {
+    flushProbeTrace(nowMillis);
+  }
+
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  if (pendingCount == TRACE_FLUSH_RECORDS) {
+    memmove(pending, pending + 1, sizeof(TraceRecord) * (TRACE_FLUSH_RECORDS - 1));
+    pendingCount--;
+  }
+  if (pendingCount == 0) {
+    pendingSince = nowMillis;
+  }
+  pending[pendingCount++] = record;
+  xSemaphoreGive(traceLock);
+
+  sinceConfigs++;
+}
+
+// Finds the newest segment and the unbroken run of full segments before
+// it, and deletes every other segment file. A torn newest segment is
+// deleted too; its records are written again from the start.
+void scanSegments() {
+  uint32_t firsts[TRACE_SEGMENTS];
+  uint32_t records[TRACE_SEGMENTS];
+  bool torn[TRACE_SEGMENTS];
+  bool valid[TRACE_SEGMENTS];
+  int newest = -1;
+  for (uint32_t i = 0; i < TRACE_SEGMENTS; i++) {
+    valid[i] = readSegment(i, firsts[i], records[i], torn[i]);
+    if (valid[i] && (newest < 0 || firsts[i] > firsts[newest])) newest = i;
+  }
+
+  stored = 0;
+  oldest = 1;
+  bool keep[TRACE_SEGMENTS] = {};
+  if (newest >= 0) {
+    uint32_t first = firsts[newest];
+    keep[newest] = !torn[newest];
+    stored = keep[newest] ? first + records[newest] - 1 : first - 1;
+    oldest = first;
+
+    for (uint32_t back = 1; back < TRACE_SEGMENTS && first > back * TRACE_SEGMENT_RECORDS; back++) {
+      uint32_t older = first - back * TRACE_SEGMENT_RECORDS;
+      uint32_t i = segmentIndex(older);
+      if (!valid[i] || firsts[i] != older || torn[i] || records[i] != TRACE_SEGMENT_RECORDS) break;
+      keep[i] = true;
+      oldest = older;
+    }
+  }
+
+  for (uint32_t i = 0; i < TRACE_SEGMENTS; i++) {
+    if (!keep[i]) removeSegment(i);
+  }
+  if (LittleFS.exists(LEGACY_TRACE_FILE)) LittleFS.remove(LEGACY_TRACE_FILE);
+}
+
+}  // namespace
+
+bool initProbeTrace() {
+  if (traceLock != nullptr) return true;
+
+  traceLock = xSemaphoreCreateMutex();
+  if (traceLock == nullptr) return false;
+  scanSegments();
+
+  TraceRecord boot = {0, (uint32_t)millis(), 0, TRACE_BOOT, 0};
+  append(boot, boot.millis);
+  logPrintf(LOG_INFO, "Probe trace: %u records stored", (unsigned)(stored - oldest + 1));
+  return true;
+}
+
+void traceProbe(const Service& service, bool passed, uint8_t error, uint32_t latencyMs, uint32_t nowMillis) {
+  TraceRecord record;
+  record.id = service.id;
+  record.millis = nowMillis;
+  record.value = latencyMs < UINT16_MAX ? latencyMs : UINT16_MAX;
+  record.kind = passed ? TRACE_PASS : TRACE_FAIL;
+  record.detail = error;
+  append(record, nowMillis);
+}
+
+void traceServiceConfigs(const ServiceTable& table, uint32_t nowMillis) {
+  for (int i = 0; i < table.count; i++) {
+    const Service& service = table.at(i);
+    TraceRecord record;
+    record.id = service.id;
+    record.millis = nowMillis;
+    record.value = service.passThreshold < UINT16_MAX ? service.passThreshold : UINT16_MAX;
+    record.kind = TRACE_CONFIG;
+    record.detail = service.failThreshold < UINT8_MAX ? service.failThreshold : UINT8_MAX;
+    append(record, nowMillis);
+  }
+  sinceConfigs = 0;
+}
+
+void traceRestoredState(const ServiceTable& table, uint32_t nowMillis) {
+  for (int i = 0; i < table.count; i++) {
+    const Service& service = table.at(i);
+    if (neverChecked(service)) continue;
+
+    // Only one of the counters is non-zero
+    bool passing = service.consecutivePasses > 0;
+    int count = passing ? service.consecutivePasses : service.consecutiveFails;
+    TraceRecord record;
+    record.id = service.id;
+    record.millis = nowMillis;
+    record.value = count < UINT16_MAX ? count : UINT16_MAX;
+    record.kind = TRACE_RESTORE;
+    record.detail = (service.isUp ? 1 : 0) | (passing ? 2 : 0);
+    append(record, nowMillis);
+  }
+}
+
+bool traceConfigDue() {
+  return sinceConfigs >= TRACE_CAPACITY / 2;
+}
+
+void flushProbeTrace(uint32_t nowMillis) {
+  if (traceLock == nullptr || pendingCount == 0) return;
+  if (pendingCount < TRACE_FLUSH_RECORDS && nowMillis - pendingSince < TRACE_FLUSH_MS) return;
+
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  bool ok = writePending();
+  xSemaphoreGive(traceLock);
+
+  if (!ok) {
+    logPrintf(LOG_ERROR, "Probe trace: write failed, %d records buffered", pendingCount);
+  }
+}
+
+uint32_t traceOldestSequence() {
+  return oldest;
+}
+
+uint32_t traceNewestSequence() {
+  return stored + pendingCount;
+}
+
+int readTrace(uint32_t sequence, TraceRecord* records, int max) {
+  if (traceLock == nullptr) return 0;
+
+  xSemaphoreTake(traceLock, portMAX_DELAY);
+  int copied = 0;
+
+  if (sequence >= oldest) {
+    // Stored part, up to the end of its segment
+    if (sequence <= stored) {
+      uint32_t first = segmentStart(sequence);
+      int run = stored - sequence + 1;
+      int untilEnd = TRACE_SEGMENT_RECORDS - (sequence - first);
+      if (run > untilEnd) run = untilEnd;
+      if (run > max) run = max;
+
+      char path[24];
+      segmentPath(segmentIndex(first), path, sizeof(path));
+      File file = LittleFS.open(path, "r");
+      size_t bytes = run * sizeof(TraceRecord);
+      if (file && file.seek(sizeof(TraceHeader) + (sequence - first) * sizeof(TraceRecord)) &&
+          file.read(reinterpret_cast<uint8_t*>(records), bytes) == bytes) {
+        copied = run;
+      }
+      file.close();
+    } else {
+      // Still buffered
+      int first = sequence - stored - 1;
+      while (copied < max && first + copied < pendingCount) {
+        records[copied] = pending[first + copied];
+        copied++;
+      }
+    }
+  }
+
+  xSemaphoreGive(traceLock);
+  return copied;
+}
@@ -0,0 +1,136 @@
+#include "runtime_state.hpp"
+
+#include <Preferences.h>
+#include <string.h>
+
+#include "incident_log.hpp"
+#include "logger.hpp"
+
+namespace {
+
+const char* NVS_NAMESPACE = "runtime";
+const char* NVS_KEY = "services";
+const uint32_t STATE_MAGIC = 0x54535452;  // "RTST"
+const uint16_t STATE_VERSION = 2;  // 2: open incidents
+
+const uint8_t INCIDENT_OPEN = 0x01;
+const uint8_t INCIDENT_DOWN = 0x02;
+
+struct __attribute__((packed)) StateHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+};
+
+struct __attribute__((packed)) StateRecord {
+  uint64_t id;
+  uint16_t consecutivePasses;  // capped at 65535
+  uint16_t consecutiveFails;
+  uint32_t lastLatency;
+  uint8_t isUp;
+  uint8_t incidentFlags;  // INCIDENT_OPEN, INCIDENT_DOWN
+  uint8_t incidentError;
+  uint8_t reserved;
+  uint32_t incidentStart;
+  uint32_t incidentFailedProbes;
+};
+
+struct StateBlob {
+  StateHeader header;
+  StateRecord records[MAX_SERVICES];
+};
+
+StateBlob blob;  // static: too large for the loop() stack with many services
+bool dirty = false;
+bool statusDirty = false;
+uint32_t lastSave = 0;
+
+uint16_t capped(int count) {
+  return count < 0 ? 0 : count > UINT16_MAX ? UINT16_MAX : count;
+}
+
+}  // namespace
+
+int restoreRuntimeState(ServiceTable& table) {
+  Preferences preferences;
+  if (!preferences.begin(NVS_NAMESPACE, true)) return 0;
+  size_t length = preferences.getBytesLength(NVS_KEY);
+  size_t read = length <= sizeof(blob) ? preferences.getBytes(NVS_KEY, &blob, length) : 0;
+  preferences.end();
+
+  if (read < sizeof(StateHeader) || blob.header.magic != STATE_MAGIC || blob.header.version != STATE_VERSION ||
+      read != sizeof(StateHeader) + blob.header.count * sizeof(StateRecord)) {
+    return 0;
+  }
+
+  int restored = 0;
+  for (int i = 0; i < blob.header.count; i++) {
+    const StateRecord& record = blob.records[i];
+    int slot = table.index.find(record.id);
+    if (slot < 0) continue;  // deleted since the snapshot
+
+    Service& service = table.slots[slot];
+    service.consecutivePasses = record.consecutivePasses;
+    service.consecutiveFails = record.consecutiveFails;
+    service.lastLatency = record.lastLatency;
+    service.isUp = record.isUp != 0;
+
+    if (record.incidentFlags & INCIDENT_OPEN) {
+      OpenIncidentState incident;
+      incident.start = record.incidentStart;
+      incident.failedProbes = record.incidentFailedProbes;
+      incident.firstError = record.incidentError;
+      incident.down = (record.incidentFlags & INCIDENT_DOWN) != 0;
+      restoreOpenIncident(slot, record.id, incident);
+    }
+    restored++;
+  }
+  return restored;
+}
+
+void markRuntimeStateDirty(bool statusChanged) {
+  dirty = true;
+  statusDirty = statusDirty || statusChanged;
+}
+
+void saveRuntimeStateIfDue(const ServiceTable& table, uint32_t nowMillis) {
+  if (!dirty) return;
+  uint32_t sinceSave = nowMillis - lastSave;
+  if (sinceSave < (statusDirty ? RUNTIME_STATE_MIN_GAP_MS : RUNTIME_STATE_SAVE_MS)) return;
+
+  int count = 0;
+  for (int i = 0; i < table.count; i++) {
+    const Service& service = table.at(i);
+    if (neverChecked(service)) continue;  // nothing to restore
+
+    StateRecord& record = blob.records[count++];
+    memset(&record, 0, sizeof(record));
+    record.id = service.id;
+    record.consecutivePasses = capped(service.consecutivePasses);
+    record.consecutiveFails = capped(service.consecutiveFails);
+    record.lastLatency = service.lastLatency;
+    record.isUp = service.isUp ? 1 : 0;
+
+    OpenIncidentState incident;
+    if (openIncidentState(table.order[i], service.id, incident)) {
+      record.incidentFlags = INCIDENT_OPEN | (incident.down ? INCIDENT_DOWN : 0);
+      record.incidentError = incident.firstError;
+      record.incidentStart = incident.start;
+      record.incidentFailedProbes = incident.failedProbes;
+    }
+  }
+  blob.header = {STATE_MAGIC, STATE_VERSION, (uint16_t)count};
+
+  size_t length = sizeof(StateHeader) + count * sizeof(StateRecord);
+  Preferences preferences;
+  bool ok = preferences.begin(NVS_NAMESPACE, false) && preferences.putBytes(NVS_KEY, &blob, length) == length;
+  preferences.end();
+
+  // Retried after the normal interval rather than on every loop() pass
+  lastSave = nowMillis;
+  dirty = !ok;
+  statusDirty = false;
+  if (!ok) {
+    logPrintf(LOG_ERROR, "Runtime state: NVS write failed");
+  }
+}
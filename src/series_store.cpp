@@ -0,0 +1,564 @@
+#include "series_store.hpp"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <new>
+#include <string.h>
+
+#include "config.hpp"
+#include "hal.hpp"
+#include "logger.hpp"
+
+namespace {
+
+const char* SERIES_DIR = "/series";
+const uint32_t DATA_BITS = sizeof(SeriesBlock::data) * 8;
+const uint32_t MAX_SAMPLE_BITS = (4 + 32) + (1 + 4) + (2 + 8);
+
+struct HotSeries {
+  uint64_t id;  // service the entry belongs to, 0 if unused
+  bool loaded;  // block resumed from flash or started
+  bool dirty;
+  uint32_t dirtySince;
+  SeriesBlock block;
+
+  // Encoder state after the last sample
+  uint32_t time;
+  int32_t delta;
+  uint8_t status;
+  uint8_t code;
+};
+
+// Guards the hot blocks and file access against readSeriesBlock() from the
+// web server
+SemaphoreHandle_t seriesLock = nullptr;
+HotSeries* hot = nullptr;
+SeriesStats stats = {};
+
+uint8_t statusBits(bool up, uint8_t error) {
+  return (up ? 1 : 0) | ((error & 7) << 1);
+}
+
+// Exact below 32 ms; above, 16 codes per doubling up to 65535 ms (code 207)
+uint8_t latencyCode(uint32_t ms) {
+  if (ms > UINT16_MAX) ms = UINT16_MAX;
+  if (ms < 32) return ms;
+
+  int exponent = 31 - __builtin_clz(ms) - 5;
+  return 32 + exponent * 16 + ((ms >> (exponent + 1)) & 15);
+}
+
+uint32_t latencyFromCode(uint8_t code) {
+  if (code < 32) return code;
+
+  int exponent = (code - 32) / 16;
+  uint32_t mantissa = (code - 32) % 16;
+  return ((16 + mantissa) << (exponent + 1)) + (1u << exponent);  // middle of the range
+}
+
+// Files of a service share its name, /series/<id>.<suffix>
+String seriesPath(uint64_t id, const String& suffix) {
+  return String(SERIES_DIR) + "/" + formatServiceId(id) + "." + suffix;
+}
+
+// Segments are numbered in turn, so the file of the next one is always that
+// of the oldest
+String segmentPath(uint64_t id, uint32_t sequence) {
+  return seriesPath(id, String((sequence - 1) / SERIES_SEGMENT_BLOCKS % SERIES_SEGMENTS_PER_SERVICE));
+}
+
+String checkpointPath(uint64_t id) {
+  return seriesPath(id, "hot");
+}
+
+size_t blockOffset(uint32_t sequence) {
+  return (size_t)((sequence - 1) % SERIES_SEGMENT_BLOCKS) * sizeof(SeriesBlock);
+}
+
+File openForReading(const String& path) {
+  return LittleFS.exists(path) ? LittleFS.open(path, "r") : File();
+}
+
+void writeBits(SeriesBlock& block, uint32_t value, int count) {
+  for (int i = count - 1; i >= 0; i--) {
+    uint32_t bit = block.header.bits++;
+    uint8_t mask = 0x80 >> (bit % 8);
+    if ((value >> i) & 1) {
+      block.data[bit / 8] |= mask;
+    } else {
+      block.data[bit / 8] &= ~mask;
+    }
+  }
+}
+
+void startBlock(HotSeries& series, uint32_t sequence, uint32_t startTime) {
+  memset(&series.block, 0, sizeof(series.block));
+  series.block.header.sequence = sequence;
+  series.block.header.startTime = startTime;
+  series.time = startTime;
+  series.delta = 0;
+  series.status = 0;
+  series.code = 0;
+}
+
+void encodeSample(HotSeries& series, uint32_t time, uint8_t status, uint8_t code) {
+  SeriesBlock& block = series.block;
+
+  int32_t delta = (int32_t)(time - series.time);
+  int32_t deltaOfDelta = delta - series.delta;
+  if (deltaOfDelta == 0) {
+    writeBits(block, 0, 1);
+  } else if (deltaOfDelta >= -64 && deltaOfDelta <= 63) {
+    writeBits(block, 0b10, 2);
+    writeBits(block, (uint32_t)deltaOfDelta & 0x7F, 7);
+  } else if (deltaOfDelta >= -2048 && deltaOfDelta <= 2047) {
+    writeBits(block, 0b110, 3);
+    writeBits(block, (uint32_t)deltaOfDelta & 0xFFF, 12);
+  } else if (deltaOfDelta >= -524288 && deltaOfDelta <= 524287) {
+    writeBits(block, 0b1110, 4);
+    writeBits(block, (uint32_t)deltaOfDelta & 0xFFFFF, 20);
+  } else {
+    writeBits(block, 0b1111, 4);
+    writeBits(block, (uint32_t)deltaOfDelta, 32);
+  }
+
+  if (status == series.status) {
+    writeBits(block, 0, 1);
+  } else {
+    writeBits(block, 1, 1);
+    writeBits(block, status, 4);
+  }
+
+  int change = (int)code - series.code;
+  if (change == 0) {
+    writeBits(block, 0, 1);
+  } else if (change >= -4 && change <= 3) {
+    writeBits(block, 0b10, 2);
+    writeBits(block, (uint32_t)change & 7, 3);
+  } else {
+    writeBits(block, 0b11, 2);
+    writeBits(block, code, 8);
+  }
+
+  block.header.count++;
+  series.time = time;
+  series.delta = delta;
+  series.status = status;
+  series.code = code;
+}
+
+// Highest block sequence in the segments of `id`, 0 if there is none. The
+// last block of each segment is its newest.
+uint32_t newestInSegments(uint64_t id) {
+  uint32_t newest = 0;
+  for (int i = 0; i < SERIES_SEGMENTS_PER_SERVICE; i++) {
+    File file = openForReading(seriesPath(id, String(i)));
+    if (!file) continue;
+
+    SeriesBlockHeader header;
+    size_t blocks = file.size() / sizeof(SeriesBlock);
+    if (blocks > 0 && file.seek((blocks - 1) * sizeof(SeriesBlock)) &&
+        file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+        header.sequence > newest) {
+      newest = header.sequence;
+    }
+    file.close();
+  }
+  return newest;
+}
+
+// Reads the block at `offset` of the file at `path` if it is block `sequence`
+bool readBlockAt(const String& path, size_t offset, uint32_t sequence, SeriesBlock& block) {
+  File file = openForReading(path);
+  if (!file) return false;
+
+  bool ok = file.seek(offset) &&
+    file.read(reinterpret_cast<uint8_t*>(&block), sizeof(block)) == sizeof(block) &&
+    block.header.sequence == sequence && block.header.bits <= DATA_BITS;
+  file.close();
+  return ok;
+}
+
+// The last copy of the hot block, newer than the segments if its sequence is
+bool readCheckpoint(uint64_t id, SeriesBlock& block) {
+  File file = openForReading(checkpointPath(id));
+  if (!file) return false;
+
+  bool ok = file.read(reinterpret_cast<uint8_t*>(&block), sizeof(block)) == sizeof(block) &&
+    block.header.sequence != 0 && block.header.bits <= DATA_BITS;
+  file.close();
+  return ok;
+}
+
+uint32_t newestOnFlash(uint64_t id) {
+  uint32_t newest = newestInSegments(id);
+  SeriesBlock checkpoint;
+  if (readCheckpoint(id, checkpoint) && checkpoint.header.sequence > newest) {
+    newest = checkpoint.header.sequence;
+  }
+  return newest;
+}
+
+// A segment holds whole blocks, so a full one is only ever appended
+bool readBlockFromFlash(uint64_t id, uint32_t sequence, SeriesBlock& block) {
+  return readBlockAt(segmentPath(id, sequence), blockOffset(sequence), sequence, block) ||
+    readBlockAt(checkpointPath(id), 0, sequence, block);
+}
+
+void countWrite(bool ok, const String& path) {
+  if (ok) {
+    stats.blocksWritten++;
+  } else {
+    stats.writeErrors++;
+    logPrintf(LOG_ERROR, "Series: failed to write %s", path.c_str());
+  }
+}
+
+// Appends the full hot block to its segment. The first block of a segment
+// replaces the oldest segment; any other follows the blocks already there.
+// A segment that does not end where it should (a failed or cut-short
+// write) is started again, with unused blocks in place of those missing.
+bool appendBlock(const HotSeries& series) {
+  static const uint8_t unused[sizeof(SeriesBlock)] = {};
+  uint32_t sequence = series.block.header.sequence;
+  String path = segmentPath(series.id, sequence);
+  size_t offset = blockOffset(sequence);
+
+  size_t size = 0;
+  File existing = openForReading(path);
+  if (existing) {
+    size = existing.size();
+    existing.close();
+    if (offset == 0 || size > offset || size % sizeof(SeriesBlock) != 0) {
+      LittleFS.remove(path);
+      size = 0;
+    }
+  }
+
+  File file = LittleFS.open(path, "a");
+  bool ok = (bool)file;
+  for (; ok && size < offset; size += sizeof(unused)) {
+    ok = file.write(unused, sizeof(unused)) == sizeof(unused);
+  }
+  ok = ok && file.write(reinterpret_cast<const uint8_t*>(&series.block), sizeof(series.block)) == sizeof(series.block);
+  file.close();
+
+  countWrite(ok, path);
+  return ok;
+}
+
+// Copies the hot block, full or not, to its checkpoint file
+bool writeCheckpoint(const HotSeries& series) {
+  String path = checkpointPath(series.id);
+  File file = LittleFS.open(path, "w");
+  bool ok = file &&
+    file.write(reinterpret_cast<const uint8_t*>(&series.block), sizeof(series.block)) == sizeof(series.block);
+  file.close();
+
+  countWrite(ok, path);
+  return ok;
+}
+
+// Continues the checkpoint of the hot block if it is newer than the
+// segments and has room, so a reboot does not leave a partly filled block
+// behind; otherwise starts the next block.
+void resumeSeries(HotSeries& series, uint32_t time) {
+  uint32_t newest = newestInSegments(series.id);
+  series.loaded = true;
+  series.dirty = false;
+
+  if (readCheckpoint(series.id, series.block) && series.block.header.sequence > newest) {
+    newest = series.block.header.sequence;
+    if (series.block.header.bits + MAX_SAMPLE_BITS <= DATA_BITS) {
+      series.time = series.block.header.startTime;
+      series.delta = 0;
+      series.status = 0;
+      series.code = 0;
+
+      SeriesDecoder decoder(series.block);
+      SeriesSample sample;
+      uint32_t previous = series.time;
+      while (decoder.next(sample)) {
+        previous = series.time;
+        series.time = sample.time;
+        series.status = statusBits(sample.up, sample.error);
+        series.code = latencyCode(sample.latencyMs);
+      }
+      series.delta = (int32_t)(series.time - previous);
+      return;
+    }
+    appendBlock(series);  // full, but never made it into its segment
+  }
+
+  startBlock(series, newest + 1, time);
+}
+
+}  // namespace
+
+SeriesDecoder::SeriesDecoder(const SeriesBlock& block)
+    : _block(block), _bit(0), _index(0), _time(block.header.startTime), _delta(0), _status(0), _code(0) {}
+
+uint32_t SeriesDecoder::readBits(int count) {
+  uint32_t value = 0;
+  for (int i = 0; i < count; i++) {
+    uint32_t bit = _bit++;
+    value <<= 1;
+    if (bit < DATA_BITS) {
+      value |= (_block.data[bit / 8] >> (7 - bit % 8)) & 1;
+    }
+  }
+  return value;
+}
+
+int32_t SeriesDecoder::readSigned(int count) {
+  uint32_t value = readBits(count);
+  if (count < 32 && (value & (1u << (count - 1)))) {
+    value |= ~0u << count;
+  }
+  return (int32_t)value;
+}
+
+bool SeriesDecoder::next(SeriesSample& sample) {
+  if (_index >= _block.header.count || _bit >= _block.header.bits) return false;
+
+  int32_t deltaOfDelta = 0;
+  if (readBits(1) == 0) {
+    deltaOfDelta = 0;
+  } else if (readBits(1) == 0) {
+    deltaOfDelta = readSigned(7);
+  } else if (readBits(1) == 0) {
+    deltaOfDelta = readSigned(12);
+  } else if (readBits(1) == 0) {
+    deltaOfDelta = readSigned(20);
+  } else {
+    deltaOfDelta = readSigned(32);
+  }
+  _delta += deltaOfDelta;
+  _time += _delta;
+
+  if (readBits(1) == 1) {
+    _status = readBits(4);
+  }
+
+  if (readBits(1) == 1) {
+    if (readBits(1) == 0) {
+      _code += readSigned(3);
+    } else {
+      _code = readBits(8);
+    }
+  }
+
+  _index++;
+  sample.time = _time;
+  sample.up = _status & 1;
+  sample.error = _status >> 1;
+  sample.latencyMs = latencyFromCode(_code);
+  return true;
+}
+
+bool initSeriesStore() {
+  if (hot != nullptr) return true;
+
+  void* memory = ps_malloc(sizeof(HotSeries) * MAX_SERVICES);
+  seriesLock = xSemaphoreCreateMutex();
+  if (memory == nullptr || seriesLock == nullptr) {
+    free(memory);
+    logPrintf(LOG_ERROR, "Series: PSRAM allocation failed, history disabled");
+    return false;
+  }
+
+  hot = static_cast<HotSeries*>(memory);
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    new (&hot[i]) HotSeries();
+  }
+
+  if (!LittleFS.exists(SERIES_DIR)) {
+    LittleFS.mkdir(SERIES_DIR);
+  }
+  return true;
+}
+
+void recordSeriesSample(uint16_t slot, uint64_t id, bool up, uint8_t error, uint32_t latencyMs) {
+  if (hot == nullptr || slot >= MAX_SERVICES) return;
+
+  uint32_t now = systemClock().unixTime();
+  if (now == 0) {
+    stats.skippedNoClock++;
+    return;
+  }
+
+  xSemaphoreTake(seriesLock, portMAX_DELAY);
+  HotSeries& series = hot[slot];
+  if (series.id != id) {
+    // A new service in this slot; the old one's file is pruned on delete
+    series.id = id;
+    series.loaded = false;
+  }
+  if (!series.loaded) {
+    resumeSeries(series, now);
+  }
+
+  if (series.block.header.bits + MAX_SAMPLE_BITS > DATA_BITS) {
+    appendBlock(series);
+    startBlock(series, series.block.header.sequence + 1, now);
+  }
+
+  encodeSample(series, now, statusBits(up, error), latencyCode(latencyMs));
+  if (!series.dirty) {
+    series.dirty = true;
+    series.dirtySince = millis();
+  }
+  stats.samples++;
+  xSemaphoreGive(seriesLock);
+}
+
+void flushSeriesStore(uint32_t nowMillis) {
+  if (hot == nullptr) return;
+
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    HotSeries& series = hot[i];
+    if (!series.dirty || nowMillis - series.dirtySince < SERIES_FLUSH_MS) continue;
+
+    xSemaphoreTake(seriesLock, portMAX_DELAY);
+    if (writeCheckpoint(series)) {
+      series.dirty = false;
+    } else {
+      series.dirtySince = nowMillis;  // retry after another interval
+    }
+    xSemaphoreGive(seriesLock);
+  }
+}
+
+void pruneSeriesStore(const ServiceTable& table) {
+  if (hot == nullptr) return;
+
+  xSemaphoreTake(seriesLock, portMAX_DELAY);
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    if (hot[i].id != 0 && table.find(hot[i].id) == nullptr) {
+      hot[i].id = 0;
+      hot[i].loaded = false;
+      hot[i].dirty = false;
+    }
+  }
+
+  // Collected first; removing while iterating the directory is not safe.
+  // Another pass as long as a full batch was removed. Names without a
+  // suffix are the single ring files of earlier builds.
+  String stale[MAX_SERVICES];
+  int removed;
+  do {
+    int staleCount = 0;
+    File dir = LittleFS.open(SERIES_DIR);
+    if (dir && dir.isDirectory()) {
+      File file = dir.openNextFile();
+      while (file && staleCount < MAX_SERVICES) {
+        String name = file.name();
+        int slash = name.lastIndexOf('/');
+        if (slash >= 0) name = name.substring(slash + 1);
+
+        int dot = name.indexOf('.');
+        uint64_t id = 0;
+        if (dot < 0 || !parseServiceId(name.substring(0, dot), id) || table.find(id) == nullptr) {
+          stale[staleCount++] = name;
+        }
+        file = dir.openNextFile();
+      }
+    }
+    dir.close();
+
+    removed = 0;
+    for (int i = 0; i < staleCount; i++) {
+      if (LittleFS.remove(String(SERIES_DIR) + "/" + stale[i])) removed++;
+    }
+  } while (removed == MAX_SERVICES);
+  xSemaphoreGive(seriesLock);
+}
+
+void seriesBlockRange(uint64_t id, uint32_t& oldest, uint32_t& newest) {
+  newest = 0;
+  if (hot != nullptr) {
+    xSemaphoreTake(seriesLock, portMAX_DELAY);
+    bool found = false;
+    for (int i = 0; i < MAX_SERVICES && !found; i++) {
+      if (hot[i].id == id && hot[i].loaded) {
+        newest = hot[i].block.header.sequence;
+        found = true;
+      }
+    }
+    if (!found) {
+      newest = newestOnFlash(id);
+    }
+    xSemaphoreGive(seriesLock);
+  }
+
+  // The first block of the oldest segment kept once the newest is written
+  uint32_t segment = newest > 0 ? (newest - 1) / SERIES_SEGMENT_BLOCKS : 0;
+  oldest = segment >= (uint32_t)SERIES_SEGMENTS_PER_SERVICE
+    ? (segment - SERIES_SEGMENTS_PER_SERVICE + 1) * SERIES_SEGMENT_BLOCKS + 1 : 1;
+}
+
+uint32_t seriesBlockFrom(uint64_t id, uint32_t oldest, uint32_t newest, uint32_t from) {
+  if (hot == nullptr || oldest >= newest) return oldest;
+
+  xSemaphoreTake(seriesLock, portMAX_DELAY);
+  const HotSeries* series = nullptr;
+  for (int i = 0; i < MAX_SERVICES && series == nullptr; i++) {
+    if (hot[i].id == id && hot[i].loaded) {
+      series = &hot[i];
+    }
+  }
+
+  // Samples are in time order, so a block ends no later than the next one
+  // starts. Skip blocks while the next one starts before `from`; stop at the
+  // first header that is missing or deleted and let the reader sort it out.
+  uint32_t first = oldest;
+  File file;
+  for (uint32_t sequence = oldest + 1; sequence <= newest; sequence++) {
+    SeriesBlockHeader header;
+    if (series != nullptr && series->block.header.sequence == sequence) {
+      header = series->block.header;
+    } else {
+      if (!file || blockOffset(sequence) == 0) {
+        if (file) file.close();
+        file = openForReading(segmentPath(id, sequence));
+      }
+      if (!file || !file.seek(blockOffset(sequence)) ||
+          file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) != sizeof(header) ||
+          header.sequence != sequence) {
+        break;
+      }
+    }
+    if (header.startTime >= from) break;
+    first = sequence;
+  }
+  if (file) file.close();
+  xSemaphoreGive(seriesLock);
+  return first;
+}
+
+bool readSeriesBlock(uint64_t id, uint32_t sequence, SeriesBlock& block) {
+  if (hot == nullptr || sequence == 0) return false;
+
+  xSemaphoreTake(seriesLock, portMAX_DELAY);
+  bool ok = false;
+  bool fromHot = false;
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    if (hot[i].id == id && hot[i].loaded && hot[i].block.header.sequence == sequence) {
+      block = hot[i].block;
+      ok = true;
+      fromHot = true;
+      break;
+    }
+  }
+  if (!fromHot) {
+    ok = readBlockFromFlash(id, sequence, block);
+  }
+  xSemaphoreGive(seriesLock);
+  return ok;
+}
+
+SeriesStats seriesStats() {
+  return stats;
+}
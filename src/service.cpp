@@ -0,0 +1,61 @@
+#include "service.hpp"
+
+String getServiceTypeString(ServiceType type) {
+  switch (type) {
+    case TYPE_HOME_ASSISTANT: return "home_assistant";
+    case TYPE_JELLYFIN: return "jellyfin";
+    case TYPE_HTTP_GET: return "http_get";
+    case TYPE_PING: return "ping";
+    default: return "unknown";
+  }
+}
+
+bool parseServiceType(const String& text, ServiceType& type) {
+  if (text == "home_assistant") {
+    type = TYPE_HOME_ASSISTANT;
+  } else if (text == "jellyfin") {
+    type = TYPE_JELLYFIN;
+  } else if (text == "http_get") {
+    type = TYPE_HTTP_GET;
+  } else if (text == "ping") {
+    type = TYPE_PING;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void resetServiceRuntime(Service& service) {
+  service.consecutivePasses = 0;
+  service.consecutiveFails = 0;
+  service.isUp = false;
+  service.lastCheck = 0;
+  service.lastUptime = 0;
+  service.lastError = "";
+  service.secondsSinceLastCheck = -1;
+  service.lastLatency = 0;
+}
+
+bool neverChecked(const Service& service) {
+  return service.consecutivePasses == 0 && service.consecutiveFails == 0;
+}
+
+void copyServiceConfig(Service& target, const Service& source) {
+  target.name = source.name;
+  target.type = source.type;
+  target.host = source.host;
+  target.port = source.port;
+  target.path = source.path;
+  target.expectedResponse = source.expectedResponse;
+  target.checkInterval = source.checkInterval;
+  target.passThreshold = source.passThreshold;
+  target.failThreshold = source.failThreshold;
+}
+
+bool probeConfigChanged(const Service& before, const Service& after) {
+  return before.type != after.type ||
+         before.host != after.host ||
+         before.port != after.port ||
+         before.path != after.path ||
+         before.expectedResponse != after.expectedResponse;
+}
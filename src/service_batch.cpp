@@ -0,0 +1,192 @@
+#include "service_batch.hpp"
+
+#include "service_import.hpp"
+
+namespace {
+
+String operationError(size_t index, const String& message) {
+  return "Operation " + String((unsigned)index) + ": " + message;
+}
+
+// Applies the fields present in `obj` on top of `service`, with the same
+// limits as import. Returns a message for the first invalid field, or nullptr.
+const char* mergeServiceUpdate(JsonObjectConst obj, Service& service) {
+  if (!obj["name"].isNull()) {
+    service.name = obj["name"].as<String>();
+    if (service.name.length() == 0) return "name must not be empty";
+  }
+
+  if (!obj["type"].isNull() && !parseServiceType(obj["type"].as<String>(), service.type)) {
+    return "invalid service type";
+  }
+
+  if (!obj["host"].isNull()) {
+    service.host = obj["host"].as<String>();
+    if (service.host.length() == 0) return "host must not be empty";
+  }
+
+  if (!obj["port"].isNull()) {
+    int port = obj["port"] | 0;
+    if (port < 1 || port > 65535) return "port must be between 1 and 65535";
+    service.port = port;
+  }
+
+  if (!obj["path"].isNull()) service.path = obj["path"].as<String>();
+  if (!obj["expectedResponse"].isNull()) service.expectedResponse = obj["expectedResponse"].as<String>();
+
+  if (!obj["checkInterval"].isNull()) {
+    int checkInterval = obj["checkInterval"] | 60;
+    service.checkInterval = checkInterval < 10 ? 10 : checkInterval;
+  }
+
+  if (!obj["passThreshold"].isNull()) {
+    int passThreshold = obj["passThreshold"] | 1;
+    service.passThreshold = passThreshold < 1 ? 1 : passThreshold;
+  }
+
+  if (!obj["failThreshold"].isNull()) {
+    int failThreshold = obj["failThreshold"] | 1;
+    service.failThreshold = failThreshold < 1 ? 1 : failThreshold;
+  }
+
+  return nullptr;
+}
+
+}  // namespace
+
+bool parseServiceBatch(JsonArrayConst array, const ServiceTable& table,
+                       std::vector<ServiceOperation>& operations, String& error) {
+  if (array.isNull()) {
+    error = "Missing operations array";
+    return false;
+  }
+  if ((int)array.size() > MAX_BATCH_OPERATIONS) {
+    error = "Too many operations";
+    return false;
+  }
+
+  operations.clear();
+  operations.reserve(array.size());
+
+  size_t index = 0;
+  for (JsonObjectConst obj : array) {
+    ServiceOperation operation;
+    String op = obj["op"].as<String>();
+
+    if (op == "add") {
+      operation.type = OP_ADD;
+      if (!serviceFromImportJson(obj, operation.config)) {
+        error = operationError(index, "name, host and a valid type are required");
+        return false;
+      }
+      operation.id = generateServiceId();
+      operation.config.id = operation.id;
+    } else if (op == "update" || op == "delete") {
+      operation.type = op == "update" ? OP_UPDATE : OP_DELETE;
+      if (!parseServiceId(obj["id"].as<String>(), operation.id)) {
+        error = operationError(index, "missing or invalid id");
+        return false;
+      }
+
+      if (operation.type == OP_UPDATE) {
+        const Service* current = table.find(operation.id);
+        if (current == nullptr) {
+          error = operationError(index, "service not found");
+          return false;
+        }
+        operation.config = *current;
+        const char* fieldError = mergeServiceUpdate(obj, operation.config);
+        if (fieldError != nullptr) {
+          error = operationError(index, fieldError);
+          return false;
+        }
+      }
+    } else {
+      error = operationError(index, "op must be add, update or delete");
+      return false;
+    }
+
+    operations.push_back(operation);
+    index++;
+  }
+
+  return validateServiceBatch(table, operations, error);
+}
+
+bool validateServiceBatch(const ServiceTable& table, const std::vector<ServiceOperation>& operations,
+                          String& error) {
+  int finalCount = table.count;
+
+  for (size_t i = 0; i < operations.size(); i++) {
+    const ServiceOperation& operation = operations[i];
+
+    if (operation.type == OP_ADD) {
+      if (table.find(operation.id) != nullptr) {
+        error = operationError(i, "duplicate id");
+        return false;
+      }
+      finalCount++;
+      continue;
+    }
+
+    if (table.find(operation.id) == nullptr) {
+      error = operationError(i, "service not found");
+      return false;
+    }
+
+    // One update or one delete per service. Apply runs the deletes first, so
+    // an update next to a delete of the same id, in either order, would have
+    // no target; a second update would silently replace the first.
+    for (size_t j = 0; j < i; j++) {
+      if (operations[j].type != OP_ADD && operations[j].id == operation.id) {
+        error = operationError(i, "service already changed by operation " + String((unsigned)j));
+        return false;
+      }
+    }
+
+    if (operation.type == OP_DELETE) {
+      finalCount--;
+    }
+  }
+
+  if (finalCount > MAX_SERVICES) {
+    error = "Maximum services reached";
+    return false;
+  }
+  return true;
+}
+
+bool applyServiceBatch(ServiceTable& table, const std::vector<ServiceOperation>& operations,
+                       String& error) {
+  if (!validateServiceBatch(table, operations, error)) {
+    return false;
+  }
+
+  // Deletes first so adds can reuse the freed slots; validation allows one
+  // operation per existing id, so the order does not matter otherwise.
+  for (const ServiceOperation& operation : operations) {
+    if (operation.type == OP_DELETE) {
+      table.remove(operation.id);
+    }
+  }
+
+  for (const ServiceOperation& operation : operations) {
+    if (operation.type != OP_UPDATE) continue;
+
+    Service* service = table.find(operation.id);
+    if (service == nullptr) continue;  // ruled out by validation
+    bool resetState = probeConfigChanged(*service, operation.config);
+    copyServiceConfig(*service, operation.config);
+    if (resetState) {
+      resetServiceRuntime(*service);
+    }
+  }
+
+  for (const ServiceOperation& operation : operations) {
+    if (operation.type == OP_ADD) {
+      table.add(operation.config);
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,188 @@
+#include "service_codec.hpp"
+
+namespace {
+
+const uint8_t MAGIC[4] = {'U', 'M', 'S', 'V'};
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+    }
+  }
+  return ~crc;
+}
+
+// Tracks the running CRC and any short write so callers can check once at the end.
+struct BinaryWriter {
+  fs::File& file;
+  uint32_t crc = 0;
+  bool ok = true;
+
+  explicit BinaryWriter(fs::File& f) : file(f) {}
+
+  void bytes(const uint8_t* data, size_t len, bool checksum = true) {
+    if (!ok || len == 0) return;
+    if (file.write(data, len) != len) {
+      ok = false;
+      return;
+    }
+    if (checksum) crc = crc32Update(crc, data, len);
+  }
+
+  void u8(uint8_t v) { bytes(&v, 1); }
+
+  void u16(uint16_t v) {
+    uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+    bytes(b, 2);
+  }
+
+  void u32(uint32_t v, bool checksum = true) {
+    uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+    bytes(b, 4, checksum);
+  }
+
+  void u64(uint64_t v) {
+    u32((uint32_t)v);
+    u32((uint32_t)(v >> 32));
+  }
+
+  void str(const String& s) {
+    uint16_t len = s.length() > 0xFFFF ? 0xFFFF : s.length();
+    u16(len);
+    bytes(reinterpret_cast<const uint8_t*>(s.c_str()), len);
+  }
+};
+
+struct BinaryReader {
+  fs::File& file;
+  uint32_t crc = 0;
+  bool ok = true;
+
+  explicit BinaryReader(fs::File& f) : file(f) {}
+
+  void bytes(uint8_t* data, size_t len, bool checksum = true) {
+    if (!ok || len == 0) return;
+    if (file.read(data, len) != len) {
+      ok = false;
+      return;
+    }
+    if (checksum) crc = crc32Update(crc, data, len);
+  }
+
+  uint8_t u8() {
+    uint8_t v = 0;
+    bytes(&v, 1);
+    return v;
+  }
+
+  uint16_t u16() {
+    uint8_t b[2] = {0, 0};
+    bytes(b, 2);
+    return (uint16_t)(b[0] | (b[1] << 8));
+  }
+
+  uint32_t u32(bool checksum = true) {
+    uint8_t b[4] = {0, 0, 0, 0};
+    bytes(b, 4, checksum);
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+  }
+
+  uint64_t u64() {
+    uint64_t low = u32();
+    return low | ((uint64_t)u32() << 32);
+  }
+
+  // Reads a length-prefixed string in small chunks directly into `out`.
+  void str(String& out) {
+    uint16_t len = u16();
+    out = "";
+    if (!ok || len == 0) return;
+    out.reserve(len);
+
+    char chunk[64];
+    while (len > 0 && ok) {
+      size_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+      bytes(reinterpret_cast<uint8_t*>(chunk), n);
+      if (ok) out.concat(chunk, n);
+      len -= n;
+    }
+  }
+};
+
+}  // namespace
+
+bool writeServicesBinary(fs::File& file, const ServiceTable& table) {
+  BinaryWriter out(file);
+  int count = table.count;
+
+  out.bytes(MAGIC, sizeof(MAGIC), false);
+  uint8_t header[4] = {SERVICE_CODEC_VERSION, 0, (uint8_t)count, (uint8_t)(count >> 8)};
+  out.bytes(header, sizeof(header), false);
+
+  for (int i = 0; i < count; i++) {
+    const Service& s = table.at(i);
+    out.u64(s.id);
+    out.u8((uint8_t)s.type);
+    out.u16((uint16_t)s.port);
+    out.u32((uint32_t)s.checkInterval);
+    out.u16((uint16_t)s.passThreshold);
+    out.u16((uint16_t)s.failThreshold);
+    out.str(s.name);
+    out.str(s.host);
+    out.str(s.path);
+    out.str(s.expectedResponse);
+  }
+
+  out.u32(out.crc, false);
+  return out.ok;
+}
+
+int readServicesBinary(fs::File& file, Service* services, int maxCount) {
+  BinaryReader in(file);
+
+  uint8_t magic[4];
+  uint8_t header[4];
+  in.bytes(magic, sizeof(magic), false);
+  in.bytes(header, sizeof(header), false);
+  if (!in.ok || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || header[0] != SERVICE_CODEC_VERSION) {
+    return -1;
+  }
+
+  int count = header[2] | (header[3] << 8);
+  int stored = 0;
+  Service overflow;
+
+  for (int i = 0; i < count && in.ok; i++) {
+    // Records past the table capacity are still decoded so the CRC covers the whole file
+    Service& s = stored < maxCount ? services[stored] : overflow;
+
+    s.id = in.u64();
+    s.type = (ServiceType)in.u8();
+    s.port = in.u16();
+    s.checkInterval = (int)in.u32();
+    s.passThreshold = in.u16();
+    s.failThreshold = in.u16();
+    in.str(s.name);
+    in.str(s.host);
+    in.str(s.path);
+    in.str(s.expectedResponse);
+
+    if (s.type > TYPE_PING) in.ok = false;
+    if (s.passThreshold < 1) s.passThreshold = 1;
+    if (s.failThreshold < 1) s.failThreshold = 1;
+    resetServiceRuntime(s);
+
+    if (stored < maxCount) stored++;
+  }
+
+  uint32_t expected = in.crc;
+  uint32_t actual = in.u32(false);
+  if (!in.ok || actual != expected) {
+    return -1;
+  }
+
+  return stored;
+}
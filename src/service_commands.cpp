@@ -0,0 +1,99 @@
+#include "service_commands.hpp"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+
+namespace {
+
+const int COMMAND_QUEUE_LENGTH = 16;
+QueueHandle_t commandQueue = nullptr;
+uint32_t acceptedCommands = 0;  // web server task only
+uint32_t appliedCommands = 0;   // writer only
+
+// Services in the table plus those reserved by accepted commands
+std::atomic<int> reservedServices(0);
+
+int slotChange(const ServiceCommand& command) {
+  switch (command.type) {
+    case CMD_ADD_SERVICES:
+      return (int)command.services.size();
+    case CMD_DELETE_SERVICE:
+      return 0;  // released once the writer has removed it
+    case CMD_APPLY_BATCH: {
+      // Accepted batches apply as checked (see requireVersion), deletes included
+      int change = 0;
+      for (const ServiceOperation& operation : command.operations) {
+        if (operation.type == OP_ADD) change++;
+        if (operation.type == OP_DELETE) change--;
+      }
+      return change;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+bool initServiceCommandQueue(int services) {
+  if (commandQueue == nullptr) {
+    commandQueue = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(ServiceCommand*));
+    reservedServices = services;
+  }
+  return commandQueue != nullptr;
+}
+
+EnqueueResult enqueueServiceCommand(ServiceCommand* command) {
+  if (commandQueue == nullptr) {
+    return ENQUEUE_BUSY;
+  }
+  // Equal only if every accepted command has been applied and published
+  if (command->requireVersion && command->configVersion != acceptedCommands) {
+    return ENQUEUE_CONFLICT;
+  }
+  int change = slotChange(*command);
+  if (change > 0 && reservedServices + change > MAX_SERVICES) {
+    return ENQUEUE_NO_ROOM;
+  }
+
+  // Reserved first: the writer may apply the command as soon as it is sent
+  command->reservedSlots = change;
+  reservedServices += change;
+  if (xQueueSend(commandQueue, &command, 0) != pdTRUE) {
+    reservedServices -= change;
+    return ENQUEUE_BUSY;
+  }
+  acceptedCommands++;
+  return ENQUEUE_OK;
+}
+
+ServiceCommand* dequeueServiceCommand() {
+  ServiceCommand* command = nullptr;
+  if (commandQueue == nullptr || xQueueReceive(commandQueue, &command, 0) != pdTRUE) {
+    return nullptr;
+  }
+  appliedCommands++;
+  return command;
+}
+
+uint32_t appliedServiceCommands() {
+  return appliedCommands;
+}
+
+int freeServiceSlots() {
+  return MAX_SERVICES - reservedServices;
+}
+
+void releaseServiceSlots(int count) {
+  reservedServices -= count;
+}
+
+bool waitForServiceCommand(TickType_t timeout) {
+  ServiceCommand* command = nullptr;
+  if (commandQueue == nullptr) {
+    vTaskDelay(timeout);
+    return false;
+  }
+  return xQueuePeek(commandQueue, &command, timeout) == pdTRUE;
+}
@@ -0,0 +1,94 @@
+#include "service_engine.hpp"
+
+unsigned long checkIntervalMs(const Service& service) {
+  unsigned long interval = service.checkInterval * 1000UL;
+
+  bool unconfirmed = service.isUp ? service.consecutiveFails > 0 : service.consecutivePasses > 0;
+  if (unconfirmed) {
+    unsigned long recheck = interval / 100 * CHECK_RECHECK_PERCENT;
+    if (recheck < CHECK_RECHECK_MIN_MS) recheck = CHECK_RECHECK_MIN_MS;
+    return recheck < interval ? recheck : interval;
+  }
+
+  unsigned long maxInterval = CHECK_RELAX_MAX_INTERVAL_S * 1000UL;
+  if (service.isUp && maxInterval > interval && CHECK_RELAX_AFTER_PASSES > 0) {
+    // Doubling stops at the cap, so this loops a handful of times at most
+    for (int steps = service.consecutivePasses / CHECK_RELAX_AFTER_PASSES; steps > 0 && interval < maxInterval;
+         steps--) {
+      interval *= 2;
+    }
+    if (interval > maxInterval) interval = maxInterval;
+  }
+  return interval;
+}
+
+unsigned long msUntilCheckDue(const Service& service, unsigned long now) {
+  unsigned long interval = checkIntervalMs(service);
+  unsigned long elapsed = now - service.lastCheck;
+  return elapsed >= interval ? 0 : interval - elapsed;
+}
+
+unsigned long msUntilNextCheck(const ServiceTable& table, unsigned long now, unsigned long maxWait) {
+  unsigned long wait = maxWait;
+  for (int i = 0; i < table.count && wait > 0; i++) {
+    unsigned long due = msUntilCheckDue(table.at(i), now);
+    if (due < wait) {
+      wait = due;
+    }
+  }
+  return wait;
+}
+
+namespace {
+
+// Makes `service` fall due `delay` ms after `now`
+void scheduleIn(Service& service, unsigned long now, unsigned long delay) {
+  service.lastCheck = now - checkIntervalMs(service) + delay;  // wraps early after boot, which msUntilCheckDue() allows
+}
+
+}  // namespace
+
+void spreadFirstChecks(ServiceTable& table, unsigned long now) {
+  for (int i = 0; i < table.count; i++) {
+    Service& service = table.at(i);
+    scheduleIn(service, now, checkIntervalMs(service) / table.count * i);
+  }
+}
+
+void spreadDueChecks(ServiceTable& table, unsigned long now) {
+  int due = 0;
+  for (int i = 0; i < table.count; i++) {
+    if (msUntilCheckDue(table.at(i), now) == 0) due++;
+  }
+
+  int position = 0;
+  for (int i = 0; i < table.count && position < due; i++) {
+    Service& service = table.at(i);
+    if (msUntilCheckDue(service, now) > 0) continue;
+    scheduleIn(service, now, checkIntervalMs(service) / due * position++);
+  }
+}
+
+bool applyCheckResult(Service& service, bool passed, unsigned long now) {
+  bool wasUp = service.isUp;
+
+  if (passed) {
+    service.consecutivePasses++;
+    service.consecutiveFails = 0;
+    service.lastUptime = now;
+    service.lastError = "";
+  } else {
+    service.consecutiveFails++;
+    service.consecutivePasses = 0;
+  }
+
+  if (!service.isUp && service.consecutivePasses >= service.passThreshold) {
+    // Passed enough times in a row to be considered UP
+    service.isUp = true;
+  } else if (service.isUp && service.consecutiveFails >= service.failThreshold) {
+    // Failed enough times in a row to be considered DOWN
+    service.isUp = false;
+  }
+
+  return service.isUp != wasUp;
+}
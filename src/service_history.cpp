@@ -0,0 +1,85 @@
+#include "service_history.hpp"
+
+#include <new>
+
+namespace {
+
+ServiceHistory* histories = nullptr;
+
+void resetHistory(ServiceHistory& history, uint64_t id) {
+  history.id.store(0, std::memory_order_release);
+  history.samples.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < UPTIME_BUCKETS; i++) {
+    history.buckets[i] = {0, 0, 0};
+  }
+  history.id.store(id, std::memory_order_release);
+}
+
+}  // namespace
+
+bool initServiceHistory() {
+  if (histories != nullptr) return true;
+
+  void* memory = ps_malloc(sizeof(ServiceHistory) * MAX_SERVICES);
+  if (memory == nullptr) {
+    Serial.println("Service history: PSRAM allocation failed, charts disabled");
+    return false;
+  }
+
+  histories = static_cast<ServiceHistory*>(memory);
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    new (&histories[i]) ServiceHistory();
+    resetHistory(histories[i], 0);
+  }
+  return true;
+}
+
+void recordServiceCheck(uint16_t slot, uint64_t id, bool up, uint32_t latencyMs, uint32_t nowMillis) {
+  if (histories == nullptr || slot >= MAX_SERVICES) return;
+
+  ServiceHistory& history = histories[slot];
+  if (history.id.load(std::memory_order_relaxed) != id) {
+    resetHistory(history, id);
+  }
+
+  uint32_t n = history.samples.load(std::memory_order_relaxed);
+  uint16_t sample = LATENCY_FAILED;
+  if (up) {
+    sample = latencyMs < LATENCY_FAILED ? latencyMs : LATENCY_FAILED - 1;
+  }
+  history.latency[n % LATENCY_HISTORY] = sample;
+  history.samples.store(n + 1, std::memory_order_release);
+
+  uint32_t index = nowMillis / UPTIME_BUCKET_MS;
+  UptimeBucket& bucket = history.buckets[index % UPTIME_BUCKETS];
+  if (bucket.index != index) {
+    bucket = {index, 0, 0};
+  }
+  if (up) {
+    if (bucket.up < UINT16_MAX) bucket.up++;
+  } else {
+    if (bucket.down < UINT16_MAX) bucket.down++;
+  }
+}
+
+const ServiceHistory* serviceHistory(uint16_t slot, uint64_t id) {
+  if (histories == nullptr || slot >= MAX_SERVICES) return nullptr;
+
+  const ServiceHistory& history = histories[slot];
+  return history.id.load(std::memory_order_acquire) == id ? &history : nullptr;
+}
+
+float uptimePercent24h(const ServiceHistory& history, uint32_t nowMillis) {
+  uint32_t current = nowMillis / UPTIME_BUCKET_MS;
+  uint32_t up = 0;
+  uint32_t total = 0;
+
+  for (int i = 0; i < UPTIME_BUCKETS; i++) {
+    const UptimeBucket& bucket = history.buckets[i];
+    if (current - bucket.index >= (uint32_t)UPTIME_BUCKETS) continue;
+    up += bucket.up;
+    total += bucket.up + bucket.down;
+  }
+
+  return total == 0 ? -1.0f : 100.0f * up / total;
+}
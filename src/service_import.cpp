@@ -0,0 +1,173 @@
+#include "service_import.hpp"
+
+#include "service_table.hpp"
+
+ServiceImportParser::ServiceImportParser(int availableSlots)
+    : _availableSlots(availableSlots) {
+  _key[0] = '\0';
+}
+
+void ServiceImportParser::feed(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && !failed(); i++) {
+    char c = (char)data[i];
+
+    if (_capturing) {
+      if (_objectLen < MAX_OBJECT_SIZE) {
+        _object[_objectLen++] = c;
+      } else {
+        _objectTooLarge = true;
+      }
+    }
+
+    if (_inString) {
+      if (_escape) {
+        _escape = false;
+      } else if (c == '\\') {
+        _escape = true;
+      } else if (c == '"') {
+        _inString = false;
+        if (_readingKey) {
+          _readingKey = false;
+          _key[_keyLen] = '\0';
+        }
+      } else if (_readingKey && _keyLen < sizeof(_key) - 1) {
+        _key[_keyLen++] = c;
+      }
+      continue;
+    }
+
+    switch (c) {
+      case '"':
+        _inString = true;
+        if (_depth == 1 && _expectingKey) {
+          _readingKey = true;
+          _keyLen = 0;
+        }
+        break;
+
+      case '{':
+      case '[':
+        if (_depth == 0 && c != '{') {
+          _error = "Invalid JSON";
+          break;
+        }
+        if (c == '{' && _depth == _itemDepth) {
+          _capturing = true;
+          _objectTooLarge = false;
+          _object[0] = c;
+          _objectLen = 1;
+        }
+        if (c == '[' && _depth == 1 && !_sawServices && strcmp(_key, "services") == 0) {
+          _sawServices = true;
+          _itemDepth = _depth + 1;
+        }
+        _depth++;
+        if (_depth == 1) _expectingKey = true;
+        break;
+
+      case '}':
+      case ']':
+        _depth--;
+        if (_depth < 0) {
+          _error = "Invalid JSON";
+          break;
+        }
+        if (_capturing && _depth == _itemDepth) {
+          _capturing = false;
+          handleObject();
+        }
+        if (c == ']' && _depth == _itemDepth - 1) {
+          _itemDepth = -1;
+        }
+        break;
+
+      case ':':
+        if (_depth == 1) _expectingKey = false;
+        break;
+
+      case ',':
+        if (_depth == 1) _expectingKey = true;
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+bool ServiceImportParser::finish() {
+  if (failed()) {
+    return false;
+  }
+  if (_depth != 0 || _inString) {
+    _error = "Invalid JSON";
+    return false;
+  }
+  if (!_sawServices) {
+    _error = "Missing services array";
+    return false;
+  }
+  return true;
+}
+
+void ServiceImportParser::handleObject() {
+  if (_objectTooLarge || importedCount() >= _availableSlots) {
+    _skipped++;
+    return;
+  }
+
+  JsonDocument doc;
+  if (deserializeJson(doc, _object, _objectLen)) {
+    _skipped++;
+    return;
+  }
+
+  Service service;
+  if (!serviceFromImportJson(doc.as<JsonObjectConst>(), service)) {
+    _skipped++;
+    return;
+  }
+
+  service.id = generateServiceId();
+  _services.push_back(service);
+}
+
+bool serviceFromImportJson(JsonObjectConst obj, Service& service) {
+  // Validate required fields
+  String name = obj["name"].as<String>();
+  String host = obj["host"].as<String>();
+  if (obj["name"].isNull() || obj["host"].isNull() || name.length() == 0 || host.length() == 0) {
+    return false;
+  }
+
+  ServiceType type;
+  if (!parseServiceType(obj["type"].as<String>(), type)) {
+    return false;
+  }
+
+  // Validate and constrain numeric values
+  int port = obj["port"] | 80;
+  if (port < 1 || port > 65535) port = 80;
+
+  int checkInterval = obj["checkInterval"] | 60;
+  if (checkInterval < 10) checkInterval = 10;
+
+  int passThreshold = obj["passThreshold"] | 1;
+  if (passThreshold < 1) passThreshold = 1;
+
+  int failThreshold = obj["failThreshold"] | 1;
+  if (failThreshold < 1) failThreshold = 1;
+
+  service.id = 0;
+  service.name = name;
+  service.type = type;
+  service.host = host;
+  service.port = port;
+  service.path = obj["path"] | "/";
+  service.expectedResponse = obj["expectedResponse"] | "*";
+  service.checkInterval = checkInterval;
+  service.passThreshold = passThreshold;
+  service.failThreshold = failThreshold;
+  resetServiceRuntime(service);
+  return true;
+}
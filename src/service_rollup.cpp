@@ -0,0 +1,189 @@
+#include "service_rollup.hpp"
+
+#include <new>
+#include <string.h>
+
+#include "logger.hpp"
+
+const uint16_t ROLLUP_LATENCY_BOUNDS[ROLLUP_LATENCY_BINS - 1] = {
+  10, 20, 30, 50, 75, 100, 150, 200, 300, 500, 750, 1000, 2000, 5000, 10000
+};
+
+namespace {
+
+ServiceRollup* rollups = nullptr;
+
+const char* const WINDOW_NAMES[WINDOW_COUNT] = {"1h", "24h", "7d", "30d"};
+
+int latencyBin(uint32_t ms) {
+  int bin = 0;
+  while (bin < ROLLUP_LATENCY_BINS - 1 && ms > ROLLUP_LATENCY_BOUNDS[bin]) {
+    bin++;
+  }
+  return bin;
+}
+
+void addCheck(RollupCounts& counts, bool up, int bin, uint32_t latencyMs) {
+  if (up) {
+    counts.up++;
+    counts.latencySum += latencyMs;
+    counts.latency[bin]++;
+  } else {
+    counts.down++;
+  }
+}
+
+void subtractCounts(RollupCounts& total, const RollupCounts& counts) {
+  total.up -= counts.up;
+  total.down -= counts.down;
+  total.latencySum -= counts.latencySum;
+  for (int i = 0; i < ROLLUP_LATENCY_BINS; i++) {
+    total.latency[i] -= counts.latency[i];
+  }
+}
+
+// One resolution: a ring of buckets and the windows summed from it
+struct Tier {
+  RollupBucket* ring;
+  int size;
+  uint32_t& current;
+  RollupWindow windows[2];
+  int lengths[2];
+  int windowCount;
+};
+
+// Moves `tier` forward to bucket `target`, taking each bucket that leaves a
+// window out of that window's totals. Costs at most one step per bucket the
+// clock passed, and clears everything after a gap longer than the ring.
+void advance(ServiceRollup& rollup, Tier tier, uint32_t target) {
+  if (tier.current != 0 && target <= tier.current) return;  // same bucket, or the clock stepped back
+
+  if (tier.current == 0 || target - tier.current >= (uint32_t)tier.size) {
+    memset(tier.ring, 0, sizeof(RollupBucket) * tier.size);
+    for (int w = 0; w < tier.windowCount; w++) {
+      memset(&rollup.windows[tier.windows[w]], 0, sizeof(RollupCounts));
+    }
+  } else {
+    for (uint32_t index = tier.current + 1; index < target; index++) {
+      for (int w = 0; w < tier.windowCount; w++) {
+        uint32_t leaving = index - tier.lengths[w];
+        const RollupBucket& bucket = tier.ring[leaving % tier.size];
+        if (bucket.index == leaving) {
+          subtractCounts(rollup.windows[tier.windows[w]], bucket.counts);
+        }
+      }
+      tier.ring[index % tier.size] = {index, {}};
+    }
+    for (int w = 0; w < tier.windowCount; w++) {
+      uint32_t leaving = target - tier.lengths[w];
+      const RollupBucket& bucket = tier.ring[leaving % tier.size];
+      if (bucket.index == leaving) {
+        subtractCounts(rollup.windows[tier.windows[w]], bucket.counts);
+      }
+    }
+  }
+
+  tier.ring[target % tier.size] = {target, {}};
+  tier.current = target;
+}
+
+void resetRollup(ServiceRollup& rollup, uint64_t id) {
+  rollup.id.store(0, std::memory_order_release);
+  memset(rollup.minutes, 0, sizeof(rollup.minutes));
+  memset(rollup.hours, 0, sizeof(rollup.hours));
+  memset(rollup.days, 0, sizeof(rollup.days));
+  rollup.currentMinute = 0;
+  rollup.currentHour = 0;
+  rollup.currentDay = 0;
+  memset(rollup.windows, 0, sizeof(rollup.windows));
+  rollup.id.store(id, std::memory_order_release);
+}
+
+uint32_t percentileMs(const RollupCounts& counts, uint8_t percentile) {
+  if (counts.up == 0) return 0;
+
+  uint64_t rank = ((uint64_t)counts.up * percentile + 99) / 100;
+  uint64_t seen = 0;
+  for (int bin = 0; bin < ROLLUP_LATENCY_BINS; bin++) {
+    uint32_t inBin = counts.latency[bin];
+    if (seen + inBin < rank) {
+      seen += inBin;
+      continue;
+    }
+
+    uint32_t lower = bin == 0 ? 0 : ROLLUP_LATENCY_BOUNDS[bin - 1];
+    if (bin == ROLLUP_LATENCY_BINS - 1) return lower;  // open bin
+    uint32_t upper = ROLLUP_LATENCY_BOUNDS[bin];
+    return lower + (uint32_t)((upper - lower) * (rank - seen) / inBin);
+  }
+  return ROLLUP_LATENCY_BOUNDS[ROLLUP_LATENCY_BINS - 2];
+}
+
+}  // namespace
+
+bool initServiceRollups() {
+  if (rollups != nullptr) return true;
+
+  void* memory = ps_malloc(sizeof(ServiceRollup) * MAX_SERVICES);
+  if (memory == nullptr) {
+    logPrintf(LOG_ERROR, "Service rollups: PSRAM allocation failed, SLA figures disabled");
+    return false;
+  }
+
+  rollups = static_cast<ServiceRollup*>(memory);
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    new (&rollups[i]) ServiceRollup();
+    resetRollup(rollups[i], 0);
+  }
+  return true;
+}
+
+void recordRollup(uint16_t slot, uint64_t id, bool up, uint32_t latencyMs, uint32_t unixTime) {
+  if (rollups == nullptr || slot >= MAX_SERVICES) return;
+
+  ServiceRollup& rollup = rollups[slot];
+  if (rollup.id.load(std::memory_order_relaxed) != id) {
+    resetRollup(rollup, id);
+  }
+
+  Tier minutes = {rollup.minutes, ROLLUP_MINUTES, rollup.currentMinute, {WINDOW_1H}, {ROLLUP_MINUTES}, 1};
+  Tier hours = {rollup.hours, ROLLUP_HOURS, rollup.currentHour, {WINDOW_24H, WINDOW_7D}, {24, ROLLUP_HOURS}, 2};
+  Tier days = {rollup.days, ROLLUP_DAYS, rollup.currentDay, {WINDOW_30D}, {ROLLUP_DAYS}, 1};
+  advance(rollup, minutes, unixTime / 60);
+  advance(rollup, hours, unixTime / 3600);
+  advance(rollup, days, unixTime / 86400);
+
+  int bin = latencyBin(latencyMs);
+  addCheck(rollup.minutes[rollup.currentMinute % ROLLUP_MINUTES].counts, up, bin, latencyMs);
+  addCheck(rollup.hours[rollup.currentHour % ROLLUP_HOURS].counts, up, bin, latencyMs);
+  addCheck(rollup.days[rollup.currentDay % ROLLUP_DAYS].counts, up, bin, latencyMs);
+  for (int w = 0; w < WINDOW_COUNT; w++) {
+    addCheck(rollup.windows[w], up, bin, latencyMs);
+  }
+}
+
+const ServiceRollup* serviceRollup(uint16_t slot, uint64_t id) {
+  if (rollups == nullptr || slot >= MAX_SERVICES) return nullptr;
+
+  const ServiceRollup& rollup = rollups[slot];
+  return rollup.id.load(std::memory_order_acquire) == id ? &rollup : nullptr;
+}
+
+RollupSummary summarizeRollup(const ServiceRollup& rollup, RollupWindow window) {
+  // Copied first so every figure comes from the same totals, barring a
+  // concurrent write
+  RollupCounts counts = rollup.windows[window];
+
+  RollupSummary summary = {};
+  summary.checks = counts.up + counts.down;
+  summary.availability = summary.checks == 0 ? -1.0f : 100.0f * counts.up / summary.checks;
+  summary.meanMs = counts.up == 0 ? 0 : counts.latencySum / counts.up;
+  summary.p50Ms = percentileMs(counts, 50);
+  summary.p95Ms = percentileMs(counts, 95);
+  summary.p99Ms = percentileMs(counts, 99);
+  return summary;
+}
+
+const char* rollupWindowName(RollupWindow window) {
+  return window < WINDOW_COUNT ? WINDOW_NAMES[window] : "";
+}
@@ -0,0 +1,48 @@
+#include "service_snapshot.hpp"
+
+#include <atomic>
+
+namespace {
+
+ServiceSnapshot buffers[2];
+std::atomic<int> activeBuffer(0);
+std::atomic<int> readerCounts[2];
+uint32_t publishedVersion = 0;
+
+}  // namespace
+
+bool publishServiceSnapshot(const ServiceTable& table, uint32_t configVersion) {
+  int back = 1 - activeBuffer.load();
+
+  // A reader that raced with the last flip may still hold the back buffer
+  if (readerCounts[back].load() != 0) {
+    return false;
+  }
+
+  ServiceSnapshot& snapshot = buffers[back];
+  snapshot.table.copyFrom(table);
+  snapshot.version = ++publishedVersion;
+  snapshot.configVersion = configVersion;
+
+  activeBuffer.store(back);
+  return true;
+}
+
+const ServiceSnapshot* acquireServiceSnapshot() {
+  while (true) {
+    int index = activeBuffer.load();
+    readerCounts[index].fetch_add(1);
+
+    // If the writer flipped between the load and the increment, the buffer we
+    // pinned may be mid-rewrite; back off and pin the new one instead.
+    if (activeBuffer.load() == index) {
+      return &buffers[index];
+    }
+    readerCounts[index].fetch_sub(1);
+  }
+}
+
+void releaseServiceSnapshot(const ServiceSnapshot* snapshot) {
+  int index = snapshot == &buffers[0] ? 0 : 1;
+  readerCounts[index].fetch_sub(1);
+}
@@ -0,0 +1,239 @@
+#include "service_table.hpp"
+
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+
+namespace {
+
+const uint32_t INDEX_MASK = ServiceIndex::CAPACITY - 1;
+
+portMUX_TYPE idLock = portMUX_INITIALIZER_UNLOCKED;
+uint64_t nextServiceId = 0;
+
+}  // namespace
+
+// --- ServiceIndex ---
+
+uint32_t ServiceIndex::bucketFor(uint64_t id) {
+  // Fibonacci hashing: the multiply spreads sequential ids across buckets
+  return (uint32_t)((id * 0x9E3779B97F4A7C15ULL) >> 32) & INDEX_MASK;
+}
+
+void ServiceIndex::clear() {
+  for (int i = 0; i < CAPACITY; i++) {
+    _ids[i] = 0;
+    _slots[i] = 0;
+  }
+}
+
+bool ServiceIndex::insert(uint64_t id, uint16_t slot) {
+  if (id == 0) return false;
+
+  uint32_t bucket = bucketFor(id);
+  for (int probe = 0; probe < CAPACITY; probe++) {
+    if (_ids[bucket] == id) return false;
+    if (_ids[bucket] == 0) {
+      _ids[bucket] = id;
+      _slots[bucket] = slot;
+      return true;
+    }
+    bucket = (bucket + 1) & INDEX_MASK;
+  }
+  return false;
+}
+
+int ServiceIndex::find(uint64_t id) const {
+  if (id == 0) return -1;
+
+  uint32_t bucket = bucketFor(id);
+  for (int probe = 0; probe < CAPACITY; probe++) {
+    if (_ids[bucket] == id) return _slots[bucket];
+    if (_ids[bucket] == 0) return -1;
+    bucket = (bucket + 1) & INDEX_MASK;
+  }
+  return -1;
+}
+
+bool ServiceIndex::remove(uint64_t id) {
+  if (id == 0) return false;
+
+  uint32_t hole = bucketFor(id);
+  int probe = 0;
+  while (_ids[hole] != id) {
+    if (_ids[hole] == 0 || ++probe >= CAPACITY) return false;
+    hole = (hole + 1) & INDEX_MASK;
+  }
+  _ids[hole] = 0;
+
+  // Backward-shift deletion: pull later entries of the run into the hole
+  // unless their home bucket lies cyclically between the hole and themselves.
+  uint32_t next = hole;
+  while (true) {
+    next = (next + 1) & INDEX_MASK;
+    if (_ids[next] == 0) break;
+
+    uint32_t home = bucketFor(_ids[next]);
+    bool staysPut = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!staysPut) {
+      _ids[hole] = _ids[next];
+      _slots[hole] = _slots[next];
+      _ids[next] = 0;
+      hole = next;
+    }
+  }
+  return true;
+}
+
+// --- ServiceTable ---
+
+void ServiceTable::clear() {
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    slotUsed[i] = false;
+  }
+  count = 0;
+  index.clear();
+}
+
+Service* ServiceTable::find(uint64_t id) {
+  int slot = index.find(id);
+  return slot < 0 ? nullptr : &slots[slot];
+}
+
+const Service* ServiceTable::find(uint64_t id) const {
+  int slot = index.find(id);
+  return slot < 0 ? nullptr : &slots[slot];
+}
+
+Service* ServiceTable::add(const Service& service) {
+  if (count >= MAX_SERVICES) return nullptr;
+
+  int slot = 0;
+  while (slotUsed[slot]) slot++;
+
+  if (!index.insert(service.id, slot)) return nullptr;
+
+  slots[slot] = service;
+  slotUsed[slot] = true;
+  order[count++] = slot;
+  return &slots[slot];
+}
+
+bool ServiceTable::remove(uint64_t id) {
+  int slot = index.find(id);
+  if (slot < 0) return false;
+
+  index.remove(id);
+  slotUsed[slot] = false;
+  slots[slot] = Service();  // release the strings
+
+  // Only the small order list shifts; services stay in their slots
+  int position = 0;
+  while (order[position] != slot) position++;
+  for (int i = position; i < count - 1; i++) {
+    order[i] = order[i + 1];
+  }
+  count--;
+  return true;
+}
+
+int ServiceTable::adoptLoadedSlots(int n) {
+  clear();
+
+  uint64_t maxId = 0;
+  int reassigned = 0;
+  for (int slot = 0; slot < n; slot++) {
+    slotUsed[slot] = true;
+    order[slot] = slot;
+    if (!index.insert(slots[slot].id, slot)) {
+      slots[slot].id = 0;
+      reassigned++;
+    } else if (slots[slot].id > maxId) {
+      maxId = slots[slot].id;
+    }
+  }
+  count = n;
+
+  // Missing or duplicate ids (hand-edited or very old files) get fresh ones
+  for (int slot = 0; slot < n && reassigned > 0; slot++) {
+    if (slots[slot].id == 0) {
+      slots[slot].id = ++maxId;
+      index.insert(slots[slot].id, slot);
+    }
+  }
+  return reassigned;
+}
+
+void ServiceTable::copyFrom(const ServiceTable& other) {
+  for (int slot = 0; slot < MAX_SERVICES; slot++) {
+    if (other.slotUsed[slot]) {
+      slots[slot] = other.slots[slot];
+    } else if (slotUsed[slot]) {
+      slots[slot] = Service();
+    }
+    slotUsed[slot] = other.slotUsed[slot];
+  }
+  for (int i = 0; i < other.count; i++) {
+    order[i] = other.order[i];
+  }
+  count = other.count;
+  index = other.index;
+}
+
+// --- Ids ---
+
+String formatServiceId(uint64_t id) {
+  char buffer[17];
+  int pos = sizeof(buffer) - 1;
+  buffer[pos] = '\0';
+  do {
+    buffer[--pos] = "0123456789abcdef"[id & 0xF];
+    id >>= 4;
+  } while (id != 0);
+  return String(buffer + pos);
+}
+
+bool parseServiceId(const String& text, uint64_t& id) {
+  if (text.length() == 0 || text.length() > 16) return false;
+
+  uint64_t value = 0;
+  for (unsigned int i = 0; i < text.length(); i++) {
+    char c = text.charAt(i);
+    int digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | digit;
+  }
+
+  if (value == 0) return false;
+  id = value;
+  return true;
+}
+
+void seedServiceIds(const ServiceTable& table) {
+  // A random 48-bit starting point keeps ids from a wiped device from being
+  // confused with ones a stale browser tab still holds
+  uint64_t next = ((uint64_t)esp_random() << 16) | 1;
+  for (int i = 0; i < table.count; i++) {
+    if (table.at(i).id >= next) {
+      next = table.at(i).id + 1;
+    }
+  }
+
+  portENTER_CRITICAL(&idLock);
+  nextServiceId = next;
+  portEXIT_CRITICAL(&idLock);
+}
+
+uint64_t generateServiceId() {
+  portENTER_CRITICAL(&idLock);
+  uint64_t id = nextServiceId++;
+  portEXIT_CRITICAL(&idLock);
+  return id;
+}
@@ -0,0 +1,276 @@
+#include "status_grid.hpp"
+
+namespace {
+
+const int16_t TILE_GAP = 4;
+const int16_t TILE_PADDING = 8;
+const uint8_t LABEL_TEXT_SIZE = 2;
+const int16_t LABEL_HEIGHT = 16;  // 8px font at LABEL_TEXT_SIZE
+
+const char* const STATUS_TEXT[] = {"DOWN", "PENDING", "UP"};
+const uint16_t TILE_COLOR[] = {TFT_RED, TFT_DARKGREY, TFT_DARKGREEN};
+
+}  // namespace
+
+void StatusGrid::begin(lgfx::LGFX_Device* display, int16_t x, int16_t y, int16_t w, int16_t h,
+                       uint16_t background) {
+  _display = display;
+  _background = background;
+  _x = x;
+  _y = y;
+  _tileW = (w - TILE_GAP * (COLUMNS + 1)) / COLUMNS;
+  _tileH = (h - TILE_GAP * (ROWS + 1)) / ROWS;
+
+  if (_tile == nullptr) {
+    _tile = new LGFX_Sprite(display);
+    _tile->setPsram(true);
+    _tile->setColorDepth(16);
+    if (_tile->createSprite(_tileW, _tileH) == nullptr) {
+      Serial.println("Status grid: tile sprite allocation failed, drawing directly");
+      delete _tile;
+      _tile = nullptr;
+    }
+  }
+
+  for (int rank = 0; rank < RANK_COUNT; rank++) {
+    _statusLabels[rank] = rasterise(_statusLabels[rank], STATUS_TEXT[rank]);
+  }
+
+  invalidate();
+}
+
+StatusGrid::Rank StatusGrid::rankOf(const Service& service) {
+  if (service.isUp) return RANK_UP;
+  return neverChecked(service) ? RANK_PENDING : RANK_DOWN;
+}
+
+uint32_t StatusGrid::hashName(const String& name) {
+  // FNV-1a; only used to notice renames
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < name.length(); i++) {
+    hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+  }
+  return hash;
+}
+
+bool StatusGrid::sameServices(const ServiceTable& table) const {
+  if (table.count != _count) return false;
+
+  for (int position = 0; position < table.count; position++) {
+    uint16_t slot = table.order[position];
+    if (_position[slot] != position || _ids[slot] != table.slots[slot].id) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void StatusGrid::sync(const ServiceTable& table) {
+  if (!sameServices(table)) {
+    rebuildOrder(table);
+    return;
+  }
+
+  for (int position = 0; position < table.count; position++) {
+    uint16_t slot = table.order[position];
+    uint8_t rank = rankOf(table.slots[slot]);
+    if (rank != _rank[slot]) {
+      move(slot, rank);
+    }
+  }
+}
+
+void StatusGrid::rebuildOrder(const ServiceTable& table) {
+  _count = table.count;
+  _downCount = 0;
+
+  for (int position = 0; position < table.count; position++) {
+    uint16_t slot = table.order[position];
+    _position[slot] = position;
+    _ids[slot] = table.slots[slot].id;
+    _rank[slot] = rankOf(table.slots[slot]);
+    if (_rank[slot] == RANK_DOWN) _downCount++;
+  }
+
+  // Counting sort by rank; configuration order is kept within a rank
+  int next = 0;
+  for (int rank = 0; rank < RANK_COUNT; rank++) {
+    for (int position = 0; position < table.count; position++) {
+      uint16_t slot = table.order[position];
+      if (_rank[slot] == rank) {
+        _order[next++] = slot;
+      }
+    }
+  }
+}
+
+void StatusGrid::move(uint16_t slot, uint8_t rank) {
+  int from = 0;
+  while (from < _count && _order[from] != slot) from++;
+  if (from == _count) return;
+
+  if (_rank[slot] == RANK_DOWN) _downCount--;
+  if (rank == RANK_DOWN) _downCount++;
+
+  for (int i = from; i < _count - 1; i++) {
+    _order[i] = _order[i + 1];
+  }
+  _rank[slot] = rank;
+
+  // The remaining entries are still sorted; binary search for the first
+  // key above this one
+  uint32_t key = sortKey(slot);
+  int low = 0;
+  int high = _count - 1;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (sortKey(_order[mid]) < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  for (int i = _count - 1; i > low; i--) {
+    _order[i] = _order[i - 1];
+  }
+  _order[low] = slot;
+}
+
+int StatusGrid::pageCount() const {
+  return _count == 0 ? 1 : (_count + TILES_PER_PAGE - 1) / TILES_PER_PAGE;
+}
+
+int StatusGrid::positionAt(int page, int16_t x, int16_t y) const {
+  int column = (x - _x - TILE_GAP) / (_tileW + TILE_GAP);
+  int row = (y - _y - TILE_GAP) / (_tileH + TILE_GAP);
+  if (x < _x || y < _y || column >= COLUMNS || row >= ROWS) return -1;
+
+  int index = page * TILES_PER_PAGE + row * COLUMNS + column;
+  if (index >= _count) return -1;
+  return _position[_order[index]];
+}
+
+void StatusGrid::invalidate() {
+  for (int i = 0; i < TILES_PER_PAGE; i++) {
+    _tiles[i].valid = false;
+  }
+}
+
+LGFX_Sprite* StatusGrid::rasterise(LGFX_Sprite* sprite, const char* text) {
+  if (sprite == nullptr) {
+    sprite = new LGFX_Sprite(_display);
+    sprite->setPsram(true);
+    sprite->setColorDepth(1);
+    if (sprite->createSprite(_tileW - 2 * TILE_PADDING, LABEL_HEIGHT) == nullptr) {
+      delete sprite;
+      return nullptr;
+    }
+    // Index 0 is pushed as transparent, index 1 in white
+    sprite->createPalette();
+    sprite->setPaletteColor(0, TFT_BLACK);
+    sprite->setPaletteColor(1, TFT_WHITE);
+  }
+
+  sprite->fillScreen(0);
+  sprite->setTextWrap(false);
+  sprite->setTextSize(LABEL_TEXT_SIZE);
+  sprite->setTextColor(1);
+  sprite->setCursor(0, 0);
+  sprite->print(text);
+  return sprite;
+}
+
+LGFX_Sprite* StatusGrid::labelFor(uint16_t slot, const Service& service, uint32_t nameHash) {
+  Label& label = _labels[slot];
+  if (label.sprite != nullptr && label.id == service.id && label.nameHash == nameHash) {
+    return label.sprite;
+  }
+
+  label.sprite = rasterise(label.sprite, service.name.c_str());
+  label.id = service.id;
+  label.nameHash = nameHash;
+  return label.sprite;
+}
+
+void StatusGrid::drawTile(lgfx::LovyanGFX& target, int16_t originX, int16_t originY,
+                          const Service* service, uint16_t slot, const TileState& state) {
+  target.fillRect(originX, originY, _tileW, _tileH, _background);
+  if (service == nullptr) return;
+
+  target.fillRoundRect(originX, originY, _tileW, _tileH, 8, TILE_COLOR[state.rank]);
+
+  int16_t textX = originX + TILE_PADDING;
+  int16_t nameY = originY + TILE_PADDING;
+  int16_t statusY = originY + _tileH - TILE_PADDING - LABEL_HEIGHT;
+
+  LGFX_Sprite* name = labelFor(slot, *service, state.nameHash);
+  if (name != nullptr) {
+    name->pushSprite(&target, textX, nameY, 0);
+  } else {
+    target.setTextSize(LABEL_TEXT_SIZE);
+    target.setTextColor(TFT_WHITE);
+    target.setCursor(textX, nameY);
+    target.print(service->name.c_str());
+  }
+
+  LGFX_Sprite* status = _statusLabels[state.rank];
+  if (status != nullptr) {
+    status->pushSprite(&target, textX, statusY, 0);
+  } else {
+    target.setTextSize(LABEL_TEXT_SIZE);
+    target.setTextColor(TFT_WHITE);
+    target.setCursor(textX, statusY);
+    target.print(STATUS_TEXT[state.rank]);
+  }
+}
+
+uint32_t StatusGrid::render(const ServiceTable& table, int page) {
+  if (_display == nullptr) return 0;
+
+  uint32_t pixels = 0;
+  bool pushed = false;
+
+  _display->startWrite();
+  for (int t = 0; t < TILES_PER_PAGE; t++) {
+    int index = page * TILES_PER_PAGE + t;
+    const Service* service = nullptr;
+    uint16_t slot = 0;
+
+    TileState state = {};
+    state.valid = true;
+    if (index < _count) {
+      slot = _order[index];
+      service = &table.slots[slot];
+      state.id = service->id;
+      state.nameHash = hashName(service->name);
+      state.rank = _rank[slot];
+    }
+
+    TileState& shown = _tiles[t];
+    if (shown.valid && shown.id == state.id && shown.nameHash == state.nameHash && shown.rank == state.rank) {
+      continue;
+    }
+
+    int16_t tileX = _x + TILE_GAP + (t % COLUMNS) * (_tileW + TILE_GAP);
+    int16_t tileY = _y + TILE_GAP + (t / COLUMNS) * (_tileH + TILE_GAP);
+
+    if (_tile != nullptr) {
+      drawTile(*_tile, 0, 0, service, slot, state);
+      if (!pushed && _beforePush != nullptr) _beforePush();
+      _tile->pushSprite(tileX, tileY);
+    } else {
+      if (!pushed && _beforePush != nullptr) _beforePush();
+      _display->setClipRect(tileX, tileY, _tileW, _tileH);
+      drawTile(*_display, tileX, tileY, service, slot, state);
+      _display->clearClipRect();
+    }
+
+    shown = state;
+    pushed = true;
+    pixels += (uint32_t)_tileW * _tileH;
+  }
+  _display->endWrite();
+
+  return pixels;
+}
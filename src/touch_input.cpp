@@ -0,0 +1,200 @@
+#include "touch_input.hpp"
+
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+
+#include "spsc_ring.hpp"
+
+namespace {
+
+const uint32_t PRESS_DEBOUNCE_MS = 30;
+const uint32_t RELEASE_DEBOUNCE_MS = 40;
+const uint32_t LONG_PRESS_MS = 700;
+const int16_t TAP_SLOP = 20;      // movement still counted as a tap or long press
+const int16_t SWIPE_MIN = 60;
+const TickType_t SAMPLE_TICKS = pdMS_TO_TICKS(15);
+
+lgfx::LGFX_Device* touchDisplay = nullptr;
+int touchIntPin = -1;
+void (*gestureCallback)() = nullptr;
+TaskHandle_t touchTaskHandle = nullptr;
+std::atomic<TickType_t> idlePollTicks{portMAX_DELAY};
+
+// Time of the first interrupt not yet answered by a sample, 0 if none
+std::atomic<uint32_t> pendingIrqMicros{0};
+
+SpscRing<TouchGesture, 8> gestures;
+TouchStats stats = {};
+
+void IRAM_ATTR onTouchInterrupt() {
+  stats.interrupts++;
+
+  uint32_t expected = 0;
+  pendingIrqMicros.compare_exchange_strong(expected, (uint32_t)micros());
+
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(touchTaskHandle, &woken);
+  if (woken == pdTRUE) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+void touchTask(void* parameter) {
+  GestureRecognizer recognizer;
+
+  for (;;) {
+    // Idle with an interrupt line: sleep until the controller reports
+    TickType_t wait = SAMPLE_TICKS;
+    if (touchIntPin >= 0 && !recognizer.active()) {
+      wait = idlePollTicks.load();
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    uint32_t sampleMicros = pendingIrqMicros.exchange(0);
+    if (sampleMicros == 0) {
+      sampleMicros = micros();
+    }
+
+    lgfx::touch_point_t point;
+    bool down = touchDisplay->getTouch(&point, 1) > 0;
+    stats.samples++;
+
+    TouchGesture gesture;
+    if (!recognizer.update(down, point.x, point.y, millis(), sampleMicros, gesture)) {
+      continue;
+    }
+
+    if (!gestures.push(gesture)) {
+      stats.dropped++;
+      continue;
+    }
+    stats.gestures++;
+    if (gestureCallback != nullptr) {
+      gestureCallback();
+    }
+  }
+}
+
+}  // namespace
+
+void GestureRecognizer::press(int16_t x, int16_t y, uint32_t nowMillis) {
+  _state = PRESSED;
+  _startX = _lastX = x;
+  _startY = _lastY = y;
+  _downAt = nowMillis;
+  _longPressSent = false;
+}
+
+bool GestureRecognizer::finish(TouchGesture& gesture) const {
+  if (_longPressSent) return false;
+
+  int16_t dx = _lastX - _startX;
+  int16_t dy = _lastY - _startY;
+  gesture.x = _startX;
+  gesture.y = _startY;
+  gesture.micros = _releasedMicros;
+
+  if (abs(dx) >= SWIPE_MIN || abs(dy) >= SWIPE_MIN) {
+    if (abs(dx) >= abs(dy)) {
+      gesture.type = dx < 0 ? GESTURE_SWIPE_LEFT : GESTURE_SWIPE_RIGHT;
+    } else {
+      gesture.type = dy < 0 ? GESTURE_SWIPE_UP : GESTURE_SWIPE_DOWN;
+    }
+    return true;
+  }
+
+  if (_releasedAt - _downAt < PRESS_DEBOUNCE_MS) return false;
+
+  gesture.type = GESTURE_TAP;
+  return true;
+}
+
+bool GestureRecognizer::update(bool down, int16_t x, int16_t y, uint32_t nowMillis,
+                               uint32_t sampleMicros, TouchGesture& gesture) {
+  switch (_state) {
+    case IDLE:
+      if (down) {
+        press(x, y, nowMillis);
+      }
+      return false;
+
+    case PRESSED:
+      if (!down) {
+        _state = RELEASING;
+        _releasedAt = nowMillis;
+        _releasedMicros = sampleMicros;
+        return false;
+      }
+
+      _lastX = x;
+      _lastY = y;
+      if (!_longPressSent && nowMillis - _downAt >= LONG_PRESS_MS &&
+          abs(x - _startX) <= TAP_SLOP && abs(y - _startY) <= TAP_SLOP) {
+        _longPressSent = true;
+        gesture.type = GESTURE_LONG_PRESS;
+        gesture.x = _startX;
+        gesture.y = _startY;
+        gesture.micros = sampleMicros;
+        return true;
+      }
+      return false;
+
+    case RELEASING:
+      if (down && nowMillis - _releasedAt < RELEASE_DEBOUNCE_MS) {
+        // Contact bounced; same touch
+        _state = PRESSED;
+        _lastX = x;
+        _lastY = y;
+        return false;
+      }
+
+      if (down) {
+        // A new touch began after the previous one ended
+        bool completed = finish(gesture);
+        press(x, y, nowMillis);
+        return completed;
+      }
+
+      if (nowMillis - _releasedAt >= RELEASE_DEBOUNCE_MS) {
+        _state = IDLE;
+        return finish(gesture);
+      }
+      return false;
+  }
+  return false;
+}
+
+bool startTouchInput(lgfx::LGFX_Device* display, int intPin, int core, void (*onGesture)()) {
+  touchDisplay = display;
+  touchIntPin = intPin;
+  gestureCallback = onGesture;
+
+  // Above the render task: a sample is a short I2C read, and it timestamps
+  // what the render task later measures latency against
+  if (xTaskCreatePinnedToCore(touchTask, "touch", 4096, nullptr, 3, &touchTaskHandle, core) != pdPASS) {
+    return false;
+  }
+
+  if (intPin >= 0) {
+    // GT911 pulses INT low when a new report is ready
+    attachInterrupt(digitalPinToInterrupt(intPin), onTouchInterrupt, FALLING);
+  }
+  return true;
+}
+
+void setTouchIdlePolling(TickType_t period) {
+  idlePollTicks.store(period);
+  if (touchTaskHandle != nullptr) {
+    xTaskNotifyGive(touchTaskHandle);  // re-evaluate the wait now
+  }
+}
+
+bool nextTouchGesture(TouchGesture& gesture) {
+  return gestures.pop(gesture);
+}
+
+const TouchStats& touchStats() {
+  return stats;
+}
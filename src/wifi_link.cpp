@@ -0,0 +1,109 @@
+#include "wifi_link.hpp"
+
+#include <WiFi.h>
+
+#include "config.hpp"
+#include "logger.hpp"
+
+namespace {
+
+volatile WifiLinkState state = LINK_CONNECTING;
+uint32_t stateSince = 0;    // millis() when `state` was entered
+uint32_t retryDelay = WIFI_RETRY_MIN_MS;
+uint32_t connects = 0;
+uint32_t losses = 0;
+uint32_t attempts = 0;
+uint64_t downMillis = 0;    // finished down periods
+uint32_t downSince = 0;
+
+void startAttempt(uint32_t nowMillis) {
+  attempts++;
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  state = LINK_CONNECTING;
+  stateSince = nowMillis;
+}
+
+void backOff(uint32_t nowMillis) {
+  // Drops a half-finished association so the next begin() starts clean
+  WiFi.disconnect();
+  state = LINK_BACKOFF;
+  stateSince = nowMillis;
+  logPrintf(LOG_WARN, "WiFi: not connected, retrying in %lus", (unsigned long)retryDelay / 1000);
+}
+
+}  // namespace
+
+void beginWifiLink() {
+  WiFi.mode(WIFI_STA);
+  // Reconnecting is done here, with back-off, not by the driver
+  WiFi.setAutoReconnect(false);
+  downSince = millis();
+  startAttempt(downSince);
+}
+
+WifiLinkEvent updateWifiLink(uint32_t nowMillis) {
+  bool connected = WiFi.status() == WL_CONNECTED;
+
+  switch (state) {
+    case LINK_CONNECTING:
+      if (connected) {
+        state = LINK_UP;
+        stateSince = nowMillis;
+        retryDelay = WIFI_RETRY_MIN_MS;
+        connects++;
+        downMillis += nowMillis - downSince;
+        logPrintf(LOG_INFO, "WiFi: connected as %s after %lu ms", WiFi.localIP().toString().c_str(),
+          (unsigned long)(nowMillis - downSince));
+        return LINK_EVENT_CONNECTED;
+      }
+      if (nowMillis - stateSince >= WIFI_CONNECT_TIMEOUT_MS) {
+        backOff(nowMillis);
+      }
+      return LINK_EVENT_NONE;
+
+    case LINK_UP:
+      if (connected) return LINK_EVENT_NONE;
+      losses++;
+      downSince = nowMillis;
+      backOff(nowMillis);
+      return LINK_EVENT_LOST;
+
+    case LINK_BACKOFF:
+      if (nowMillis - stateSince >= retryDelay) {
+        retryDelay = retryDelay * 2 < WIFI_RETRY_MAX_MS ? retryDelay * 2 : WIFI_RETRY_MAX_MS;
+        startAttempt(nowMillis);
+      }
+      return LINK_EVENT_NONE;
+  }
+  return LINK_EVENT_NONE;
+}
+
+bool wifiLinkUp() {
+  return state == LINK_UP;
+}
+
+WifiLinkStats wifiLinkStats(uint32_t nowMillis) {
+  WifiLinkStats stats = {};
+  stats.state = state;
+  stats.connects = connects;
+  stats.losses = losses;
+  stats.attempts = attempts;
+  stats.downMillis = downMillis + (state == LINK_UP ? 0 : nowMillis - downSince);
+  if (state == LINK_BACKOFF) {
+    uint32_t waited = nowMillis - stateSince;
+    stats.retryInMillis = waited < retryDelay ? retryDelay - waited : 0;
+  }
+  return stats;
+}
+
+String wifiLinkStatusText(uint32_t nowMillis) {
+  switch (state) {
+    case LINK_UP:
+      return WiFi.localIP().toString();
+    case LINK_CONNECTING:
+      return "Connecting to WiFi...";
+    case LINK_BACKOFF:
+      return "No WiFi, retry in " + String((wifiLinkStats(nowMillis).retryInMillis + 999) / 1000) + "s";
+  }
+  return String();
+}
@@ -0,0 +1,193 @@
+#include <unity.h>
+
+#include "check_runner.hpp"
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "service_engine.hpp"
+
+namespace {
+
+FakeClock fakeClock;
+FakeNetwork network;
+FakeHttpClient http(fakeClock);
+FakePinger pinger;
+RecordingDisplay display;
+CheckPlatform platform = {fakeClock, network, http, pinger, display};
+
+ServiceTable table;
+std::vector<CheckOutcome> outcomes;
+
+void recordOutcome(Service& service, const CheckOutcome& outcome) {
+  (void)service;
+  outcomes.push_back(outcome);
+}
+
+Service* addService(uint64_t id, ServiceType type) {
+  Service service = fakeService(id, type);
+  service.failThreshold = 2;
+  return table.add(service);
+}
+
+}  // namespace
+
+void setUp() {
+  fakeClock = FakeClock();
+  fakeClock.advance(100000);
+  network = FakeNetwork();
+  http.respond = nullptr;
+  http.requests.clear();
+  pinger = FakePinger();
+  display.updates = 0;
+  table.clear();
+  outcomes.clear();
+  setSystemClock(fakeClock);
+}
+
+void tearDown() {}
+
+void test_checks_only_due_services() {
+  Service* due = addService(1, TYPE_HTTP_GET);
+  Service* notDue = addService(2, TYPE_HTTP_GET);
+  due->lastCheck = fakeClock.millis() - 60000;
+  notDue->lastCheck = fakeClock.millis() - 1000;
+
+  TEST_ASSERT_EQUAL(1, runDueChecks(table, platform, recordOutcome));
+  TEST_ASSERT_EQUAL(1, (int)outcomes.size());
+  TEST_ASSERT_EQUAL(table.index.find(1), outcomes[0].slot);
+  TEST_ASSERT_EQUAL(fakeClock.millis(), due->lastCheck);
+  TEST_ASSERT_EQUAL(fakeClock.millis() - 1000, notDue->lastCheck);
+}
+
+void test_first_check_updates_display_and_reports_up() {
+  Service* service = addService(1, TYPE_HTTP_GET);
+  http.respond = [](const FakeHttpClient::Request&) { return httpResult(PROBE_OK, 200, 35); };
+
+  runDueChecks(table, platform, recordOutcome);
+
+  TEST_ASSERT_EQUAL(1, (int)outcomes.size());
+  TEST_ASSERT_TRUE(outcomes[0].firstCheck);
+  TEST_ASSERT_TRUE(outcomes[0].changed);
+  TEST_ASSERT_EQUAL(PROBE_OK, outcomes[0].error);
+  TEST_ASSERT_EQUAL(0, outcomes[0].lateness);
+  TEST_ASSERT_EQUAL(35000, outcomes[0].probeMicros);
+  TEST_ASSERT_TRUE(service->isUp);
+  TEST_ASSERT_EQUAL(35, service->lastLatency);
+  TEST_ASSERT_EQUAL(1, display.updates);
+}
+
+void test_display_waits_for_the_threshold() {
+  Service* service = addService(1, TYPE_HTTP_GET);
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_EQUAL(1, display.updates);
+
+  // One failure of two: still UP, nothing to show
+  http.respond = [](const FakeHttpClient::Request&) { return httpResult(PROBE_TIMEOUT, 0, 8000); };
+  fakeClock.advance(checkIntervalMs(*service));
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_TRUE(service->isUp);
+  TEST_ASSERT_FALSE(outcomes.back().changed);
+  TEST_ASSERT_EQUAL(1, display.updates);
+
+  fakeClock.advance(checkIntervalMs(*service));
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_FALSE(service->isUp);
+  TEST_ASSERT_TRUE(outcomes.back().changed);
+  TEST_ASSERT_EQUAL(PROBE_TIMEOUT, outcomes.back().error);
+  TEST_ASSERT_EQUAL_STRING("Timed out after 8000 ms", service->lastError.c_str());
+  TEST_ASSERT_EQUAL(2, display.updates);
+}
+
+void test_lateness_includes_earlier_probes() {
+  Service* first = addService(1, TYPE_HTTP_GET);
+  Service* second = addService(2, TYPE_HTTP_GET);
+  first->consecutivePasses = second->consecutivePasses = 1;
+  first->isUp = second->isUp = true;
+  first->lastCheck = second->lastCheck = fakeClock.millis() - 60000;
+  http.respond = [](const FakeHttpClient::Request&) { return httpResult(PROBE_OK, 200, 500); };
+
+  runDueChecks(table, platform, recordOutcome);
+
+  TEST_ASSERT_EQUAL(2, (int)outcomes.size());
+  TEST_ASSERT_EQUAL(0, outcomes[0].lateness);
+  TEST_ASSERT_EQUAL(500, outcomes[1].lateness);
+  TEST_ASSERT_EQUAL(0, display.updates);
+}
+
+void test_failure_without_link_is_discarded() {
+  Service* first = addService(1, TYPE_HTTP_GET);
+  Service* second = addService(2, TYPE_HTTP_GET);
+  unsigned long due = fakeClock.millis() - 60000;
+  first->lastCheck = second->lastCheck = due;
+  network.up = false;
+  http.respond = [](const FakeHttpClient::Request&) { return httpResult(PROBE_CONNECT_FAILED); };
+
+  TEST_ASSERT_EQUAL(0, runDueChecks(table, platform, recordOutcome));
+  TEST_ASSERT_EQUAL(0, (int)outcomes.size());
+  TEST_ASSERT_EQUAL(1, (int)http.requests.size());
+  TEST_ASSERT_EQUAL(due, first->lastCheck);
+  TEST_ASSERT_EQUAL(due, second->lastCheck);
+  TEST_ASSERT_TRUE(neverChecked(*first));
+}
+
+void test_http_types_use_their_paths_and_statuses() {
+  addService(1, TYPE_HOME_ASSISTANT);
+  addService(2, TYPE_JELLYFIN);
+  Service* get = addService(3, TYPE_HTTP_GET);
+  get->path = "/status";
+  get->expectedResponse = "ok";
+  http.respond = [](const FakeHttpClient::Request&) { return httpResult(PROBE_OK, 404); };
+
+  runDueChecks(table, platform, recordOutcome);
+
+  TEST_ASSERT_EQUAL(3, (int)http.requests.size());
+  TEST_ASSERT_EQUAL_STRING("/api/", http.requests[0].path.c_str());
+  TEST_ASSERT_EQUAL_STRING("/health", http.requests[1].path.c_str());
+  TEST_ASSERT_EQUAL_STRING("/status", http.requests[2].path.c_str());
+  TEST_ASSERT_EQUAL_STRING("ok", http.requests[2].expected.c_str());
+
+  // Any status means Home Assistant is alive; the others want 200
+  TEST_ASSERT_EQUAL(PROBE_OK, outcomes[0].error);
+  TEST_ASSERT_EQUAL(PROBE_HTTP_STATUS, outcomes[1].error);
+  TEST_ASSERT_EQUAL(PROBE_HTTP_STATUS, outcomes[2].error);
+  TEST_ASSERT_EQUAL_STRING("HTTP 404", get->lastError.c_str());
+}
+
+void test_ping_reports_dns_and_timeouts_apart() {
+  Service* service = addService(1, TYPE_PING);
+  network.failResolve = true;
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_EQUAL(PROBE_DNS_FAILED, outcomes.back().error);
+  TEST_ASSERT_EQUAL(0, pinger.pings);
+
+  network.failResolve = false;
+  pinger.reachable = false;
+  fakeClock.advance(checkIntervalMs(*service));
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_EQUAL(PROBE_TIMEOUT, outcomes.back().error);
+  TEST_ASSERT_EQUAL_STRING("Ping timeout", service->lastError.c_str());
+  TEST_ASSERT_EQUAL(1, pinger.pings);
+}
+
+void test_unix_time_follows_the_clock() {
+  addService(1, TYPE_PING);
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_EQUAL(0, outcomes.back().unixTime);
+
+  fakeClock.setUnixStart(1750000000);
+  addService(2, TYPE_PING);
+  runDueChecks(table, platform, recordOutcome);
+  TEST_ASSERT_EQUAL(1750000000 + fakeClock.millis() / 1000, outcomes.back().unixTime);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_checks_only_due_services);
+  RUN_TEST(test_first_check_updates_display_and_reports_up);
+  RUN_TEST(test_display_waits_for_the_threshold);
+  RUN_TEST(test_lateness_includes_earlier_probes);
+  RUN_TEST(test_failure_without_link_is_discarded);
+  RUN_TEST(test_http_types_use_their_paths_and_statuses);
+  RUN_TEST(test_ping_reports_dns_and_timeouts_apart);
+  RUN_TEST(test_unix_time_follows_the_clock);
+  return UNITY_END();
+}
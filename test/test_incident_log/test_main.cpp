@@ -0,0 +1,285 @@
+#include <unity.h>
+
+#include <LittleFS.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "incident_log.hpp"
+#include "service_engine.hpp"
+
+// The log has no reset and opens once per process, so the tests run in
+// order: the first one opens it over damaged files, the others keep adding.
+
+namespace {
+
+const uint32_t START_TIME = 1750000000;
+const int SEEDED_RECORDS = INCIDENT_INDEX_EVERY + 8;
+
+FakeClock fakeClock;
+
+// Every incident expected in the files, in the order they were closed
+std::vector<IncidentRecord> expected;
+
+IncidentRecord incident(uint64_t id, uint32_t start, uint32_t end, uint32_t failedProbes, uint8_t firstError) {
+  IncidentRecord record = {};
+  record.id = id;
+  record.start = start;
+  record.end = end;
+  record.failedProbes = failedProbes;
+  record.firstError = firstError;
+  return record;
+}
+
+size_t fileRecords(const char* path) {
+  if (!LittleFS.exists(path)) return 0;
+  File file = LittleFS.open(path, "r");
+  size_t records = file.size() / sizeof(IncidentRecord);
+  file.close();
+  return records;
+}
+
+// Closed incidents the cursor returns for the query, ongoing ones left out
+std::vector<IncidentRecord> query(uint32_t from, uint32_t to, uint64_t id) {
+  std::vector<IncidentRecord> records;
+  IncidentCursor cursor(from, to, id);
+  IncidentRecord record;
+  while (cursor.next(record)) {
+    if (record.end != 0) records.push_back(record);
+  }
+  return records;
+}
+
+void assertSameIncident(const IncidentRecord& expected, const IncidentRecord& actual) {
+  TEST_ASSERT_TRUE(expected.id == actual.id);
+  TEST_ASSERT_EQUAL_UINT32(expected.start, actual.start);
+  TEST_ASSERT_EQUAL_UINT32(expected.end, actual.end);
+  TEST_ASSERT_EQUAL_UINT32(expected.failedProbes, actual.failedProbes);
+  TEST_ASSERT_EQUAL(expected.firstError, actual.firstError);
+}
+
+// Checks the service once at the fake clock's time
+void check(uint16_t slot, Service& service, bool passed, uint8_t error) {
+  applyCheckResult(service, passed, fakeClock.millis());
+  trackIncident(slot, service, passed, passed ? 0 : error, fakeClock.millis(), fakeClock.unixTime());
+}
+
+// The log's rules, for the brute-force comparison
+struct OpenRun {
+  bool failing = false;
+  bool down = false;
+  IncidentRecord record = {};
+
+  void follow(const Service& service, bool passed, uint8_t error, uint32_t unixTime) {
+    if (!passed) {
+      if (!failing) {
+        failing = true;
+        record = incident(service.id, unixTime, 0, 0, error);
+      }
+      record.failedProbes++;
+      if (!service.isUp) down = true;
+    } else if (down && service.isUp) {
+      record.end = unixTime;
+      expected.push_back(record);
+      failing = false;
+      down = false;
+    } else if (!down) {
+      failing = false;
+    }
+  }
+};
+
+}  // namespace
+
+void setUp() {
+  setSystemClock(fakeClock);
+}
+
+void tearDown() {}
+
+void test_open_repairs_a_cut_short_write() {
+  useTempLittleFS();
+  fakeClock.setUnixStart(START_TIME);
+
+  // A reset after the records of a full block but before its index entry,
+  // and in the middle of the next record
+  File data = LittleFS.open("/incidents.bin", "w");
+  for (int i = 0; i < SEEDED_RECORDS; i++) {
+    IncidentRecord record = incident(0x5eed, START_TIME - 100000 + i * 1000, START_TIME - 99500 + i * 1000, 3, 2);
+    data.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    expected.push_back(record);
+  }
+  data.write(reinterpret_cast<const uint8_t*>("partial"), 7);
+  data.close();
+  LittleFS.open("/incidents.idx", "w").close();
+
+  TEST_ASSERT_TRUE(initIncidentLog());
+
+  TEST_ASSERT_EQUAL(SEEDED_RECORDS * sizeof(IncidentRecord), LittleFS.open("/incidents.bin", "r").size());
+  TEST_ASSERT_EQUAL(sizeof(IncidentIndexEntry), LittleFS.open("/incidents.idx", "r").size());
+
+  std::vector<IncidentRecord> all = query(0, UINT32_MAX, 0);
+  TEST_ASSERT_EQUAL(SEEDED_RECORDS, (int)all.size());
+  for (int i = 0; i < SEEDED_RECORDS; i++) {
+    assertSameIncident(expected[i], all[i]);
+  }
+}
+
+void test_incidents_match_a_reference_model() {
+  srand(7);
+  Service services[3];
+  OpenRun runs[3];
+  for (int k = 0; k < 3; k++) {
+    services[k] = fakeService(100 + k);
+    services[k].passThreshold = 2;
+    services[k].failThreshold = 3;
+  }
+
+  // Enough outages to rotate the file twice
+  for (int i = 0; i < 120000; i++) {
+    fakeClock.advance(20000);
+    for (int k = 0; k < 3; k++) {
+      bool passed = rand() % 100 < (k == 2 ? 70 : 95);
+      uint8_t error = 1 + rand() % 7;
+      check(k, services[k], passed, error);
+      runs[k].follow(services[k], passed, passed ? 0 : error, fakeClock.unixTime());
+    }
+  }
+  TEST_ASSERT_TRUE(LittleFS.exists("/incidents.old.bin"));
+
+  // Two files' worth is kept
+  size_t kept = fileRecords("/incidents.old.bin") + fileRecords("/incidents.bin");
+  TEST_ASSERT_TRUE(kept <= expected.size());
+  std::vector<IncidentRecord> keptIncidents(expected.end() - kept, expected.end());
+  uint32_t first = keptIncidents.front().start;
+
+  for (int q = 0; q < 200; q++) {
+    uint32_t from = q == 0 ? 0 : first - 5000 + rand() % (fakeClock.unixTime() - first + 10000);
+    uint32_t to = q == 0 ? UINT32_MAX : from + rand() % 200000;
+    uint64_t id = q == 0 || rand() % 2 ? 0 : 100 + rand() % 3;
+
+    std::vector<IncidentRecord> want;
+    for (const IncidentRecord& record : keptIncidents) {
+      if ((id == 0 || record.id == id) && record.start <= to && record.end >= from) {
+        want.push_back(record);
+      }
+    }
+
+    std::vector<IncidentRecord> got = query(from, to, id);
+    TEST_ASSERT_EQUAL((int)want.size(), (int)got.size());
+    for (size_t i = 0; i < want.size(); i++) {
+      assertSameIncident(want[i], got[i]);
+    }
+  }
+}
+
+void test_ongoing_outage_is_listed_without_an_end() {
+  Service service = fakeService(0x0d0);
+  service.failThreshold = 2;
+  check(10, service, true, 0);
+
+  fakeClock.advance(60000);
+  uint32_t start = fakeClock.unixTime();
+  check(10, service, false, 4);
+  TEST_ASSERT_EQUAL(0, (int)query(start, UINT32_MAX, service.id).size());
+
+  IncidentCursor pending(start, UINT32_MAX, service.id);
+  IncidentRecord record;
+  TEST_ASSERT_FALSE(pending.next(record));  // still UP, not an incident yet
+
+  fakeClock.advance(60000);
+  check(10, service, false, 5);
+  TEST_ASSERT_FALSE(service.isUp);
+
+  IncidentCursor ongoing(start, UINT32_MAX, service.id);
+  TEST_ASSERT_TRUE(ongoing.next(record));
+  assertSameIncident(incident(service.id, start, 0, 2, 4), record);
+  TEST_ASSERT_FALSE(ongoing.next(record));
+
+  IncidentCursor earlier(0, start - 1, service.id);
+  TEST_ASSERT_FALSE(earlier.next(record));
+
+  fakeClock.advance(60000);
+  check(10, service, true, 0);
+  std::vector<IncidentRecord> closed = query(start, UINT32_MAX, service.id);
+  TEST_ASSERT_EQUAL(1, (int)closed.size());
+  assertSameIncident(incident(service.id, start, fakeClock.unixTime(), 2, 4), closed[0]);
+}
+
+void test_outage_continues_across_a_reboot() {
+  Service service = fakeService(0xb00);
+  service.failThreshold = 1;
+
+  OpenIncidentState state;
+  TEST_ASSERT_FALSE(openIncidentState(11, service.id, state));
+
+  fakeClock.advance(60000);
+  uint32_t start = fakeClock.unixTime();
+  check(11, service, false, 3);
+  fakeClock.advance(60000);
+  check(11, service, false, 6);
+
+  TEST_ASSERT_FALSE(openIncidentState(11, 0xbad, state));
+  TEST_ASSERT_TRUE(openIncidentState(11, service.id, state));
+  TEST_ASSERT_EQUAL_UINT32(start, state.start);
+  TEST_ASSERT_EQUAL_UINT32(2, state.failedProbes);
+  TEST_ASSERT_EQUAL(3, state.firstError);
+  TEST_ASSERT_TRUE(state.down);
+
+  // After the reboot the service may sit in another slot and starts out
+  // with its saved status
+  fakeClock.advance(300000);
+  restoreOpenIncident(12, service.id, state);
+  check(12, service, false, 1);
+  fakeClock.advance(60000);
+  check(12, service, true, 0);
+
+  std::vector<IncidentRecord> closed = query(start, UINT32_MAX, service.id);
+  TEST_ASSERT_EQUAL(1, (int)closed.size());
+  assertSameIncident(incident(service.id, start, fakeClock.unixTime(), 3, 3), closed[0]);
+  TEST_ASSERT_FALSE(openIncidentState(12, service.id, state));
+}
+
+void test_short_failure_runs_are_not_incidents() {
+  Service service = fakeService(0x5a0);
+  service.failThreshold = 3;
+  check(13, service, true, 0);
+
+  fakeClock.advance(60000);
+  check(13, service, false, 2);
+  OpenIncidentState state;
+  TEST_ASSERT_TRUE(openIncidentState(13, service.id, state));
+  TEST_ASSERT_FALSE(state.down);
+
+  fakeClock.advance(60000);
+  check(13, service, true, 0);
+  TEST_ASSERT_FALSE(openIncidentState(13, service.id, state));
+  TEST_ASSERT_EQUAL(0, (int)query(0, UINT32_MAX, service.id).size());
+}
+
+void test_outage_without_a_clock_is_dropped() {
+  Service service = fakeService(0xc10c);
+  service.failThreshold = 1;
+  size_t before = fileRecords("/incidents.bin");
+
+  fakeClock.setUnixStart(0);
+  check(14, service, false, 2);
+  fakeClock.advance(60000);
+  check(14, service, true, 0);
+  fakeClock.setUnixStart(START_TIME);
+
+  TEST_ASSERT_EQUAL(before, fileRecords("/incidents.bin"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_open_repairs_a_cut_short_write);
+  RUN_TEST(test_incidents_match_a_reference_model);
+  RUN_TEST(test_ongoing_outage_is_listed_without_an_end);
+  RUN_TEST(test_outage_continues_across_a_reboot);
+  RUN_TEST(test_short_failure_runs_are_not_incidents);
+  RUN_TEST(test_outage_without_a_clock_is_dropped);
+  return UNITY_END();
+}
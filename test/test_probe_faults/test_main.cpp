@@ -0,0 +1,298 @@
+#include <unity.h>
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "check_runner.hpp"
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "mock_servers.hpp"
+
+// The service checks against local servers that fail the way real outages
+// do. Every probe must end within PROBE_DEADLINE_MS, stay within a small
+// heap budget whatever the server sends, and report the right ProbeError.
+// The native build shortens the deadline so the slow cases run quickly.
+
+namespace {
+
+const uint32_t SLACK_MS = 150;     // scheduling and the probe's 1 ms polling
+const int64_t HEAP_BUDGET = 1024;  // request line, socket, error text
+const uint32_t ECHO_TIMEOUT_MS = 200;
+
+// Heap use of the probing thread; the servers' threads are not counted
+thread_local bool counting = false;
+int64_t heapInUse = 0;
+int64_t heapPeak = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* memory = malloc(size != 0 ? size : 1);
+  if (memory == nullptr) throw std::bad_alloc();
+  if (counting) {
+    heapInUse += malloc_usable_size(memory);
+    if (heapInUse > heapPeak) heapPeak = heapInUse;
+  }
+  return memory;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+  if (memory != nullptr && counting) heapInUse -= malloc_usable_size(memory);
+  free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+  operator delete(memory);
+}
+
+namespace {
+
+PosixClock posixClock;
+PosixNetwork network;
+BoundedHttpClient http(network, posixClock);
+RecordingDisplay display;
+
+struct ProbeRun {
+  ProbeError error;
+  char lastError[64];
+  uint32_t millis;     // wall time of the whole check
+  int64_t heapPeak;    // above what was in use before
+  int64_t heapLeaked;
+};
+
+// One check of a service of `type` at 127.0.0.1:`port`, or `host`. The
+// service lives only for the check so its heap use is counted too.
+ProbeRun check(ServiceType type, uint16_t port, const char* expected = "*", const char* host = "127.0.0.1",
+    uint16_t echoPort = 0) {
+  UdpEchoPinger pinger(echoPort, ECHO_TIMEOUT_MS);
+  CheckPlatform platform = {posixClock, network, http, pinger, display};
+  ProbeRun run = {};
+
+  heapInUse = 0;
+  heapPeak = 0;
+  counting = true;
+  {
+    Service service = fakeService(0x42, type);
+    service.host = host;
+    service.port = port;
+    service.path = "/status";
+    service.expectedResponse = expected;
+
+    uint32_t start = posixClock.millis();
+    run.error = probeService(service, platform);
+    run.millis = posixClock.millis() - start;
+    strncpy(run.lastError, service.lastError.c_str(), sizeof(run.lastError) - 1);
+  }
+  counting = false;
+  run.heapPeak = heapPeak;
+  run.heapLeaked = heapInUse;
+  return run;
+}
+
+void assertBounded(const ProbeRun& run) {
+  TEST_ASSERT_LESS_OR_EQUAL(PROBE_DEADLINE_MS + SLACK_MS, run.millis);
+  TEST_ASSERT_LESS_OR_EQUAL(HEAP_BUDGET, run.heapPeak);
+  TEST_ASSERT_EQUAL(0, run.heapLeaked);
+}
+
+// Ran into the deadline rather than failing early
+void assertTimedOut(const ProbeRun& run) {
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_TIMEOUT, run.error);
+  TEST_ASSERT_TRUE(run.millis + SLACK_MS >= PROBE_DEADLINE_MS);
+  TEST_ASSERT_EQUAL(0, strncmp(run.lastError, "Timed out after ", 16));
+}
+
+}  // namespace
+
+void setUp() {
+  network.useDnsServer(0, 0);
+}
+
+void tearDown() {}
+
+void test_healthy_server_passes() {
+  MockHttpServer server(MOCK_HTTP_OK, "{\"status\": \"healthy\"}");
+
+  ProbeRun run = check(TYPE_HTTP_GET, server.port(), "healthy");
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_OK, run.error);
+
+  TEST_ASSERT_EQUAL(PROBE_OK, check(TYPE_JELLYFIN, server.port()).error);
+  TEST_ASSERT_EQUAL(PROBE_OK, check(TYPE_HOME_ASSISTANT, server.port()).error);
+  TEST_ASSERT_EQUAL(3, server.connections());
+}
+
+void test_error_status() {
+  MockHttpServer server(MOCK_HTTP_OK, "Not Found", 404);
+
+  ProbeRun run = check(TYPE_HTTP_GET, server.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_HTTP_STATUS, run.error);
+  TEST_ASSERT_EQUAL_STRING("HTTP 404", run.lastError);
+
+  TEST_ASSERT_EQUAL(PROBE_HTTP_STATUS, check(TYPE_JELLYFIN, server.port()).error);
+  TEST_ASSERT_EQUAL(PROBE_OK, check(TYPE_HOME_ASSISTANT, server.port()).error);  // any answer will do
+}
+
+void test_slowloris_times_out() {
+  MockHttpServer server(MOCK_HTTP_SLOWLORIS);
+  assertTimedOut(check(TYPE_HTTP_GET, server.port()));
+  assertTimedOut(check(TYPE_HOME_ASSISTANT, server.port()));
+}
+
+void test_half_open_connection_times_out() {
+  MockHttpServer server(MOCK_HTTP_HALF_OPEN);
+  assertTimedOut(check(TYPE_HTTP_GET, server.port(), "healthy"));
+  assertTimedOut(check(TYPE_JELLYFIN, server.port()));
+}
+
+void test_reset_in_headers() {
+  MockHttpServer server(MOCK_HTTP_RESET_IN_HEADERS);
+  ProbeRun run = check(TYPE_HTTP_GET, server.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_CONNECTION_CLOSED, run.error);
+  TEST_ASSERT_EQUAL_STRING("Connection closed before response", run.lastError);
+}
+
+void test_reset_in_body() {
+  MockHttpServer server(MOCK_HTTP_RESET_IN_BODY, std::string(2000, '-') + "healthy");
+
+  // The expected text was in the half that never came
+  ProbeRun run = check(TYPE_HTTP_GET, server.port(), "healthy");
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_MISMATCH, run.error);
+  TEST_ASSERT_EQUAL_STRING("Response mismatch", run.lastError);
+
+  // Without a body to check, the status was enough
+  TEST_ASSERT_EQUAL(PROBE_OK, check(TYPE_JELLYFIN, server.port()).error);
+}
+
+void test_huge_body_is_read_up_to_the_cap() {
+  MockHttpServer server(MOCK_HTTP_HUGE_BODY);
+  ProbeRun run = check(TYPE_HTTP_GET, server.port(), "healthy");
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_MISMATCH, run.error);
+  TEST_ASSERT_EQUAL_STRING("Response mismatch (first 16 KB)", run.lastError);
+  TEST_ASSERT_TRUE(run.millis < PROBE_DEADLINE_MS / 2);  // stops at the cap, not the deadline
+}
+
+void test_endless_chunked_body() {
+  MockHttpServer server(MOCK_HTTP_ENDLESS_CHUNKED);
+  assertTimedOut(check(TYPE_HTTP_GET, server.port(), "healthy"));
+
+  // Nothing to find in the body: done after the headers
+  ProbeRun run = check(TYPE_HTTP_GET, server.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_OK, run.error);
+  TEST_ASSERT_TRUE(run.millis < PROBE_DEADLINE_MS / 2);
+}
+
+void test_endless_headers_are_invalid() {
+  MockHttpServer server(MOCK_HTTP_HUGE_HEADERS);
+  ProbeRun run = check(TYPE_JELLYFIN, server.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_BAD_RESPONSE, run.error);
+  TEST_ASSERT_EQUAL_STRING("Invalid HTTP response", run.lastError);
+}
+
+void test_other_protocol_is_invalid() {
+  MockHttpServer server(MOCK_HTTP_NOT_HTTP);
+  ProbeRun run = check(TYPE_HOME_ASSISTANT, server.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_BAD_RESPONSE, run.error);
+}
+
+void test_refused_connection() {
+  uint16_t port;
+  {
+    MockHttpServer closed(MOCK_HTTP_OK);
+    port = closed.port();
+  }
+  ProbeRun run = check(TYPE_HTTP_GET, port);
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_CONNECT_FAILED, run.error);
+  TEST_ASSERT_EQUAL_STRING("Connection failed", run.lastError);
+}
+
+void test_names_resolve_through_the_dns_server() {
+  MockHttpServer server(MOCK_HTTP_OK, "healthy");
+  MockDnsServer dns(MOCK_DNS_ANSWER);
+  network.useDnsServer(0x0100007F, dns.port());
+
+  TEST_ASSERT_EQUAL(PROBE_OK, check(TYPE_HTTP_GET, server.port(), "healthy", "nas.home.lan").error);
+  TEST_ASSERT_EQUAL(1, dns.queries());
+}
+
+void test_hanging_dns_fails_within_the_deadline() {
+  MockDnsServer dns(MOCK_DNS_HANG);
+  network.useDnsServer(0x0100007F, dns.port());
+
+  for (ServiceType type : {TYPE_HTTP_GET, TYPE_PING}) {
+    ProbeRun run = check(type, 80, "*", "nas.home.lan");
+    assertBounded(run);
+    TEST_ASSERT_EQUAL(PROBE_DNS_FAILED, run.error);
+    TEST_ASSERT_EQUAL_STRING("DNS lookup failed", run.lastError);
+  }
+  TEST_ASSERT_EQUAL(2, dns.queries());
+}
+
+void test_unknown_name_fails_at_once() {
+  MockDnsServer dns(MOCK_DNS_NXDOMAIN);
+  network.useDnsServer(0x0100007F, dns.port());
+
+  ProbeRun run = check(TYPE_JELLYFIN, 80, "*", "gone.home.lan");
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_DNS_FAILED, run.error);
+  TEST_ASSERT_TRUE(run.millis < PROBE_DEADLINE_MS / 2);
+}
+
+void test_ping() {
+  MockEchoServer up(true);
+  ProbeRun run = check(TYPE_PING, 0, "*", "127.0.0.1", up.port());
+  assertBounded(run);
+  TEST_ASSERT_EQUAL(PROBE_OK, run.error);
+
+  // Three echo requests, each given up on
+  MockEchoServer down(false);
+  run = check(TYPE_PING, 0, "*", "127.0.0.1", down.port());
+  TEST_ASSERT_EQUAL(PROBE_TIMEOUT, run.error);
+  TEST_ASSERT_EQUAL_STRING("Ping timeout", run.lastError);
+  TEST_ASSERT_UINT32_WITHIN(SLACK_MS, 3 * ECHO_TIMEOUT_MS, run.millis);
+  TEST_ASSERT_LESS_OR_EQUAL(HEAP_BUDGET, run.heapPeak);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_healthy_server_passes);
+  RUN_TEST(test_error_status);
+  RUN_TEST(test_slowloris_times_out);
+  RUN_TEST(test_half_open_connection_times_out);
+  RUN_TEST(test_reset_in_headers);
+  RUN_TEST(test_reset_in_body);
+  RUN_TEST(test_huge_body_is_read_up_to_the_cap);
+  RUN_TEST(test_endless_chunked_body);
+  RUN_TEST(test_endless_headers_are_invalid);
+  RUN_TEST(test_other_protocol_is_invalid);
+  RUN_TEST(test_refused_connection);
+  RUN_TEST(test_names_resolve_through_the_dns_server);
+  RUN_TEST(test_hanging_dns_fails_within_the_deadline);
+  RUN_TEST(test_unknown_name_fails_at_once);
+  RUN_TEST(test_ping);
+  return UNITY_END();
+}
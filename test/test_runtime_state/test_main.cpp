@@ -0,0 +1,215 @@
+#include <unity.h>
+
+#include <Preferences.h>
+
+#include <vector>
+
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "incident_log.hpp"
+#include "runtime_state.hpp"
+#include "service_engine.hpp"
+
+// A "reboot" here is restoring into a freshly loaded table: NVS (host
+// Preferences) and the incident log outlive it, like on the device.
+
+namespace {
+
+const uint32_t START_TIME = 1750000000;
+
+FakeClock fakeClock;
+ServiceTable table;
+
+// The services as loaded from flash at boot, never checked, in `ids` order
+void loadTable(ServiceTable& loaded, const std::vector<uint64_t>& ids) {
+  loaded.clear();
+  for (uint64_t id : ids) {
+    Service service = fakeService(id);
+    service.failThreshold = 2;
+    loaded.add(service);
+  }
+}
+
+void check(uint64_t id, bool passed, uint8_t error = 0, uint32_t latency = 0) {
+  Service* service = table.find(id);
+  bool changed = applyCheckResult(*service, passed, fakeClock.millis());
+  service->lastLatency = latency;
+  trackIncident(table.index.find(id), *service, passed, error, fakeClock.millis(), fakeClock.unixTime());
+  markRuntimeStateDirty(changed);
+}
+
+bool saved() {
+  Preferences preferences;
+  preferences.begin("runtime", true);
+  size_t length = preferences.getBytesLength("services");
+  preferences.end();
+  return length > 0;
+}
+
+// Saves whatever is pending, as the next loop() pass would
+void saveNow() {
+  fakeClock.advance(RUNTIME_STATE_SAVE_MS);
+  saveRuntimeStateIfDue(table, fakeClock.millis());
+}
+
+}  // namespace
+
+void setUp() {
+  setSystemClock(fakeClock);
+  Preferences::clearAll();
+  fakeClock.advance(RUNTIME_STATE_SAVE_MS);
+}
+
+void tearDown() {}
+
+void test_nothing_saved_restores_nothing() {
+  useTempLittleFS();
+  TEST_ASSERT_TRUE(initIncidentLog());
+  fakeClock.setUnixStart(START_TIME);
+
+  loadTable(table, {0x1, 0x2});
+  TEST_ASSERT_EQUAL(0, restoreRuntimeState(table));
+  TEST_ASSERT_TRUE(neverChecked(table.at(0)));
+}
+
+void test_status_and_counters_survive_a_reboot() {
+  loadTable(table, {0x1, 0x2, 0x3, 0x4});
+  check(0x1, true, 0, 35);
+  check(0x1, true, 0, 40);
+  check(0x2, false, 3);
+  check(0x3, false, 3);
+  check(0x3, false, 3);
+  saveNow();
+
+  // 0x4 was never checked and 0x2 has been deleted; the rest load in
+  // another order, so into other slots
+  loadTable(table, {0x5, 0x4, 0x3, 0x1});
+  TEST_ASSERT_EQUAL(2, restoreRuntimeState(table));
+
+  const Service* up = table.find(0x1);
+  TEST_ASSERT_TRUE(up->isUp);
+  TEST_ASSERT_EQUAL(2, up->consecutivePasses);
+  TEST_ASSERT_EQUAL(0, up->consecutiveFails);
+  TEST_ASSERT_EQUAL_UINT32(40, up->lastLatency);
+
+  const Service* down = table.find(0x3);
+  TEST_ASSERT_FALSE(down->isUp);
+  TEST_ASSERT_EQUAL(2, down->consecutiveFails);
+  TEST_ASSERT_FALSE(neverChecked(*down));
+
+  TEST_ASSERT_TRUE(neverChecked(*table.find(0x4)));
+  TEST_ASSERT_TRUE(neverChecked(*table.find(0x5)));
+}
+
+void test_saves_are_spaced_out() {
+  loadTable(table, {0x10});
+  check(0x10, true);
+  saveNow();
+  Preferences::clearAll();
+
+  // Routine results wait for RUNTIME_STATE_SAVE_MS
+  fakeClock.advance(RUNTIME_STATE_MIN_GAP_MS);
+  check(0x10, true);
+  saveRuntimeStateIfDue(table, fakeClock.millis());
+  TEST_ASSERT_FALSE(saved());
+
+  // A status change waits only RUNTIME_STATE_MIN_GAP_MS after the last save
+  saveNow();
+  Preferences::clearAll();
+  fakeClock.advance(RUNTIME_STATE_MIN_GAP_MS / 2);
+  check(0x10, false);
+  check(0x10, false);
+  TEST_ASSERT_FALSE(table.find(0x10)->isUp);
+  saveRuntimeStateIfDue(table, fakeClock.millis());
+  TEST_ASSERT_FALSE(saved());
+  fakeClock.advance(RUNTIME_STATE_MIN_GAP_MS / 2);
+  saveRuntimeStateIfDue(table, fakeClock.millis());
+  TEST_ASSERT_TRUE(saved());
+
+  // Nothing new, nothing written
+  Preferences::clearAll();
+  saveNow();
+  TEST_ASSERT_FALSE(saved());
+}
+
+void test_open_outage_keeps_its_start() {
+  loadTable(table, {0x20, 0x21});
+  check(0x21, true);
+  check(0x21, true);
+
+  fakeClock.advance(60000);
+  uint32_t start = fakeClock.unixTime();
+  check(0x21, false, 5);
+  fakeClock.advance(60000);
+  check(0x21, false, 2);
+  TEST_ASSERT_FALSE(table.find(0x21)->isUp);
+  saveNow();
+
+  // Back in another slot after the reboot, and recovering there
+  loadTable(table, {0x21, 0x20});
+  fakeClock.advance(120000);
+  TEST_ASSERT_EQUAL(1, restoreRuntimeState(table));
+  check(0x20, true);  // takes over the slot 0x21 had
+  check(0x21, false, 1);
+  fakeClock.advance(60000);
+  check(0x21, true);
+
+  IncidentCursor cursor(0, UINT32_MAX, 0x21);
+  IncidentRecord record;
+  TEST_ASSERT_TRUE(cursor.next(record));
+  TEST_ASSERT_EQUAL_UINT32(start, record.start);
+  TEST_ASSERT_EQUAL_UINT32(fakeClock.unixTime(), record.end);
+  TEST_ASSERT_EQUAL_UINT32(3, record.failedProbes);
+  TEST_ASSERT_EQUAL(5, record.firstError);
+  TEST_ASSERT_FALSE(cursor.next(record));
+}
+
+void test_failure_run_below_the_threshold_is_not_an_incident() {
+  loadTable(table, {0x30});
+  check(0x30, true);
+  fakeClock.advance(60000);
+  uint32_t start = fakeClock.unixTime();
+  check(0x30, false, 4);
+  saveNow();
+
+  loadTable(table, {0x30});
+  TEST_ASSERT_EQUAL(1, restoreRuntimeState(table));
+  TEST_ASSERT_TRUE(table.find(0x30)->isUp);
+  TEST_ASSERT_EQUAL(1, table.find(0x30)->consecutiveFails);
+
+  // The run continues: one more failure makes it DOWN, still from the first
+  fakeClock.advance(60000);
+  check(0x30, false, 6);
+  fakeClock.advance(60000);
+  check(0x30, true);
+
+  IncidentCursor cursor(0, UINT32_MAX, 0x30);
+  IncidentRecord record;
+  TEST_ASSERT_TRUE(cursor.next(record));
+  TEST_ASSERT_EQUAL_UINT32(start, record.start);
+  TEST_ASSERT_EQUAL_UINT32(2, record.failedProbes);
+  TEST_ASSERT_EQUAL(4, record.firstError);
+}
+
+void test_foreign_blob_is_ignored() {
+  loadTable(table, {0x1});
+  const uint8_t stale[] = {0x52, 0x54, 0x53, 0x54, 1, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0};  // version 1
+  Preferences preferences;
+  preferences.begin("runtime", false);
+  preferences.putBytes("services", stale, sizeof(stale));
+  preferences.end();
+
+  TEST_ASSERT_EQUAL(0, restoreRuntimeState(table));
+  TEST_ASSERT_TRUE(neverChecked(table.at(0)));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_nothing_saved_restores_nothing);
+  RUN_TEST(test_status_and_counters_survive_a_reboot);
+  RUN_TEST(test_saves_are_spaced_out);
+  RUN_TEST(test_open_outage_keeps_its_start);
+  RUN_TEST(test_failure_run_below_the_threshold_is_not_an_incident);
+  RUN_TEST(test_foreign_blob_is_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,244 @@
+#include <unity.h>
+
+#include <LittleFS.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "series_store.hpp"
+
+// Round trips through the Gorilla-style encoder and the block segments. The store
+// has no reset, so the tests run in order and use their own ids and slots.
+
+namespace {
+
+const uint32_t START_TIME = 1750000000;
+
+FakeClock fakeClock;
+
+// Encodes the samples of one slot and remembers what went in.
+struct Recorder {
+  uint16_t slot;
+  uint64_t id;
+  std::vector<SeriesSample> samples;
+
+  void record(bool up, uint8_t error, uint32_t latencyMs) {
+    recordSeriesSample(slot, id, up, error, latencyMs);
+    samples.push_back({fakeClock.unixTime(), up, error, latencyMs});
+  }
+};
+
+std::vector<SeriesSample> decodeAll(uint64_t id) {
+  uint32_t oldest, newest;
+  seriesBlockRange(id, oldest, newest);
+
+  std::vector<SeriesSample> samples;
+  SeriesBlock block;
+  for (uint32_t sequence = oldest; sequence <= newest; sequence++) {
+    TEST_ASSERT_TRUE(readSeriesBlock(id, sequence, block));
+    SeriesDecoder decoder(block);
+    SeriesSample sample;
+    while (decoder.next(sample)) samples.push_back(sample);
+  }
+  return samples;
+}
+
+// Latency codes are exact below 32 ms and within 3.2% above
+void assertLatency(uint32_t expected, uint32_t decoded) {
+  double tolerance = expected < 32 ? 0 : expected * 0.032 + 0.5;
+  TEST_ASSERT_TRUE(fabs((double)decoded - expected) <= tolerance);
+}
+
+// `decoded` must match the newest samples of `recorded`
+void assertTail(const std::vector<SeriesSample>& recorded, const std::vector<SeriesSample>& decoded) {
+  TEST_ASSERT_TRUE(decoded.size() <= recorded.size());
+  size_t skipped = recorded.size() - decoded.size();
+  for (size_t i = 0; i < decoded.size(); i++) {
+    const SeriesSample& expected = recorded[skipped + i];
+    TEST_ASSERT_EQUAL_UINT32(expected.time, decoded[i].time);
+    TEST_ASSERT_EQUAL(expected.up, decoded[i].up);
+    TEST_ASSERT_EQUAL(expected.error, decoded[i].error);
+    assertLatency(expected.latencyMs, decoded[i].latencyMs);
+  }
+}
+
+Recorder ring = {0, 0xabc, {}};
+
+}  // namespace
+
+void setUp() {
+  setSystemClock(fakeClock);
+}
+
+void tearDown() {}
+
+void test_samples_wait_for_the_clock() {
+  useTempLittleFS();
+  TEST_ASSERT_TRUE(initSeriesStore());
+
+  recordSeriesSample(0, 0xabc, true, 0, 10);
+  TEST_ASSERT_EQUAL_UINT32(1, seriesStats().skippedNoClock);
+  TEST_ASSERT_EQUAL_UINT32(0, seriesStats().samples);
+
+  fakeClock.setUnixStart(START_TIME);
+}
+
+void test_ring_round_trip() {
+  srand(3);
+  bool up = true;
+  uint8_t error = 0;
+  int count = SERIES_BLOCKS_PER_SERVICE * 1000;  // rotates every segment
+
+  for (int i = 0; i < count; i++) {
+    fakeClock.advance(60000 + (rand() % 10 == 0 ? (rand() % 5 - 2) * 1000 : 0));
+    if (i == count / 3) fakeClock.advance(100000000);  // clock jumps ahead
+    if (i == count / 3 + 5) fakeClock.setUnixStart(START_TIME - 3000);  // and back
+    if (rand() % 200 == 0) {
+      up = !up;
+      error = up ? 0 : 1 + rand() % 7;
+    }
+    ring.record(up, error, 40 + rand() % 6 + (rand() % 50 == 0 ? 2000 : 0));
+  }
+
+  uint32_t oldest, newest;
+  seriesBlockRange(ring.id, oldest, newest);
+  // Every segment but the newest is full
+  TEST_ASSERT_TRUE(newest - oldest + 1 > (uint32_t)(SERIES_BLOCKS_PER_SERVICE - SERIES_SEGMENT_BLOCKS));
+  TEST_ASSERT_TRUE(newest - oldest + 1 <= (uint32_t)SERIES_BLOCKS_PER_SERVICE);
+  TEST_ASSERT_EQUAL_UINT32(0, (oldest - 1) % SERIES_SEGMENT_BLOCKS);
+
+  std::vector<SeriesSample> decoded = decodeAll(ring.id);
+  TEST_ASSERT_TRUE(decoded.size() > (size_t)(SERIES_BLOCKS_PER_SERVICE - SERIES_SEGMENT_BLOCKS) * 500);
+  assertTail(ring.samples, decoded);
+
+  uint32_t bits = 0;
+  SeriesBlock block;
+  for (uint32_t sequence = oldest; sequence <= newest; sequence++) {
+    readSeriesBlock(ring.id, sequence, block);
+    bits += block.header.bits;
+  }
+  TEST_ASSERT_TRUE(bits < decoded.size() * 10);  // steady checks cost about a byte
+}
+
+void test_latency_codes() {
+  Recorder latencies = {1, 0x1a7, {}};
+  for (uint32_t ms = 0; ms <= 65535; ms += ms < 300 ? 1 : ms / 50) {
+    fakeClock.advance(60000);
+    latencies.record(true, 0, ms);
+  }
+  assertTail(latencies.samples, decodeAll(latencies.id));
+}
+
+void test_block_from_skips_older_blocks() {
+  uint32_t oldest, newest;
+  seriesBlockRange(ring.id, oldest, newest);
+
+  SeriesBlock block;
+  for (uint32_t sequence = oldest + 1; sequence <= newest; sequence += 7) {
+    readSeriesBlock(ring.id, sequence, block);
+    uint32_t from = block.header.startTime;
+
+    // The block before can still hold samples at `from`, its predecessors not
+    TEST_ASSERT_EQUAL_UINT32(sequence - 1, seriesBlockFrom(ring.id, oldest, newest, from));
+  }
+  TEST_ASSERT_EQUAL_UINT32(oldest, seriesBlockFrom(ring.id, oldest, newest, 0));
+  TEST_ASSERT_EQUAL_UINT32(newest, seriesBlockFrom(ring.id, oldest, newest, UINT32_MAX));
+}
+
+void test_reboot_resumes_the_partial_block() {
+  Recorder resumed = {2, 0xb007, {}};
+  for (int i = 0; i < 100; i++) {
+    fakeClock.advance(30000);
+    resumed.record(i % 10 != 0, i % 10 != 0 ? 0 : 3, 20 + i);
+  }
+  fakeClock.advance(SERIES_FLUSH_MS);
+  flushSeriesStore(fakeClock.millis());
+
+  // Another service takes the slot, dropping the hot block; the first one
+  // then continues from flash as after a reboot
+  fakeClock.advance(30000);
+  recordSeriesSample(resumed.slot, 0xdead, true, 0, 5);
+  for (int i = 0; i < 100; i++) {
+    fakeClock.advance(30000);
+    resumed.record(true, 0, 70);
+  }
+
+  uint32_t oldest, newest;
+  seriesBlockRange(resumed.id, oldest, newest);
+  TEST_ASSERT_EQUAL_UINT32(1, newest);
+
+  std::vector<SeriesSample> decoded = decodeAll(resumed.id);
+  TEST_ASSERT_EQUAL(200, (int)decoded.size());
+  assertTail(resumed.samples, decoded);
+}
+
+void test_reboot_after_the_checkpoint_was_appended() {
+  Recorder resumed = {3, 0xc0de, {}};
+  fakeClock.advance(30000);
+  resumed.record(true, 0, 10);
+  fakeClock.advance(SERIES_FLUSH_MS);
+  flushSeriesStore(fakeClock.millis());
+
+  // The checkpointed block fills up and is appended; the checkpoint is now
+  // older than the segment
+  uint32_t oldest, newest;
+  do {
+    fakeClock.advance(30000);
+    resumed.record(rand() % 2, 0, rand() % 5000);
+    seriesBlockRange(resumed.id, oldest, newest);
+  } while (newest == 1);
+  resumed.samples.pop_back();  // started block 2, which the next line drops unwritten
+
+  fakeClock.advance(30000);
+  recordSeriesSample(resumed.slot, 0xdead, true, 0, 5);
+  fakeClock.advance(30000);
+  resumed.record(true, 0, 70);
+
+  seriesBlockRange(resumed.id, oldest, newest);
+  TEST_ASSERT_EQUAL_UINT32(1, oldest);
+  TEST_ASSERT_EQUAL_UINT32(2, newest);
+  std::vector<SeriesSample> decoded = decodeAll(resumed.id);
+  TEST_ASSERT_EQUAL(resumed.samples.size(), decoded.size());
+  assertTail(resumed.samples, decoded);
+}
+
+void test_prune_removes_deleted_services() {
+  File junk = LittleFS.open("/series/junk", "w");
+  junk.write(1);
+  junk.close();
+  File legacy = LittleFS.open("/series/abc", "w");  // an earlier build's ring file
+  legacy.write(1);
+  legacy.close();
+
+  ServiceTable table;
+  table.add(fakeService(ring.id));
+  pruneSeriesStore(table);
+
+  uint32_t oldest, newest;
+  seriesBlockRange(ring.id, oldest, newest);
+  TEST_ASSERT_TRUE(newest >= oldest);
+  TEST_ASSERT_TRUE(LittleFS.exists("/series/abc.0"));
+  TEST_ASSERT_FALSE(LittleFS.exists("/series/b007.hot"));
+  TEST_ASSERT_FALSE(LittleFS.exists("/series/junk"));
+  TEST_ASSERT_FALSE(LittleFS.exists("/series/abc"));
+
+  seriesBlockRange(0xb007, oldest, newest);
+  TEST_ASSERT_TRUE(oldest > newest);
+  SeriesBlock block;
+  TEST_ASSERT_FALSE(readSeriesBlock(0x1a7, 1, block));  // never flushed, now dropped
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_samples_wait_for_the_clock);
+  RUN_TEST(test_ring_round_trip);
+  RUN_TEST(test_latency_codes);
+  RUN_TEST(test_block_from_skips_older_blocks);
+  RUN_TEST(test_reboot_resumes_the_partial_block);
+  RUN_TEST(test_reboot_after_the_checkpoint_was_appended);
+  RUN_TEST(test_prune_removes_deleted_services);
+  return UNITY_END();
+}
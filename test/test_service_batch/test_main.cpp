@@ -0,0 +1,192 @@
+#include <unity.h>
+
+#include "fakes.hpp"
+#include "service_batch.hpp"
+
+namespace {
+
+ServiceTable table;
+std::vector<ServiceOperation> operations;
+String error;
+
+// Parses {"operations": ...} against the table. Ids 0xa, 0xb and 0xc exist.
+bool parse(const char* operationsJson) {
+  JsonDocument doc;
+  String body = String("{\"operations\": ") + operationsJson + "}";
+  if (deserializeJson(doc, body.c_str())) return false;
+  error = "";
+  return parseServiceBatch(doc["operations"].as<JsonArrayConst>(), table, operations, error);
+}
+
+ServiceOperation operation(ServiceOperationType type, uint64_t id) {
+  ServiceOperation result;
+  result.type = type;
+  result.id = id;
+  result.config = fakeService(id);
+  return result;
+}
+
+}  // namespace
+
+void setUp() {
+  table.clear();
+  for (uint64_t id = 0xa; id <= 0xc; id++) {
+    Service* service = table.add(fakeService(id));
+    service->isUp = true;
+    service->consecutivePasses = 4;
+  }
+  seedServiceIds(table);
+  operations.clear();
+}
+
+void tearDown() {}
+
+void test_valid_batch_is_parsed() {
+  TEST_ASSERT_TRUE(parse(R"([
+    {"op": "add", "name": "NAS", "type": "ping", "host": "192.168.1.20"},
+    {"op": "update", "id": "a", "checkInterval": 120},
+    {"op": "delete", "id": "B"}
+  ])"));
+  TEST_ASSERT_EQUAL(3, (int)operations.size());
+  TEST_ASSERT_EQUAL(OP_ADD, operations[0].type);
+  TEST_ASSERT_TRUE(operations[0].id > 0xc);
+  TEST_ASSERT_TRUE(operations[0].config.id == operations[0].id);
+  TEST_ASSERT_EQUAL(OP_UPDATE, operations[1].type);
+  TEST_ASSERT_EQUAL(120, operations[1].config.checkInterval);
+  TEST_ASSERT_EQUAL_STRING("example.lan", operations[1].config.host.c_str());  // merged onto the current config
+  TEST_ASSERT_EQUAL(OP_DELETE, operations[2].type);
+  TEST_ASSERT_EQUAL(0xb, operations[2].id);
+}
+
+void test_malformed_operations_name_the_first_bad_one() {
+  TEST_ASSERT_FALSE(parse("{}"));
+  TEST_ASSERT_EQUAL_STRING("Missing operations array", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "delete", "id": "a"}, {"op": "rename", "id": "b"}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 1: op must be add, update or delete", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "update", "id": "zz"}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: missing or invalid id", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "update", "id": "ff"}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: service not found", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "update", "id": "a", "port": 0}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: port must be between 1 and 65535", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "update", "id": "a", "type": "gopher"}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: invalid service type", error.c_str());
+
+  TEST_ASSERT_FALSE(parse(R"([{"op": "add", "name": "x", "type": "ping"}])"));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: name, host and a valid type are required", error.c_str());
+}
+
+void test_too_many_operations_are_rejected() {
+  String json = "[";
+  for (int i = 0; i <= MAX_BATCH_OPERATIONS; i++) {
+    json += i == 0 ? "" : ",";
+    json += R"({"op": "delete", "id": "a"})";
+  }
+  json += "]";
+  TEST_ASSERT_FALSE(parse(json.c_str()));
+  TEST_ASSERT_EQUAL_STRING("Too many operations", error.c_str());
+}
+
+void test_one_change_per_service() {
+  const char* conflicts[] = {
+    R"([{"op": "update", "id": "a", "name": "x"}, {"op": "delete", "id": "a"}])",
+    R"([{"op": "delete", "id": "a"}, {"op": "update", "id": "a", "name": "x"}])",
+    R"([{"op": "delete", "id": "a"}, {"op": "delete", "id": "a"}])",
+    R"([{"op": "update", "id": "a", "name": "x"}, {"op": "update", "id": "a", "port": 81}])",
+  };
+  for (const char* json : conflicts) {
+    TEST_ASSERT_FALSE(parse(json));
+    TEST_ASSERT_EQUAL_STRING("Operation 1: service already changed by operation 0", error.c_str());
+  }
+
+  TEST_ASSERT_TRUE(parse(R"([{"op": "update", "id": "a", "name": "x"}, {"op": "delete", "id": "b"}])"));
+}
+
+void test_result_must_fit_the_table() {
+  while (table.count < MAX_SERVICES) {
+    table.add(fakeService(0x100 + table.count));
+  }
+  const char* add = R"({"op": "add", "name": "NAS", "type": "ping", "host": "nas"})";
+
+  TEST_ASSERT_FALSE(parse((String("[") + add + "]").c_str()));
+  TEST_ASSERT_EQUAL_STRING("Maximum services reached", error.c_str());
+
+  // Deletes in the same batch make room, whatever their position
+  TEST_ASSERT_TRUE(parse((String("[") + add + R"(, {"op": "delete", "id": "c"}])").c_str()));
+}
+
+void test_apply_keeps_state_unless_the_probe_changes() {
+  TEST_ASSERT_TRUE(parse(R"([
+    {"op": "update", "id": "a", "name": "Renamed", "failThreshold": 3},
+    {"op": "update", "id": "b", "host": "other.lan"}
+  ])"));
+  TEST_ASSERT_TRUE(applyServiceBatch(table, operations, error));
+
+  const Service* renamed = table.find(0xa);
+  TEST_ASSERT_EQUAL_STRING("Renamed", renamed->name.c_str());
+  TEST_ASSERT_EQUAL(3, renamed->failThreshold);
+  TEST_ASSERT_TRUE(renamed->isUp);
+  TEST_ASSERT_EQUAL(4, renamed->consecutivePasses);
+
+  const Service* moved = table.find(0xb);
+  TEST_ASSERT_EQUAL_STRING("other.lan", moved->host.c_str());
+  TEST_ASSERT_FALSE(moved->isUp);
+  TEST_ASSERT_EQUAL(0, moved->consecutivePasses);
+}
+
+void test_apply_reuses_deleted_slots() {
+  int slot = table.index.find(0xb);
+  TEST_ASSERT_TRUE(parse(R"([
+    {"op": "add", "name": "NAS", "type": "ping", "host": "nas"},
+    {"op": "delete", "id": "b"}
+  ])"));
+  TEST_ASSERT_TRUE(applyServiceBatch(table, operations, error));
+
+  TEST_ASSERT_EQUAL(3, table.count);
+  TEST_ASSERT_NULL(table.find(0xb));
+  TEST_ASSERT_EQUAL(slot, table.index.find(operations[0].id));
+  TEST_ASSERT_EQUAL_STRING("NAS", table.at(2).name.c_str());
+}
+
+void test_apply_is_all_or_nothing() {
+  // Valid against the snapshot, but the live table lost 0xc meanwhile
+  TEST_ASSERT_TRUE(parse(R"([{"op": "delete", "id": "a"}, {"op": "update", "id": "c", "name": "x"}])"));
+  table.remove(0xc);
+
+  TEST_ASSERT_FALSE(applyServiceBatch(table, operations, error));
+  TEST_ASSERT_EQUAL_STRING("Operation 1: service not found", error.c_str());
+  TEST_ASSERT_NOT_NULL(table.find(0xa));
+  TEST_ASSERT_EQUAL(2, table.count);
+}
+
+void test_apply_rejects_conflicts_built_by_hand() {
+  // The queued command skips parsing; validation still guards apply
+  operations.push_back(operation(OP_DELETE, 0xa));
+  operations.push_back(operation(OP_UPDATE, 0xa));
+  TEST_ASSERT_FALSE(applyServiceBatch(table, operations, error));
+  TEST_ASSERT_EQUAL(3, table.count);
+
+  operations.clear();
+  operations.push_back(operation(OP_ADD, 0xb));
+  TEST_ASSERT_FALSE(applyServiceBatch(table, operations, error));
+  TEST_ASSERT_EQUAL_STRING("Operation 0: duplicate id", error.c_str());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_batch_is_parsed);
+  RUN_TEST(test_malformed_operations_name_the_first_bad_one);
+  RUN_TEST(test_too_many_operations_are_rejected);
+  RUN_TEST(test_one_change_per_service);
+  RUN_TEST(test_result_must_fit_the_table);
+  RUN_TEST(test_apply_keeps_state_unless_the_probe_changes);
+  RUN_TEST(test_apply_reuses_deleted_slots);
+  RUN_TEST(test_apply_is_all_or_nothing);
+  RUN_TEST(test_apply_rejects_conflicts_built_by_hand);
+  return UNITY_END();
+}
@@ -0,0 +1,179 @@
+#include <unity.h>
+
+#include <LittleFS.h>
+
+#include <vector>
+
+#include "fakes.hpp"
+#include "service_codec.hpp"
+
+namespace {
+
+const char* PATH = "/services.bin";
+
+ServiceTable table;
+Service loaded[MAX_SERVICES + 1];
+
+void fillTable(int count) {
+  table.clear();
+  for (int i = 0; i < count; i++) {
+    Service service = fakeService(0x1000 + i, (ServiceType)(i % 4));
+    service.name = "Service " + String(i);
+    service.host = "host-" + String(i) + ".lan";
+    service.port = 1 + i * 997 % 65535;
+    service.path = i % 3 == 0 ? String("") : "/health?probe=" + String(i);
+    service.expectedResponse = i % 2 == 0 ? String("*") : String("\"status\":\"ok\"");
+    service.checkInterval = 10 + i;
+    service.passThreshold = 1 + i % 3;
+    service.failThreshold = 1 + i % 5;
+    table.add(service);
+  }
+}
+
+bool save() {
+  File file = LittleFS.open(PATH, "w");
+  bool ok = writeServicesBinary(file, table);
+  file.close();
+  return ok;
+}
+
+int load(int maxCount = MAX_SERVICES) {
+  File file = LittleFS.open(PATH, "r");
+  int count = readServicesBinary(file, loaded, maxCount);
+  file.close();
+  return count;
+}
+
+std::vector<uint8_t> readAll() {
+  File file = LittleFS.open(PATH, "r");
+  std::vector<uint8_t> bytes(file.size());
+  file.read(bytes.data(), bytes.size());
+  file.close();
+  return bytes;
+}
+
+void writeAll(const std::vector<uint8_t>& bytes) {
+  File file = LittleFS.open(PATH, "w");
+  file.write(bytes.data(), bytes.size());
+  file.close();
+}
+
+}  // namespace
+
+void setUp() {
+  useTempLittleFS();
+}
+
+void tearDown() {}
+
+void test_round_trip_keeps_every_field() {
+  fillTable(MAX_SERVICES);
+  table.remove(0x1003);  // configuration order, not slot order, is saved
+  table.add(fakeService(0x2000));
+  TEST_ASSERT_TRUE(save());
+
+  TEST_ASSERT_EQUAL(table.count, load());
+  for (int i = 0; i < table.count; i++) {
+    const Service& expected = table.at(i);
+    const Service& actual = loaded[i];
+    TEST_ASSERT_TRUE(expected.id == actual.id);
+    TEST_ASSERT_EQUAL_STRING(expected.name.c_str(), actual.name.c_str());
+    TEST_ASSERT_EQUAL(expected.type, actual.type);
+    TEST_ASSERT_EQUAL_STRING(expected.host.c_str(), actual.host.c_str());
+    TEST_ASSERT_EQUAL(expected.port, actual.port);
+    TEST_ASSERT_EQUAL_STRING(expected.path.c_str(), actual.path.c_str());
+    TEST_ASSERT_EQUAL_STRING(expected.expectedResponse.c_str(), actual.expectedResponse.c_str());
+    TEST_ASSERT_EQUAL(expected.checkInterval, actual.checkInterval);
+    TEST_ASSERT_EQUAL(expected.passThreshold, actual.passThreshold);
+    TEST_ASSERT_EQUAL(expected.failThreshold, actual.failThreshold);
+  }
+}
+
+void test_loading_resets_runtime_state() {
+  fillTable(1);
+  table.at(0).isUp = true;
+  table.at(0).consecutivePasses = 7;
+  table.at(0).lastError = "old";
+  save();
+
+  loaded[0].isUp = true;
+  loaded[0].consecutivePasses = 3;
+  loaded[0].lastCheck = 1000;
+  TEST_ASSERT_EQUAL(1, load());
+  TEST_ASSERT_FALSE(loaded[0].isUp);
+  TEST_ASSERT_EQUAL(0, loaded[0].consecutivePasses);
+  TEST_ASSERT_EQUAL(0, loaded[0].lastCheck);
+  TEST_ASSERT_EQUAL_STRING("", loaded[0].lastError.c_str());
+}
+
+void test_empty_table_round_trips() {
+  table.clear();
+  TEST_ASSERT_TRUE(save());
+  TEST_ASSERT_EQUAL(0, load());
+}
+
+void test_any_flipped_byte_is_rejected() {
+  fillTable(3);
+  save();
+  std::vector<uint8_t> good = readAll();
+
+  for (size_t i = 0; i < good.size(); i++) {
+    if (i == 5) continue;  // reserved header byte
+    std::vector<uint8_t> bad = good;
+    bad[i] ^= 0x20;
+    writeAll(bad);
+    TEST_ASSERT_EQUAL(-1, load());
+  }
+}
+
+void test_truncated_and_foreign_files_are_rejected() {
+  fillTable(3);
+  save();
+  std::vector<uint8_t> good = readAll();
+
+  for (size_t length = 0; length < good.size(); length += 7) {
+    writeAll(std::vector<uint8_t>(good.begin(), good.begin() + length));
+    TEST_ASSERT_EQUAL(-1, load());
+  }
+
+  std::vector<uint8_t> future = good;
+  future[4] = SERVICE_CODEC_VERSION + 1;
+  writeAll(future);
+  TEST_ASSERT_EQUAL(-1, load());
+
+  std::vector<uint8_t> moreRecords = good;
+  moreRecords[6] = 4;
+  writeAll(moreRecords);
+  TEST_ASSERT_EQUAL(-1, load());
+}
+
+void test_records_past_capacity_are_checked_but_dropped() {
+  fillTable(5);
+  save();
+  TEST_ASSERT_EQUAL(3, load(3));
+  TEST_ASSERT_TRUE(loaded[2].id == table.at(2).id);
+
+  std::vector<uint8_t> bad = readAll();
+  bad[bad.size() - 10] ^= 1;  // inside the last, dropped record
+  writeAll(bad);
+  TEST_ASSERT_EQUAL(-1, load(3));
+}
+
+void test_unknown_service_type_is_rejected() {
+  fillTable(1);
+  table.at(0).type = (ServiceType)9;
+  save();
+  TEST_ASSERT_EQUAL(-1, load());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_keeps_every_field);
+  RUN_TEST(test_loading_resets_runtime_state);
+  RUN_TEST(test_empty_table_round_trips);
+  RUN_TEST(test_any_flipped_byte_is_rejected);
+  RUN_TEST(test_truncated_and_foreign_files_are_rejected);
+  RUN_TEST(test_records_past_capacity_are_checked_but_dropped);
+  RUN_TEST(test_unknown_service_type_is_rejected);
+  return UNITY_END();
+}
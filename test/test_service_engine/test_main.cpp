@@ -0,0 +1,168 @@
+#include <unity.h>
+
+#include "fakes.hpp"
+#include "service_engine.hpp"
+
+// The native environment builds with CHECK_RELAX_MAX_INTERVAL_S set, so the
+// relaxed intervals are covered as well.
+static_assert(CHECK_RELAX_MAX_INTERVAL_S > 0, "tests expect interval relaxing to be enabled");
+
+namespace {
+
+Service stableUp(int passes) {
+  Service service = fakeService(1);
+  service.isUp = true;
+  service.consecutivePasses = passes;
+  return service;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_stable_service_uses_its_interval() {
+  Service service = stableUp(1);
+  TEST_ASSERT_EQUAL(60000, checkIntervalMs(service));
+
+  service.isUp = false;
+  service.consecutivePasses = 0;
+  service.consecutiveFails = 4;
+  TEST_ASSERT_EQUAL(60000, checkIntervalMs(service));
+}
+
+void test_unconfirmed_change_is_rechecked_sooner() {
+  Service failing = stableUp(0);
+  failing.consecutiveFails = 1;
+  failing.failThreshold = 3;
+  TEST_ASSERT_EQUAL(60000UL * CHECK_RECHECK_PERCENT / 100, checkIntervalMs(failing));
+
+  Service recovering = fakeService(2);
+  recovering.consecutivePasses = 1;
+  recovering.passThreshold = 3;
+  TEST_ASSERT_EQUAL(60000UL * CHECK_RECHECK_PERCENT / 100, checkIntervalMs(recovering));
+}
+
+void test_recheck_has_a_floor_and_never_lengthens() {
+  Service service = stableUp(0);
+  service.consecutiveFails = 1;
+  service.checkInterval = 4;  // 25% would be 1 s
+  TEST_ASSERT_EQUAL(CHECK_RECHECK_MIN_MS, checkIntervalMs(service));
+
+  service.checkInterval = 1;  // shorter than the floor itself
+  TEST_ASSERT_EQUAL(1000, checkIntervalMs(service));
+}
+
+void test_stable_up_relaxes_by_doubling_up_to_the_cap() {
+  unsigned long cap = CHECK_RELAX_MAX_INTERVAL_S * 1000UL;
+  TEST_ASSERT_EQUAL(60000, checkIntervalMs(stableUp(CHECK_RELAX_AFTER_PASSES - 1)));
+  TEST_ASSERT_EQUAL(120000 < cap ? 120000 : cap, checkIntervalMs(stableUp(CHECK_RELAX_AFTER_PASSES)));
+  TEST_ASSERT_EQUAL(240000 < cap ? 240000 : cap, checkIntervalMs(stableUp(2 * CHECK_RELAX_AFTER_PASSES)));
+  TEST_ASSERT_EQUAL(cap, checkIntervalMs(stableUp(1000 * CHECK_RELAX_AFTER_PASSES)));
+
+  // Already at or above the cap: left alone
+  Service slow = stableUp(100 * CHECK_RELAX_AFTER_PASSES);
+  slow.checkInterval = CHECK_RELAX_MAX_INTERVAL_S * 2;
+  TEST_ASSERT_EQUAL(slow.checkInterval * 1000UL, checkIntervalMs(slow));
+}
+
+void test_failure_returns_to_the_configured_interval() {
+  Service service = stableUp(5 * CHECK_RELAX_AFTER_PASSES);
+  TEST_ASSERT_TRUE(checkIntervalMs(service) > 60000);
+
+  service.failThreshold = 3;
+  applyCheckResult(service, false, 0);
+  TEST_ASSERT_EQUAL(60000UL * CHECK_RECHECK_PERCENT / 100, checkIntervalMs(service));
+}
+
+void test_due_time_follows_the_interval() {
+  Service service = stableUp(1);
+  service.lastCheck = 1000;
+  TEST_ASSERT_EQUAL(60000, msUntilCheckDue(service, 1000));
+  TEST_ASSERT_EQUAL(1, msUntilCheckDue(service, 60999));
+  TEST_ASSERT_EQUAL(0, msUntilCheckDue(service, 61000));
+  TEST_ASSERT_EQUAL(0, msUntilCheckDue(service, 500000));
+
+  // millis() wrapping between checks
+  service.lastCheck = (unsigned long)-1000;
+  TEST_ASSERT_EQUAL(1000, msUntilCheckDue(service, 58000));
+}
+
+void test_next_check_is_the_soonest_due() {
+  ServiceTable table;
+  Service first = stableUp(1);
+  first.lastCheck = 0;
+  Service second = stableUp(1);
+  second.id = 2;
+  second.lastCheck = 30000;
+  table.add(first);
+  table.add(second);
+
+  TEST_ASSERT_EQUAL(20000, msUntilNextCheck(table, 40000, 120000));
+  TEST_ASSERT_EQUAL(5000, msUntilNextCheck(table, 40000, 5000));
+  TEST_ASSERT_EQUAL(0, msUntilNextCheck(table, 60000, 120000));
+}
+
+void test_first_checks_are_spread_over_the_interval() {
+  ServiceTable table;
+  for (uint64_t id = 1; id <= 4; id++) {
+    table.add(fakeService(id));
+  }
+  spreadFirstChecks(table, 100000);
+
+  for (int i = 0; i < table.count; i++) {
+    TEST_ASSERT_EQUAL(15000UL * i, msUntilCheckDue(table.at(i), 100000));
+  }
+}
+
+void test_only_due_checks_are_respread() {
+  ServiceTable table;
+  for (uint64_t id = 1; id <= 4; id++) {
+    Service service = stableUp(1);
+    service.id = id;
+    service.lastCheck = id == 4 ? 90000 : 0;  // the last one is not due
+    table.add(service);
+  }
+  spreadDueChecks(table, 100000);
+
+  TEST_ASSERT_EQUAL(0, msUntilCheckDue(table.at(0), 100000));
+  TEST_ASSERT_EQUAL(20000, msUntilCheckDue(table.at(1), 100000));
+  TEST_ASSERT_EQUAL(40000, msUntilCheckDue(table.at(2), 100000));
+  TEST_ASSERT_EQUAL(50000, msUntilCheckDue(table.at(3), 100000));
+}
+
+void test_thresholds_gate_transitions() {
+  Service service = fakeService(1);
+  service.passThreshold = 2;
+  service.failThreshold = 3;
+
+  TEST_ASSERT_FALSE(applyCheckResult(service, true, 1000));
+  TEST_ASSERT_TRUE(applyCheckResult(service, true, 2000));
+  TEST_ASSERT_TRUE(service.isUp);
+  TEST_ASSERT_EQUAL(2000, service.lastUptime);
+
+  TEST_ASSERT_FALSE(applyCheckResult(service, false, 3000));
+  TEST_ASSERT_FALSE(applyCheckResult(service, false, 4000));
+  TEST_ASSERT_FALSE(applyCheckResult(service, true, 5000));  // a pass resets the run
+  TEST_ASSERT_FALSE(applyCheckResult(service, false, 6000));
+  TEST_ASSERT_FALSE(applyCheckResult(service, false, 7000));
+  TEST_ASSERT_TRUE(applyCheckResult(service, false, 8000));
+  TEST_ASSERT_FALSE(service.isUp);
+  TEST_ASSERT_EQUAL(3, service.consecutiveFails);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_stable_service_uses_its_interval);
+  RUN_TEST(test_unconfirmed_change_is_rechecked_sooner);
+  RUN_TEST(test_recheck_has_a_floor_and_never_lengthens);
+  RUN_TEST(test_stable_up_relaxes_by_doubling_up_to_the_cap);
+  RUN_TEST(test_failure_returns_to_the_configured_interval);
+  RUN_TEST(test_due_time_follows_the_interval);
+  RUN_TEST(test_next_check_is_the_soonest_due);
+  RUN_TEST(test_first_checks_are_spread_over_the_interval);
+  RUN_TEST(test_only_due_checks_are_respread);
+  RUN_TEST(test_thresholds_gate_transitions);
+  return UNITY_END();
+}
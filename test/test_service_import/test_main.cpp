@@ -0,0 +1,171 @@
+#include <unity.h>
+
+#include <string>
+
+#include "fakes.hpp"
+#include "service_import.hpp"
+#include "service_table.hpp"
+
+namespace {
+
+const char* BACKUP = R"({
+  "version": 1,
+  "meta": {"services": [{"name": "nested, ignored", "type": "ping", "host": "x"}]},
+  "services": [
+    {"id": "1f", "name": "Home \"Assistant\" {main}", "type": "home_assistant", "host": "ha.lan",
+     "port": 8123, "checkInterval": 30, "passThreshold": 2, "failThreshold": 3},
+    {"name": "NAS", "type": "ping", "host": "192.168.1.20", "checkInterval": 5, "port": 0},
+    {"name": "no host", "type": "http_get"},
+    {"name": "bad type", "type": "gopher", "host": "g.lan"},
+    {"name": "Jellyfin", "type": "jellyfin", "host": "media.lan", "path": "/health",
+     "expectedResponse": "Healthy", "passThreshold": 0},
+    "not an object", 42, [1, 2]
+  ],
+  "trailer": "]}"
+})";
+
+// Feeds `json` in chunks of `chunk` bytes and finishes the parse
+bool parse(ServiceImportParser& parser, const std::string& json, size_t chunk) {
+  for (size_t offset = 0; offset < json.size(); offset += chunk) {
+    size_t length = json.size() - offset < chunk ? json.size() - offset : chunk;
+    parser.feed(reinterpret_cast<const uint8_t*>(json.data() + offset), length);
+  }
+  return parser.finish();
+}
+
+}  // namespace
+
+void setUp() {
+  ServiceTable empty;
+  seedServiceIds(empty);
+}
+
+void tearDown() {}
+
+void test_valid_services_are_imported_with_defaults() {
+  ServiceImportParser parser(MAX_SERVICES);
+  TEST_ASSERT_TRUE(parse(parser, BACKUP, 4096));
+  TEST_ASSERT_EQUAL(3, parser.importedCount());
+  TEST_ASSERT_EQUAL(2, parser.skippedCount());
+
+  const Service& ha = parser.services()[0];
+  TEST_ASSERT_EQUAL_STRING("Home \"Assistant\" {main}", ha.name.c_str());
+  TEST_ASSERT_EQUAL(TYPE_HOME_ASSISTANT, ha.type);
+  TEST_ASSERT_EQUAL(8123, ha.port);
+  TEST_ASSERT_EQUAL(30, ha.checkInterval);
+  TEST_ASSERT_EQUAL(2, ha.passThreshold);
+  TEST_ASSERT_EQUAL(3, ha.failThreshold);
+  TEST_ASSERT_TRUE(ha.id != 0x1f);  // exported ids are not reused
+
+  const Service& nas = parser.services()[1];
+  TEST_ASSERT_EQUAL(80, nas.port);
+  TEST_ASSERT_EQUAL(10, nas.checkInterval);
+  TEST_ASSERT_EQUAL_STRING("/", nas.path.c_str());
+  TEST_ASSERT_EQUAL_STRING("*", nas.expectedResponse.c_str());
+
+  const Service& jellyfin = parser.services()[2];
+  TEST_ASSERT_EQUAL_STRING("/health", jellyfin.path.c_str());
+  TEST_ASSERT_EQUAL_STRING("Healthy", jellyfin.expectedResponse.c_str());
+  TEST_ASSERT_EQUAL(1, jellyfin.passThreshold);
+  TEST_ASSERT_FALSE(jellyfin.isUp);
+  TEST_ASSERT_EQUAL(0, jellyfin.consecutivePasses);
+  TEST_ASSERT_EQUAL(-1, jellyfin.secondsSinceLastCheck);
+  TEST_ASSERT_TRUE(ha.id != nas.id && nas.id != jellyfin.id);
+}
+
+void test_chunk_boundaries_do_not_matter() {
+  ServiceImportParser whole(MAX_SERVICES);
+  parse(whole, BACKUP, 4096);
+
+  for (size_t chunk = 1; chunk <= 64; chunk++) {
+    ServiceImportParser parser(MAX_SERVICES);
+    TEST_ASSERT_TRUE(parse(parser, BACKUP, chunk));
+    TEST_ASSERT_EQUAL(whole.importedCount(), parser.importedCount());
+    TEST_ASSERT_EQUAL(whole.skippedCount(), parser.skippedCount());
+    for (int i = 0; i < parser.importedCount(); i++) {
+      TEST_ASSERT_EQUAL_STRING(whole.services()[i].name.c_str(), parser.services()[i].name.c_str());
+      TEST_ASSERT_EQUAL_STRING(whole.services()[i].host.c_str(), parser.services()[i].host.c_str());
+    }
+  }
+}
+
+void test_services_beyond_the_free_slots_are_skipped() {
+  ServiceImportParser parser(2);
+  TEST_ASSERT_TRUE(parse(parser, BACKUP, 100));
+  TEST_ASSERT_EQUAL(2, parser.importedCount());
+  TEST_ASSERT_EQUAL(3, parser.skippedCount());
+  TEST_ASSERT_EQUAL_STRING("NAS", parser.services()[1].name.c_str());
+}
+
+void test_oversized_object_is_skipped_without_buffering_it() {
+  std::string json = R"({"services": [{"name": ")";
+  json += std::string(ServiceImportParser::MAX_OBJECT_SIZE, 'x');
+  json += R"(", "type": "ping", "host": "a"}, {"name": "small", "type": "ping", "host": "b"}]})";
+
+  ServiceImportParser parser(MAX_SERVICES);
+  TEST_ASSERT_TRUE(parse(parser, json, 512));
+  TEST_ASSERT_EQUAL(1, parser.importedCount());
+  TEST_ASSERT_EQUAL(1, parser.skippedCount());
+  TEST_ASSERT_EQUAL_STRING("small", parser.services()[0].name.c_str());
+}
+
+void test_large_backup_is_streamed() {
+  std::string json = R"({"services": [)";
+  for (int i = 0; i < 5000; i++) {
+    if (i > 0) json += ",";
+    json += R"({"name": "s)" + std::to_string(i) + R"(", "type": "ping", "host": "10.0.0.1"})";
+  }
+  json += "]}";
+
+  ServiceImportParser parser(MAX_SERVICES);
+  TEST_ASSERT_TRUE(parse(parser, json, 1460));
+  TEST_ASSERT_EQUAL(MAX_SERVICES, parser.importedCount());
+  TEST_ASSERT_EQUAL(5000 - MAX_SERVICES, parser.skippedCount());
+}
+
+void test_bodies_without_a_services_array_fail() {
+  const char* missing[] = {"{}", R"({"service": []})", R"({"meta": {"services": []}})"};
+  for (const char* json : missing) {
+    ServiceImportParser parser(MAX_SERVICES);
+    TEST_ASSERT_FALSE(parse(parser, json, 3));
+    TEST_ASSERT_EQUAL_STRING("Missing services array", parser.error());
+  }
+
+  const char* invalid[] = {"[]", R"({"services": [)", R"({"services": []}})", R"({"services": "]})"};
+  for (const char* json : invalid) {
+    ServiceImportParser parser(MAX_SERVICES);
+    TEST_ASSERT_FALSE(parse(parser, json, 3));
+    TEST_ASSERT_EQUAL_STRING("Invalid JSON", parser.error());
+    TEST_ASSERT_TRUE(parser.failed());
+  }
+}
+
+void test_service_from_json_applies_the_form_limits() {
+  JsonDocument doc;
+  deserializeJson(doc, R"({"name": "API", "type": "http_get", "host": "api.lan", "port": 70000,
+    "checkInterval": 1, "failThreshold": -2, "path": "/status", "expectedResponse": "ok"})");
+  Service service;
+  TEST_ASSERT_TRUE(serviceFromImportJson(doc.as<JsonObjectConst>(), service));
+  TEST_ASSERT_EQUAL(80, service.port);
+  TEST_ASSERT_EQUAL(10, service.checkInterval);
+  TEST_ASSERT_EQUAL(1, service.failThreshold);
+  TEST_ASSERT_EQUAL_STRING("/status", service.path.c_str());
+  TEST_ASSERT_EQUAL_STRING("ok", service.expectedResponse.c_str());
+
+  deserializeJson(doc, R"({"name": "", "type": "ping", "host": "a"})");
+  TEST_ASSERT_FALSE(serviceFromImportJson(doc.as<JsonObjectConst>(), service));
+  deserializeJson(doc, R"({"name": "x", "host": "a"})");
+  TEST_ASSERT_FALSE(serviceFromImportJson(doc.as<JsonObjectConst>(), service));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_services_are_imported_with_defaults);
+  RUN_TEST(test_chunk_boundaries_do_not_matter);
+  RUN_TEST(test_services_beyond_the_free_slots_are_skipped);
+  RUN_TEST(test_oversized_object_is_skipped_without_buffering_it);
+  RUN_TEST(test_large_backup_is_streamed);
+  RUN_TEST(test_bodies_without_a_services_array_fail);
+  RUN_TEST(test_service_from_json_applies_the_form_limits);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#include <unity.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "service_rollup.hpp"
+
+namespace {
+
+const uint32_t START_TIME = 1750000000;
+
+const uint32_t WINDOW_SECONDS[WINDOW_COUNT] = {3600, 24 * 3600, 7 * 24 * 3600, 30 * 24 * 3600};
+const uint32_t BUCKET_SECONDS[WINDOW_COUNT] = {60, 3600, 3600, 24 * 3600};
+
+struct Check {
+  uint32_t bucket[WINDOW_COUNT];
+  bool up;
+  uint32_t latencyMs;
+};
+
+// Every check kept, and the windows summed from scratch. A check made after
+// the clock stepped back counts in the bucket the rollup was already in.
+struct Reference {
+  std::vector<Check> checks;
+  uint32_t current[WINDOW_COUNT] = {};
+
+  void record(bool up, uint32_t latencyMs, uint32_t unixTime) {
+    Check check = {{}, up, latencyMs};
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+      current[w] = std::max(current[w], unixTime / BUCKET_SECONDS[w]);
+      check.bucket[w] = current[w];
+    }
+    checks.push_back(check);
+  }
+
+  void assertMatches(const ServiceRollup& rollup) {
+    for (int w = 0; w < WINDOW_COUNT; w++) {
+      uint32_t buckets = WINDOW_SECONDS[w] / BUCKET_SECONDS[w];
+      uint32_t up = 0;
+      uint32_t down = 0;
+      uint64_t latencySum = 0;
+      for (const Check& check : checks) {
+        if (check.bucket[w] + buckets <= current[w]) continue;
+        if (check.up) {
+          up++;
+          latencySum += check.latencyMs;
+        } else {
+          down++;
+        }
+      }
+
+      RollupSummary summary = summarizeRollup(rollup, (RollupWindow)w);
+      TEST_ASSERT_EQUAL_UINT32(up + down, summary.checks);
+      TEST_ASSERT_EQUAL_UINT32(up == 0 ? 0 : latencySum / up, summary.meanMs);
+      if (up + down > 0) {
+        TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f * up / (up + down), summary.availability);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+void setUp() {
+  TEST_ASSERT_TRUE(initServiceRollups());
+}
+
+void tearDown() {}
+
+void test_unknown_service_has_no_rollup() {
+  TEST_ASSERT_NULL(serviceRollup(0, 0x77));
+  TEST_ASSERT_NULL(serviceRollup(MAX_SERVICES, 0x77));
+}
+
+void test_running_totals_match_brute_force() {
+  srand(5);
+  Reference reference;
+  uint32_t time = START_TIME;
+
+  for (int i = 0; i < 60000; i++) {
+    time += 30 + rand() % 40;
+    if (i == 15000) time += 3 * 24 * 3600;  // gaps shorter and longer than a ring
+    if (i == 30000) time += 40 * 24 * 3600;
+    if (i == 45000) time -= 500;            // the clock steps back
+    bool up = rand() % 100 < 97;
+    uint32_t latencyMs = 20 + rand() % 300;
+
+    recordRollup(3, 0x9, up, latencyMs, time);
+    reference.record(up, latencyMs, time);
+    if (i % 997 == 0 || i == 15000 || i == 30000 || i == 45000) {
+      const ServiceRollup* rollup = serviceRollup(3, 0x9);
+      TEST_ASSERT_NOT_NULL(rollup);
+      reference.assertMatches(*rollup);
+    }
+  }
+}
+
+void test_percentiles_interpolate_within_a_bin() {
+  uint32_t time = START_TIME;
+  for (int i = 0; i < 100; i++) {
+    recordRollup(4, 0x10, true, 60, time++);  // all in the 50..75 ms bin
+  }
+  recordRollup(4, 0x10, false, 0, time++);
+
+  RollupSummary summary = summarizeRollup(*serviceRollup(4, 0x10), WINDOW_1H);
+  TEST_ASSERT_EQUAL_UINT32(101, summary.checks);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 99.01f, summary.availability);
+  TEST_ASSERT_EQUAL_UINT32(60, summary.meanMs);
+  TEST_ASSERT_EQUAL_UINT32(62, summary.p50Ms);
+  TEST_ASSERT_EQUAL_UINT32(73, summary.p95Ms);
+  TEST_ASSERT_EQUAL_UINT32(74, summary.p99Ms);
+
+  // The open bin reports its lower bound
+  for (int i = 0; i < 100; i++) {
+    recordRollup(4, 0x10, true, 20000, time++);
+  }
+  summary = summarizeRollup(*serviceRollup(4, 0x10), WINDOW_1H);
+  TEST_ASSERT_EQUAL_UINT32(10000, summary.p99Ms);
+}
+
+void test_empty_window() {
+  recordRollup(5, 0x11, false, 0, START_TIME);
+
+  RollupSummary summary = summarizeRollup(*serviceRollup(5, 0x11), WINDOW_30D);
+  TEST_ASSERT_EQUAL_UINT32(1, summary.checks);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, summary.availability);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.meanMs);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p50Ms);
+
+  // A check two hours later leaves the 1 h window with only itself
+  recordRollup(5, 0x11, true, 12, START_TIME + 7200);
+  summary = summarizeRollup(*serviceRollup(5, 0x11), WINDOW_1H);
+  TEST_ASSERT_EQUAL_UINT32(1, summary.checks);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, summary.availability);
+}
+
+void test_new_service_in_a_slot_starts_over() {
+  recordRollup(6, 0x12, true, 40, START_TIME);
+  recordRollup(6, 0x12, true, 40, START_TIME + 60);
+  recordRollup(6, 0x13, false, 0, START_TIME + 120);
+
+  TEST_ASSERT_NULL(serviceRollup(6, 0x12));
+  RollupSummary summary = summarizeRollup(*serviceRollup(6, 0x13), WINDOW_7D);
+  TEST_ASSERT_EQUAL_UINT32(1, summary.checks);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, summary.availability);
+}
+
+void test_window_names() {
+  TEST_ASSERT_EQUAL_STRING("1h", rollupWindowName(WINDOW_1H));
+  TEST_ASSERT_EQUAL_STRING("24h", rollupWindowName(WINDOW_24H));
+  TEST_ASSERT_EQUAL_STRING("7d", rollupWindowName(WINDOW_7D));
+  TEST_ASSERT_EQUAL_STRING("30d", rollupWindowName(WINDOW_30D));
+  TEST_ASSERT_EQUAL_STRING("", rollupWindowName(WINDOW_COUNT));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unknown_service_has_no_rollup);
+  RUN_TEST(test_running_totals_match_brute_force);
+  RUN_TEST(test_percentiles_interpolate_within_a_bin);
+  RUN_TEST(test_empty_window);
+  RUN_TEST(test_new_service_in_a_slot_starts_over);
+  RUN_TEST(test_window_names);
+  return UNITY_END();
+}
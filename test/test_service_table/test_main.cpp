@@ -0,0 +1,201 @@
+#include <unity.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "fakes.hpp"
+#include "service_table.hpp"
+
+namespace {
+
+ServiceTable table;
+
+// Ids whose Fibonacci hash lands in the same bucket as `id`
+std::vector<uint64_t> collidingIds(uint64_t id, int count) {
+  std::vector<uint64_t> ids;
+  uint32_t home = (uint32_t)((id * 0x9E3779B97F4A7C15ULL) >> 32) & (ServiceIndex::CAPACITY - 1);
+  for (uint64_t candidate = id + 1; (int)ids.size() < count; candidate++) {
+    if (((uint32_t)((candidate * 0x9E3779B97F4A7C15ULL) >> 32) & (ServiceIndex::CAPACITY - 1)) == home) {
+      ids.push_back(candidate);
+    }
+  }
+  return ids;
+}
+
+}  // namespace
+
+void setUp() {
+  table.clear();
+}
+
+void tearDown() {}
+
+void test_capacity_keeps_the_index_half_empty() {
+  TEST_ASSERT_TRUE(ServiceIndex::CAPACITY >= 2 * MAX_SERVICES);
+  TEST_ASSERT_EQUAL(0, ServiceIndex::CAPACITY & (ServiceIndex::CAPACITY - 1));
+  TEST_ASSERT_EQUAL(64, serviceIndexCapacity(20));
+  TEST_ASSERT_EQUAL(8192, serviceIndexCapacity(4096));
+}
+
+void test_index_rejects_zero_and_duplicates() {
+  ServiceIndex index;
+  index.clear();
+  TEST_ASSERT_FALSE(index.insert(0, 1));
+  TEST_ASSERT_TRUE(index.insert(42, 1));
+  TEST_ASSERT_FALSE(index.insert(42, 2));
+  TEST_ASSERT_EQUAL(1, index.find(42));
+  TEST_ASSERT_EQUAL(-1, index.find(0));
+  TEST_ASSERT_EQUAL(-1, index.find(43));
+  TEST_ASSERT_FALSE(index.remove(43));
+}
+
+void test_removal_keeps_colliding_ids_reachable() {
+  ServiceIndex index;
+  index.clear();
+  std::vector<uint64_t> ids = collidingIds(1000, 4);
+  ids.insert(ids.begin(), 1000);
+  for (size_t i = 0; i < ids.size(); i++) {
+    TEST_ASSERT_TRUE(index.insert(ids[i], (uint16_t)i));
+  }
+
+  // Removing from the front and the middle of the run shifts the rest back
+  TEST_ASSERT_TRUE(index.remove(ids[0]));
+  TEST_ASSERT_TRUE(index.remove(ids[2]));
+  TEST_ASSERT_EQUAL(-1, index.find(ids[0]));
+  TEST_ASSERT_EQUAL(-1, index.find(ids[2]));
+  TEST_ASSERT_EQUAL(1, index.find(ids[1]));
+  TEST_ASSERT_EQUAL(3, index.find(ids[3]));
+  TEST_ASSERT_EQUAL(4, index.find(ids[4]));
+}
+
+void test_index_matches_a_map_under_random_churn() {
+  std::mt19937_64 random(28);
+  std::map<uint64_t, uint16_t> reference;
+  ServiceIndex index;
+  index.clear();
+
+  for (int step = 0; step < 200000; step++) {
+    // Small id range so inserts, removes and collisions all happen often
+    uint64_t id = 1 + random() % (4 * MAX_SERVICES);
+    bool full = (int)reference.size() >= MAX_SERVICES;
+    if (!full && random() % 2 == 0) {
+      bool inserted = index.insert(id, (uint16_t)(id % MAX_SERVICES));
+      TEST_ASSERT_EQUAL(reference.count(id) == 0, inserted);
+      if (inserted) reference[id] = (uint16_t)(id % MAX_SERVICES);
+    } else {
+      TEST_ASSERT_EQUAL(reference.erase(id) == 1, index.remove(id));
+    }
+
+    uint64_t probe = 1 + random() % (4 * MAX_SERVICES);
+    auto found = reference.find(probe);
+    TEST_ASSERT_EQUAL(found == reference.end() ? -1 : found->second, index.find(probe));
+  }
+}
+
+void test_slots_stay_put_when_others_are_removed() {
+  for (uint64_t id = 1; id <= 3; id++) {
+    TEST_ASSERT_NOT_NULL(table.add(fakeService(id)));
+  }
+  Service* third = table.find(3);
+  TEST_ASSERT_TRUE(table.remove(2));
+
+  TEST_ASSERT_EQUAL(2, table.count);
+  TEST_ASSERT_TRUE(table.find(3) == third);
+  TEST_ASSERT_EQUAL(1, table.at(0).id);
+  TEST_ASSERT_EQUAL(3, table.at(1).id);
+  TEST_ASSERT_NULL(table.find(2));
+
+  // The freed slot is reused, at the end of the configuration order
+  Service* fourth = table.add(fakeService(4));
+  TEST_ASSERT_EQUAL(1, table.index.find(4));
+  TEST_ASSERT_TRUE(&table.at(2) == fourth);
+}
+
+void test_add_fails_when_full_or_duplicate() {
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    TEST_ASSERT_NOT_NULL(table.add(fakeService(100 + i)));
+  }
+  TEST_ASSERT_NULL(table.add(fakeService(1)));
+
+  table.remove(100);
+  TEST_ASSERT_NULL(table.add(fakeService(101)));
+  TEST_ASSERT_NOT_NULL(table.add(fakeService(1)));
+}
+
+void test_adopting_loaded_slots_replaces_bad_ids() {
+  uint64_t ids[] = {7, 0, 7, 9};
+  for (int i = 0; i < 4; i++) {
+    table.slots[i] = fakeService(ids[i]);
+  }
+
+  TEST_ASSERT_EQUAL(2, table.adoptLoadedSlots(4));
+  TEST_ASSERT_EQUAL(4, table.count);
+  TEST_ASSERT_EQUAL(7, table.slots[0].id);
+  TEST_ASSERT_EQUAL(10, table.slots[1].id);
+  TEST_ASSERT_EQUAL(11, table.slots[2].id);
+  TEST_ASSERT_EQUAL(9, table.slots[3].id);
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL(i, table.index.find(table.slots[i].id));
+  }
+}
+
+void test_copy_matches_the_source() {
+  for (uint64_t id = 1; id <= 5; id++) {
+    table.add(fakeService(id));
+  }
+  table.remove(3);
+
+  ServiceTable copy;
+  copy.add(fakeService(99));
+  copy.copyFrom(table);
+  TEST_ASSERT_EQUAL(table.count, copy.count);
+  TEST_ASSERT_NULL(copy.find(99));
+  TEST_ASSERT_NULL(copy.find(3));
+  for (int i = 0; i < copy.count; i++) {
+    TEST_ASSERT_EQUAL(table.at(i).id, copy.at(i).id);
+    TEST_ASSERT_EQUAL_STRING(table.at(i).name.c_str(), copy.at(i).name.c_str());
+  }
+}
+
+void test_ids_round_trip_as_hex() {
+  uint64_t values[] = {1, 0xabc, 0x1234567890abcdefULL, UINT64_MAX};
+  for (uint64_t value : values) {
+    uint64_t parsed = 0;
+    TEST_ASSERT_TRUE(parseServiceId(formatServiceId(value), parsed));
+    TEST_ASSERT_TRUE(parsed == value);
+  }
+  TEST_ASSERT_EQUAL_STRING("ff", formatServiceId(255).c_str());
+
+  uint64_t id = 5;
+  TEST_ASSERT_TRUE(parseServiceId("ABC", id));
+  TEST_ASSERT_EQUAL(0xabc, id);
+  TEST_ASSERT_FALSE(parseServiceId("", id));
+  TEST_ASSERT_FALSE(parseServiceId("0", id));
+  TEST_ASSERT_FALSE(parseServiceId("12g", id));
+  TEST_ASSERT_FALSE(parseServiceId("11112222333344445", id));
+  TEST_ASSERT_EQUAL(0xabc, id);
+}
+
+void test_generated_ids_are_above_the_table() {
+  table.add(fakeService(0xffffffffffffULL));
+  seedServiceIds(table);
+  uint64_t first = generateServiceId();
+  TEST_ASSERT_TRUE(first > 0xffffffffffffULL);
+  TEST_ASSERT_TRUE(generateServiceId() > first);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_capacity_keeps_the_index_half_empty);
+  RUN_TEST(test_index_rejects_zero_and_duplicates);
+  RUN_TEST(test_removal_keeps_colliding_ids_reachable);
+  RUN_TEST(test_index_matches_a_map_under_random_churn);
+  RUN_TEST(test_slots_stay_put_when_others_are_removed);
+  RUN_TEST(test_add_fails_when_full_or_duplicate);
+  RUN_TEST(test_adopting_loaded_slots_replaces_bad_ids);
+  RUN_TEST(test_copy_matches_the_source);
+  RUN_TEST(test_ids_round_trip_as_hex);
+  RUN_TEST(test_generated_ids_are_above_the_table);
+  return UNITY_END();
+}
@@ -0,0 +1,580 @@
+// Runs the firmware's check loop on the host against a local fleet of mock
+// endpoints, and reports how it keeps up. The services are checked by the
+// real pipeline: runDueChecks() (what checkServices() runs), the bounded HTTP
+// probe over sockets, DNS lookups through a mock server and pings over UDP
+// echo. The responders answer with the latency, slow-response and error
+// profile set on the command line.
+//
+// Each responder decides a check's outcome from the service name and check
+// number. The bench knows the same decisions, so it can tell whether every
+// check was classified right and whether the UP/DOWN transitions follow the
+// thresholds.
+//
+// Build from the repository root:
+//
+//   g++ -std=gnu++17 -O2 -Ihost -Iinclude -DMAX_SERVICES_VALUE=512 -o check_bench
+//     tools/check_bench/check_bench.cpp src/check_runner.cpp src/http_probe.cpp
+//     src/probe_simulator.cpp src/service.cpp src/service_engine.cpp
+//     src/service_table.cpp host/fakes.cpp host/fs.cpp host/host_platform.cpp
+//     host/mock_servers.cpp -lpthread
+//
+// Usage: check_bench [--services N] [--seconds N] [--interval S]
+//          [--latency-ms N] [--slow-percent N] [--slow-ms N]
+//          [--error-percent N] [--pass N] [--fail N]
+//
+// Every fourth service is a ping; the others are HTTP GET, Jellyfin and Home
+// Assistant in turn. Exits with 1 if any check or transition was wrong.
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check_runner.hpp"
+#include "fakes.hpp"
+#include "host_platform.hpp"
+#include "mock_servers.hpp"
+#include "service_engine.hpp"
+
+namespace {
+
+const uint32_t MAX_LOOP_WAIT_MS = 1000;
+const uint32_t ECHO_TIMEOUT_MS = 1000;  // per echo request, as ESP32Ping
+const uint32_t DEADLINE_MARGIN_MS = 200;  // outcomes this close to a timeout are not judged
+const char* const HEALTHY_BODY = "{\"status\": \"healthy\"}";
+
+struct Options {
+  int services = 200;
+  int seconds = 60;
+  int interval = 10;
+  uint32_t latencyMs = 20;
+  uint32_t slowPercent = 5;
+  uint32_t slowMs = 2000;
+  uint32_t errorPercent = 2;
+  int passThreshold = 2;
+  int failThreshold = 2;
+};
+
+Options options;
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (i + 1 >= argc) return false;
+    long value = atol(argv[++i]);
+    if (arg == "--services") {
+      options.services = value;
+    } else if (arg == "--seconds") {
+      options.seconds = value;
+    } else if (arg == "--interval") {
+      options.interval = value;
+    } else if (arg == "--latency-ms") {
+      options.latencyMs = value;
+    } else if (arg == "--slow-percent") {
+      options.slowPercent = value;
+    } else if (arg == "--slow-ms") {
+      options.slowMs = value;
+    } else if (arg == "--error-percent") {
+      options.errorPercent = value;
+    } else if (arg == "--pass") {
+      options.passThreshold = value;
+    } else if (arg == "--fail") {
+      options.failThreshold = value;
+    } else {
+      return false;
+    }
+  }
+  return options.services > 0 && options.services <= MAX_SERVICES && options.seconds > 0 &&
+    options.interval > 0 && options.passThreshold > 0 && options.failThreshold > 0;
+}
+
+// What a responder does with one check
+enum Fault {
+  FAULT_NONE,
+  FAULT_STATUS,  // HTTP 500; a lost echo for a ping
+  FAULT_RESET,   // reset before the headers are complete
+  FAULT_HANG     // no answer until the client gives up
+};
+
+struct Decision {
+  Fault fault;
+  uint32_t delayMs;
+};
+
+// SplitMix64 over the name and check number, as in probe_simulator.cpp
+uint32_t draw(const std::string& name, uint32_t checkNumber, uint32_t salt) {
+  uint64_t x = 14695981039346656037ULL;
+  for (char c : name) x = (x ^ (uint8_t)c) * 1099511628211ULL;
+  x ^= ((uint64_t)checkNumber << 32) ^ salt;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return (uint32_t)(x ^ (x >> 31));
+}
+
+Decision decide(const std::string& host, uint32_t checkNumber) {
+  Decision decision = {FAULT_NONE, options.latencyMs / 2 + draw(host, checkNumber, 1) % (options.latencyMs + 1)};
+  if (draw(host, checkNumber, 2) % 100 < options.slowPercent) {
+    decision.delayMs = options.slowMs;
+  }
+  if (draw(host, checkNumber, 3) % 100 < options.errorPercent) {
+    decision.fault = (Fault)(FAULT_STATUS + draw(host, checkNumber, 4) % 3);
+  }
+  return decision;
+}
+
+// The ProbeError the check of a `type` service should get. False if the
+// outcome is too close to the deadline to call.
+bool expectedError(ServiceType type, const Decision& decision, ProbeError& error) {
+  if (type == TYPE_PING) {
+    // Every echo of a check is as late as the first
+    error = decision.fault != FAULT_NONE || decision.delayMs >= ECHO_TIMEOUT_MS ? PROBE_TIMEOUT : PROBE_OK;
+    return decision.fault != FAULT_NONE || decision.delayMs + DEADLINE_MARGIN_MS < ECHO_TIMEOUT_MS ||
+      decision.delayMs >= ECHO_TIMEOUT_MS + DEADLINE_MARGIN_MS;
+  }
+
+  if (decision.fault == FAULT_HANG || decision.delayMs >= PROBE_DEADLINE_MS + DEADLINE_MARGIN_MS) {
+    error = PROBE_TIMEOUT;
+    return true;
+  }
+  if (decision.delayMs + DEADLINE_MARGIN_MS > PROBE_DEADLINE_MS) return false;
+
+  switch (decision.fault) {
+    case FAULT_STATUS:
+      error = type == TYPE_HOME_ASSISTANT ? PROBE_OK : PROBE_HTTP_STATUS;  // any status will do
+      break;
+    case FAULT_RESET:
+      error = PROBE_CONNECTION_CLOSED;
+      break;
+    default:
+      error = PROBE_OK;
+      break;
+  }
+  return true;
+}
+
+// Counts requests per name; the responders run on their own threads
+class CheckCounter {
+ public:
+  uint32_t next(const std::string& name) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return ++_counts[name];
+  }
+
+ private:
+  std::mutex _mutex;
+  std::map<std::string, uint32_t> _counts;
+};
+
+bool waitReadable(int fd, int timeoutMs) {
+  pollfd pending = {fd, POLLIN, 0};
+  return poll(&pending, 1, timeoutMs) == 1;
+}
+
+// HTTP for every HTTP service at once, told apart by the Host header. Each
+// connection gets a thread, so a hanging answer does not hold up the next.
+class FleetHttpServer {
+ public:
+  FleetHttpServer() {
+    _listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(local);
+    bind(_listener, reinterpret_cast<sockaddr*>(&local), sizeof(local));
+    getsockname(_listener, reinterpret_cast<sockaddr*>(&local), &length);
+    listen(_listener, 16);
+    _port = ntohs(local.sin_port);
+    _thread = std::thread(&FleetHttpServer::run, this);
+  }
+
+  ~FleetHttpServer() {
+    _stopping = true;
+    _thread.join();
+    while (_active > 0) usleep(10 * 1000);
+    close(_listener);
+  }
+
+  uint16_t port() const { return _port; }
+
+ private:
+  void run() {
+    while (!_stopping) {
+      if (!waitReadable(_listener, 20)) continue;
+      int client = accept(_listener, nullptr, nullptr);
+      if (client < 0) continue;
+      _active++;
+      std::thread(&FleetHttpServer::serve, this, client).detach();
+    }
+  }
+
+  void serve(int client) {
+    std::string request;
+    char buffer[512];
+    while (!_stopping && request.find("\r\n\r\n") == std::string::npos) {
+      if (!waitReadable(client, 20)) continue;
+      ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+      if (count <= 0) break;
+      request.append(buffer, count);
+    }
+
+    size_t host = request.find("\r\nHost: ");
+    if (host != std::string::npos) {
+      host += 8;
+      std::string name = request.substr(host, request.find("\r\n", host) - host);
+      answer(client, decide(name, _counter.next(name)));
+    }
+    close(client);
+    _active--;
+  }
+
+  void answer(int client, const Decision& decision) {
+    // Sleeps in steps so a stopping server does not wait out a hang
+    uint32_t delay = decision.fault == FAULT_HANG ? UINT32_MAX : decision.delayMs;
+    for (uint32_t waited = 0; waited < delay && !_stopping; waited += 10) {
+      usleep(std::min<uint32_t>(10, delay - waited) * 1000);
+      char c;
+      if (decision.fault == FAULT_HANG && recv(client, &c, 1, MSG_DONTWAIT | MSG_PEEK) == 0) return;
+    }
+
+    std::string body = HEALTHY_BODY;
+    std::string response = std::string(decision.fault == FAULT_STATUS ? "HTTP/1.1 500 Internal Server Error"
+      : "HTTP/1.1 200 OK") + "\r\nContent-Type: application/json\r\nContent-Length: " +
+      std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+    if (decision.fault == FAULT_RESET) {
+      send(client, response.data(), response.size() / 3, MSG_NOSIGNAL);
+      usleep(20 * 1000);
+      linger abort = {1, 0};
+      setsockopt(client, SOL_SOCKET, SO_LINGER, &abort, sizeof(abort));
+      return;
+    }
+    send(client, response.data(), response.size(), MSG_NOSIGNAL);
+  }
+
+  int _listener;
+  uint16_t _port;
+  CheckCounter _counter;
+  std::atomic<bool> _stopping{false};
+  std::atomic<int> _active{0};
+  std::thread _thread;
+};
+
+// UDP echo for every ping service at once. Each has its own 127.x address,
+// which the server reads back from the datagram to look up the decision.
+class FleetEchoServer {
+ public:
+  FleetEchoServer() {
+    _socket = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1;
+    setsockopt(_socket, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t length = sizeof(local);
+    bind(_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local));
+    getsockname(_socket, reinterpret_cast<sockaddr*>(&local), &length);
+    _port = ntohs(local.sin_port);
+    _thread = std::thread(&FleetEchoServer::run, this);
+  }
+
+  ~FleetEchoServer() {
+    _stopping = true;
+    _thread.join();
+    close(_socket);
+  }
+
+  uint16_t port() const { return _port; }
+
+ private:
+  struct Echo {
+    uint64_t due;  // steady clock ms
+    sockaddr_in client;
+    in_addr from;  // the service address the request went to
+    uint8_t sequence;
+  };
+
+  static uint64_t nowMs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+  }
+
+  void run() {
+    std::vector<Echo> pending;
+    while (!_stopping) {
+      uint64_t now = nowMs();
+      for (size_t i = 0; i < pending.size();) {
+        if (pending[i].due > now) {
+          i++;
+          continue;
+        }
+        reply(pending[i]);
+        pending.erase(pending.begin() + i);
+      }
+
+      if (!waitReadable(_socket, 5)) continue;
+      Echo echo = {};
+      char control[64];
+      iovec data = {&echo.sequence, 1};
+      msghdr message = {};
+      message.msg_name = &echo.client;
+      message.msg_namelen = sizeof(echo.client);
+      message.msg_iov = &data;
+      message.msg_iovlen = 1;
+      message.msg_control = control;
+      message.msg_controllen = sizeof(control);
+      if (recvmsg(_socket, &message, 0) != 1) continue;
+
+      for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_PKTINFO) {
+          echo.from = reinterpret_cast<in_pktinfo*>(CMSG_DATA(header))->ipi_addr;
+        }
+      }
+
+      // Retries of one ping share its decision
+      char name[INET_ADDRSTRLEN];
+      inet_ntop(AF_INET, &echo.from, name, sizeof(name));
+      if (echo.sequence == 0) _decisions[name] = decide(name, _counter.next(name));
+      const Decision& decision = _decisions[name];
+      if (decision.fault != FAULT_NONE) continue;
+      echo.due = now + decision.delayMs;
+      pending.push_back(echo);
+    }
+  }
+
+  // Sent from the service's address, as a real host would
+  void reply(const Echo& echo) {
+    char control[CMSG_SPACE(sizeof(in_pktinfo))] = {};
+    iovec data = {const_cast<uint8_t*>(&echo.sequence), 1};
+    msghdr message = {};
+    message.msg_name = const_cast<sockaddr_in*>(&echo.client);
+    message.msg_namelen = sizeof(echo.client);
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = IPPROTO_IP;
+    header->cmsg_type = IP_PKTINFO;
+    header->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+    reinterpret_cast<in_pktinfo*>(CMSG_DATA(header))->ipi_spec_dst = echo.from;
+    sendmsg(_socket, &message, 0);
+  }
+
+  int _socket;
+  uint16_t _port;
+  CheckCounter _counter;
+  std::map<std::string, Decision> _decisions;
+  std::atomic<bool> _stopping{false};
+  std::thread _thread;
+};
+
+// Heap use of the check loop's thread; the responders are not counted
+thread_local bool countingHeap = false;
+int64_t heapInUse = 0;
+int64_t heapPeak = 0;
+
+// What the bench expects of one service
+struct Expectation {
+  std::string host;
+  uint32_t checks = 0;
+  int passes = 0;
+  int fails = 0;
+  bool up = false;
+};
+
+struct Results {
+  uint32_t checks = 0;
+  uint32_t failures = 0;
+  uint32_t unjudged = 0;       // too close to the deadline to call
+  uint32_t misclassified = 0;
+  uint32_t transitions = 0;
+  uint32_t wrongStates = 0;    // isUp differs from the thresholds' verdict
+  std::vector<uint32_t> lateness;
+  std::vector<uint32_t> probeMillis;
+  uint32_t errors[8] = {};
+};
+
+Expectation expectations[MAX_SERVICES];
+Results results;
+
+void recordOutcome(Service& service, const CheckOutcome& outcome) {
+  Expectation& expected = expectations[outcome.slot];
+  Decision decision = decide(expected.host, ++expected.checks);
+
+  results.checks++;
+  results.probeMillis.push_back(outcome.probeMicros / 1000);
+  if (!outcome.firstCheck) results.lateness.push_back(outcome.lateness);
+  if (outcome.error != PROBE_OK) results.failures++;
+  if (outcome.error < 8) results.errors[outcome.error]++;
+  if (outcome.changed) results.transitions++;
+
+  ProbeError error;
+  bool passed = outcome.error == PROBE_OK;
+  if (!expectedError(service.type, decision, error)) {
+    results.unjudged++;
+  } else if (error != outcome.error) {
+    results.misclassified++;
+    fprintf(stderr, "%s check %u: %s, expected %s\n", expected.host.c_str(), expected.checks,
+      probeErrorName(outcome.error), probeErrorName(error));
+  } else {
+    passed = error == PROBE_OK;
+  }
+
+  // The thresholds, applied to what should have happened
+  expected.passes = passed ? expected.passes + 1 : 0;
+  expected.fails = passed ? 0 : expected.fails + 1;
+  if (!expected.up && expected.passes >= service.passThreshold) {
+    expected.up = true;
+  } else if (expected.up && expected.fails >= service.failThreshold) {
+    expected.up = false;
+  }
+  if (expected.up != service.isUp) {
+    results.wrongStates++;
+    expected.up = service.isUp;  // report each divergence once
+  }
+}
+
+uint32_t percentile(std::vector<uint32_t>& values, int percent) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+double cpuSeconds(clockid_t clock) {
+  timespec used;
+  clock_gettime(clock, &used);
+  return used.tv_sec + used.tv_nsec / 1e9;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* memory = malloc(size != 0 ? size : 1);
+  if (memory == nullptr) throw std::bad_alloc();
+  if (countingHeap) {
+    heapInUse += malloc_usable_size(memory);
+    heapPeak = std::max(heapPeak, heapInUse);
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  if (memory != nullptr && countingHeap) heapInUse -= malloc_usable_size(memory);
+  free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  operator delete(memory);
+}
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    fprintf(stderr, "usage: %s [--services N] [--seconds N] [--interval S] [--latency-ms N] [--slow-percent N]\n"
+      "         [--slow-ms N] [--error-percent N] [--pass N] [--fail N]\n"
+      "--services is at most MAX_SERVICES (%d in this build)\n", argv[0], MAX_SERVICES);
+    return 2;
+  }
+
+  FleetHttpServer http;
+  FleetEchoServer echo;
+  MockDnsServer dns(MOCK_DNS_ANSWER);
+
+  PosixClock clock;
+  PosixNetwork network;
+  network.useDnsServer(htonl(INADDR_LOOPBACK), dns.port());
+  BoundedHttpClient httpClient(network, clock);
+  UdpEchoPinger pinger(echo.port(), ECHO_TIMEOUT_MS);
+  RecordingDisplay display;
+  CheckPlatform platform = {clock, network, httpClient, pinger, display};
+
+  static ServiceTable table;
+  static const ServiceType TYPES[] = {TYPE_HTTP_GET, TYPE_JELLYFIN, TYPE_HOME_ASSISTANT, TYPE_PING};
+  int typeCounts[4] = {};
+  for (int i = 0; i < options.services; i++) {
+    Service service = fakeService(i + 1, TYPES[i % 4]);
+    service.checkInterval = options.interval;
+    service.passThreshold = options.passThreshold;
+    service.failThreshold = options.failThreshold;
+    if (service.type == TYPE_PING) {
+      service.host = "127.1." + String(i / 250) + "." + String(i % 250 + 1);
+    } else {
+      service.host = "service-" + String(i + 1) + ".bench";
+      service.port = http.port();
+      service.path = "/status";
+      service.expectedResponse = "healthy";
+    }
+    typeCounts[i % 4]++;
+    table.add(service);
+    expectations[table.index.find(service.id)].host = service.host.c_str();
+  }
+  results.lateness.reserve(options.services * options.seconds);
+  results.probeMillis.reserve(options.services * options.seconds);
+
+  printf("%d services (%d HTTP GET, %d Jellyfin, %d Home Assistant, %d ping), %d s interval, %d s run\n",
+    options.services, typeCounts[0], typeCounts[1], typeCounts[2], typeCounts[3], options.interval,
+    options.seconds);
+  printf("profile: %u ms typical, %u%% slow (%u ms), %u%% errors; deadline %u ms\n\n", options.latencyMs,
+    options.slowPercent, options.slowMs, options.errorPercent, (unsigned)PROBE_DEADLINE_MS);
+
+  // The firmware's loop(): checks when one is due, otherwise waits for it
+  double threadCpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+  double processCpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+  uint32_t start = clock.millis();
+  uint32_t runMillis = options.seconds * 1000;
+  spreadFirstChecks(table, start);
+
+  countingHeap = true;
+  while (clock.millis() - start < runMillis) {
+    uint32_t wait = msUntilNextCheck(table, clock.millis(), MAX_LOOP_WAIT_MS);
+    if (wait == 0) {
+      runDueChecks(table, platform, recordOutcome);
+    } else {
+      clock.sleep(std::min(wait, runMillis - (clock.millis() - start)));
+    }
+  }
+  countingHeap = false;
+
+  double elapsed = (clock.millis() - start) / 1000.0;
+  threadCpu = cpuSeconds(CLOCK_THREAD_CPUTIME_ID) - threadCpu;
+  processCpu = cpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - processCpu;
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  uint32_t checks = std::max<uint32_t>(results.checks, 1);
+  printf("checks        %u in %.1f s, %.1f/s (%.1f/s scheduled)\n", results.checks, elapsed,
+    results.checks / elapsed, (double)options.services / options.interval);
+  printf("lateness      p50 %u  p90 %u  p99 %u  max %u ms\n", percentile(results.lateness, 50),
+    percentile(results.lateness, 90), percentile(results.lateness, 99), percentile(results.lateness, 100));
+  printf("probe time    p50 %u  p90 %u  p99 %u  max %u ms\n", percentile(results.probeMillis, 50),
+    percentile(results.probeMillis, 90), percentile(results.probeMillis, 99), percentile(results.probeMillis, 100));
+  printf("CPU per check %.0f us in the check loop, %.0f us with the responders\n", threadCpu * 1e6 / checks,
+    processCpu * 1e6 / checks);
+  printf("memory        heap peak %.1f KB in the check loop, max RSS %.1f MB\n", heapPeak / 1024.0,
+    usage.ru_maxrss / 1024.0);
+  printf("failures      %u%s", results.failures, results.failures > 0 ? ":" : "");
+  for (int i = 1; i < 8; i++) {
+    if (results.errors[i] > 0) printf(" %s %u", probeErrorName(i), results.errors[i]);
+  }
+  printf("\nscreen        %d updates\n", display.updates);
+  printf("correctness   %u misclassified, %u not judged (near the deadline); %u transitions, %u wrong\n",
+    results.misclassified, results.unjudged, results.transitions, results.wrongStates);
+
+  return results.misclassified == 0 && results.wrongStates == 0 ? 0 : 1;
+}
@@ -0,0 +1,403 @@
+// Compares loading the service table from the legacy services.json against
+// the binary services.bin, at several table sizes. Both files are written
+// from the same generated services; each load then runs the way the firmware
+// does it: the JSON path parses the whole document into a JsonDocument and
+// copies every field into the table (loadServicesFromJson()), the binary path
+// decodes records straight into the slots (readServicesBinary()). Both end
+// with adoptLoadedSlots(), which rebuilds the id index.
+//
+// Reported per format: file size, median and best load time, and the peak
+// heap the load needed on top of what was allocated before it, which
+// includes the service strings themselves. Heap is counted by wrapping
+// malloc, so the JsonDocument's pool (allocated through malloc by
+// ArduinoJson's default allocator) is included. Times are for a file in the
+// page cache; on the device LittleFS reads add to both, more to the larger
+// JSON file.
+//
+// Build from the repository root, with ArduinoJson 7 on the include path
+// (`pio test -e native` fetches it into .pio/libdeps/native):
+//
+//   g++ -std=gnu++17 -O2 -Ihost -Iinclude -I.pio/libdeps/native/ArduinoJson/src
+//     -DARDUINOJSON_ENABLE_ARDUINO_STRING=1 -DMAX_SERVICES_VALUE=512 -o codec_bench
+//     tools/codec_bench/codec_bench.cpp src/service.cpp src/service_codec.cpp
+//     src/service_table.cpp host/fakes.cpp host/fs.cpp
+//
+// Usage: codec_bench [--repeat N] [--counts N,N,...]
+//
+// Counts above MAX_SERVICES are skipped. Exits with 1 if a format loads a
+// table that differs from the one that was written.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "fakes.hpp"
+#include "service_codec.hpp"
+
+// Heap accounting. Every allocation goes through these, so whatever the
+// standard library, String and ArduinoJson allocate is counted. glibc only.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+size_t malloc_usable_size(void* pointer);
+}
+
+namespace {
+
+bool counting = false;
+long heapInUse = 0;
+long heapPeak = 0;
+
+void allocated(void* pointer) {
+  if (!counting || pointer == nullptr) return;
+  heapInUse += malloc_usable_size(pointer);
+  if (heapInUse > heapPeak) heapPeak = heapInUse;
+}
+
+void released(void* pointer) {
+  if (counting && pointer != nullptr) heapInUse -= malloc_usable_size(pointer);
+}
+
+}  // namespace
+
+extern "C" {
+
+void* malloc(size_t size) {
+  void* pointer = __libc_malloc(size);
+  allocated(pointer);
+  return pointer;
+}
+
+void* calloc(size_t count, size_t size) {
+  void* pointer = __libc_calloc(count, size);
+  allocated(pointer);
+  return pointer;
+}
+
+void* realloc(void* pointer, size_t size) {
+  released(pointer);
+  void* moved = __libc_realloc(pointer, size);
+  allocated(moved != nullptr || size == 0 ? moved : pointer);
+  return moved;
+}
+
+void free(void* pointer) {
+  released(pointer);
+  __libc_free(pointer);
+}
+
+}  // extern "C"
+
+namespace {
+
+const char* const JSON_FILE = "/services.json";
+const char* const BINARY_FILE = "/services.bin";
+
+struct Options {
+  int repeat = 50;
+  std::vector<int> counts = {20, 64, 128, 256, 512};
+};
+
+Options options;
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* value = argv[++i];
+
+    if (arg == "--repeat") {
+      options.repeat = atoi(value);
+      if (options.repeat < 1) return false;
+    } else if (arg == "--counts") {
+      options.counts.clear();
+      for (const char* p = value; *p != '\0';) {
+        char* end;
+        long count = strtol(p, &end, 10);
+        if (end == p || count < 1) return false;
+        options.counts.push_back((int)count);
+        p = *end == ',' ? end + 1 : end;
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t nextRandom(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// A home-lab mix: pings to bare addresses, HTTP checks with paths and the
+// occasional longer expected response.
+void generateServices(ServiceTable& table, int count) {
+  static const char* const ROOMS[] = {"Living room", "Office", "Garage", "Basement rack", "Attic"};
+  static const char* const THINGS[] = {"NAS", "Printer", "Camera", "Switch", "Media server", "Router"};
+  static const char* const PATHS[] = {"/", "/health", "/api/", "/web/index.html", "/status.json"};
+  uint64_t state = 26;
+
+  table.clear();
+  for (int i = 0; i < count; i++) {
+    uint64_t draw = nextRandom(state);
+    Service service = fakeService(nextRandom(state) | 1, (ServiceType)(draw % 4));
+    service.name = String(ROOMS[draw % 5]) + " " + THINGS[(draw >> 8) % 6] + " " + String(i);
+    service.checkInterval = 30 + (int)((draw >> 16) % 10) * 30;
+    service.passThreshold = 1 + (int)((draw >> 24) % 3);
+    service.failThreshold = 1 + (int)((draw >> 28) % 3);
+
+    if (service.type == TYPE_PING) {
+      service.host = "192.168." + String((int)((draw >> 32) % 4)) + "." + String(i % 250 + 2);
+      service.port = 0;
+      service.path = "";
+      service.expectedResponse = "";
+    } else {
+      service.host = "host-" + String(i) + ".home.lan";
+      service.port = service.type == TYPE_JELLYFIN ? 8096 : service.type == TYPE_HOME_ASSISTANT ? 8123 : 80;
+      service.path = PATHS[(draw >> 40) % 5];
+      service.expectedResponse = (draw >> 48) % 4 == 0 ? String("{\"status\": \"healthy\"}") : String("*");
+    }
+    table.add(service);
+  }
+}
+
+String jsonEscaped(const String& text) {
+  String escaped;
+  for (unsigned int i = 0; i < text.length(); i++) {
+    char c = text[i];
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+// The pre-binary layout that loadServicesFromJson() migrates from.
+bool writeServicesJson(const ServiceTable& table) {
+  File file = LittleFS.open(JSON_FILE, "w");
+  if (!file) return false;
+
+  String json = "{\"services\":[";
+  for (int i = 0; i < table.count; i++) {
+    const Service& service = table.at(i);
+    if (i > 0) json += ",";
+    json += "{\"id\":\"" + formatServiceId(service.id) + "\",\"name\":\"" + jsonEscaped(service.name) +
+      "\",\"type\":" + String((int)service.type) + ",\"host\":\"" + jsonEscaped(service.host) +
+      "\",\"port\":" + String(service.port) + ",\"path\":\"" + jsonEscaped(service.path) +
+      "\",\"expectedResponse\":\"" + jsonEscaped(service.expectedResponse) +
+      "\",\"checkInterval\":" + String(service.checkInterval) + ",\"passThreshold\":" +
+      String(service.passThreshold) + ",\"failThreshold\":" + String(service.failThreshold) + "}";
+  }
+  json += "]}";
+
+  bool written = file.write(reinterpret_cast<const uint8_t*>(json.c_str()), json.length()) == json.length();
+  file.close();
+  return written;
+}
+
+bool writeServicesFile(const ServiceTable& table) {
+  File file = LittleFS.open(BINARY_FILE, "w");
+  if (!file) return false;
+  bool written = writeServicesBinary(file, table);
+  file.close();
+  return written;
+}
+
+// Lets deserializeJson() stream from the file, as it does from a LittleFS
+// File (a Stream) on the device.
+struct FileReader {
+  File& file;
+
+  int read() { return file.read(); }
+  size_t readBytes(char* buffer, size_t length) { return file.read(reinterpret_cast<uint8_t*>(buffer), length); }
+};
+
+// loadServicesFromJson() from main.cpp, on `table` instead of the global one
+bool loadJson(ServiceTable& table) {
+  File file = LittleFS.open(JSON_FILE, "r");
+  if (!file) {
+    return false;
+  }
+
+  JsonDocument doc;
+  FileReader reader = {file};
+  DeserializationError error = deserializeJson(doc, reader);
+  file.close();
+
+  if (error) {
+    return false;
+  }
+
+  JsonArrayConst array = doc["services"].as<JsonArrayConst>();
+  int loaded = 0;
+
+  for (JsonObjectConst obj : array) {
+    if (loaded >= MAX_SERVICES) break;
+
+    Service& service = table.slots[loaded];
+    service.id = 0;
+    parseServiceId(obj["id"].as<String>(), service.id);
+    service.name = obj["name"].as<String>();
+    service.type = (ServiceType)(obj["type"] | 0);
+    service.host = obj["host"].as<String>();
+    service.port = obj["port"] | 0;
+    service.path = obj["path"].as<String>();
+    service.expectedResponse = obj["expectedResponse"].as<String>();
+    service.checkInterval = obj["checkInterval"] | 0;
+    service.passThreshold = obj["passThreshold"] | 1;
+    service.failThreshold = obj["failThreshold"] | 1;
+    service.consecutivePasses = 0;
+    service.consecutiveFails = 0;
+    service.isUp = false;
+    service.lastCheck = 0;
+    service.lastUptime = 0;
+    service.lastError = "";
+    service.secondsSinceLastCheck = -1;
+
+    loaded++;
+  }
+
+  table.adoptLoadedSlots(loaded);
+  return true;
+}
+
+// The binary half of loadServices()
+bool loadBinary(ServiceTable& table) {
+  File file = LittleFS.open(BINARY_FILE, "r");
+  if (!file) {
+    return false;
+  }
+
+  int count = readServicesBinary(file, table.slots, MAX_SERVICES);
+  file.close();
+  if (count < 0) {
+    return false;
+  }
+
+  table.adoptLoadedSlots(count);
+  return true;
+}
+
+bool sameTable(const ServiceTable& expected, const ServiceTable& actual) {
+  if (expected.count != actual.count) return false;
+  for (int i = 0; i < expected.count; i++) {
+    const Service& a = expected.at(i);
+    const Service* b = actual.find(a.id);
+    if (b == nullptr || b->name != a.name || b->type != a.type || b->host != a.host || b->port != a.port ||
+        b->path != a.path || b->expectedResponse != a.expectedResponse || b->checkInterval != a.checkInterval ||
+        b->passThreshold != a.passThreshold || b->failThreshold != a.failThreshold) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Frees the strings a previous load left in the slots, so every load starts
+// from the same heap.
+void emptyTable(ServiceTable& table) {
+  for (int i = 0; i < MAX_SERVICES; i++) {
+    table.slots[i] = Service();
+  }
+  table.clear();
+}
+
+uint64_t nowNanos() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+struct Measurement {
+  size_t fileBytes = 0;
+  double medianUs = 0;
+  double bestUs = 0;
+  long peakHeap = 0;
+  bool correct = true;
+};
+
+Measurement measure(bool (*load)(ServiceTable&), const char* path, const ServiceTable& expected,
+                    ServiceTable& table) {
+  Measurement result;
+  File file = LittleFS.open(path, "r");
+  result.fileBytes = file.size();
+  file.close();
+
+  std::vector<double> times;
+  for (int run = 0; run < options.repeat; run++) {
+    emptyTable(table);
+
+    heapInUse = 0;
+    heapPeak = 0;
+    counting = true;
+    uint64_t start = nowNanos();
+    bool loaded = load(table);
+    uint64_t elapsed = nowNanos() - start;
+    counting = false;
+
+    times.push_back(elapsed / 1000.0);
+    result.peakHeap = std::max(result.peakHeap, heapPeak);
+    result.correct = result.correct && loaded && sameTable(expected, table);
+  }
+
+  std::sort(times.begin(), times.end());
+  result.medianUs = times[times.size() / 2];
+  result.bestUs = times[0];
+  return result;
+}
+
+void printRow(const char* format, int count, const Measurement& m) {
+  printf("%8d  %-6s  %9zu  %10.1f  %10.1f  %10ld  %9ld%s\n", count, format, m.fileBytes, m.medianUs, m.bestUs,
+    m.peakHeap, m.peakHeap / count, m.correct ? "" : "  WRONG");
+}
+
+// Large enough for MAX_SERVICES_VALUE=512 and beyond; kept off the stack
+ServiceTable written;
+ServiceTable loaded;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    fprintf(stderr, "usage: %s [--repeat N] [--counts N,N,...]\n", argv[0]);
+    return 2;
+  }
+
+  useTempLittleFS();
+  printf("%d runs per format, MAX_SERVICES %d, index %zu bytes\n\n", options.repeat, MAX_SERVICES,
+    sizeof(ServiceIndex));
+  printf("%8s  %-6s  %9s  %10s  %10s  %10s  %9s\n", "services", "format", "file B", "median us", "best us",
+    "peak heap", "B/service");
+
+  bool allCorrect = true;
+  for (int count : options.counts) {
+    if (count > MAX_SERVICES) {
+      printf("%8d  skipped, above MAX_SERVICES\n", count);
+      continue;
+    }
+
+    generateServices(written, count);
+    if (!writeServicesJson(written) || !writeServicesFile(written)) {
+      fprintf(stderr, "could not write the service files\n");
+      return 2;
+    }
+
+    Measurement json = measure(loadJson, JSON_FILE, written, loaded);
+    Measurement binary = measure(loadBinary, BINARY_FILE, written, loaded);
+    printRow("json", count, json);
+    printRow("binary", count, binary);
+    allCorrect = allCorrect && json.correct && binary.correct;
+  }
+
+  return allCorrect ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+// Measures id lookups in the service table at large service counts, against
+// the linear scans the index replaced. For each count the table is filled
+// through ServiceTable::add(), then looked up in shuffled order:
+//
+//   index      ServiceIndex::find(), what ServiceTable::find() uses
+//   scan u64   a loop over the table in configuration order comparing the
+//              services' 64-bit ids, i.e. the table without its index
+//   scan str   a loop over an array of String ids, as the firmware compared
+//              them before ids became 64-bit (decimal millis() strings)
+//
+// Each is timed for ids that are present and ids that are not (DELETE of a
+// stale id). The index is then churned, every service removed and re-added
+// with a new id several times over, and timed again: backward-shift deletion
+// should leave lookups as fast as on a fresh table.
+//
+// Ids are drawn the way the firmware makes them (counting upward from a
+// seed) or at random, as in tables restored from another device.
+//
+// Build from the repository root:
+//
+//   g++ -std=gnu++17 -O2 -Ihost -Iinclude -DMAX_SERVICES_VALUE=4096 -o table_bench
+//     tools/table_bench/table_bench.cpp src/service.cpp src/service_table.cpp
+//     host/fakes.cpp host/fs.cpp
+//
+// Usage: table_bench [--lookups N] [--counts N,N,...] [--churn N]
+//
+// Counts above MAX_SERVICES are skipped. Exits with 1 if any lookup returned
+// the wrong slot.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "fakes.hpp"
+#include "service_table.hpp"
+
+namespace {
+
+struct Options {
+  long lookups = 2000000;
+  int churn = 4;  // rounds of removing and re-adding every service
+  std::vector<int> counts = {20, 256, 1024, 2048, 4096};
+};
+
+Options options;
+
+bool parseCounts(const char* text) {
+  options.counts.clear();
+  for (const char* p = text; *p != '\0';) {
+    char* end;
+    long count = strtol(p, &end, 10);
+    if (end == p || count < 1) return false;
+    options.counts.push_back((int)count);
+    p = *end == ',' ? end + 1 : end;
+  }
+  return !options.counts.empty();
+}
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* value = argv[++i];
+
+    if (arg == "--lookups") {
+      options.lookups = atol(value);
+      if (options.lookups < 1) return false;
+    } else if (arg == "--churn") {
+      options.churn = atoi(value);
+      if (options.churn < 0) return false;
+    } else if (arg == "--counts") {
+      if (!parseCounts(value)) return false;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t nextRandom(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t nowNanos() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Ids and what they should resolve to, in the layout the old lookups scanned
+struct Fleet {
+  std::vector<uint64_t> ids;      // by position in configuration order
+  std::vector<String> textIds;    // the same, as the old decimal strings
+  std::vector<uint16_t> slots;    // slot each position was given
+  std::vector<uint64_t> missing;  // ids that are not in the table
+  std::vector<String> missingText;
+};
+
+class IdSource {
+ public:
+  IdSource(bool sequential, uint64_t seed) : _sequential(sequential), _state(seed), _next(1700000000000ULL) {}
+
+  uint64_t next() { return _sequential ? ++_next : nextRandom(_state) | 1; }
+
+ private:
+  bool _sequential;
+  uint64_t _state;
+  uint64_t _next;
+};
+
+void fill(ServiceTable& table, Fleet& fleet, int count, IdSource& ids) {
+  table.clear();
+  fleet = Fleet();
+  for (int i = 0; i < count; i++) {
+    Service* added = table.add(fakeService(ids.next(), TYPE_HTTP_GET));
+    if (added == nullptr) {
+      i--;  // a random id drawn twice
+      continue;
+    }
+    fleet.ids.push_back(added->id);
+    fleet.textIds.push_back(String((unsigned long long)added->id));
+    fleet.slots.push_back((uint16_t)(added - table.slots));
+  }
+  for (int i = 0; i < count; i++) {
+    fleet.missing.push_back(ids.next());
+    fleet.missingText.push_back(String((unsigned long long)fleet.missing.back()));
+  }
+}
+
+// Removes and re-adds every service, in random order, with fresh ids.
+void churn(ServiceTable& table, Fleet& fleet, IdSource& ids, uint64_t& state) {
+  for (int round = 0; round < options.churn; round++) {
+    std::vector<int> positions(fleet.ids.size());
+    for (size_t i = 0; i < positions.size(); i++) positions[i] = (int)i;
+    for (size_t i = positions.size(); i > 1; i--) std::swap(positions[i - 1], positions[nextRandom(state) % i]);
+
+    for (int position : positions) {
+      table.remove(fleet.ids[position]);
+      Service* added = nullptr;
+      while (added == nullptr) {
+        added = table.add(fakeService(ids.next(), TYPE_HTTP_GET));
+      }
+      fleet.ids[position] = added->id;
+      fleet.textIds[position] = String((unsigned long long)added->id);
+      fleet.slots[position] = (uint16_t)(added - table.slots);
+    }
+  }
+  for (size_t i = 0; i < fleet.missing.size(); i++) {
+    fleet.missing[i] = ids.next();
+    fleet.missingText[i] = String((unsigned long long)fleet.missing[i]);
+  }
+}
+
+// The order the lookups visit positions in: shuffled, so neither the index
+// nor the scans get the cache's help from a predictable pattern
+std::vector<int> lookupOrder(int count, uint64_t& state) {
+  std::vector<int> order(65536);
+  for (size_t i = 0; i < order.size(); i++) order[i] = (int)(nextRandom(state) % count);
+  return order;
+}
+
+struct Timing {
+  double hitNs;
+  double missNs;
+  bool correct;
+};
+
+template <typename Lookup>
+Timing timeLookups(const Fleet& fleet, const std::vector<int>& order, long lookups, Lookup lookup) {
+  Timing timing = {0, 0, true};
+  long sink = 0;
+
+  uint64_t start = nowNanos();
+  for (long i = 0; i < lookups; i++) {
+    int position = order[i % order.size()];
+    int slot = lookup(fleet.ids[position], fleet.textIds[position]);
+    timing.correct = timing.correct && slot == fleet.slots[position];
+    sink += slot;
+  }
+  timing.hitNs = (double)(nowNanos() - start) / lookups;
+
+  start = nowNanos();
+  for (long i = 0; i < lookups; i++) {
+    int position = order[i % order.size()];
+    int slot = lookup(fleet.missing[position], fleet.missingText[position]);
+    timing.correct = timing.correct && slot == -1;
+    sink += slot;
+  }
+  timing.missNs = (double)(nowNanos() - start) / lookups;
+
+  if (sink == 42) printf(" ");  // keeps the loops from being optimised away
+  return timing;
+}
+
+void printRow(int count, const char* ids, const char* lookup, const Timing& timing, long lookups) {
+  printf("%8d  %-10s  %-13s  %9.1f  %9.1f  %9ld%s\n", count, ids, lookup, timing.hitNs, timing.missNs, lookups,
+    timing.correct ? "" : "  WRONG");
+}
+
+ServiceTable table;  // about 1 MB at 4096 services; kept off the stack
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    fprintf(stderr, "usage: %s [--lookups N] [--counts N,N,...] [--churn N]\n", argv[0]);
+    return 2;
+  }
+
+  printf("MAX_SERVICES %d: index %d buckets, %zu bytes; slot bookkeeping %zu bytes; table %zu bytes\n\n",
+    MAX_SERVICES, ServiceIndex::CAPACITY, sizeof(ServiceIndex),
+    sizeof(table.slotUsed) + sizeof(table.order), sizeof(ServiceTable));
+  printf("%8s  %-10s  %-13s  %9s  %9s  %9s\n", "services", "ids", "lookup", "hit ns", "miss ns", "lookups");
+
+  bool allCorrect = true;
+  uint64_t state = 28;
+
+  for (int count : options.counts) {
+    if (count > MAX_SERVICES) {
+      printf("%8d  skipped, above MAX_SERVICES\n", count);
+      continue;
+    }
+
+    // The scans cost O(count) per lookup; fewer of them keep the run short
+    long scanLookups = std::max(1000L, options.lookups / std::max(1, count / 16));
+
+    for (bool sequential : {true, false}) {
+      const char* kind = sequential ? "sequential" : "random";
+      IdSource ids(sequential, state);
+      Fleet fleet;
+      fill(table, fleet, count, ids);
+      std::vector<int> order = lookupOrder(count, state);
+
+      Timing index = timeLookups(fleet, order, options.lookups, [](uint64_t id, const String&) {
+        return table.index.find(id);
+      });
+      Timing scanIds = timeLookups(fleet, order, scanLookups, [](uint64_t id, const String&) {
+        for (int i = 0; i < table.count; i++) {
+          if (table.at(i).id == id) return (int)table.order[i];
+        }
+        return -1;
+      });
+      Timing scanText = timeLookups(fleet, order, scanLookups, [&fleet](uint64_t, const String& id) {
+        for (size_t i = 0; i < fleet.textIds.size(); i++) {
+          if (fleet.textIds[i] == id) return (int)fleet.slots[i];
+        }
+        return -1;
+      });
+
+      churn(table, fleet, ids, state);
+      Timing churned = timeLookups(fleet, order, options.lookups, [](uint64_t id, const String&) {
+        return table.index.find(id);
+      });
+
+      printRow(count, kind, "index", index, options.lookups);
+      printRow(count, kind, "index churned", churned, options.lookups);
+      printRow(count, kind, "scan u64", scanIds, scanLookups);
+      printRow(count, kind, "scan str", scanText, scanLookups);
+      allCorrect = allCorrect && index.correct && churned.correct && scanIds.correct && scanText.correct;
+    }
+
+    printf("%8d  index load %.0f%%, %.1f bytes per service (the scans need none)\n\n", count,
+      100.0 * count / ServiceIndex::CAPACITY, (double)sizeof(ServiceIndex) / count);
+  }
+
+  return allCorrect ? 0 : 1;
+}
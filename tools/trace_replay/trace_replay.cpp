@@ -0,0 +1,282 @@
+// Replays a probe trace downloaded from /api/trace through the firmware's
+// threshold state machine (src/service_engine.cpp) on a virtual clock, and
+// applies the notification rules of checkServices(). A production flapping
+// incident replays exactly, and a changed state machine can be compared
+// against real traces far faster than real time.
+//
+// Build from the repository root:
+//
+//   g++ -std=c++17 -O2 -Ihost -Iinclude -o trace_replay
+//     tools/trace_replay/trace_replay.cpp src/service.cpp src/service_engine.cpp
+//
+// Usage: trace_replay [--quiet] [--repeat N] [--pass N] [--fail N] trace.bin
+//
+// --pass/--fail set the thresholds of services whose configuration record was
+// deleted with an old segment; --repeat replays the trace N times to time the state machine.
+
+#include <Arduino.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "http_probe.hpp"
+#include "probe_trace.hpp"
+#include "service_engine.hpp"
+
+namespace {
+
+const char* const ERROR_NAMES[] = {
+  "ok", "dns", "connect", "timeout", "closed", "bad response", "http status", "mismatch"
+};
+
+struct Options {
+  bool quiet = false;
+  int repeat = 1;
+  int passThreshold = 1;
+  int failThreshold = 1;
+  const char* path = nullptr;
+};
+
+struct ReplayedService {
+  Service service;
+  bool checkedSinceBoot = false;
+  bool down = false;       // reported DOWN (pending does not count)
+  uint64_t downSince = 0;  // virtual ms
+
+  uint32_t checks = 0;
+  uint32_t failures = 0;
+  uint32_t transitions = 0;
+  uint32_t notifications = 0;
+  uint64_t downMillis = 0;
+};
+
+struct Totals {
+  uint32_t records = 0;
+  uint32_t transitions = 0;
+  uint32_t notifications = 0;
+  uint64_t span = 0;  // virtual ms covered
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    String arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--quiet") {
+      options.quiet = true;
+    } else if (arg == "--repeat" && hasValue) {
+      options.repeat = atoi(argv[++i]);
+    } else if (arg == "--pass" && hasValue) {
+      options.passThreshold = atoi(argv[++i]);
+    } else if (arg == "--fail" && hasValue) {
+      options.failThreshold = atoi(argv[++i]);
+    } else if (argv[i][0] != '-' && options.path == nullptr) {
+      options.path = argv[i];
+    } else {
+      return false;
+    }
+  }
+  return options.path != nullptr && options.repeat > 0 && options.passThreshold > 0 && options.failThreshold > 0;
+}
+
+bool readTraceFile(const char* path, std::vector<TraceRecord>& records) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+
+  TraceHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_MAGIC ||
+      header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord)) {
+    fprintf(stderr, "%s: not a version %u probe trace\n", path, TRACE_VERSION);
+    fclose(file);
+    return false;
+  }
+
+  TraceRecord record;
+  while (fread(&record, sizeof(record), 1, file) == 1) {
+    records.push_back(record);
+  }
+  fclose(file);
+  return true;
+}
+
+// Thresholds for each service from the first configuration record that
+// mentions it, so probes from before that record (its predecessor having
+// been deleted with an old segment) are still judged correctly.
+std::map<uint64_t, TraceRecord> firstConfigs(const std::vector<TraceRecord>& records) {
+  std::map<uint64_t, TraceRecord> configs;
+  for (const TraceRecord& record : records) {
+    if (record.kind == TRACE_CONFIG && configs.count(record.id) == 0) {
+      configs[record.id] = record;
+    }
+  }
+  return configs;
+}
+
+void formatTime(uint64_t millis, char* out, size_t size) {
+  snprintf(out, size, "%3u:%02u:%02u.%03u", (unsigned)(millis / 3600000), (unsigned)(millis / 60000 % 60),
+    (unsigned)(millis / 1000 % 60), (unsigned)(millis % 1000));
+}
+
+Totals replay(const std::vector<TraceRecord>& records, const Options& options,
+    std::map<uint64_t, ReplayedService>& services, bool print) {
+  std::map<uint64_t, TraceRecord> configs = firstConfigs(records);
+  Totals totals;
+
+  // Device millis() restarts at every boot; the virtual clock keeps going
+  uint64_t bootBase = 0;
+  uint32_t bootMillis = 0;
+  uint64_t now = 0;
+
+  for (const TraceRecord& record : records) {
+    totals.records++;
+    if (record.kind == TRACE_BOOT) {
+      bootBase = now;
+      bootMillis = record.millis;
+      // Every service starts over as pending; TRACE_RESTORE records follow
+      // for those whose state was restored
+      for (auto& entry : services) {
+        ReplayedService& replayed = entry.second;
+        if (replayed.down) {
+          replayed.downMillis += now - replayed.downSince;
+        }
+        resetServiceRuntime(replayed.service);
+        replayed.checkedSinceBoot = false;
+        replayed.down = false;
+      }
+      continue;
+    }
+
+    uint64_t virtualNow = bootBase + (uint32_t)(record.millis - bootMillis);
+    if (virtualNow > now) now = virtualNow;
+
+    bool isNew = services.count(record.id) == 0;
+    ReplayedService& replayed = services[record.id];
+    if (isNew) {
+      replayed.service.id = record.id;
+      replayed.service.passThreshold = options.passThreshold;
+      replayed.service.failThreshold = options.failThreshold;
+      auto config = configs.find(record.id);
+      if (config != configs.end()) {
+        replayed.service.passThreshold = config->second.value;
+        replayed.service.failThreshold = config->second.detail;
+      }
+      resetServiceRuntime(replayed.service);
+    }
+    Service& service = replayed.service;
+
+    if (record.kind == TRACE_CONFIG) {
+      service.passThreshold = record.value;
+      service.failThreshold = record.detail;
+      continue;
+    }
+    if (record.kind == TRACE_RESTORE) {
+      bool passing = record.detail & 2;
+      service.isUp = record.detail & 1;
+      service.consecutivePasses = passing ? record.value : 0;
+      service.consecutiveFails = passing ? 0 : record.value;
+      replayed.checkedSinceBoot = true;
+      replayed.down = !service.isUp;
+      replayed.downSince = now;
+      continue;
+    }
+    if (record.kind != TRACE_PASS && record.kind != TRACE_FAIL) continue;
+
+    bool passed = record.kind == TRACE_PASS;
+    bool firstCheck = !replayed.checkedSinceBoot;
+    replayed.checkedSinceBoot = true;
+    replayed.checks++;
+    if (!passed) {
+      replayed.failures++;
+      service.lastError = record.detail < 8 ? ERROR_NAMES[record.detail] : "unknown";
+    }
+
+    if (!applyCheckResult(service, passed, record.millis)) continue;
+
+    replayed.transitions++;
+    totals.transitions++;
+    if (replayed.down) {
+      replayed.downMillis += now - replayed.downSince;
+    }
+    replayed.down = !service.isUp;
+    replayed.downSince = now;
+
+    // Same rule as checkServices(): DOWN always notifies, UP only once the
+    // service had been checked before
+    bool notify = !service.isUp || !firstCheck;
+    if (notify) {
+      replayed.notifications++;
+      totals.notifications++;
+    }
+
+    if (print) {
+      char time[20];
+      formatTime(now, time, sizeof(time));
+      printf("%s  %016llx  %-4s after %d %s%s%s%s\n", time, (unsigned long long)service.id,
+        service.isUp ? "UP" : "DOWN",
+        service.isUp ? service.consecutivePasses : service.consecutiveFails,
+        service.isUp ? "passes" : "fails",
+        service.isUp ? "" : " (", service.isUp ? "" : service.lastError.c_str(), service.isUp ? "" : ")");
+    }
+  }
+
+  for (auto& entry : services) {
+    ReplayedService& replayed = entry.second;
+    if (replayed.down) {
+      replayed.downMillis += now - replayed.downSince;
+      replayed.downSince = now;
+    }
+  }
+  totals.span = now;
+  return totals;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    fprintf(stderr, "usage: %s [--quiet] [--repeat N] [--pass N] [--fail N] trace.bin\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<TraceRecord> records;
+  if (!readTraceFile(options.path, records)) return 1;
+
+  std::map<uint64_t, ReplayedService> services;
+  Totals totals = replay(records, options, services, !options.quiet);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 1; i < options.repeat; i++) {
+    std::map<uint64_t, ReplayedService> scratch;
+    replay(records, options, scratch, false);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("\n%-16s  %7s  %7s  %6s  %6s  %10s\n", "service", "checks", "fails", "flips", "notify", "down");
+  for (const auto& entry : services) {
+    const ReplayedService& replayed = entry.second;
+    if (replayed.checks == 0) continue;
+
+    char down[20];
+    formatTime(replayed.downMillis, down, sizeof(down));
+    printf("%016llx  %7u  %7u  %6u  %6u  %s\n", (unsigned long long)entry.first, replayed.checks,
+      replayed.failures, replayed.transitions, replayed.notifications, down);
+  }
+
+  char span[20];
+  formatTime(totals.span, span, sizeof(span));
+  printf("\n%u records over %s: %u transitions, %u notifications\n", totals.records, span,
+    totals.transitions, totals.notifications);
+
+  if (options.repeat > 1) {
+    int timed = options.repeat - 1;
+    double perReplay = seconds / timed;
+    printf("%d replays in %.3f s: %.0f records/s, %.0fx real time\n", timed, seconds,
+      totals.records / perReplay, perReplay > 0 ? totals.span / 1000.0 / perReplay : 0.0);
+  }
+  return 0;
+}
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""Load test for the web server while the device runs its checks.
+
+Drives concurrent clients against /, /api/services, /api/export and the
+add/delete endpoints of a device, one stage per concurrency level. For
+each stage it reports request latency percentiles and failures, and from
+/api/diag the internal heap low point and how late checks started. The
+lateness comes from the difference of the histogram before and after the
+stage, so it covers only that stage.
+
+Meant for a build with -DSIMULATE_PROBES=1 (see README), so the probe
+load is known and repeatable. Leave SIMULATED_SERVICE_COUNT below
+MAX_SERVICES by at least the largest client count; each mutation client
+adds one service and deletes it again.
+
+  tools/web_load/web_load.py 192.168.1.50 --clients 1,2,4,8 --seconds 60
+"""
+
+import argparse
+import base64
+import http.client
+import json
+import random
+import threading
+import time
+
+ENDPOINTS = ("page", "services", "export", "mutate")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("host", help="device address, optionally host:port")
+    parser.add_argument("--clients", default="1,2,4,8",
+                        help="comma-separated concurrency levels, one stage each (default 1,2,4,8)")
+    parser.add_argument("--seconds", type=float, default=30, help="length of each stage (default 30)")
+    parser.add_argument("--think-ms", type=float, default=0,
+                        help="pause between a client's requests; 5000 behaves like an open dashboard")
+    parser.add_argument("--mix", default="page=1,services=6,export=2,mutate=1",
+                        help="relative weights of " + ", ".join(ENDPOINTS))
+    parser.add_argument("--timeout", type=float, default=10, help="per-request timeout in seconds")
+    parser.add_argument("--user", help="web username, if WEB_AUTH_USERNAME is set")
+    parser.add_argument("--password", default="")
+    return parser.parse_args()
+
+
+def parse_mix(text):
+    weights = {}
+    for part in text.split(","):
+        name, _, weight = part.partition("=")
+        if name not in ENDPOINTS:
+            raise SystemExit(f"unknown endpoint in --mix: {name}")
+        weights[name] = float(weight)
+    return weights
+
+
+class Device:
+    def __init__(self, host, timeout, user, password):
+        self.host = host
+        self.timeout = timeout
+        self.headers = {}
+        if user:
+            token = base64.b64encode(f"{user}:{password}".encode()).decode()
+            self.headers["Authorization"] = "Basic " + token
+
+    def request(self, method, path, body=None):
+        """Returns (status, body bytes); status 0 for a connection error or timeout."""
+        headers = dict(self.headers)
+        if body is not None:
+            body = json.dumps(body)
+            headers["Content-Type"] = "application/json"
+
+        connection = http.client.HTTPConnection(self.host, timeout=self.timeout)
+        try:
+            connection.request(method, path, body=body, headers=headers)
+            response = connection.getresponse()
+            return response.status, response.read()
+        except (OSError, http.client.HTTPException):
+            return 0, b""
+        finally:
+            connection.close()
+
+    def diag(self):
+        status, body = self.request("GET", "/api/diag")
+        if status != 200:
+            raise SystemExit(f"GET /api/diag failed ({status}); is the device reachable?")
+        return json.loads(body)
+
+
+class Results:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = {name: [] for name in ENDPOINTS}
+        self.failures = {name: 0 for name in ENDPOINTS}
+        self.busy = 0  # 503 from a full command queue
+
+    def add(self, name, seconds, status):
+        with self.lock:
+            if 200 <= status < 300:
+                self.latencies[name].append(seconds)
+            else:
+                self.failures[name] += 1
+                if status == 503:
+                    self.busy += 1
+
+
+def mutate(device, client, results):
+    """Adds a service and deletes it again, timing each request."""
+    service = {
+        "name": f"load-{client}", "type": "http_get", "host": "simulated", "port": 80,
+        "path": "/", "expectedResponse": "*", "checkInterval": 60,
+    }
+    start = time.monotonic()
+    status, body = device.request("POST", "/api/services", service)
+    results.add("mutate", time.monotonic() - start, status)
+    if status != 200:
+        return
+
+    # loop() applies the add between check rounds; until then the delete
+    # answers 404, so keep trying rather than leave the service behind
+    service_id = json.loads(body).get("id")
+    give_up = time.monotonic() + 60
+    while True:
+        start = time.monotonic()
+        status, _ = device.request("DELETE", f"/api/services/{service_id}")
+        if status != 404 or time.monotonic() > give_up:
+            break
+        time.sleep(0.2)
+    results.add("mutate", time.monotonic() - start, status)
+
+
+def run_client(device, client, weights, think, deadline, results):
+    paths = {"page": "/", "services": "/api/services", "export": "/api/export"}
+    names = list(weights)
+    rng = random.Random(client)
+
+    while time.monotonic() < deadline:
+        name = rng.choices(names, [weights[n] for n in names])[0]
+        if name == "mutate":
+            mutate(device, client, results)
+        else:
+            start = time.monotonic()
+            status, _ = device.request("GET", paths[name])
+            results.add(name, time.monotonic() - start, status)
+        if think > 0:
+            time.sleep(think)
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    rank = max(0, min(len(sorted_values) - 1, int(len(sorted_values) * p / 100 + 0.999999) - 1))
+    return sorted_values[rank]
+
+
+def histogram_percentile(before, after, p):
+    """Percentile (ms) of the samples recorded between two /api/diag histograms,
+    inf past the last bound and None without samples."""
+    counts = [b["count"] - a["count"] for a, b in zip(before["buckets"], after["buckets"])]
+    total = sum(counts)
+    if total == 0:
+        return None
+    rank = (total * p + 99) // 100
+    seen = 0
+    for bucket, count in zip(after["buckets"], counts):
+        seen += count
+        if seen >= rank:
+            return float("inf") if bucket["le"] == "inf" else bucket["le"] / 1000
+    return None
+
+
+def run_stage(device, clients, args, weights):
+    before = device.diag()
+    results = Results()
+    deadline = time.monotonic() + args.seconds
+    lowest_free = before["heap"]["free"]
+
+    threads = [threading.Thread(target=run_client,
+                                args=(device, c, weights, args.think_ms / 1000, deadline, results))
+               for c in range(clients)]
+    for thread in threads:
+        thread.start()
+
+    # Sample the heap while the stage runs; the lifetime minimum in
+    # /api/diag cannot be reset between stages
+    while any(t.is_alive() for t in threads):
+        time.sleep(1)
+        status, body = device.request("GET", "/api/diag")
+        if status == 200:
+            lowest_free = min(lowest_free, json.loads(body)["heap"]["free"])
+    for thread in threads:
+        thread.join()
+
+    after = device.diag()
+    return before, after, results, lowest_free
+
+
+def format_ms(value):
+    if value is None:
+        return "-"
+    return ">10s" if value == float("inf") else f"{value:.1f}"
+
+
+def main():
+    args = parse_args()
+    weights = parse_mix(args.mix)
+    device = Device(args.host, args.timeout, args.user, args.password)
+    levels = [int(level) for level in args.clients.split(",")]
+
+    print(f"{'clients':>7} {'req/s':>7} {'p50 ms':>7} {'p99 ms':>7} {'failed':>6} {'busy':>5} "
+          f"{'heap lo':>8} {'late p50':>8} {'late p99':>8} {'checks/s':>8}")
+
+    for clients in levels:
+        before, after, results, lowest_free = run_stage(device, clients, args, weights)
+
+        everything = sorted(v for values in results.latencies.values() for v in values)
+        failed = sum(results.failures.values())
+        checks = after["probe"]["count"] - before["probe"]["count"]
+        elapsed = (after["uptimeMillis"] - before["uptimeMillis"]) / 1000
+
+        print(f"{clients:7d} {len(everything) / args.seconds:7.1f} "
+              f"{percentile(everything, 50) * 1000:7.1f} {percentile(everything, 99) * 1000:7.1f} "
+              f"{failed:6d} {results.busy:5d} {lowest_free:8d} "
+              f"{format_ms(histogram_percentile(before['scheduleLateness'], after['scheduleLateness'], 50)):>8} "
+              f"{format_ms(histogram_percentile(before['scheduleLateness'], after['scheduleLateness'], 99)):>8} "
+              f"{checks / elapsed if elapsed > 0 else 0:8.2f}")
+
+        for name in ENDPOINTS:
+            values = sorted(results.latencies[name])
+            if not values and results.failures[name] == 0:
+                continue
+            print(f"{'':7} {name:>8}: {len(values):5d} ok, {results.failures[name]:4d} failed, "
+                  f"p50 {percentile(values, 50) * 1000:7.1f} ms, p99 {percentile(values, 99) * 1000:7.1f} ms")
+
+
+if __name__ == "__main__":
+    main()